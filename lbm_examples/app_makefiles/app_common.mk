@@ -237,6 +237,12 @@ COMMON_C_DEFS += \
 LBM_BUILD_OPTIONS += LBM_STORE_AND_FORWARD=yes
 endif
 
+ifeq ($(ALLOW_SESSION_JOURNAL),yes)
+COMMON_C_DEFS += \
+	-DUSE_SESSION_JOURNAL
+LBM_BUILD_OPTIONS += LBM_SESSION_JOURNAL=yes
+endif
+
 ifneq ($(LBM_NB_OF_STACK),1)
 COMMON_C_DEFS += \
 	-DMULTISTACK
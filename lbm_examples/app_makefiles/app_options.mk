@@ -32,6 +32,9 @@ FUOTA_VERSION ?= 1
 # USE LBM Store and forward (take more RAM on STM32L4, due to read_modify_write feature)
 ALLOW_STORE_AND_FORWARD ?= no
 
+# USE LBM session journal to resume the LoRaWAN session after a reset (STM32L4 only)
+ALLOW_SESSION_JOURNAL ?= no
+
 #TRACE
 LBM_TRACE ?= yes
 APP_TRACE ?= yes
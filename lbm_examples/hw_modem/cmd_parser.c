@@ -286,6 +286,7 @@ static const uint8_t host_cmd_tab[CMD_MAX][HOST_CMD_TAB_IDX_COUNT] = {
     [CMD_MODEM_GET_CRASHLOG]                     = { 1, 0, 0 },
     [CMD_MODEM_GET_REPORT_ALL_DOWNLINKS_TO_USER] = { 1, 0, 0 },
     [CMD_MODEM_SET_REPORT_ALL_DOWNLINKS_TO_USER] = { 1, 1, 1 },
+    [CMD_MODEM_GET_RP_TIMELINE]                  = { 1, 0, 0 },
 };
 
 /**
@@ -463,6 +464,7 @@ static const char* host_cmd_str[CMD_MAX] = {
     [CMD_MODEM_GET_CRASHLOG]                     = "CMD_GET_CRASHLOG",
     [CMD_MODEM_GET_REPORT_ALL_DOWNLINKS_TO_USER] = "CMD_MODEM_GET_REPORT_ALL_DOWNLINKS_TO_USER",
     [CMD_MODEM_SET_REPORT_ALL_DOWNLINKS_TO_USER] = "CMD_MODEM_SET_REPORT_ALL_DOWNLINKS_TO_USER",
+    [CMD_MODEM_GET_RP_TIMELINE]                  = "CMD_MODEM_GET_RP_TIMELINE",
 };
 #endif
 
@@ -1895,6 +1897,25 @@ cmd_parse_status_t parse_cmd( cmd_input_t* cmd_input, cmd_response_t* cmd_output
 
         break;
     }
+    case CMD_MODEM_GET_RP_TIMELINE:
+    {
+        // 2 bytes of lost events count followed by as many events as the response can hold
+        uint16_t timeline_length   = 0;
+        uint16_t lost_events_count = 0;
+
+        cmd_output->return_code = rc_lut[smtc_modem_debug_get_rp_timeline(
+            &cmd_output->buffer[2],
+            ( SMTC_MODEM_MAX_LORAWAN_PAYLOAD_LENGTH / SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH ) *
+                SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH,
+            &timeline_length, &lost_events_count )];
+        if( cmd_output->return_code == CMD_RC_OK )
+        {
+            cmd_output->buffer[0] = ( lost_events_count >> 8 ) & 0xFF;
+            cmd_output->buffer[1] = ( lost_events_count & 0xFF );
+            cmd_output->length    = timeline_length + 2;
+        }
+        break;
+    }
 #if defined( STM32L476xx )
     case CMD_STORE_AND_FORWARD_SET_STATE:
     {
@@ -210,6 +210,7 @@ typedef enum host_cmd_id_e
     CMD_MODEM_GET_CRASHLOG                     = 0x98,
     CMD_MODEM_GET_REPORT_ALL_DOWNLINKS_TO_USER = 0x99,
     CMD_MODEM_SET_REPORT_ALL_DOWNLINKS_TO_USER = 0x9A,
+    CMD_MODEM_GET_RP_TIMELINE                  = 0x9B,
     CMD_MAX
 } host_cmd_id_t;
 
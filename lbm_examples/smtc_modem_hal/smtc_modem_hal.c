@@ -89,6 +89,7 @@
 #if defined( STM32L476xx )
 #define ADDR_FLASH_FUOTA ADDR_FLASH_PAGE_150
 #define ADDR_FLASH_STORE_AND_FORWARD ADDR_FLASH_PAGE_200
+#define ADDR_FLASH_SESSION_JOURNAL ADDR_FLASH_PAGE_240
 #define ADDR_FLASH_SECURE_ELEMENT_CONTEXT ADDR_FLASH_PAGE_252
 #define ADDR_FLASH_MODEM_CONTEXT ADDR_FLASH_PAGE_253
 #define ADDR_FLASH_LORAWAN_CONTEXT ADDR_FLASH_PAGE_254
@@ -219,6 +220,9 @@ void smtc_modem_hal_context_restore( const modem_context_type_t ctx_type, uint32
     case CONTEXT_STORE_AND_FORWARD:
         // no store and fw example on stm32l0
         break;
+    case CONTEXT_SESSION_JOURNAL:
+        // no session journal example on stm32l0
+        break;
     case CONTEXT_SECURE_ELEMENT:
         hal_eeprom_read_buffer( ADDR_EEPROM_SECURE_ELEMENT_CONTEXT_OFFSET, buffer, size );
         break;
@@ -241,6 +245,9 @@ void smtc_modem_hal_context_restore( const modem_context_type_t ctx_type, uint32
     case CONTEXT_STORE_AND_FORWARD:
         hal_flash_read_buffer( ADDR_FLASH_STORE_AND_FORWARD + offset, buffer, size );
         break;
+    case CONTEXT_SESSION_JOURNAL:
+        hal_flash_read_buffer( ADDR_FLASH_SESSION_JOURNAL + offset, buffer, size );
+        break;
 #endif
     default:
         mcu_panic( );
@@ -271,6 +278,9 @@ void smtc_modem_hal_context_store( const modem_context_type_t ctx_type, uint32_t
     case CONTEXT_STORE_AND_FORWARD:
         // no store and fw example on stm32l0
         break;
+    case CONTEXT_SESSION_JOURNAL:
+        // no session journal example on stm32l0
+        break;
     case CONTEXT_SECURE_ELEMENT:
         hal_eeprom_write_buffer( ADDR_EEPROM_SECURE_ELEMENT_CONTEXT_OFFSET, buffer, size );
         break;
@@ -309,6 +319,9 @@ void smtc_modem_hal_context_store( const modem_context_type_t ctx_type, uint32_t
     case CONTEXT_STORE_AND_FORWARD:
         hal_flash_write_buffer( ADDR_FLASH_STORE_AND_FORWARD + offset, buffer, size );
         break;
+    case CONTEXT_SESSION_JOURNAL:
+        hal_flash_write_buffer( ADDR_FLASH_SESSION_JOURNAL + offset, buffer, size );
+        break;
 #endif
     default:
         mcu_panic( );
@@ -324,6 +337,9 @@ void smtc_modem_hal_context_flash_pages_erase( const modem_context_type_t ctx_ty
     case CONTEXT_STORE_AND_FORWARD:
         hal_flash_erase_page( ADDR_FLASH_STORE_AND_FORWARD + offset, nb_page );
         break;
+    case CONTEXT_SESSION_JOURNAL:
+        hal_flash_erase_page( ADDR_FLASH_SESSION_JOURNAL + offset, nb_page );
+        break;
 #endif
     default:
         mcu_panic( );
@@ -537,7 +553,17 @@ uint16_t smtc_modem_hal_store_and_forward_get_number_of_pages( void )
 {
     return 10;
 }
+#endif
+
+/* ------------ Needed for the LoRaWAN session journal  ------------*/
+#if defined( USE_SESSION_JOURNAL )
+uint16_t smtc_modem_hal_session_journal_get_number_of_pages( void )
+{
+    return 4;
+}
+#endif
 
+#if defined( USE_STORE_AND_FORWARD ) || defined( USE_SESSION_JOURNAL )
 uint16_t smtc_modem_hal_flash_get_page_size( void )
 {
     return hal_flash_get_page_size( );
@@ -145,19 +145,50 @@ LBM_C_DEFS += \
 	-DMODEM_HAL_DBG_TRACE=0
 endif
 
+# Select the CRC-32 implementation
+LBM_C_DEFS += \
+	-DMODEM_CRC32_IMPLEMENTATION=MODEM_CRC32_$(CRC32)
+
+# Time the modem and key contexts may wait in RAM to merge their writes
+LBM_C_DEFS += \
+	-DMODEM_CONTEXT_CACHE_WINDOW_MS=$(CONTEXT_CACHE_WINDOW_MS)
+
 ifeq ($(PERF_TEST),yes)
 LBM_C_DEFS += \
 	-DPERF_TEST_ENABLED
 endif
 
+ifeq ($(LBM_RP_TIMELINE),yes)
+LBM_C_DEFS += \
+	-DADD_RP_TIMELINE
+endif
+
+ifeq ($(LBM_LBT_TIMER_SAMPLING),yes)
+LBM_C_DEFS += \
+	-DADD_LBT_TIMER_SAMPLING
+endif
+
+ifeq ($(LBM_CHANNEL_OCCUPANCY),yes)
+LBM_C_DEFS += \
+	-DADD_CHANNEL_OCCUPANCY
+endif
+
 ifeq ($(LBM_STREAM),yes)
 LBM_C_DEFS += \
     -DADD_SMTC_STREAM
+    ifeq ($(STREAM_COEFF_CACHE),yes)
+    LBM_C_DEFS += \
+        -DROSE_COEFF_CACHE
+    endif
 endif
 
 ifeq ($(LBM_LFU),yes)
 LBM_C_DEFS += \
     -DADD_SMTC_LFU
+    ifeq ($(LFU_STREAMED),yes)
+    LBM_C_DEFS += \
+        -DADD_LFU_STREAMED
+    endif
 endif
 
 ifeq ($(LBM_DEVICE_MANAGEMENT),yes)
@@ -168,6 +199,15 @@ endif
 ifeq ($(LBM_STORE_AND_FORWARD),yes)
 LBM_C_DEFS += \
     -DADD_SMTC_STORE_AND_FORWARD
+    ifeq ($(STORE_AND_FORWARD_AGGREGATION),yes)
+    LBM_C_DEFS += \
+        -DADD_STORE_AND_FORWARD_AGGREGATION
+    endif
+endif
+
+ifeq ($(LBM_SESSION_JOURNAL),yes)
+LBM_C_DEFS += \
+    -DADD_SMTC_SESSION_JOURNAL
 endif
 
 ifeq ($(LBM_FUOTA),yes)
@@ -188,6 +228,10 @@ LBM_C_DEFS += \
     ifneq ($(FUOTA_MAXIMUM_FRAG_REDUNDANCY),nc)
     LBM_C_DEFS += \
        	-DFRAG_MAX_REDUNDANCY=$(FUOTA_MAXIMUM_FRAG_REDUNDANCY)
+    endif
+    ifeq ($(FUOTA_PAGED_MATRIX),yes)
+    LBM_C_DEFS += \
+       	-DFRAG_DECODER_PAGED_MATRIX=1
     endif
 	ifeq ($(LBM_FUOTA_ENABLE_FMP),yes)
     LBM_C_DEFS += \
@@ -252,7 +296,9 @@ SMTC_MODEM_CORE_C_SOURCES += \
 	smtc_modem_core/smtc_modem_test.c\
 	smtc_modem_core/modem_utilities/modem_event_utilities.c\
 	smtc_modem_core/modem_utilities/fifo_ctrl.c\
+	smtc_modem_core/modem_utilities/modem_context_cache.c\
 	smtc_modem_core/modem_utilities/modem_core.c \
+	smtc_modem_core/modem_utilities/modem_crc.c\
 	smtc_modem_core/modem_supervisor/modem_supervisor_light.c\
 	smtc_modem_core/modem_supervisor/modem_tx_protocol_manager.c\
 	smtc_modem_core/lorawan_packages/lorawan_certification/lorawan_certification.c\
@@ -358,10 +404,19 @@ endif
 
 ifeq ($(LBM_STORE_AND_FORWARD),yes)
 SMTC_MODEM_CORE_C_SOURCES += \
-	smtc_modem_core/modem_utilities/circularfs.c\
 	smtc_modem_core/modem_services/store_and_forward/store_and_forward_flash.c
 endif
 
+ifeq ($(LBM_SESSION_JOURNAL),yes)
+SMTC_MODEM_CORE_C_SOURCES += \
+	smtc_modem_core/lr1mac/src/lr1mac_session_journal.c
+endif
+
+ifneq ($(filter yes,$(LBM_STORE_AND_FORWARD) $(LBM_SESSION_JOURNAL)),)
+SMTC_MODEM_CORE_C_SOURCES += \
+	smtc_modem_core/modem_utilities/circularfs.c
+endif
+
 ifeq ($(ALLOW_CSMA_BUILD),yes)
 ifeq ($(LBM_CSMA),yes)
 LR1MAC_C_SOURCES += \
@@ -500,6 +555,11 @@ LBM_C_SOURCES = \
 
 MODEM_ASM_SOURCES = $(BOARD_ASM_SOURCES)
 
+# Select the soft AES implementation
+ifeq ($(CRYPTO_SOFT_AES),TTABLE)
+LBM_C_SOURCES := $(patsubst %/soft_secure_element/aes.c,%/soft_secure_element/aes_ttable.c,$(LBM_C_SOURCES))
+endif
+
 # Remove duplicates in sources by sorting it
 LBM_C_SOURCES := $(sort $(LBM_C_SOURCES))
 
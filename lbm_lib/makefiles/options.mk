@@ -60,6 +60,16 @@ REGION ?= ALL
 # Crypto management only for lr11xx targets (SOFT, LR11XX, LR11XX_WITH_CREDENTIALS )
 CRYPTO ?= SOFT
 
+# Soft AES implementation, only for SOFT crypto (BYTE: smallest flash footprint, TTABLE: 32-bit tables, ~4KB more flash but faster)
+CRYPTO_SOFT_AES ?= BYTE
+
+# CRC-32 implementation used for contexts and flash records
+# (BITWISE: no table, NIBBLE: 64B table, BYTE: 1KB table, SLICE_BY_4: 4KB tables, from slowest to fastest)
+CRC32 ?= NIBBLE
+
+# Time in ms the modem and key contexts may wait in RAM to merge their writes (0: written immediately)
+CONTEXT_CACHE_WINDOW_MS ?= 0
+
 #-----------------------------------------------------------------------------
 # LoRaWAN Stack related options
 #-----------------------------------------------------------------------------
@@ -92,6 +102,8 @@ LBM_FUOTA_VERSION ?= 1
 FUOTA_MAXIMUM_NB_OF_FRAGMENTS ?= nc
 FUOTA_MAXIMUM_SIZE_OF_FRAGMENTS ?= nc
 FUOTA_MAXIMUM_FRAG_REDUNDANCY ?= nc
+# In case FUOTA v2 is enabled, store the decoding matrix in the FUOTA context instead of RAM (for large sessions)
+FUOTA_PAGED_MATRIX ?= no
 # In case FUOTA is allowed, allow the use of Firmware Management Package
 LBM_FUOTA_ENABLE_FMP ?= yes
 # In case FUOTA is allowed, allow the use of Multi-Package Access Package
@@ -106,9 +118,13 @@ LBM_ALMANAC ?= no
 
 # Stream feature
 LBM_STREAM ?= no
+# In case Stream is enabled, generate the redundancy coefficients ahead of each frame (about 1 KB of RAM)
+STREAM_COEFF_CACHE ?= no
 
 # Large File Upload feature
 LBM_LFU ?= no
+# In case Large File Upload is enabled, allow to read the file through a callback (about 380 bytes of RAM)
+LFU_STREAMED ?= no
 
 # Cloud Device Management feature
 LBM_DEVICE_MANAGEMENT ?= no
@@ -122,6 +138,11 @@ LBM_GEOLOCATION ?= no
 
 #Store and Forward Management feature
 LBM_STORE_AND_FORWARD ?= no
+# In case Store and Forward is enabled, pack several stored data in one uplink (about 250 bytes of RAM)
+STORE_AND_FORWARD_AGGREGATION ?= no
+
+# LoRaWAN session journal, to resume the session after a reset instead of joining
+LBM_SESSION_JOURNAL ?= no
 
 # Multistack
 NB_OF_STACK ?= 1
@@ -130,4 +151,13 @@ NB_OF_STACK ?= 1
 LBM_RELAY_TX_ENABLE ?= no
 
 # Relay Rx
-LBM_RELAY_RX_ENABLE ?= no
\ No newline at end of file
+LBM_RELAY_RX_ENABLE ?= no
+
+# Radio planner timeline recorder
+LBM_RP_TIMELINE ?= no
+
+# Sample the LBT carrier sense on the radio planner timer instead of busy-waiting
+LBM_LBT_TIMER_SAMPLING ?= no
+
+# Keep per-channel LBT/CAD occupancy statistics and prefer the quieter channels
+LBM_CHANNEL_OCCUPANCY ?= no
\ No newline at end of file
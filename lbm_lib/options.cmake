@@ -11,6 +11,11 @@ set(LBM_REGIONS "ALL" CACHE STRING "The world regions to target (colon-separated
 
 set(LBM_CRYPTO "SOFT" CACHE STRING "Which crypto flavour to build")
 set_property(CACHE LBM_CRYPTO PROPERTY STRINGS "SOFT;LR11XX;LR11XX_WITH_CREDENTIALS")
+set(LBM_CRYPTO_SOFT_AES "BYTE" CACHE STRING "Which AES implementation to build for soft crypto (BYTE: smallest, TTABLE: faster, ~4KB more flash)")
+set_property(CACHE LBM_CRYPTO_SOFT_AES PROPERTY STRINGS "BYTE;TTABLE")
+set(LBM_CRC32 "NIBBLE" CACHE STRING "Which CRC-32 implementation to build (BITWISE: no table, NIBBLE: 64B, BYTE: 1KB, SLICE_BY_4: 4KB, fastest)")
+set_property(CACHE LBM_CRC32 PROPERTY STRINGS "BITWISE;NIBBLE;BYTE;SLICE_BY_4")
+set(LBM_CONTEXT_CACHE_WINDOW_MS "" CACHE STRING "Time in ms the modem and key contexts may wait in RAM to merge their writes (default 0: written immediately)")
 
 set(LBM_NUMBER_OF_STACKS 1 CACHE STRING "Number of network stacks (on the same transceiver)")
 
@@ -33,16 +38,24 @@ cmake_dependent_option(LBM_FUOTA_MPA "Build FUOTA Multi-Package Access Package"
 set(LBM_FUOTA_FRAGMENTS_MAX_NUM "" CACHE STRING "Maximum number of fragments for FUOTA")
 set(LBM_FUOTA_FRAGMENTS_MAX_SIZE "" CACHE STRING "Maximum size of fragments for FUOTA")
 set(LBM_FUOTA_FRAGMENTS_MAX_REDUNDANCY "" CACHE STRING "Maximum redundancy of fragments for FUOTA")
+cmake_dependent_option(LBM_FUOTA_PAGED_MATRIX "Store the FUOTA v2 decoding matrix in the FUOTA context instead of RAM" OFF "LBM_FUOTA" OFF)
 
 option(LBM_ALMANAC "Build Cloud Almanac Update service")
 option(LBM_STREAM "Build Cloud Stream service")
+cmake_dependent_option(LBM_STREAM_COEFF_CACHE "Generate the Cloud Stream redundancy coefficients ahead of each frame" OFF "LBM_STREAM" OFF)
 option(LBM_LFU "Build Cloud Large File Upload service")
+cmake_dependent_option(LBM_LFU_STREAMED "Read the Large File Upload file through a callback instead of a RAM buffer" OFF "LBM_LFU" OFF)
 option(LBM_DEVICE_MANAGEMENT "Build Cloud Device Management service")
 option(LBM_GEOLOCATION "Build Geolocation service")
 option(LBM_STORE_AND_FORWARD "Build Store and Forward service")
+cmake_dependent_option(LBM_STORE_AND_FORWARD_AGGREGATION "Pack several stored data in one Store and Forward uplink" OFF "LBM_STORE_AND_FORWARD" OFF)
+option(LBM_SESSION_JOURNAL "Build the LoRaWAN session journal, to resume the session after a reset instead of joining")
 option(LBM_RELAY_RX "Build Relay RX service")
 option(LBM_RELAY_TX "Build Relay TX service")
 option(LBM_BEACON_TX "Build Beacon TX service")
+option(LBM_RP_TIMELINE "Build the radio planner timeline recorder")
+option(LBM_LBT_TIMER_SAMPLING "Sample the LBT carrier sense on the radio planner timer instead of busy-waiting")
+option(LBM_CHANNEL_OCCUPANCY "Keep per-channel LBT/CAD occupancy statistics and prefer the quieter channels")
 
 # Internal options
 option(LBM_PERF_TEST "Build LBM with perf test")
@@ -61,6 +74,14 @@ if(LBM_CRYPTO MATCHES "^LR11XX" AND NOT RADIO_FAMILY STREQUAL "lr11xx")
     endif()
 endif()
 
+if(NOT LBM_CRYPTO_SOFT_AES MATCHES "^(BYTE|TTABLE)$")
+    message(SEND_ERROR "Unknown soft AES implementation ${LBM_CRYPTO_SOFT_AES}. Please use BYTE or TTABLE.")
+endif()
+
+if(NOT LBM_CRC32 MATCHES "^(BITWISE|NIBBLE|BYTE|SLICE_BY_4)$")
+    message(SEND_ERROR "Unknown CRC-32 implementation ${LBM_CRC32}. Please use BITWISE, NIBBLE, BYTE or SLICE_BY_4.")
+endif()
+
 # Sanitize use cases of non-soft crypto
 if(NOT LBM_CRYPTO STREQUAL "SOFT")
     if(NOT LBM_NUMBER_OF_STACKS STREQUAL 1)
@@ -87,6 +87,11 @@ extern "C" {
  */
 #define SMTC_MODEM_DM_USER_DATA_LENGTH 8
 
+/**
+ * @brief Length in byte of a radio planner timeline event
+ */
+#define SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH 16
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC TYPES ------------------------------------------------------------
@@ -263,6 +268,15 @@ typedef enum smtc_modem_file_upload_cipher_mode_e
     SMTC_MODEM_FILE_UPLOAD_AES_WITH_APPSKEY,  //!< Encrypt file using AES with appskey
 } smtc_modem_file_upload_cipher_mode_t;
 
+/**
+ * @brief Read callback of a streamed file upload session
+ *
+ * @param [in]  offset Offset in the file of the first byte to read
+ * @param [out] buffer Buffer to be filled with the file data
+ * @param [in]  size   Number of bytes to read
+ */
+typedef void ( *smtc_modem_file_upload_read_t )( uint32_t offset, uint8_t* buffer, uint16_t size );
+
 /**
  * @brief Modem status
  */
@@ -448,6 +462,7 @@ typedef struct smtc_modem_event_s
     uint8_t                 stack_id;
     smtc_modem_event_type_t event_type;
     uint8_t                 missed_events;  //!< Number of event_type events missed before the current one
+    uint32_t                timestamp_ms;   //!< Time of the event, as given by smtc_modem_hal_get_time_in_ms
     union
     {
         struct
@@ -522,10 +537,38 @@ typedef struct smtc_modem_event_s
         {
             smtc_modem_event_no_rx_threshold_status_t status;
         } no_downlink;
+        struct
+        {
+            uint8_t fport;   //!< LoRaWAN port of the downlink
+            uint8_t length;  //!< Payload length, the payload is read with smtc_modem_get_downlink_data
+        } downdata;
 
     } event_data;
 } smtc_modem_event_t;
 
+/**
+ * @brief Statistics of the event queue
+ */
+typedef struct smtc_modem_event_queue_stats_s
+{
+    uint8_t  capacity;         //!< Number of events the queue can hold
+    uint8_t  high_water_mark;  //!< Largest number of pending events
+    uint16_t folded_events;    //!< Events merged in a pending event of the same type (reported as missed_events)
+    uint16_t dropped_events;   //!< Events lost, no pending event of the same type to merge them in
+} smtc_modem_event_queue_stats_t;
+
+/**
+ * @brief Occupancy statistics of a channel, built from the LBT and CAD senses done before the uplinks
+ */
+typedef struct smtc_modem_channel_occupancy_s
+{
+    uint32_t frequency_hz;    //!< Channel frequency in Hz
+    uint8_t  nb_senses;       //!< Number of senses the statistics are made of (up to 32)
+    uint8_t  busy_ratio_pct;  //!< Percentage of these senses that found the channel busy
+    bool     rssi_valid;      //!< True if at least one LBT rssi was measured on the channel
+    int16_t  rssi_dbm;        //!< Running average of the LBT rssi measured on the channel
+} smtc_modem_channel_occupancy_t;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
@@ -583,6 +626,9 @@ smtc_modem_return_code_t smtc_modem_get_region( uint8_t stack_id, smtc_modem_reg
 /**
  * @brief Join the network
  *
+ * @remark When the modem is built with the session journal (LBM_SESSION_JOURNAL), the OTAA session opened before the
+ * last reset is resumed if it is still valid: SMTC_MODEM_EVENT_JOINED is then raised without any join request
+ *
  * @param [in] stack_id Stack identifier
  *
  * @return Modem return code as defined in @ref smtc_modem_return_code_t
@@ -630,6 +676,20 @@ smtc_modem_return_code_t smtc_modem_request_uplink( uint8_t stack_id, uint8_t fp
 
 smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_t* event_pending_count );
 
+/**
+ * @brief Get the statistics of the event queue since the last call
+ *
+ * @remark Events are returned by smtc_modem_get_event in the order they occurred. When the queue is full, an event is
+ * merged in the newest pending event of the same type, or lost if there is none.
+ *
+ * @param [out] stats   Statistics of the event queue
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK            Command executed without errors
+ * @retval SMTC_MODEM_RC_INVALID       \p stats is NULL
+ */
+smtc_modem_return_code_t smtc_modem_get_event_queue_stats( smtc_modem_event_queue_stats_t* stats );
+
 /**
  * @brief Get all the data from a downlink
  *
@@ -1071,7 +1131,9 @@ smtc_modem_return_code_t smtc_modem_get_next_tx_max_payload( uint8_t stack_id, u
  * @brief Get the current status of the duty cycle
  *
  * @remark If the returned value is positive, it is the time still available. A negative value indicates the time to
- * wait until band availability
+ * wait until band availability. SMTC_MODEM_EVENT_REGIONAL_DUTY_CYCLE follows the same rule: it is raised with status 1
+ * when the returned value becomes negative and with status 0 when it becomes positive again. The modem may still hold
+ * an uplink while the value is positive, until its time on air fits in the time available.
  *
  * @param [in]  stack_id             Stack identifier
  * @param [out] duty_cycle_status_ms Status of the duty cycle in milliseconds
@@ -1426,6 +1488,27 @@ smtc_modem_return_code_t smtc_modem_csma_set_parameters( uint8_t stack_id, uint8
 smtc_modem_return_code_t smtc_modem_csma_get_parameters( uint8_t stack_id, uint8_t* max_ch_change, bool* bo_enabled,
                                                          uint8_t* nb_bo_max );
 
+/**
+ * @brief Get the occupancy statistics of a channel sensed by LBT or CSMA
+ *
+ * Statistics cover the last 32 senses of a channel, only the last 8 once it has not been sensed for 10 minutes.
+ * Call it with an increasing \p index until it returns SMTC_MODEM_RC_FAIL to read all of them.
+ *
+ * @remark Only available when the modem is built with ADD_CHANNEL_OCCUPANCY
+ *
+ * @param [in]  stack_id                Stack identifier
+ * @param [in]  index                   Index of the tracked channel
+ * @param [out] occupancy               Statistics of the channel
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_INVALID           \p occupancy is NULL
+ * @retval SMTC_MODEM_RC_FAIL              No channel tracked at \p index or channel occupancy is not compiled
+ * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
+ */
+smtc_modem_return_code_t smtc_modem_get_channel_occupancy( uint8_t stack_id, uint8_t index,
+                                                           smtc_modem_channel_occupancy_t* occupancy );
+
 /**
  * @brief Get the total charge counter of the modem in mAh
  *
@@ -1919,6 +2002,59 @@ smtc_modem_return_code_t smtc_modem_file_upload_init( uint8_t stack_id, uint8_t
                                                       const uint8_t* file, uint16_t file_length,
                                                       uint32_t average_delay_s );
 
+/**
+ * @brief Create and initialize a streamed file upload session
+ *
+ * @remark The file is not kept in RAM: the modem fetches it through \p read_callback (e.g. from flash) while the
+ *         upload is ongoing, through a small cache of a few file windows. The file content shall then be given once
+ *         with smtc_modem_file_upload_write(), in order, as it is stored: its hash is computed on the fly.
+ * @remark The file content returned by \p read_callback shall not change until the end of the upload session
+ * @remark An encrypted streamed file is encrypted with the AppSKey while it is read: if the stack joins again during
+ *         the upload, the upload is aborted (SMTC_MODEM_EVENT_UPLOAD_DONE with SMTC_MODEM_EVENT_UPLOAD_DONE_ABORTED)
+ * @remark Only available when built with LBM_LFU_STREAMED
+ *
+ * @param [in] stack_id        Stack identifier
+ * @param [in] index           Index on which the upload is done
+ * @param [in] cipher_mode     Cipher mode
+ * @param [in] file_length     File size in bytes
+ * @param [in] read_callback   Callback used by the modem to read the file
+ * @param [in] average_delay_s Minimum delay between two file upload fragments in seconds (from the end of an uplink to
+ *                             the start of the next one)
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_INVALID           \p file_length is equal to 0 or greater than 8180 bytes, or \p read_callback
+ *                                         is NULL
+ * @retval SMTC_MODEM_RC_BUSY              Modem is currently in test mode, or a file upload is already ongoing
+ * @retval SMTC_MODEM_RC_FAIL              Streamed file upload is not built
+ * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
+ */
+smtc_modem_return_code_t smtc_modem_file_upload_init_streamed( uint8_t stack_id, uint8_t index,
+                                                               smtc_modem_file_upload_cipher_mode_t cipher_mode,
+                                                               uint16_t                             file_length,
+                                                               smtc_modem_file_upload_read_t        read_callback,
+                                                               uint32_t                             average_delay_s );
+
+/**
+ * @brief Give the next part of the file of a streamed file upload session
+ *
+ * @remark The data shall be the same as the one returned later by the read callback at the same offset. Once
+ *         \p file_length bytes have been given, the file upload session can be started.
+ *
+ * @param [in] stack_id Stack identifier
+ * @param [in] data     File data, following the previously given one
+ * @param [in] length   Length of \p data in bytes
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_NOT_INIT          No streamed file upload session is waiting for data
+ * @retval SMTC_MODEM_RC_INVALID           \p data is NULL, or \p length exceeds the remaining file size
+ * @retval SMTC_MODEM_RC_BUSY              Modem is currently in test mode
+ * @retval SMTC_MODEM_RC_FAIL              Streamed file upload is not built
+ * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
+ */
+smtc_modem_return_code_t smtc_modem_file_upload_write( uint8_t stack_id, const uint8_t* data, uint16_t length );
+
 /**
  * @brief Start the file upload session
  *
@@ -1926,6 +2062,7 @@ smtc_modem_return_code_t smtc_modem_file_upload_init( uint8_t stack_id, uint8_t
  *
  * @return Modem return code as defined in @ref smtc_modem_return_code_t
  * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_NOT_INIT          No file upload session, or the streamed file is not fully written
  * @retval SMTC_MODEM_RC_BUSY              Modem is currently in test mode, or a file upload is already ongoing
  * @retval SMTC_MODEM_RC_FAIL              Modem is not available (suspended, muted, or not joined)
  * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
@@ -2148,6 +2285,30 @@ smtc_modem_return_code_t smtc_modem_store_and_forward_set_state( uint8_t
 smtc_modem_return_code_t smtc_modem_store_and_forward_get_state( uint8_t                               stack_id,
                                                                  smtc_modem_store_and_forward_state_t* state );
 
+/**
+ * @brief Configure the aggregation of stored data in the store and forward service
+ *
+ * When enabled, the data following the oldest one with the same FPort are packed in the same uplink as long as they fit
+ * in the maximum payload of the next uplink. Every data is prefixed by its length on one byte, even when it is sent
+ * alone, so the application server decodes all the uplinks of the service the same way while aggregation is enabled.
+ * The uplink is confirmed if one of the packed data is. While aggregation is enabled, data longer than 50 bytes are
+ * refused by @ref smtc_modem_store_and_forward_flash_add_data so that any data fits with its prefix in a 51-byte
+ * uplink. The first uplink is delayed by up to \p max_latency_s after storing data in an empty fifo to gather more
+ * data. Aggregation is only available when built with LBM_STORE_AND_FORWARD_AGGREGATION.
+ *
+ * @param [in] stack_id       Stack identifier
+ * @param [in] enabled        Aggregation state
+ * @param [in] max_latency_s  Maximum delay before sending the first uplink, up to 3600 seconds
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_INVALID           \p max_latency_s is too large, or aggregation is not built
+ * @retval SMTC_MODEM_RC_BUSY              Modem is currently in test mode
+ * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
+ */
+smtc_modem_return_code_t smtc_modem_store_and_forward_set_aggregation( uint8_t stack_id, bool enabled,
+                                                                       uint32_t max_latency_s );
+
 /**
  * @brief Add data to the store and forward service
  *
@@ -2159,7 +2320,9 @@ smtc_modem_return_code_t smtc_modem_store_and_forward_get_state( uint8_t
  *
  * @return Modem return code as defined in @ref smtc_modem_return_code_t
  * @retval SMTC_MODEM_RC_OK                Command executed without errors
- * @retval SMTC_MODEM_RC_INVALID           \p fport is out of the [1:223] range or equal to the DM LoRaWAN FPort
+ * @retval SMTC_MODEM_RC_INVALID           \p fport is out of the [1:223] range or equal to the DM LoRaWAN FPort, or
+ *                                         \p payload_length is too large (50 bytes while aggregation is enabled, see
+ *                                         @ref smtc_modem_store_and_forward_set_aggregation)
  * @retval SMTC_MODEM_RC_BUSY              Modem is currently in test mode
  * @retval SMTC_MODEM_RC_FAIL              Modem is not available (suspended, muted, or not joined)
  * @retval SMTC_MODEM_RC_INVALID_STACK_ID  Invalid \p stack_id
@@ -2183,7 +2346,7 @@ smtc_modem_return_code_t smtc_modem_store_and_forward_flash_clear_data( uint8_t
  * @brief Get the fifo capacity and the number of free slots before data loss by overwriting the slot already in use
  *
  * @param [in]  stack_id  Stack identifier
- * @param [out] capacity  Capacity of the fifo (number of slot)
+ * @param [out] capacity  Capacity of the fifo (number of slot, a slot holds several records)
  * @param [out] free_slot Number of free slots
  *
  * @return Modem return code as defined in @ref smtc_modem_return_code_t
@@ -2233,6 +2396,29 @@ smtc_modem_return_code_t smtc_modem_debug_connect_with_abp( uint8_t stack_id, ui
                                                             uint8_t nwk_skey[SMTC_MODEM_KEY_LENGTH],
                                                             uint8_t app_skey[SMTC_MODEM_KEY_LENGTH] );
 
+/**
+ * @brief Read and remove the oldest events recorded by the radio planner timeline
+ *
+ * Each event is serialized on @ref SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH bytes (big endian):
+ * event time (4 bytes), task start time relative to the event time (4 bytes signed), task duration (4 bytes),
+ * event type, hook id, task type and event specific information (1 byte each).
+ *
+ * @remark Only available when the modem is built with ADD_RP_TIMELINE
+ *
+ * @param [out] timeline_array            Buffer filled with the events
+ * @param [in]  timeline_array_max_length Size of \p timeline_array in byte
+ * @param [out] timeline_array_length     Number of bytes written in \p timeline_array
+ * @param [out] lost_events_count         Number of events dropped because the timeline was full since the last call
+ *
+ * @return Modem return code as defined in @ref smtc_modem_return_code_t
+ * @retval SMTC_MODEM_RC_OK                Command executed without errors
+ * @retval SMTC_MODEM_RC_INVALID           At least one of the pointers is NULL
+ * @retval SMTC_MODEM_RC_FAIL              Timeline recorder is not compiled
+ */
+smtc_modem_return_code_t smtc_modem_debug_get_rp_timeline( uint8_t* timeline_array, uint16_t timeline_array_max_length,
+                                                           uint16_t* timeline_array_length,
+                                                           uint16_t* lost_events_count );
+
 #ifdef __cplusplus
 }
 #endif
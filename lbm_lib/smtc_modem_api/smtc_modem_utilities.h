@@ -86,6 +86,13 @@ void smtc_modem_init( void ( *event_callback )( void ) );
  */
 uint32_t smtc_modem_run_engine( void );
 
+/**
+ * @brief Write to non volatile memory the modem contexts still held in RAM
+ * @remark To be called before resetting or powering off the MCU when the modem is built with a context write window
+ * (MODEM_CONTEXT_CACHE_WINDOW_MS)
+ */
+void smtc_modem_flush_context( void );
+
 /**
  * @brief Check if some modem irq flags are pending
  *
@@ -386,6 +386,7 @@ void mw_gnss_almanac_services_init( uint8_t* service_id, uint8_t task_id,
 
     /* Configuration */
     mw_gnss_almanac_task_obj.constellations_enabled = LR11XX_GNSS_GPS_MASK | LR11XX_GNSS_BEIDOU_MASK;
+    modem_downlink_set_windows( mw_gnss_almanac_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 void mw_gnss_almanac_add_task( void )
@@ -281,6 +281,7 @@ void mw_gnss_scan_services_init( uint8_t* service_id, uint8_t task_id,
     mw_gnss_task_obj.current_token =
         ( uint8_t ) smtc_modem_hal_get_random_nb_in_range( 2, 0x1F ); /* 5-bits token with 0x00 and 0x01 excluded */
     mw_gnss_task_obj.last_scan_mode = LR11XX_GNSS_LAST_SCAN_MODE_AUTONOMOUS_NO_TIME_NO_AP;
+    modem_downlink_set_windows( mw_gnss_scan_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 smtc_modem_return_code_t mw_gnss_scan_add_task( smtc_modem_gnss_mode_t mode, uint32_t start_delay_s )
@@ -214,6 +214,7 @@ void mw_gnss_send_services_init( uint8_t* service_id, uint8_t task_id,
     mw_gnss_send_obj.fport         = GNSS_DEFAULT_UPLINK_PORT;
     mw_gnss_send_obj.is_busy       = false;
     mw_gnss_send_obj.send_mode     = SMTC_MODEM_SEND_MODE_UPLINK;
+    modem_downlink_set_windows( mw_gnss_send_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 void mw_gnss_send_add_task( const navgroup_t* nav_group )
@@ -240,6 +240,7 @@ void mw_wifi_scan_services_init( uint8_t* service_id, uint8_t task_id,
 
     /* Configuration */
     mw_wifi_task_obj.current_mw_scan_mode = SMTC_MODEM_WIFI_SCAN_MODE_MAC;
+    modem_downlink_set_windows( mw_wifi_scan_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 smtc_modem_return_code_t mw_wifi_scan_add_task( uint32_t start_delay_s )
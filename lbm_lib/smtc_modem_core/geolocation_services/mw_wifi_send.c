@@ -230,6 +230,7 @@ void mw_wifi_send_services_init( uint8_t* service_id, uint8_t task_id,
     mw_wifi_send_obj.is_busy        = false;
     mw_wifi_send_obj.send_mode      = SMTC_MODEM_SEND_MODE_UPLINK;
     mw_wifi_send_obj.payload_format = SMTC_MODEM_WIFI_PAYLOAD_MAC;
+    modem_downlink_set_windows( mw_wifi_send_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 void mw_wifi_send_add_task( const wifi_scan_result_t* wifi_results )
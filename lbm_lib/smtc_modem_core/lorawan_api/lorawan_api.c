@@ -219,6 +219,14 @@ status_lorawan_t lorawan_api_join( uint32_t target_time_ms, uint8_t stack_id )
     return lr1mac_core_join( &lr1_mac_obj[stack_id], target_time_ms );
 }
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+status_lorawan_t lorawan_api_session_restore( uint8_t stack_id )
+{
+    PANIC_IF_STACK_ID_TOO_HIGH( stack_id );
+    return lr1mac_core_session_restore( &lr1_mac_obj[stack_id] );
+}
+#endif
+
 join_status_t lorawan_api_isjoined( uint8_t stack_id )
 {
     PANIC_IF_STACK_ID_TOO_HIGH( stack_id );
@@ -449,6 +457,14 @@ uint32_t lorawan_api_next_network_free_duty_cycle_ms_get( uint8_t stack_id )
     return lr1_stack_network_next_free_duty_cycle_ms_get( &lr1_mac_obj[stack_id] );
 }
 
+uint32_t lorawan_api_next_toa_ms_get( uint8_t stack_id, uint8_t payload_length )
+{
+    PANIC_IF_STACK_ID_TOO_HIGH( stack_id );
+    // MHDR + FHDR without FOpts, FPort, payload and MIC
+    return lr1_stack_toa_compute( &lr1_mac_obj[stack_id], lr1mac_core_next_dr_get( &lr1_mac_obj[stack_id] ),
+                                  FHDROFFSET + 1 + payload_length + MICSIZE );
+}
+
 uint32_t lorawan_api_fcnt_up_get( uint8_t stack_id )
 {
     PANIC_IF_STACK_ID_TOO_HIGH( stack_id );
@@ -176,6 +176,16 @@ status_lorawan_t lorawan_api_send_stack_cid_req( uint8_t* cid_req_list, uint8_t
  */
 status_lorawan_t lorawan_api_join( uint32_t target_time_ms, uint8_t stack_id );
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+/**
+ * @brief Resume the OTAA session recorded before the last reset instead of sending a join request
+ *
+ * @param [in] stack_id
+ * @return status_lorawan_t OKLORAWAN if the session has been restored, the device is then joined
+ */
+status_lorawan_t lorawan_api_session_restore( uint8_t stack_id );
+#endif
+
 /**
  * @brief Returns the join status
  *
@@ -428,6 +438,15 @@ bool lorawan_api_is_dtc_supported( uint8_t stack_id );
  */
 uint32_t lorawan_api_next_network_free_duty_cycle_ms_get( uint8_t stack_id );
 
+/**
+ * @brief Time on air of the next uplink frame at the next datarate
+ *
+ * @param [in] stack_id        Stack identifier
+ * @param [in] payload_length  Application payload length of the frame
+ * @return uint32_t Time on air in milliseconds
+ */
+uint32_t lorawan_api_next_toa_ms_get( uint8_t stack_id, uint8_t payload_length );
+
 /**
  * @brief return the last uplink frame counter
  *
@@ -122,6 +122,7 @@ void lorawan_cid_request_management_init( uint8_t* service_id, uint8_t task_id,
     *on_launch_callback = lorawan_cid_request_management_on_launch;
     *on_update_callback = lorawan_cid_request_management_on_update;
     *context_callback   = ( void* ) modem_supervisor_get_task( );
+    modem_downlink_set_windows( lorawan_cid_request_management_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 lorawan_management_rc_t lorawan_cid_request_add_task( uint8_t stack_id, uint8_t cid_request_mask, uint32_t delay_s )
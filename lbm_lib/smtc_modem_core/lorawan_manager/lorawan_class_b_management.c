@@ -173,6 +173,8 @@ void lorawan_class_b_management_services_init( uint8_t* service_id, uint8_t task
         lorawan_class_b_management_obj[i].previous_tx_class_b_bit = false;
         lorawan_class_b_management_obj[i].current_tx_class_b_bit  = false;
     }
+    modem_downlink_set_windows( lorawan_class_b_management_service_downlink_handler,
+                                MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXBEACON ) );
 }
 
 void lorawan_class_b_management_enable( uint8_t stack_id, bool enable, uint8_t delay )
@@ -126,6 +126,7 @@ void lorawan_join_management_services_init( uint8_t* service_id, uint8_t task_id
     *on_launch_callback = lorawan_join_management_service_on_launch;
     *on_update_callback = lorawan_join_management_service_on_update;
     *context_callback   = ( void* ) modem_supervisor_get_task( );
+    modem_downlink_set_windows( lorawan_join_management_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 void lorawan_join_add_task( uint8_t stack_id )
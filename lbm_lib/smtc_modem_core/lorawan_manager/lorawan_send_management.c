@@ -140,6 +140,14 @@ void lorawan_send_management_services_init( uint8_t* service_id, uint8_t task_id
     *on_launch_callback = lorawan_send_management_service_on_launch;
     *on_update_callback = lorawan_send_management_service_on_update;
     *context_callback   = ( void* ) modem_supervisor_get_task( );
+#if defined( ADD_RELAY_TX )
+    modem_downlink_set_windows( lorawan_send_management_service_downlink_handler,
+                                MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RX1 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RX2 ) |
+                                    MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXR ) );
+#else
+    modem_downlink_set_windows( lorawan_send_management_service_downlink_handler,
+                                MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RX1 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RX2 ) );
+#endif
 }
 
 void lorawan_send_add_task( uint8_t stack_id, uint8_t f_port, bool send_fport, bool confirmed, const uint8_t* payload,
@@ -174,6 +182,7 @@ void lorawan_send_add_task( uint8_t stack_id, uint8_t f_port, bool send_fport, b
     task_send.time_to_execute_s = smtc_modem_hal_get_time_in_s( ) + delay_s;
     task_send.stack_id          = stack_id;
     task_send.id                = SEND_TASK + ( NUMBER_OF_TASKS * stack_id );
+    task_send.payload_length    = lorawan_send_management_obj[stack_id].payload_length;
 
     SMTC_MODEM_HAL_PANIC_ON_FAILURE( modem_supervisor_add_task( &task_send ) == TASK_VALID );
 }
@@ -353,6 +353,7 @@ void lorawan_alcsync_services_init( uint8_t* service_id, uint8_t task_id,
     ctx->stack_id = CURRENT_STACK;
 
     alc_sync_init( ctx );
+    modem_downlink_set_windows( lorawan_alcsync_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_UNICAST );
 }
 
 void lorawan_alcsync_service_on_launch( void* service_id )
@@ -277,6 +277,9 @@ void lorawan_fmp_package_services_init( uint8_t* service_id, uint8_t task_id,
 #if defined( FUOTA_BUILT_IN_TEST )
     fmp_test( );
 #endif
+    modem_downlink_set_filter( lorawan_fmp_package_service_downlink_handler, CURRENT_STACK, MODEM_DOWNLINK_FILTER_FPORT,
+                               FMP_PORT );
+    modem_downlink_set_windows( lorawan_fmp_package_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_UNICAST );
 }
 
 void lorawan_fmp_package_service_on_launch( void* service_id )
@@ -280,6 +280,8 @@ void lorawan_fragmentation_package_services_init( uint8_t* service_id, uint8_t t
     frag_decoder_callback.FragDecoderWrite = frag_decoder_write;
     frag_decoder_callback.FragDecoderRead  = frag_decoder_read;
     nb_transmit_ans                        = 1;
+    modem_downlink_set_filter( lorawan_fragmentation_package_service_downlink_handler, CURRENT_STACK,
+                               MODEM_DOWNLINK_FILTER_FPORT, FRAGMENTATION_PORT );
 }
 
 void lorawan_fragmentation_package_service_on_launch( void* service_id )
@@ -38,6 +38,16 @@
 
 #define DBG_TRACE 0
 
+/*!
+ * Number of 32 bits words of a bit array holding nb_bits bits
+ */
+#define FRAG_BIT_ARRAY_WORDS( nb_bits ) ( ( ( nb_bits ) >> 5 ) + 1 )
+
+/*!
+ * Number of 32 bits words of a data row holding nb_bytes bytes
+ */
+#define FRAG_DATA_WORDS( nb_bytes ) ( ( ( nb_bytes ) + 3 ) >> 2 )
+
 #if DBG_TRACE == 1
 #include <stdio.h>
 /*!
@@ -58,6 +68,22 @@
  *=============================================================================
  */
 
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+/*!
+ * Invalid row index of an empty cache line
+ */
+#define FRAG_MATRIX_CACHE_LINE_EMPTY 0xFFFF
+
+/*!
+ * RAM copy of a row of the paged matrix
+ */
+typedef struct
+{
+    uint16_t Row;
+    uint32_t Data[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_REDUNDANCY )];
+} FragMatrixCacheLine_t;
+#endif
+
 typedef struct
 {
     FragDecoderCallbacks_t* Callbacks;
@@ -66,10 +92,25 @@ typedef struct
     uint8_t  FragSize;
 
     uint32_t M2BLine;
-    uint8_t  MatrixM2B[( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ) * FRAG_MAX_REDUNDANCY];
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+    // Matrix rows are stored after the file through the callbacks, row i at MatrixRowAddr( i ). The most recently used
+    // rows are kept in a direct mapped cache
+    FragMatrixCacheLine_t MatrixCache[FRAG_DECODER_MATRIX_CACHE_ROWS];
+    // Received uncoded fragments bit array and number of lost fragments before each word of it (valid once the coded
+    // fragments are received), the missing index of a fragment is its rank among the lost fragments
+    uint32_t FragReceived[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_NB )];
+    uint16_t FragLostRank[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_NB )];
+    bool     FragLostRankValid;
+#else
+    // Upper triangular matrix, row i only holds ones at index >= i. Rows are word aligned so that they are XORed and
+    // scanned 32 bits at a time
+    uint32_t MatrixM2B[FRAG_MAX_REDUNDANCY][FRAG_BIT_ARRAY_WORDS( FRAG_MAX_REDUNDANCY )];
     uint16_t FragNbMissingIndex[FRAG_MAX_NB];
+    // Reverse lookup of FragNbMissingIndex: fragment index of the x th missing fragment
+    uint16_t MissingFragIndex[FRAG_MAX_REDUNDANCY];
+#endif
 
-    uint8_t S[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
+    uint32_t S[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_REDUNDANCY )];
 
     FragDecoderStatus_t Status;
 } FragDecoder_t;
@@ -100,16 +141,15 @@ static void GetRow( uint8_t* src, uint16_t row, uint16_t size );
  *
  * \retval parity         Parity value at the given index
  */
-static uint8_t GetParity( uint16_t index, uint8_t* matrixRow );
+static uint8_t GetParity( uint16_t index, const uint32_t* matrixRow );
 
 /*!
- * \brief Sets the parity value on the given row of the parity matrix
+ * \brief Sets to one the parity value on the given row of the parity matrix
  *
  * \param [IN]     index     The index of the row to be computed
  * \param [IN/OUT] matrixRow Pointer to the parity matrix.
- * \param [IN]     parity    The parity value to be set in the parity matrix
  */
-static void SetParity( uint16_t index, uint8_t* matrixRow, uint8_t parity );
+static void SetParity( uint16_t index, uint32_t* matrixRow );
 
 /*!
  * \brief Check if the provided value is a power of 2
@@ -121,26 +161,15 @@ static void SetParity( uint16_t index, uint8_t* matrixRow, uint8_t parity );
 static bool IsPowerOfTwo( uint32_t x );
 
 /*!
- * \brief XOrs two data lines
+ * \brief XORs two lines (data or parity) word by word
  *
- * \param [IN]  line1  1st Data line to be XORed
- * \param [IN]  line2  2nd Data line to be XORed
- * \param [IN]  size   Number of elements in line1
+ * \param [IN]  line1  1st line to be XORed
+ * \param [IN]  line2  2nd line to be XORed
+ * \param [IN]  size   Number of words in line1
  *
  * \param [OUT] result XOR( line1, line2 ) result stored in line1
  */
-static void XorDataLine( uint8_t* line1, uint8_t* line2, int32_t size );
-
-/*!
- * \brief XORs two parity lines
- *
- * \param [IN]  line1  1st Parity line to be XORed
- * \param [IN]  line2  2nd Parity line to be XORed
- * \param [IN]  size   Number of elements in line1
- *
- * \param [OUT] result XOR( line1, line2 ) result stored in line1
- */
-static void XorParityLine( uint8_t* line1, uint8_t* line2, int32_t size );
+static void XorLine( uint32_t* line1, const uint32_t* line2, int32_t size );
 
 /*!
  * \brief Generates a pseudo random number : PRBS23
@@ -158,7 +187,7 @@ static int32_t FragPrbs23( int32_t value );
  * \param [IN]  m         Fragment number
  * \param [OUT] matrixRow Parity matrix
  */
-static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t* matrixRow );
+static void FragGetParityMatrixRow( int32_t n, int32_t m, uint32_t* matrixRow );
 
 /*!
  * \brief Finds the index of the first one in a bit array
@@ -167,7 +196,7 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t* matrixRow );
  * \param [IN] size     Bit array size
  * \retval index        The index of the first 1 in the bit array
  */
-static uint16_t BitArrayFindFirstOne( uint8_t* bitArray, uint16_t size );
+static uint16_t BitArrayFindFirstOne( const uint32_t* bitArray, uint16_t size );
 
 /*!
  * \brief Checks if the provided bit array only contains zeros
@@ -176,7 +205,7 @@ static uint16_t BitArrayFindFirstOne( uint8_t* bitArray, uint16_t size );
  * \param [IN] size     Bit array size
  * \retval isAllZeros   [0: Contains ones, 1: Contains all zeros]
  */
-static uint8_t BitArrayIsAllZeros( uint8_t* bitArray, uint16_t size );
+static uint8_t BitArrayIsAllZeros( const uint32_t* bitArray, uint16_t size );
 
 /*!
  * \brief Finds & marks missing fragments
@@ -196,22 +225,46 @@ static void FragFindMissingFrags( uint16_t counter );
 static uint16_t FragFindMissingIndex( uint16_t x );
 
 /*!
- * \brief Extacts a row from the binary matrix and expands it to a bitArray
+ * \brief Marks an uncoded fragment as received
+ *
+ * \param [IN] index Fragment index
+ */
+static void FragSetReceived( uint16_t index );
+
+/*!
+ * \brief Marks an uncoded fragment as lost, lost fragments shall be marked in increasing index order
+ *
+ * \param [IN] index Fragment index
+ */
+static void FragSetLost( uint16_t index );
+
+/*!
+ * \brief Gets the missing index of an uncoded fragment
  *
- * \param [IN] bitArray  Pointer to the bit array
- * \param [IN] rowIndex  Matrix row index
- * \param [IN] bitsInRow Number of bits in one row
+ * \param [IN] index Fragment index
+ *
+ * \retval missingIndex 0 if the fragment has been received, x + 1 if it is the x th missing frag
+ */
+static uint16_t FragGetMissingIndex( uint16_t index );
+
+/*!
+ * \brief Gets a row of the M2B matrix
+ *
+ * \param [IN] row   Matrix row index, the row shall have been pushed
+ * \param [IN] words Number of words in the row
+ *
+ * \retval row       Pointer to the row, valid until the next call
  */
-static void FragExtractLineFromBinaryMatrix( uint8_t* bitArray, uint16_t rowIndex, uint16_t bitsInRow );
+static const uint32_t* FragGetMatrixLine( uint16_t row, int32_t words );
 
 /*!
- * \brief Collapses and Pushs a row of a bit array to the matrix
+ * \brief Pushes a row to the M2B matrix
  *
- * \param [IN] bitArray  Pointer to the bit array
- * \param [IN] rowIndex  Matrix row index
- * \param [IN] bitsInRow Number of bits in one row
+ * \param [IN] bitArray Row content, without ones before the row index
+ * \param [IN] row      Matrix row index
+ * \param [IN] words    Number of words in the row
  */
-static void FragPushLineToBinaryMatrix( uint8_t* bitArray, uint16_t rowIndex, uint16_t bitsInRow );
+static void FragPushMatrixLine( const uint32_t* bitArray, uint16_t row, int32_t words );
 
 /*
  *=============================================================================
@@ -232,22 +285,20 @@ void FragDecoderInit( uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t*
     FragDecoder.Status.FragNbLost   = 0;
     FragDecoder.M2BLine             = 0;
 
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+    for( uint8_t i = 0; i < FRAG_DECODER_MATRIX_CACHE_ROWS; i++ )
+    {
+        FragDecoder.MatrixCache[i].Row = FRAG_MATRIX_CACHE_LINE_EMPTY;
+    }
+#else
     // Initialize missing fragments index array
     for( uint16_t i = 0; i < FRAG_MAX_NB; i++ )
     {
         FragDecoder.FragNbMissingIndex[i] = 1;
     }
+#endif
 
-    // Initialize parity matrix
-    for( uint32_t i = 0; i < ( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ); i++ )
-    {
-        FragDecoder.S[i] = 0;
-    }
-
-    for( uint32_t i = 0; i < ( ( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ) * FRAG_MAX_REDUNDANCY ); i++ )
-    {
-        FragDecoder.MatrixM2B[i] = 0xFF;
-    }
+    // Parity matrix and S are cleared by the memset, a row of MatrixM2B is always fully written before being read
 
     FragDecoder.Status.FragNbLost   = 0;
     FragDecoder.Status.FragNbLastRx = 0;
@@ -259,21 +310,27 @@ uint32_t FragDecoderGetMaxFileSize( void )
     return FRAG_MAX_NB * FRAG_MAX_SIZE;
 }
 
+uint32_t FragDecoderGetMaxStorageSize( void )
+{
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+    return FragDecoderGetMaxFileSize( ) +
+           ( FRAG_MAX_REDUNDANCY * FRAG_BIT_ARRAY_WORDS( FRAG_MAX_REDUNDANCY ) * sizeof( uint32_t ) );
+#else
+    return FragDecoderGetMaxFileSize( );
+#endif
+}
+
 int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData )
 {
     uint16_t firstOneInRow = 0;
     int32_t  first         = 0;
     int32_t  noInfo        = 0;
 
-    uint8_t matrixRow[( FRAG_MAX_NB >> 3 ) + 1];
-    uint8_t matrixDataTemp[FRAG_MAX_SIZE];
-    uint8_t dataTempVector[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
-    uint8_t dataTempVector2[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
-
-    memset( matrixRow, 0, ( FRAG_MAX_NB >> 3 ) + 1 );
-    memset( matrixDataTemp, 0, FRAG_MAX_SIZE );
-    memset( dataTempVector, 0, ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 );
-    memset( dataTempVector2, 0, ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 );
+    // Word aligned buffers, fragments are XORed 32 bits at a time
+    uint32_t matrixRow[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_NB )];
+    uint32_t matrixDataTemp[FRAG_DATA_WORDS( FRAG_MAX_SIZE )];
+    uint32_t dataRow[FRAG_DATA_WORDS( FRAG_MAX_SIZE )];
+    uint32_t dataTempVector[FRAG_BIT_ARRAY_WORDS( FRAG_MAX_REDUNDANCY )];
 
     FragDecoder.Status.FragNbRx = fragCounter;
 
@@ -290,7 +347,7 @@ int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData )
 
         SetRow( rawData, fragCounter - 1, FragDecoder.FragSize );
 
-        FragDecoder.FragNbMissingIndex[fragCounter - 1] = 0;
+        FragSetReceived( fragCounter - 1 );
 
         // Update the FragDecoder.FragNbMissingIndex with the loosing frame
         FragFindMissingFrags( fragCounter );
@@ -316,30 +373,47 @@ int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData )
         // In case of the end of true data is missing
         FragFindMissingFrags( fragCounter );
 
+        if( FragDecoder.Status.FragNbLost > FRAG_MAX_REDUNDANCY )
+        {
+            // The last uncoded fragments were lost, the matrix cannot hold all the missing fragments
+            FragDecoder.Status.MatrixError = 1;
+            return FRAG_SESSION_FAILED;
+        }
+
+        const int32_t dataWords   = FRAG_DATA_WORDS( FragDecoder.FragSize );
+        const int32_t parityWords = FRAG_BIT_ARRAY_WORDS( FragDecoder.Status.FragNbLost );
+
+        memset( dataRow, 0, sizeof( dataRow ) );
+        memset( matrixDataTemp, 0, sizeof( matrixDataTemp ) );
+        memset( dataTempVector, 0, sizeof( dataTempVector ) );
+        memcpy( dataRow, rawData, FragDecoder.FragSize );
+
         // fragCounter - FragDecoder.FragNb
         FragGetParityMatrixRow( fragCounter - FragDecoder.FragNb, FragDecoder.FragNb, matrixRow );
 
-        for( int32_t i = 0; i < FragDecoder.FragNb; i++ )
+        for( int32_t w = 0; w < FRAG_BIT_ARRAY_WORDS( FragDecoder.FragNb ); w++ )
         {
-            if( GetParity( i, matrixRow ) == 1 )
+            uint32_t word = matrixRow[w];
+
+            while( word != 0 )
             {
-                if( FragDecoder.FragNbMissingIndex[i] == 0 )
+                uint16_t i = ( w << 5 ) + __builtin_ctz( word );
+
+                word &= word - 1;
+                uint16_t missingIndex = FragGetMissingIndex( i );
+
+                if( missingIndex == 0 )
                 {
                     // XOR with already receive frag
-                    SetParity( i, matrixRow, 0 );
-
-                    GetRow( matrixDataTemp, i, FragDecoder.FragSize );
+                    GetRow( ( uint8_t* ) matrixDataTemp, i, FragDecoder.FragSize );
 
-                    XorDataLine( rawData, matrixDataTemp, FragDecoder.FragSize );
+                    XorLine( dataRow, matrixDataTemp, dataWords );
                 }
                 else
                 {
                     // Fill the "little" boolean matrix m2b
-                    SetParity( FragDecoder.FragNbMissingIndex[i] - 1, dataTempVector, 1 );
-                    if( first == 0 )
-                    {
-                        first = 1;
-                    }
+                    SetParity( missingIndex - 1, dataTempVector );
+                    first = 1;
                 }
             }
         }
@@ -349,20 +423,18 @@ int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData )
         if( first > 0 )
         {
             int32_t li;
-            int32_t lj;
 
             // Manage a new line in MatrixM2B
             while( GetParity( firstOneInRow, FragDecoder.S ) == 1 )
             {
-                // Row already diagonalized exist & ( FragDecoder.MatrixM2B[firstOneInRow][0] )
-                FragExtractLineFromBinaryMatrix( dataTempVector2, firstOneInRow, FragDecoder.Status.FragNbLost );
-                XorParityLine( dataTempVector, dataTempVector2, FragDecoder.Status.FragNbLost );
+                // Row already diagonalized exist, its ones before firstOneInRow are already cleared
+                XorLine( dataTempVector, FragGetMatrixLine( firstOneInRow, parityWords ), parityWords );
                 // Have to store it in the mi th position of the missing frag
                 li = FragFindMissingIndex( firstOneInRow );
 
-                GetRow( matrixDataTemp, li, FragDecoder.FragSize );
+                GetRow( ( uint8_t* ) matrixDataTemp, li, FragDecoder.FragSize );
 
-                XorDataLine( rawData, matrixDataTemp, FragDecoder.FragSize );
+                XorLine( dataRow, matrixDataTemp, dataWords );
                 if( BitArrayIsAllZeros( dataTempVector, FragDecoder.Status.FragNbLost ) )
                 {
                     noInfo = 1;
@@ -373,52 +445,50 @@ int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData )
 
             if( noInfo == 0 )
             {
-                FragPushLineToBinaryMatrix( dataTempVector, firstOneInRow, FragDecoder.Status.FragNbLost );
+                // No one before firstOneInRow, the line can be pushed as is in the upper triangular matrix
+                FragPushMatrixLine( dataTempVector, firstOneInRow, parityWords );
                 li = FragFindMissingIndex( firstOneInRow );
 
-                SetRow( rawData, li, FragDecoder.FragSize );
+                SetRow( ( uint8_t* ) dataRow, li, FragDecoder.FragSize );
 
-                SetParity( firstOneInRow, FragDecoder.S, 1 );
+                SetParity( firstOneInRow, FragDecoder.S );
                 FragDecoder.M2BLine++;
             }
             FragDecoder.Status.MissingFrag = FragDecoder.Status.FragNbLost - FragDecoder.M2BLine;
             if( FragDecoder.M2BLine == FragDecoder.Status.FragNbLost )
             {
-                // Then last step diagonalized
-                if( FragDecoder.Status.FragNbLost > 1 )
+                // Then last step diagonalized: back substitution from the last row, the rows after i are already
+                // solved so each one of row i (except the diagonal) is resolved by a XOR with the solved fragment
+                for( int32_t i = ( FragDecoder.Status.FragNbLost - 2 ); i >= 0; i-- )
                 {
-                    int32_t i, j;
-
-                    for( i = ( FragDecoder.Status.FragNbLost - 2 ); i >= 0; i-- )
-                    {
-                        li = FragFindMissingIndex( i );
+                    const uint32_t* line = FragGetMatrixLine( i, parityWords );
 
-                        GetRow( matrixDataTemp, li, FragDecoder.FragSize );
+                    li = FragFindMissingIndex( i );
 
-                        for( j = ( FragDecoder.Status.FragNbLost - 1 ); j > i; j-- )
-                        {
-                            FragExtractLineFromBinaryMatrix( dataTempVector2, i, FragDecoder.Status.FragNbLost );
-                            FragExtractLineFromBinaryMatrix( dataTempVector, j, FragDecoder.Status.FragNbLost );
-                            if( GetParity( j, dataTempVector2 ) == 1 )
-                            {
-                                XorParityLine( dataTempVector2, dataTempVector, FragDecoder.Status.FragNbLost );
+                    GetRow( ( uint8_t* ) matrixDataTemp, li, FragDecoder.FragSize );
 
-                                lj = FragFindMissingIndex( j );
+                    for( int32_t w = ( i >> 5 ); w < parityWords; w++ )
+                    {
+                        uint32_t word = line[w];
 
-                                GetRow( rawData, lj, FragDecoder.FragSize );
-                                XorDataLine( matrixDataTemp, rawData, FragDecoder.FragSize );
-                            }
+                        if( w == ( i >> 5 ) )
+                        {
+                            // Skip the diagonal one
+                            word &= ~( ( uint32_t ) 1 << ( i & 31 ) );
                         }
+                        while( word != 0 )
+                        {
+                            uint16_t j = ( w << 5 ) + __builtin_ctz( word );
 
-                        SetRow( matrixDataTemp, li, FragDecoder.FragSize );
+                            word &= word - 1;
+                            GetRow( ( uint8_t* ) dataRow, FragFindMissingIndex( j ), FragDecoder.FragSize );
+                            XorLine( matrixDataTemp, dataRow, dataWords );
+                        }
                     }
-                    return FRAG_SESSION_FINISHED_SUCCESSFULLY;
-                }
-                else
-                {
-                    // If not ( FragDecoder.FragNbLost > 1 )
-                    return FRAG_SESSION_FINISHED_SUCCESSFULLY;
+
+                    SetRow( ( uint8_t* ) matrixDataTemp, li, FragDecoder.FragSize );
                 }
+                return FRAG_SESSION_FINISHED_SUCCESSFULLY;
             }
         }
     }
@@ -452,49 +522,26 @@ static void GetRow( uint8_t* dst, uint16_t row, uint16_t size )
     }
 }
 
-static uint8_t GetParity( uint16_t index, uint8_t* matrixRow )
+static uint8_t GetParity( uint16_t index, const uint32_t* matrixRow )
 {
-    uint8_t parity;
-    parity = matrixRow[index >> 3];
-    parity = ( parity >> ( 7 - ( index % 8 ) ) ) & 0x01;
-    return parity;
+    return ( matrixRow[index >> 5] >> ( index & 31 ) ) & 0x01;
 }
 
-static void SetParity( uint16_t index, uint8_t* matrixRow, uint8_t parity )
+static void SetParity( uint16_t index, uint32_t* matrixRow )
 {
-    uint8_t mask          = 0xFF - ( 1 << ( 7 - ( index % 8 ) ) );
-    parity                = parity << ( 7 - ( index % 8 ) );
-    matrixRow[index >> 3] = ( matrixRow[index >> 3] & mask ) + parity;
+    matrixRow[index >> 5] |= ( uint32_t ) 1 << ( index & 31 );
 }
 
 static bool IsPowerOfTwo( uint32_t x )
 {
-    uint8_t sumBit = 0;
-
-    for( uint8_t i = 0; i < 32; i++ )
-    {
-        sumBit += ( x & ( 1 << i ) ) >> i;
-    }
-    if( sumBit == 1 )
-    {
-        return true;
-    }
-    return false;
+    return ( x != 0 ) && ( ( x & ( x - 1 ) ) == 0 );
 }
 
-static void XorDataLine( uint8_t* line1, uint8_t* line2, int32_t size )
+static void XorLine( uint32_t* line1, const uint32_t* line2, int32_t size )
 {
     for( int32_t i = 0; i < size; i++ )
     {
-        line1[i] = line1[i] ^ line2[i];
-    }
-}
-
-static void XorParityLine( uint8_t* line1, uint8_t* line2, int32_t size )
-{
-    for( int32_t i = 0; i < size; i++ )
-    {
-        SetParity( i, line1, ( GetParity( i, line1 ) ^ GetParity( i, line2 ) ) );
+        line1[i] ^= line2[i];
     }
 }
 
@@ -505,7 +552,7 @@ static int32_t FragPrbs23( int32_t value )
     return ( value >> 1 ) + ( ( b0 ^ b1 ) << 22 );
 }
 
-static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t* matrixRow )
+static void FragGetParityMatrixRow( int32_t n, int32_t m, uint32_t* matrixRow )
 {
     int32_t mTemp;
     int32_t x;
@@ -522,7 +569,7 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t* matrixRow )
     }
 
     x = 1 + ( 1001 * n );
-    for( int32_t i = 0; i < ( ( m >> 3 ) + 1 ); i++ )
+    for( int32_t i = 0; i < FRAG_BIT_ARRAY_WORDS( m ); i++ )
     {
         matrixRow[i] = 0;
     }
@@ -536,34 +583,33 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t* matrixRow )
         }
         if( GetParity( r, matrixRow ) == 0 )
         {
-            SetParity( r, matrixRow, 1 );
+            SetParity( r, matrixRow );
             nbCoeff += 1;
         }
     }
 }
 
-static uint16_t BitArrayFindFirstOne( uint8_t* bitArray, uint16_t size )
+static uint16_t BitArrayFindFirstOne( const uint32_t* bitArray, uint16_t size )
 {
-    for( uint16_t i = 0; i < size; i++ )
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( size ); i++ )
     {
-        if( GetParity( i, bitArray ) == 1 )
+        if( bitArray[i] != 0 )
         {
-            return i;
+            return ( i << 5 ) + __builtin_ctz( bitArray[i] );
         }
     }
     return 0;
 }
 
-static uint8_t BitArrayIsAllZeros( uint8_t* bitArray, uint16_t size )
+static uint8_t BitArrayIsAllZeros( const uint32_t* bitArray, uint16_t size )
 {
-    for( uint16_t i = 0; i < size; i++ )
+    uint32_t ones = 0;
+
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( size ); i++ )
     {
-        if( GetParity( i, bitArray ) == 1 )
-        {
-            return 0;
-        }
+        ones |= bitArray[i];
     }
-    return 1;
+    return ( ones == 0 ) ? 1 : 0;
 }
 
 /*!
@@ -579,8 +625,7 @@ static void FragFindMissingFrags( uint16_t counter )
     {
         if( i < FragDecoder.FragNb )
         {
-            FragDecoder.Status.FragNbLost++;
-            FragDecoder.FragNbMissingIndex[i] = FragDecoder.Status.FragNbLost;
+            FragSetLost( i );
         }
     }
     if( i < FragDecoder.FragNb )
@@ -604,84 +649,161 @@ static void FragFindMissingFrags( uint16_t counter )
  *
  * \retval counter The counter value associated to the x th missing frag
  */
-static uint16_t FragFindMissingIndex( uint16_t x )
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+/*!
+ * \brief Computes the number of lost fragments before each word of the received fragments bit array
+ */
+static void FragUpdateLostRank( void )
 {
-    for( uint16_t i = 0; i < FragDecoder.FragNb; i++ )
+    uint16_t lostRank = 0;
+
+    if( FragDecoder.FragLostRankValid == true )
     {
-        if( FragDecoder.FragNbMissingIndex[i] == ( x + 1 ) )
-        {
-            return i;
-        }
+        return;
     }
-    return 0;
+    for( uint16_t w = 0; w < FRAG_BIT_ARRAY_WORDS( FragDecoder.FragNb ); w++ )
+    {
+        FragDecoder.FragLostRank[w] = lostRank;
+        lostRank += 32 - __builtin_popcount( FragDecoder.FragReceived[w] );
+    }
+    FragDecoder.FragLostRankValid = true;
 }
 
-/*!
- * \brief Extacts a row from the binary matrix and expands it to a bitArray
- *
- * \param [IN] bitArray  Pointer to the bit array
- * \param [IN] rowIndex  Matrix row index
- * \param [IN] bitsInRow Number of bits in one row
- */
-static void FragExtractLineFromBinaryMatrix( uint8_t* bitArray, uint16_t rowIndex, uint16_t bitsInRow )
+static uint16_t FragFindMissingIndex( uint16_t x )
 {
-    uint32_t findByte      = 0;
-    uint32_t findBitInByte = 0;
+    uint16_t low  = 0;
+    uint16_t high = FRAG_BIT_ARRAY_WORDS( FragDecoder.FragNb ) - 1;
 
-    if( rowIndex > 0 )
-    {
-        findByte      = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) >> 3;
-        findBitInByte = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) % 8;
-    }
-    if( rowIndex > 0 )
+    FragUpdateLostRank( );
+    // Last word with less than x + 1 lost fragments before it
+    while( low < high )
     {
-        for( uint16_t i = 0; i < rowIndex; i++ )
+        uint16_t mid = ( low + high + 1 ) >> 1;
+
+        if( FragDecoder.FragLostRank[mid] <= x )
+        {
+            low = mid;
+        }
+        else
         {
-            SetParity( i, bitArray, 0 );
+            high = mid - 1;
         }
     }
-    for( uint16_t i = rowIndex; i < bitsInRow; i++ )
+
+    uint32_t lost = ~FragDecoder.FragReceived[low];
+
+    for( uint16_t n = x - FragDecoder.FragLostRank[low]; n > 0; n-- )
+    {
+        lost &= lost - 1;
+    }
+    if( lost == 0 )
     {
-        SetParity( i, bitArray, ( FragDecoder.MatrixM2B[findByte] >> ( 7 - findBitInByte ) ) & 0x01 );
+        return 0;
+    }
+    return ( low << 5 ) + __builtin_ctz( lost );
+}
 
-        findBitInByte++;
-        if( findBitInByte == 8 )
-        {
-            findBitInByte = 0;
-            findByte++;
-        }
+static void FragSetReceived( uint16_t index )
+{
+    SetParity( index, FragDecoder.FragReceived );
+    FragDecoder.FragLostRankValid = false;
+}
+
+static void FragSetLost( uint16_t index )
+{
+    ( void ) index;
+    FragDecoder.Status.FragNbLost++;
+    FragDecoder.FragLostRankValid = false;
+}
+
+static uint16_t FragGetMissingIndex( uint16_t index )
+{
+    if( GetParity( index, FragDecoder.FragReceived ) == 1 )
+    {
+        return 0;
     }
+    FragUpdateLostRank( );
+
+    uint32_t lostBefore = ~FragDecoder.FragReceived[index >> 5] & ( ( ( uint32_t ) 1 << ( index & 31 ) ) - 1 );
+
+    return FragDecoder.FragLostRank[index >> 5] + __builtin_popcount( lostBefore ) + 1;
 }
 
 /*!
- * \brief Collapses and Pushs a row of a bit array to the matrix
+ * \brief Gets the storage address of a row of the paged M2B matrix, rows are stored right after the file
+ *
+ * \param [IN] row   Matrix row index
+ * \param [IN] words Number of words in a row
  *
- * \param [IN] bitArray  Pointer to the bit array
- * \param [IN] rowIndex  Matrix row index
- * \param [IN] bitsInRow Number of bits in one row
+ * \retval address   Row address
  */
-static void FragPushLineToBinaryMatrix( uint8_t* bitArray, uint16_t rowIndex, uint16_t bitsInRow )
+static uint32_t MatrixRowAddr( uint16_t row, int32_t words )
 {
-    uint32_t findByte      = 0;
-    uint32_t findBitInByte = 0;
+    return FragDecoderGetMaxFileSize( ) + ( ( uint32_t ) row * words * sizeof( uint32_t ) );
+}
 
-    if( rowIndex > 0 )
-    {
-        findByte      = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) >> 3;
-        findBitInByte = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) % 8;
-    }
-    for( uint16_t i = rowIndex; i < bitsInRow; i++ )
+static const uint32_t* FragGetMatrixLine( uint16_t row, int32_t words )
+{
+    FragMatrixCacheLine_t* cacheLine = &FragDecoder.MatrixCache[row % FRAG_DECODER_MATRIX_CACHE_ROWS];
+
+    if( cacheLine->Row != row )
     {
-        if( GetParity( i, bitArray ) == 0 )
+        if( ( FragDecoder.Callbacks != NULL ) && ( FragDecoder.Callbacks->FragDecoderRead != NULL ) )
         {
-            FragDecoder.MatrixM2B[findByte] =
-                FragDecoder.MatrixM2B[findByte] & ( 0xFF - ( 1 << ( 7 - findBitInByte ) ) );
-        }
-        findBitInByte++;
-        if( findBitInByte == 8 )
-        {
-            findBitInByte = 0;
-            findByte++;
+            FragDecoder.Callbacks->FragDecoderRead( MatrixRowAddr( row, words ), ( uint8_t* ) cacheLine->Data,
+                                                    words * sizeof( uint32_t ) );
         }
+        cacheLine->Row = row;
+    }
+    return cacheLine->Data;
+}
+
+static void FragPushMatrixLine( const uint32_t* bitArray, uint16_t row, int32_t words )
+{
+    FragMatrixCacheLine_t* cacheLine = &FragDecoder.MatrixCache[row % FRAG_DECODER_MATRIX_CACHE_ROWS];
+
+    memcpy( cacheLine->Data, bitArray, words * sizeof( uint32_t ) );
+    cacheLine->Row = row;
+    if( ( FragDecoder.Callbacks != NULL ) && ( FragDecoder.Callbacks->FragDecoderWrite != NULL ) )
+    {
+        FragDecoder.Callbacks->FragDecoderWrite( MatrixRowAddr( row, words ), ( uint8_t* ) cacheLine->Data,
+                                                 words * sizeof( uint32_t ) );
+    }
+}
+#else
+static uint16_t FragFindMissingIndex( uint16_t x )
+{
+    return FragDecoder.MissingFragIndex[x];
+}
+
+static void FragSetReceived( uint16_t index )
+{
+    FragDecoder.FragNbMissingIndex[index] = 0;
+}
+
+static void FragSetLost( uint16_t index )
+{
+    if( FragDecoder.Status.FragNbLost < FRAG_MAX_REDUNDANCY )
+    {
+        FragDecoder.MissingFragIndex[FragDecoder.Status.FragNbLost] = index;
     }
+    FragDecoder.Status.FragNbLost++;
+    FragDecoder.FragNbMissingIndex[index] = FragDecoder.Status.FragNbLost;
+}
+
+static uint16_t FragGetMissingIndex( uint16_t index )
+{
+    return FragDecoder.FragNbMissingIndex[index];
+}
+
+static const uint32_t* FragGetMatrixLine( uint16_t row, int32_t words )
+{
+    ( void ) words;
+    return FragDecoder.MatrixM2B[row];
+}
+
+static void FragPushMatrixLine( const uint32_t* bitArray, uint16_t row, int32_t words )
+{
+    memcpy( FragDecoder.MatrixM2B[row], bitArray, words * sizeof( uint32_t ) );
 }
+#endif  // FRAG_DECODER_PAGED_MATRIX
@@ -72,6 +72,27 @@ extern "C" {
 #define FRAG_MAX_REDUNDANCY FRAG_MAX_NB
 #endif
 
+/*!
+ * If set to 1 the decoding matrix is not kept in RAM but stored right after the file through the
+ * \ref FragDecoderWrite and \ref FragDecoderRead callbacks, only a few rows are cached in RAM. The RAM footprint then
+ * grows with 3 * FRAG_MAX_NB / 16 bytes instead of FRAG_MAX_REDUNDANCY^2 / 8 bytes, allowing sessions of thousands of
+ * fragments.
+ *
+ * \remark The storage behind the callbacks shall hold \ref FragDecoderGetMaxStorageSize bytes.
+ */
+#ifndef FRAG_DECODER_PAGED_MATRIX
+#define FRAG_DECODER_PAGED_MATRIX 0
+#endif
+
+/*!
+ * Number of matrix rows cached in RAM when FRAG_DECODER_PAGED_MATRIX is set.
+ *
+ * \remark This parameter has an impact on the memory footprint.
+ */
+#ifndef FRAG_DECODER_MATRIX_CACHE_ROWS
+#define FRAG_DECODER_MATRIX_CACHE_ROWS 4
+#endif
+
 #define FRAG_SESSION_FAILED ( int32_t ) 1
 #define FRAG_SESSION_FINISHED_SUCCESSFULLY ( int32_t ) 0
 #define FRAG_SESSION_NOT_STARTED ( int32_t ) - 2
@@ -140,6 +161,14 @@ void FragDecoderInit( uint16_t fragNb, uint8_t fragSize, uint8_t* file, uint32_t
  * \retval size FileSize
  */
 uint32_t FragDecoderGetMaxFileSize( void );
+
+/*!
+ * \brief Gets the size needed behind the Write/Read callbacks: the file and, when
+ *        FRAG_DECODER_PAGED_MATRIX is set, the decoding matrix
+ *
+ * \retval size Storage size
+ */
+uint32_t FragDecoderGetMaxStorageSize( void );
 #endif
 
 /*!
@@ -309,6 +309,8 @@ void lorawan_fragmentation_package_services_init( uint8_t* service_id, uint8_t t
         frag_session_data[i].frag_group_data.session_cnt_prev = -1;
     }
     nb_transmit_ans = 1;
+    modem_downlink_set_filter( lorawan_fragmentation_package_service_downlink_handler, CURRENT_STACK,
+                               MODEM_DOWNLINK_FILTER_FPORT, FRAGMENTATION_PORT );
 }
 
 void lorawan_fragmentation_package_service_on_launch( void* service_id )
@@ -0,0 +1,485 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fragmentation_helper_v2.0.0.h"
+
+// Previous implementation, see fragmentation_helper_ref.c
+void                ref_FragDecoderInit( uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t* callbacks );
+uint32_t            ref_FragDecoderGetMaxFileSize( void );
+int32_t             ref_FragDecoderProcess( uint16_t fragCounter, uint8_t* rawData );
+FragDecoderStatus_t ref_FragDecoderGetStatus( void );
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+/**
+ * Storage behind the Write/Read callbacks of each decoder, with access accounting
+ */
+typedef struct storage_s
+{
+    uint8_t* data;
+    uint32_t size;
+    uint32_t max_addr;  // highest address accessed + 1
+    uint64_t rd_bytes;
+    uint64_t wr_bytes;
+    uint32_t rd_count;
+    uint32_t wr_count;
+    bool     out_of_bounds;
+} storage_t;
+
+static storage_t new_storage;
+static storage_t ref_storage;
+
+static int8_t storage_access( storage_t* storage, uint32_t addr, uint8_t* data, uint32_t size, bool write )
+{
+    if( ( ( uint64_t ) addr + size ) > storage->size )
+    {
+        storage->out_of_bounds = true;
+        return -1;
+    }
+    if( ( addr + size ) > storage->max_addr )
+    {
+        storage->max_addr = addr + size;
+    }
+    if( write == true )
+    {
+        memcpy( storage->data + addr, data, size );
+        storage->wr_bytes += size;
+        storage->wr_count++;
+    }
+    else
+    {
+        memcpy( data, storage->data + addr, size );
+        storage->rd_bytes += size;
+        storage->rd_count++;
+    }
+    return 0;
+}
+
+static int8_t new_write( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return storage_access( &new_storage, addr, data, size, true );
+}
+
+static int8_t new_read( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return storage_access( &new_storage, addr, data, size, false );
+}
+
+static int8_t ref_write( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return storage_access( &ref_storage, addr, data, size, true );
+}
+
+static int8_t ref_read( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return storage_access( &ref_storage, addr, data, size, false );
+}
+
+static FragDecoderCallbacks_t new_callbacks = { new_write, new_read };
+static FragDecoderCallbacks_t ref_callbacks = { ref_write, ref_read };
+
+// --- HELPERS -----------------------------------------------------------------
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static uint8_t file[FRAG_MAX_NB][FRAG_MAX_SIZE];
+
+/**
+ * Parity row generator of the LoRa-Alliance fragmentation specification, one byte per fragment
+ */
+static int32_t parity_prbs23( int32_t value )
+{
+    int32_t b0 = value & 1;
+    int32_t b1 = ( value & 0x20 ) >> 5;
+    return ( value >> 1 ) + ( ( b0 ^ b1 ) << 22 );
+}
+
+static void parity_row( int32_t n, int32_t m, uint8_t* row )
+{
+    int32_t mm = ( ( m & ( m - 1 ) ) == 0 ) ? 1 : 0;
+    int32_t x  = 1 + ( 1001 * n );
+    int32_t nb = 0;
+
+    memset( row, 0, m );
+    while( nb < ( m >> 1 ) )
+    {
+        int32_t r = 1 << 16;
+        while( r >= m )
+        {
+            x = parity_prbs23( x );
+            r = x % ( m + mm );
+        }
+        if( row[r] == 0 )
+        {
+            row[r] = 1;
+            nb++;
+        }
+    }
+}
+
+/**
+ * Build the fragment of counter `counter`: an uncoded fragment or the xor of the fragments of its parity row
+ */
+static void build_fragment( uint16_t counter, uint16_t frag_nb, uint8_t frag_size, uint8_t* fragment )
+{
+    static uint8_t row[FRAG_MAX_NB];
+
+    if( counter <= frag_nb )
+    {
+        memcpy( fragment, file[counter - 1], frag_size );
+        return;
+    }
+    parity_row( counter - frag_nb, frag_nb, row );
+    memset( fragment, 0, frag_size );
+    for( uint16_t i = 0; i < frag_nb; i++ )
+    {
+        if( row[i] != 0 )
+        {
+            for( uint8_t j = 0; j < frag_size; j++ )
+            {
+                fragment[j] ^= file[i][j];
+            }
+        }
+    }
+}
+
+static void storage_reset( storage_t* storage )
+{
+    memset( storage->data, 0xFF, storage->size );
+    storage->max_addr      = 0;
+    storage->out_of_bounds = false;
+}
+
+static bool status_is_equal( FragDecoderStatus_t a, FragDecoderStatus_t b )
+{
+    return ( a.FragNbRx == b.FragNbRx ) && ( a.FragNbLost == b.FragNbLost ) && ( a.MissingFrag == b.MissingFrag ) &&
+           ( a.FragNbLastRx == b.FragNbLastRx ) && ( a.MatrixError == b.MatrixError );
+}
+
+typedef struct session_s
+{
+    uint16_t frag_nb;
+    uint8_t  frag_size;
+    uint8_t  loss_percent;
+    uint16_t redundancy;
+    bool     duplicates;  // some fragments are received twice
+} session_t;
+
+typedef struct session_stat_s
+{
+    uint32_t sessions;
+    uint32_t decoded;
+    uint32_t failed;
+    uint32_t errors;
+} session_stat_t;
+
+/**
+ * Run a session on both decoders, comparing the returned status, the decoder status and the file after each
+ * fragment, and the decoded file with the original one
+ */
+static void run_session( const session_t* session, bool compare, session_stat_t* stat )
+{
+    uint8_t new_buffer[FRAG_MAX_SIZE + 4];
+    uint8_t ref_buffer[FRAG_MAX_SIZE + 4];
+    int32_t new_rc = FRAG_SESSION_ONGOING;
+    int32_t ref_rc = FRAG_SESSION_ONGOING;
+
+    for( uint16_t i = 0; i < session->frag_nb; i++ )
+    {
+        for( uint8_t j = 0; j < session->frag_size; j++ )
+        {
+            file[i][j] = rnd( );
+        }
+    }
+    storage_reset( &new_storage );
+    FragDecoderInit( session->frag_nb, session->frag_size, &new_callbacks );
+    if( compare == true )
+    {
+        storage_reset( &ref_storage );
+        ref_FragDecoderInit( session->frag_nb, session->frag_size, &ref_callbacks );
+    }
+    stat->sessions++;
+
+    uint16_t last_counter = session->frag_nb + session->redundancy;
+    for( uint16_t counter = 1; ( counter <= last_counter ) && ( new_rc < 0 ); counter++ )
+    {
+        if( ( rnd( ) % 100 ) < session->loss_percent )
+        {
+            continue;
+        }
+        // The package stops feeding the decoder once the file is complete
+        uint8_t repeat = ( ( session->duplicates == true ) && ( ( rnd( ) % 8 ) == 0 ) ) ? 2 : 1;
+        for( uint8_t k = 0; ( k < repeat ) && ( new_rc < 0 ); k++ )
+        {
+            // Fragments are not aligned in the downlink buffer
+            uint8_t* new_fragment = new_buffer + ( rnd( ) % 4 );
+            build_fragment( counter, session->frag_nb, session->frag_size, new_fragment );
+            if( compare == true )
+            {
+                uint8_t* ref_fragment = ref_buffer + ( rnd( ) % 4 );
+                memcpy( ref_fragment, new_fragment, session->frag_size );
+                ref_rc = ref_FragDecoderProcess( counter, ref_fragment );
+            }
+            new_rc = FragDecoderProcess( counter, new_fragment );
+            if( ( compare == true ) &&
+                ( ( new_rc != ref_rc ) || !status_is_equal( FragDecoderGetStatus( ), ref_FragDecoderGetStatus( ) ) ) )
+            {
+                stat->errors++;
+            }
+        }
+    }
+
+    if( new_rc == FRAG_SESSION_FINISHED_SUCCESSFULLY )
+    {
+        stat->decoded++;
+        for( uint16_t i = 0; i < session->frag_nb; i++ )
+        {
+            if( memcmp( new_storage.data + ( i * session->frag_size ), file[i], session->frag_size ) != 0 )
+            {
+                stat->errors++;
+                break;
+            }
+        }
+    }
+    else
+    {
+        stat->failed++;
+    }
+    if( ( compare == true ) &&
+        ( memcmp( new_storage.data, ref_storage.data, ( uint32_t ) session->frag_nb * session->frag_size ) != 0 ) )
+    {
+        stat->errors++;
+    }
+    if( ( new_storage.out_of_bounds == true ) || ( ref_storage.out_of_bounds == true ) )
+    {
+        stat->errors++;
+    }
+}
+
+static void random_session( session_t* session, uint16_t max_nb )
+{
+    session->frag_nb      = 1 + rnd( ) % max_nb;
+    session->frag_size    = ( ( rnd( ) % 3 ) == 0 ) ? FRAG_MAX_SIZE : 1 + rnd( ) % FRAG_MAX_SIZE;
+    session->loss_percent = rnd( ) % 60;
+    session->redundancy   = 1 + rnd( ) % FRAG_MAX_REDUNDANCY;
+    session->duplicates   = ( rnd( ) % 4 ) == 0;
+}
+
+/**
+ * Decode a session on one decoder only and return the decoding time in us, the storage accesses are reset first
+ */
+static uint32_t decode_alone( const session_t* session, bool reference, uint32_t seed )
+{
+    storage_t*      storage = ( reference == true ) ? &ref_storage : &new_storage;
+    uint8_t         fragment[FRAG_MAX_SIZE];
+    struct timespec start;
+    struct timespec end;
+
+    rnd_state = seed;
+    for( uint16_t i = 0; i < session->frag_nb; i++ )
+    {
+        for( uint8_t j = 0; j < session->frag_size; j++ )
+        {
+            file[i][j] = rnd( );
+        }
+    }
+    storage_reset( storage );
+    storage->rd_bytes = 0;
+    storage->wr_bytes = 0;
+    storage->rd_count = 0;
+    storage->wr_count = 0;
+
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    if( reference == true )
+    {
+        ref_FragDecoderInit( session->frag_nb, session->frag_size, &ref_callbacks );
+    }
+    else
+    {
+        FragDecoderInit( session->frag_nb, session->frag_size, &new_callbacks );
+    }
+    for( uint16_t counter = 1; counter <= ( session->frag_nb + session->redundancy ); counter++ )
+    {
+        if( ( rnd( ) % 100 ) < session->loss_percent )
+        {
+            continue;
+        }
+        build_fragment( counter, session->frag_nb, session->frag_size, fragment );
+        int32_t rc = ( reference == true ) ? ref_FragDecoderProcess( counter, fragment )
+                                           : FragDecoderProcess( counter, fragment );
+        if( rc >= 0 )
+        {
+            break;
+        }
+    }
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    return ( uint32_t ) ( ( end.tv_sec - start.tv_sec ) * 1000000 + ( end.tv_nsec - start.tv_nsec ) / 1000 );
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies on random sessions of up to FRAG_MAX_NB fragments, with losses, duplicates and any fragment size, that
+ * both implementations return the same status after each fragment and decode the same file.
+ */
+void test_random_sessions_match_previous( )
+{
+    session_stat_t stat = { 0 };
+    session_t      session;
+
+    rnd_state = 1;
+    for( uint32_t i = 0; i < 300; i++ )
+    {
+        random_session( &session, FRAG_MAX_NB );
+        run_session( &session, true, &stat );
+    }
+    printf( "     %u sessions: %u decoded, %u not decoded\n", stat.sessions, stat.decoded, stat.failed );
+    print_result( "test_random_sessions_match_previous",
+                  ( stat.errors == 0 ) && ( stat.decoded > 0 ) && ( stat.failed > 0 ) );
+}
+
+/**
+ * Verifies small sessions, where the parity rows use the power of two correction and the matrix is only a few words.
+ */
+void test_small_sessions_match_previous( )
+{
+    session_stat_t stat = { 0 };
+    session_t      session;
+
+    rnd_state = 2;
+    for( uint32_t i = 0; i < 2000; i++ )
+    {
+        random_session( &session, 40 );
+        run_session( &session, true, &stat );
+    }
+    print_result( "test_small_sessions_match_previous", ( stat.errors == 0 ) && ( stat.decoded > 0 ) );
+}
+
+/**
+ * Verifies the largest sessions, FRAG_MAX_NB fragments of FRAG_MAX_SIZE bytes with every redundancy fragment.
+ */
+void test_full_sessions_match_previous( )
+{
+    session_stat_t stat    = { 0 };
+    session_t      session = {
+        .frag_nb = FRAG_MAX_NB, .frag_size = FRAG_MAX_SIZE, .redundancy = FRAG_MAX_REDUNDANCY, .duplicates = false
+    };
+
+    rnd_state = 3;
+    for( uint8_t loss = 0; loss <= 40; loss += 10 )
+    {
+        session.loss_percent = loss;
+        run_session( &session, true, &stat );
+    }
+    print_result( "test_full_sessions_match_previous", ( stat.errors == 0 ) && ( stat.decoded > 0 ) );
+}
+
+/**
+ * Verifies that the decoder stays within the storage it declares.
+ */
+void test_storage_size( )
+{
+    session_stat_t stat    = { 0 };
+    session_t      session = {
+        .frag_nb = FRAG_MAX_NB, .frag_size = FRAG_MAX_SIZE, .redundancy = FRAG_MAX_REDUNDANCY, .duplicates = false
+    };
+    bool passed = true;
+
+    rnd_state            = 4;
+    session.loss_percent = 30;
+    new_storage.size     = FragDecoderGetMaxStorageSize( );
+    run_session( &session, false, &stat );
+    passed = ( stat.errors == 0 ) && ( new_storage.max_addr <= FragDecoderGetMaxStorageSize( ) ) &&
+             ( FragDecoderGetMaxFileSize( ) == ref_FragDecoderGetMaxFileSize( ) );
+#if( FRAG_DECODER_PAGED_MATRIX == 1 )
+    // The matrix rows are stored after the file
+    passed = passed && ( new_storage.max_addr > FragDecoderGetMaxFileSize( ) );
+#else
+    passed = passed && ( FragDecoderGetMaxStorageSize( ) == FragDecoderGetMaxFileSize( ) );
+#endif
+    new_storage.size = ref_storage.size;
+    print_result( "test_storage_size", passed );
+}
+
+/**
+ * Measures the decoding time and the storage accesses of both implementations, by fragment count and loss rate.
+ */
+void benchmark( )
+{
+    static const uint16_t nb_list[]   = { 25, 50, 100, 200, 400 };
+    static const uint8_t  loss_list[] = { 5, 20, 40 };
+
+    printf( "\n---- BENCHMARK ----\n" );
+    printf( "  nb loss |   ref us   new us |  ref rd KB  ref wr KB |  new rd KB  new wr KB | new rd/wr calls\n" );
+    for( uint8_t n = 0; ( n < sizeof( nb_list ) / sizeof( nb_list[0] ) ) && ( nb_list[n] <= FRAG_MAX_NB ); n++ )
+    {
+        for( uint8_t l = 0; l < sizeof( loss_list ) / sizeof( loss_list[0] ); l++ )
+        {
+            session_t session = { .frag_nb      = nb_list[n],
+                                  .frag_size    = FRAG_MAX_SIZE,
+                                  .loss_percent = loss_list[l],
+                                  .redundancy   = FRAG_MAX_REDUNDANCY,
+                                  .duplicates   = false };
+            uint32_t  ref_us  = decode_alone( &session, true, 10 + n * 16 + l );
+            uint32_t  new_us  = decode_alone( &session, false, 10 + n * 16 + l );
+
+            printf( "%4u %3u%% | %8u %8u | %10.1f %10.1f | %10.1f %10.1f | %7u/%u\n", session.frag_nb,
+                    session.loss_percent, ref_us, new_us, ref_storage.rd_bytes / 1024.0,
+                    ref_storage.wr_bytes / 1024.0, new_storage.rd_bytes / 1024.0, new_storage.wr_bytes / 1024.0,
+                    new_storage.rd_count, new_storage.wr_count );
+        }
+    }
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( int argc, char** argv )
+{
+    // The reference decoder keeps its matrix in RAM, the same storage size is given to both
+    new_storage.size = ref_storage.size = FragDecoderGetMaxStorageSize( );
+    new_storage.data                    = malloc( new_storage.size );
+    ref_storage.data                    = malloc( ref_storage.size );
+
+    printf( "FRAG_MAX_NB %u, FRAG_DECODER_PAGED_MATRIX %u\n", FRAG_MAX_NB, FRAG_DECODER_PAGED_MATRIX );
+    if( ( argc > 1 ) && ( strcmp( argv[1], "bench" ) == 0 ) )
+    {
+        benchmark( );
+        return 0;
+    }
+
+    test_random_sessions_match_previous( );
+    test_small_sessions_match_previous( );
+    test_full_sessions_match_previous( );
+    test_storage_size( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    free( new_storage.data );
+    free( ref_storage.data );
+    return failed_count == 0 ? 0 : 1;
+}
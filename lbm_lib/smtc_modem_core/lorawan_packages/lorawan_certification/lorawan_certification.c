@@ -47,6 +47,7 @@
 #include "smtc_duty_cycle.h"
 #include "smtc_modem_test_api.h"
 #include "modem_core.h"
+#include "modem_context_cache.h"
 #include "lora_basics_modem_version.h"
 #include "lorawan_certification.h"
 #include "modem_tx_protocol_manager.h"
@@ -572,6 +573,7 @@ static lorawan_certification_requested_tx_type_t lorawan_certification_parser(
         if( rx_buffer_length == LORAWAN_CERTIFICATION_DUT_RESET_REQ_SIZE )
         {
             SMTC_MODEM_HAL_TRACE_PRINTF( "Certif mcu reset\n" );
+            modem_context_cache_flush_all( );
             smtc_modem_hal_reset_mcu( );
         }
         else
@@ -917,6 +919,7 @@ static lorawan_certification_requested_tx_type_t lorawan_certification_parser(
         {
             lorawan_certification->enabled = false;
             lorawan_api_modem_certification_set( false, lorawan_certification->stack_id );
+            modem_context_cache_flush_all( );
             smtc_modem_hal_reset_mcu( );
         }
         else
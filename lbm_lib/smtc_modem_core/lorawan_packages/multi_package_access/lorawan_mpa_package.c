@@ -363,6 +363,8 @@ void lorawan_mpa_package_services_init( uint8_t* service_id, uint8_t task_id,
 #if defined( FUOTA_BUILT_IN_TEST )
     mpa_test( );
 #endif
+    modem_downlink_set_filter( lorawan_mpa_package_service_downlink_handler, CURRENT_STACK, MODEM_DOWNLINK_FILTER_FPORT,
+                               MPA_PORT );
 }
 
 void lorawan_mpa_package_service_on_launch( void* service_id )
@@ -362,6 +362,8 @@ void lorawan_remote_multicast_setup_package_services_init(
     }
 
     memset( multicast_group_params, 0, sizeof( multicast_group_params ) );
+    modem_downlink_set_filter( lorawan_remote_multicast_setup_package_service_downlink_handler, CURRENT_STACK,
+                               MODEM_DOWNLINK_FILTER_FPORT, REMOTE_MULTICAST_SETUP_PORT );
 }
 
 void lorawan_remote_multicast_setup_package_service_on_launch( void* ctx_service )
@@ -50,6 +50,10 @@
 #include "lr1mac_config.h"
 #include "smtc_modem_crypto.h"
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+#include "lr1mac_session_journal.h"
+#endif
+
 #if defined( ADD_RELAY_RX )
 #include "relay_rx_mac_parser.h"
 #include "relay_def.h"
@@ -207,6 +211,11 @@ void lr1_stack_mac_region_config( lr1_stack_mac_t* lr1_mac )
 
 void lr1_stack_mac_tx_frame_build( lr1_stack_mac_t* lr1_mac )
 {
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+    // The frame counter shall be reserved in the journal before it is sent
+    lr1mac_session_journal_reserve( lr1_mac );
+#endif
+
     uint8_t tx_fopts_length = 0;
     if( lr1_mac->tx_fport != PORTNWK )
     {
@@ -1588,17 +1597,21 @@ uint32_t lr1_stack_network_next_free_duty_cycle_ms_get( lr1_stack_mac_t* lr1_mac
 }
 
 uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
+{
+    return lr1_stack_toa_compute( lr1_mac, lr1_mac->tx_data_rate, lr1_mac->tx_payload_size );
+}
+
+uint32_t lr1_stack_toa_compute( lr1_stack_mac_t* lr1_mac, uint8_t data_rate, uint8_t payload_size )
 {
     uint32_t toa = 0;
 
-    modulation_type_t tx_modulation_type =
-        smtc_real_get_modulation_type_from_datarate( lr1_mac->real, lr1_mac->tx_data_rate );
+    modulation_type_t tx_modulation_type = smtc_real_get_modulation_type_from_datarate( lr1_mac->real, data_rate );
 
     if( tx_modulation_type == LORA )
     {
         uint8_t            tx_sf;
         lr1mac_bandwidth_t tx_bw;
-        smtc_real_lora_dr_to_sf_bw( lr1_mac->real, lr1_mac->tx_data_rate, &tx_sf, &tx_bw );
+        smtc_real_lora_dr_to_sf_bw( lr1_mac->real, data_rate, &tx_sf, &tx_bw );
 
         ralf_params_lora_t lora_param;
         memset( &lora_param, 0, sizeof( ralf_params_lora_t ) );
@@ -1610,7 +1623,7 @@ uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
 
         lora_param.pkt_params.crc_is_on        = true;
         lora_param.pkt_params.invert_iq_is_on  = false;
-        lora_param.pkt_params.pld_len_in_bytes = lr1_mac->tx_payload_size;
+        lora_param.pkt_params.pld_len_in_bytes = payload_size;
         lora_param.pkt_params.preamble_len_in_symb =
             smtc_real_get_preamble_len( lr1_mac->real, lora_param.mod_params.sf );
         lora_param.pkt_params.header_type = RAL_LORA_PKT_EXPLICIT;
@@ -1621,7 +1634,7 @@ uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
     else if( tx_modulation_type == FSK )
     {
         uint8_t tx_bitrate;
-        smtc_real_fsk_dr_to_bitrate( lr1_mac->real, lr1_mac->tx_data_rate, &tx_bitrate );
+        smtc_real_fsk_dr_to_bitrate( lr1_mac->real, data_rate, &tx_bitrate );
 
         ralf_params_gfsk_t gfsk_param;
         memset( &gfsk_param, 0, sizeof( ralf_params_gfsk_t ) );
@@ -1633,7 +1646,7 @@ uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
         gfsk_param.crc_polynomial = GFSK_CRC_POLYNOMIAL;
 
         gfsk_param.pkt_params.header_type           = RAL_GFSK_PKT_VAR_LEN;
-        gfsk_param.pkt_params.pld_len_in_bytes      = lr1_mac->tx_payload_size;
+        gfsk_param.pkt_params.pld_len_in_bytes      = payload_size;
         gfsk_param.pkt_params.preamble_len_in_bits  = 40;
         gfsk_param.pkt_params.preamble_detector     = RAL_GFSK_PREAMBLE_DETECTOR_MIN_16BITS;
         gfsk_param.pkt_params.sync_word_len_in_bits = 24;
@@ -1652,7 +1665,7 @@ uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
     {
         lr_fhss_v1_cr_t tx_cr;
         lr_fhss_v1_bw_t tx_bw;
-        smtc_real_lr_fhss_dr_to_cr_bw( lr1_mac->real, lr1_mac->tx_data_rate, &tx_cr, &tx_bw );
+        smtc_real_lr_fhss_dr_to_cr_bw( lr1_mac->real, data_rate, &tx_cr, &tx_bw );
 
         ralf_params_lr_fhss_t lr_fhss_param;
         memset( &lr_fhss_param, 0, sizeof( ralf_params_lr_fhss_t ) );
@@ -1662,7 +1675,7 @@ uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac )
         lr_fhss_param.ral_lr_fhss_params.lr_fhss_params.header_count   = smtc_real_lr_fhss_get_header_count( tx_cr );
 
         ral_lr_fhss_get_time_on_air_in_ms( ( &lr1_mac->rp->radio->ral ), &lr_fhss_param.ral_lr_fhss_params,
-                                           lr1_mac->tx_payload_size, &toa );
+                                           payload_size, &toa );
     }
     else
     {
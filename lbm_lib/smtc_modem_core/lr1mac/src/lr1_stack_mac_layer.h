@@ -384,6 +384,16 @@ uint32_t lr1_stack_network_next_free_duty_cycle_ms_get( lr1_stack_mac_t* lr1_mac
  */
 uint32_t lr1_stack_toa_get( lr1_stack_mac_t* lr1_mac );
 
+/*!
+ * \brief lr1_stack_toa_compute
+ * \remark Same as lr1_stack_toa_get for any frame size and datarate
+ * \param [IN]  lr1_stack_mac_t
+ * \param [IN]  data_rate     datarate of the frame
+ * \param [IN]  payload_size  size of the frame, MHDR to MIC
+ * \return toa of the frame
+ */
+uint32_t lr1_stack_toa_compute( lr1_stack_mac_t* lr1_mac, uint8_t data_rate, uint8_t payload_size );
+
 /**
  * @brief
  *
@@ -52,6 +52,10 @@
 #include "smtc_modem_crypto.h"
 #include "smtc_modem_hal.h"
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+#include "lr1mac_session_journal.h"
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE MACROS-----------------------------------------------------------
@@ -1126,6 +1130,9 @@ static rx_packet_type_t smtc_ping_slot_mac_rx_frame_decode( smtc_ping_slot_t* pi
         RX_DOWN_DATA.rx_metadata.tx_ack_bit = tx_ack_bit;
         RX_SESSION_PARAM_CURRENT->fcnt_dwn  = fcnt_dwn_stack_tmp;
         ping_slot_obj->lr1_mac->fcnt_dwn    = ping_slot_obj->rx_session_param[RX_SESSION_UNICAST]->fcnt_dwn;
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+        lr1mac_session_journal_update( ping_slot_obj->lr1_mac );
+#endif
     }
 
     SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( " RxB rx_packet_type = %u \n", rx_packet_type );
@@ -52,6 +52,10 @@
 #include "smtc_modem_crypto.h"
 #include "smtc_modem_hal.h"
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+#include "lr1mac_session_journal.h"
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE MACROS-----------------------------------------------------------
@@ -92,6 +96,8 @@ static rx_packet_type_t lr1mac_class_c_mac_rx_frame_decode( lr1mac_class_c_t* cl
 static void             lr1mac_class_c_rp_callback( lr1mac_class_c_t* class_c_obj );
 static int              lr1mac_class_c_mac_downlink_check_under_it( lr1mac_class_c_t* class_c_obj );
 static void             lr1mac_class_c_launch( lr1mac_class_c_t* class_c_obj );
+static int              lr1mac_class_c_mac_verify_mic( lr1mac_class_c_t* class_c_obj, uint16_t fcnt_dwn_tmp,
+                                                       uint32_t* fcnt_dwn_stack, uint32_t mic_in );
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -678,7 +684,7 @@ static rx_packet_type_t lr1mac_class_c_mac_rx_frame_decode( lr1mac_class_c_t* cl
     class_c_obj->rx_session_param[RX_SESSION_UNICAST]->fcnt_dwn = class_c_obj->lr1_mac->fcnt_dwn;
 
     uint16_t fcnt_dwn_tmp       = 0;
-    uint32_t fcnt_dwn_stack_tmp = RX_SESSION_PARAM_CURRENT->fcnt_dwn;
+    uint32_t fcnt_dwn_stack_tmp = 0;
 
     status += lr1mac_rx_fhdr_extract(
         class_c_obj->lr1_mac->rx_down_data.rx_payload, class_c_obj->lr1_mac->rx_down_data.rx_payload_size,
@@ -687,20 +693,7 @@ static rx_packet_type_t lr1mac_class_c_mac_rx_frame_decode( lr1mac_class_c_t* cl
         &( class_c_obj->lr1_mac->rx_down_data.rx_metadata.rx_fport_present ), &( class_c_obj->rx_fctrl ),
         class_c_obj->rx_fopts );
 
-    if( status == OKLORAWAN )
-    {
-        status = lr1mac_fcnt_dwn_accept( fcnt_dwn_tmp, &fcnt_dwn_stack_tmp );
-    }
-
-    if( status == OKLORAWAN )
-    {
-        if( ( fcnt_dwn_stack_tmp < RX_SESSION_PARAM_CURRENT->fcnt_dwn_min ) ||
-            ( fcnt_dwn_stack_tmp > RX_SESSION_PARAM_CURRENT->fcnt_dwn_max ) )
-        {
-            status = ERRORLORAWAN;
-        }
-    }
-
+    // The frame counter is checked against each session sharing the device address by the MIC verification
     if( status == OKLORAWAN )
     {
         class_c_obj->lr1_mac->rx_down_data.rx_payload_size =
@@ -709,13 +702,7 @@ static rx_packet_type_t lr1mac_class_c_mac_rx_frame_decode( lr1mac_class_c_t* cl
                 &class_c_obj->lr1_mac->rx_down_data.rx_payload[class_c_obj->lr1_mac->rx_down_data.rx_payload_size],
                 MICSIZE );
 
-        if( smtc_modem_crypto_verify_mic(
-                &class_c_obj->lr1_mac->rx_down_data.rx_payload[0], class_c_obj->lr1_mac->rx_down_data.rx_payload_size,
-                RX_SESSION_PARAM_CURRENT->nwk_skey, RX_SESSION_PARAM_CURRENT->dev_addr, 1, fcnt_dwn_stack_tmp, mic_in,
-                class_c_obj->lr1_mac->stack_id ) != SMTC_MODEM_CRYPTO_RC_SUCCESS )
-        {
-            status = ERRORLORAWAN;
-        }
+        status = lr1mac_class_c_mac_verify_mic( class_c_obj, fcnt_dwn_tmp, &fcnt_dwn_stack_tmp, mic_in );
     }
     if( status == OKLORAWAN )
     {
@@ -783,9 +770,86 @@ static rx_packet_type_t lr1mac_class_c_mac_rx_frame_decode( lr1mac_class_c_t* cl
         class_c_obj->lr1_mac->rx_down_data.rx_metadata.tx_ack_bit = tx_ack_bit;
         RX_SESSION_PARAM_CURRENT->fcnt_dwn                        = fcnt_dwn_stack_tmp;
         class_c_obj->lr1_mac->fcnt_dwn = class_c_obj->rx_session_param[RX_SESSION_UNICAST]->fcnt_dwn;
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+        lr1mac_session_journal_update( class_c_obj->lr1_mac );
+#endif
     }
 
     SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( " RxC rx_packet_type = %d \n", rx_packet_type );
     return ( rx_packet_type );
 }
+
+/**
+ * @brief Verify the MIC of the received frame against the keys of the sessions sharing its device address
+ *
+ * Multicast groups may be configured with the same address: the frame is checked against the keys of all the enabled
+ * groups that accept its frame counter, and the current session becomes the group whose key matches.
+ *
+ * @param [in]  class_c_obj    Class C object
+ * @param [in]  fcnt_dwn_tmp   16 bits frame counter of the received frame
+ * @param [out] fcnt_dwn_stack Frame counter of the received frame in the matching session
+ * @param [in]  mic_in         MIC of the received frame
+ * @return int OKLORAWAN if a key matches
+ */
+static int lr1mac_class_c_mac_verify_mic( lr1mac_class_c_t* class_c_obj, uint16_t fcnt_dwn_tmp,
+                                          uint32_t* fcnt_dwn_stack, uint32_t mic_in )
+{
+    smtc_se_key_identifier_t nwk_skeys[LR1MAC_NUMBER_OF_RXC_SESSION];
+    rx_session_type_t        sessions[LR1MAC_NUMBER_OF_RXC_SESSION];
+    uint32_t                 fcnt_dwn[LR1MAC_NUMBER_OF_RXC_SESSION];
+    uint8_t                  key_candidates[LR1MAC_NUMBER_OF_RXC_SESSION];
+    bool                     is_checked[LR1MAC_NUMBER_OF_RXC_SESSION] = { false };
+    uint8_t                  nb_candidates                            = 0;
+    uint32_t                 dev_addr                                 = RX_SESSION_PARAM_CURRENT->dev_addr;
+
+    // The current session is the first one with this address, the unicast session keys are never shared
+    rx_session_type_t last_session =
+        ( class_c_obj->rx_session_index == RX_SESSION_UNICAST ) ? RX_SESSION_UNICAST : LR1MAC_NUMBER_OF_RXC_SESSION - 1;
+
+    for( rx_session_type_t i = class_c_obj->rx_session_index; i <= last_session; i++ )
+    {
+        lr1mac_rx_session_param_t* session = class_c_obj->rx_session_param[i];
+        uint32_t                   fcnt    = session->fcnt_dwn;
+
+        if( ( session->enabled == true ) && ( session->dev_addr == dev_addr ) &&
+            ( lr1mac_fcnt_dwn_accept( fcnt_dwn_tmp, &fcnt ) == OKLORAWAN ) && ( fcnt >= session->fcnt_dwn_min ) &&
+            ( fcnt <= session->fcnt_dwn_max ) )
+        {
+            sessions[nb_candidates]   = i;
+            fcnt_dwn[nb_candidates++] = fcnt;
+        }
+    }
+
+    // B0 holds the frame counter: the keys of the candidates reaching the same frame counter are checked together
+    for( uint8_t first = 0; first < nb_candidates; first++ )
+    {
+        uint8_t nb_keys   = 0;
+        uint8_t key_index = 0;
+
+        if( is_checked[first] == true )
+        {
+            continue;
+        }
+        for( uint8_t j = first; j < nb_candidates; j++ )
+        {
+            if( ( is_checked[j] == false ) && ( fcnt_dwn[j] == fcnt_dwn[first] ) )
+            {
+                is_checked[j]             = true;
+                nwk_skeys[nb_keys]        = class_c_obj->rx_session_param[sessions[j]]->nwk_skey;
+                key_candidates[nb_keys++] = j;
+            }
+        }
+
+        if( smtc_modem_crypto_verify_mic_with_keys(
+                &class_c_obj->lr1_mac->rx_down_data.rx_payload[0], class_c_obj->lr1_mac->rx_down_data.rx_payload_size,
+                nwk_skeys, nb_keys, dev_addr, 1, fcnt_dwn[first], mic_in, &key_index,
+                class_c_obj->lr1_mac->stack_id ) == SMTC_MODEM_CRYPTO_RC_SUCCESS )
+        {
+            class_c_obj->rx_session_index = sessions[key_candidates[key_index]];
+            *fcnt_dwn_stack               = fcnt_dwn[first];
+            return OKLORAWAN;
+        }
+    }
+    return ERRORLORAWAN;
+}
 /* --- EOF ------------------------------------------------------------------ */
@@ -0,0 +1,331 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The decoding functions are static: the module is built within the test
+#include "lr1mac_class_c.c"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static int      mic_calls;
+static uint32_t mic_fcnt[LR1MAC_NUMBER_OF_RXC_SESSION];
+
+/**
+ * Keyed MIC model: a frame only verifies with the key and the 32-bit frame counter it was built with.
+ */
+static uint32_t fake_mic( smtc_se_key_identifier_t key, uint32_t dev_addr, uint32_t fcnt )
+{
+    return ( ( uint32_t ) key + 1 ) * 0x9E3779B1u ^ dev_addr * 31u ^ fcnt * 0x85EBCA6Bu;
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic_with_keys( const uint8_t* buffer, uint16_t size,
+                                                                        const smtc_se_key_identifier_t* key_ids,
+                                                                        uint8_t nb_key_ids, uint32_t devaddr,
+                                                                        uint8_t dir, uint32_t fcnt,
+                                                                        uint32_t expected_mic, uint8_t* key_index,
+                                                                        uint8_t stack_id )
+{
+    if( mic_calls < LR1MAC_NUMBER_OF_RXC_SESSION )
+    {
+        mic_fcnt[mic_calls] = fcnt;
+    }
+    mic_calls++;
+    for( uint8_t i = 0; i < nb_key_ids; i++ )
+    {
+        if( fake_mic( key_ids[i], devaddr, fcnt ) == expected_mic )
+        {
+            *key_index = i;
+            return SMTC_MODEM_CRYPTO_RC_SUCCESS;
+        }
+    }
+    return SMTC_MODEM_CRYPTO_RC_FAIL_MIC;
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_payload_decrypt( const uint8_t* enc_buffer, uint16_t size,
+                                                                   smtc_se_key_identifier_t key_id, uint32_t address,
+                                                                   uint8_t dir, uint32_t frame_counter,
+                                                                   uint8_t* dec_buffer, uint8_t stack_id )
+{
+    return SMTC_MODEM_CRYPTO_RC_SUCCESS;
+}
+
+status_lorawan_t lr1mac_rx_payload_max_size_check( lr1_stack_mac_t* lr1_mac, uint8_t size, uint8_t rx_datarate )
+{
+    return OKLORAWAN;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+void lr1mac_session_journal_update( lr1_stack_mac_t* lr1_mac ) {}
+void lr1_stack_mac_rx_gfsk_launch_callback_for_rp( void* rp_void ) {}
+void lr1_stack_mac_rx_lora_launch_callback_for_rp( void* rp_void ) {}
+void rp_get_status( const radio_planner_t* rp, const uint8_t id, uint32_t* irq_timestamp_ms, rp_status_t* status )
+{
+    *irq_timestamp_ms = 0;
+    *status           = RP_STATUS_TASK_INIT;
+}
+rp_hook_status_t rp_hook_get_id( const radio_planner_t* rp, const void* hook, uint8_t* id ) { return RP_HOOK_STATUS_OK; }
+rp_hook_status_t rp_hook_init( radio_planner_t* rp, const uint8_t id, void ( *callback )( void* context ), void* hook )
+{
+    return RP_HOOK_STATUS_OK;
+}
+rp_hook_status_t rp_release_hook( radio_planner_t* rp, uint8_t id ) { return RP_HOOK_STATUS_OK; }
+rp_hook_status_t rp_task_abort( radio_planner_t* rp, const uint8_t id ) { return RP_HOOK_STATUS_OK; }
+rp_hook_status_t rp_task_enqueue( radio_planner_t* rp, const rp_task_t* task, uint8_t* payload, uint16_t payload_size,
+                                  const rp_radio_params_t* radio_params )
+{
+    return RP_HOOK_STATUS_OK;
+}
+uint32_t smtc_modem_hal_get_time_in_ms( void ) { return 0; }
+void smtc_real_fsk_dr_to_bitrate( smtc_real_t* real, uint8_t in_dr, uint8_t* out_bitrate ) { *out_bitrate = 50; }
+ral_lora_cr_t smtc_real_get_coding_rate( smtc_real_t* real ) { return RAL_LORA_CR_4_5; }
+uint8_t* smtc_real_get_gfsk_sync_word( smtc_real_t* real ) { return NULL; }
+uint8_t smtc_real_get_max_payload_size( smtc_real_t* real, uint8_t dr, uint32_t dwell_time ) { return 255; }
+modulation_type_t smtc_real_get_modulation_type_from_datarate( smtc_real_t* real, uint8_t datarate ) { return LORA; }
+uint8_t smtc_real_get_preamble_len( const smtc_real_t* real, uint8_t sf ) { return 8; }
+uint8_t smtc_real_get_sync_word( smtc_real_t* real ) { return 0x34; }
+status_lorawan_t smtc_real_is_frequency_valid( smtc_real_t* real, uint32_t frequency ) { return OKLORAWAN; }
+status_lorawan_t smtc_real_is_rx_dr_valid( smtc_real_t* real, uint8_t dr ) { return OKLORAWAN; }
+void smtc_real_lora_dr_to_sf_bw( smtc_real_t* real, uint8_t in_dr, uint8_t* out_sf, lr1mac_bandwidth_t* out_bw ) {}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define DEV_ADDR_UNICAST 0x26011111
+#define DEV_ADDR_SHARED 0x26022222
+
+static lr1_stack_mac_t           lr1_mac;
+static lr1mac_class_c_t          class_c;
+static lr1mac_rx_session_param_t multicast[LR1MAC_NUMBER_OF_RXC_SESSION - 1];
+
+static const smtc_se_key_identifier_t mc_nwk_skeys[] = { SMTC_SE_MC_NWK_S_KEY_0, SMTC_SE_MC_NWK_S_KEY_1,
+                                                         SMTC_SE_MC_NWK_S_KEY_2, SMTC_SE_MC_NWK_S_KEY_3 };
+static const smtc_se_key_identifier_t mc_app_skeys[] = { SMTC_SE_MC_APP_S_KEY_0, SMTC_SE_MC_APP_S_KEY_1,
+                                                         SMTC_SE_MC_APP_S_KEY_2, SMTC_SE_MC_APP_S_KEY_3 };
+
+static void setup( void )
+{
+    memset( &lr1_mac, 0, sizeof( lr1_mac ) );
+    memset( &class_c, 0, sizeof( class_c ) );
+    memset( multicast, 0, sizeof( multicast ) );
+
+    lr1_mac.join_status = JOINED;
+    lr1_mac.fcnt_dwn    = 0xFFFFFFFF;
+    class_c.lr1_mac     = &lr1_mac;
+
+    class_c.rx_session_param[RX_SESSION_UNICAST]  = &class_c.rx_session_param_unicast;
+    class_c.rx_session_param_unicast.enabled      = true;
+    class_c.rx_session_param_unicast.dev_addr     = DEV_ADDR_UNICAST;
+    class_c.rx_session_param_unicast.fcnt_dwn_max = 0xFFFFFFFF;
+    class_c.rx_session_param_unicast.nwk_skey     = SMTC_SE_NWK_S_ENC_KEY;
+    for( uint8_t i = 1; i < LR1MAC_NUMBER_OF_RXC_SESSION; i++ )
+    {
+        class_c.rx_session_param[i] = &multicast[i - 1];
+        multicast[i - 1].fcnt_dwn   = 0xFFFFFFFF;
+        multicast[i - 1].nwk_skey   = mc_nwk_skeys[i - 1];
+        multicast[i - 1].app_skey   = mc_app_skeys[i - 1];
+    }
+    mic_calls = 0;
+}
+
+static void group_enable( rx_session_type_t session, uint32_t dev_addr, uint32_t fcnt_dwn, uint32_t min, uint32_t max )
+{
+    class_c.rx_session_param[session]->enabled      = true;
+    class_c.rx_session_param[session]->dev_addr     = dev_addr;
+    class_c.rx_session_param[session]->fcnt_dwn     = fcnt_dwn;
+    class_c.rx_session_param[session]->fcnt_dwn_min = min;
+    class_c.rx_session_param[session]->fcnt_dwn_max = max;
+}
+
+/**
+ * Receive an unconfirmed downlink on fport 10 signed with key and the 32-bit frame counter fcnt
+ */
+static rx_packet_type_t receive( uint32_t dev_addr, uint32_t fcnt, smtc_se_key_identifier_t key )
+{
+    uint8_t* p = lr1_mac.rx_down_data.rx_payload;
+    uint8_t  n = 0;
+    uint32_t mic;
+
+    p[n++] = UNCONF_DATA_DOWN << 5;
+    p[n++] = dev_addr;
+    p[n++] = dev_addr >> 8;
+    p[n++] = dev_addr >> 16;
+    p[n++] = dev_addr >> 24;
+    p[n++] = 0;  // FCtrl
+    p[n++] = fcnt;
+    p[n++] = fcnt >> 8;
+    p[n++] = 10;  // FPort
+    p[n++] = 0xA5;
+    p[n++] = 0x5A;
+    mic    = fake_mic( key, dev_addr, fcnt );
+    memcpy( &p[n], &mic, 4 );
+    lr1_mac.rx_down_data.rx_payload_size = n + 4;
+
+    mic_calls = 0;
+    if( lr1mac_class_c_mac_downlink_check_under_it( &class_c ) != OKLORAWAN )
+    {
+        return NO_MORE_VALID_RX_PACKET;
+    }
+    return lr1mac_class_c_mac_rx_frame_decode( &class_c );
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies that a frame of the second group sharing a DevAddr is accepted although it is out of the counter window of
+ * the first group.
+ */
+void test_shared_dev_addr_disjoint_windows( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0xFFFFFFFF, 0, 99 );
+    group_enable( RX_SESSION_MULTICAST_G1, DEV_ADDR_SHARED, 999, 1000, 1999 );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 1005, SMTC_SE_MC_NWK_S_KEY_1 );
+    print_result( "test_shared_dev_addr_disjoint_windows",
+                  ( type == USER_RX_PACKET ) && ( class_c.rx_session_index == RX_SESSION_MULTICAST_G1 ) &&
+                      ( multicast[1].fcnt_dwn == 1005 ) && ( multicast[0].fcnt_dwn == 0xFFFFFFFF ) );
+}
+
+/**
+ * Verifies that the first group still receives its own frames.
+ */
+void test_shared_dev_addr_first_group( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0xFFFFFFFF, 0, 99 );
+    group_enable( RX_SESSION_MULTICAST_G1, DEV_ADDR_SHARED, 999, 1000, 1999 );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 10, SMTC_SE_MC_NWK_S_KEY_0 );
+    print_result( "test_shared_dev_addr_first_group", ( type == USER_RX_PACKET ) &&
+                                                          ( class_c.rx_session_index == RX_SESSION_MULTICAST_G0 ) &&
+                                                          ( multicast[0].fcnt_dwn == 10 ) &&
+                                                          ( multicast[1].fcnt_dwn == 999 ) && ( mic_calls == 1 ) );
+}
+
+/**
+ * Verifies that groups reaching different 32-bit frame counters are each verified with their own B0 counter.
+ */
+void test_shared_dev_addr_distinct_counters( )
+{
+    setup( );
+    // the same 16-bit counter 0x0040 is 0x00040 for G0 and 0x20040 for G2 after its roll-over
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0x00030, 0, 0xFFFFFFFF );
+    group_enable( RX_SESSION_MULTICAST_G2, DEV_ADDR_SHARED, 0x1FFF0, 0, 0xFFFFFFFF );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 0x20040, SMTC_SE_MC_NWK_S_KEY_2 );
+    print_result( "test_shared_dev_addr_distinct_counters",
+                  ( type == USER_RX_PACKET ) && ( class_c.rx_session_index == RX_SESSION_MULTICAST_G2 ) &&
+                      ( multicast[2].fcnt_dwn == 0x20040 ) && ( multicast[0].fcnt_dwn == 0x00030 ) &&
+                      ( mic_calls == 2 ) && ( mic_fcnt[0] == 0x00040 ) && ( mic_fcnt[1] == 0x20040 ) );
+}
+
+/**
+ * Verifies that groups reaching the same frame counter are verified in a single call.
+ */
+void test_shared_dev_addr_same_counter( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 5, 0, 0xFFFFFFFF );
+    group_enable( RX_SESSION_MULTICAST_G1, DEV_ADDR_SHARED, 7, 0, 0xFFFFFFFF );
+    group_enable( RX_SESSION_MULTICAST_G3, DEV_ADDR_SHARED, 2, 0, 0xFFFFFFFF );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 8, SMTC_SE_MC_NWK_S_KEY_3 );
+    print_result( "test_shared_dev_addr_same_counter", ( type == USER_RX_PACKET ) &&
+                                                           ( class_c.rx_session_index == RX_SESSION_MULTICAST_G3 ) &&
+                                                           ( multicast[3].fcnt_dwn == 8 ) && ( mic_calls == 1 ) );
+}
+
+/**
+ * Verifies that a frame whose MIC matches no group is dropped without updating any counter.
+ */
+void test_shared_dev_addr_bad_mic( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0xFFFFFFFF, 0, 99 );
+    group_enable( RX_SESSION_MULTICAST_G1, DEV_ADDR_SHARED, 999, 1000, 1999 );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 1005, SMTC_SE_MC_NWK_S_KEY_3 );
+    print_result( "test_shared_dev_addr_bad_mic", ( type == NO_MORE_VALID_RX_PACKET ) &&
+                                                      ( multicast[0].fcnt_dwn == 0xFFFFFFFF ) &&
+                                                      ( multicast[1].fcnt_dwn == 999 ) );
+}
+
+/**
+ * Verifies that a frame out of the counter window of every group is dropped before any MIC computation.
+ */
+void test_shared_dev_addr_out_of_windows( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0xFFFFFFFF, 0, 99 );
+    group_enable( RX_SESSION_MULTICAST_G1, DEV_ADDR_SHARED, 999, 1000, 1999 );
+
+    rx_packet_type_t type = receive( DEV_ADDR_SHARED, 500, SMTC_SE_MC_NWK_S_KEY_0 );
+    print_result( "test_shared_dev_addr_out_of_windows", ( type == NO_MORE_VALID_RX_PACKET ) && ( mic_calls == 0 ) );
+}
+
+/**
+ * Verifies that a replayed multicast frame is dropped.
+ */
+void test_multicast_replay( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_SHARED, 0xFFFFFFFF, 0, 0xFFFFFFFF );
+
+    rx_packet_type_t first  = receive( DEV_ADDR_SHARED, 42, SMTC_SE_MC_NWK_S_KEY_0 );
+    rx_packet_type_t replay = receive( DEV_ADDR_SHARED, 42, SMTC_SE_MC_NWK_S_KEY_0 );
+    print_result( "test_multicast_replay", ( first == USER_RX_PACKET ) && ( replay == NO_MORE_VALID_RX_PACKET ) );
+}
+
+/**
+ * Verifies that the unicast session is never verified with a multicast key.
+ */
+void test_unicast_not_shared( )
+{
+    setup( );
+    group_enable( RX_SESSION_MULTICAST_G0, DEV_ADDR_UNICAST, 0xFFFFFFFF, 0, 0xFFFFFFFF );
+
+    rx_packet_type_t mc_key = receive( DEV_ADDR_UNICAST, 3, SMTC_SE_MC_NWK_S_KEY_0 );
+    rx_packet_type_t uc_key = receive( DEV_ADDR_UNICAST, 4, SMTC_SE_NWK_S_ENC_KEY );
+    print_result( "test_unicast_not_shared", ( mc_key == NO_MORE_VALID_RX_PACKET ) && ( uc_key == USER_RX_PACKET ) &&
+                                                 ( class_c.rx_session_index == RX_SESSION_UNICAST ) &&
+                                                 ( lr1_mac.fcnt_dwn == 4 ) );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_shared_dev_addr_disjoint_windows( );
+    test_shared_dev_addr_first_group( );
+    test_shared_dev_addr_distinct_counters( );
+    test_shared_dev_addr_same_counter( );
+    test_shared_dev_addr_bad_mic( );
+    test_shared_dev_addr_out_of_windows( );
+    test_multicast_replay( );
+    test_unicast_not_shared( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
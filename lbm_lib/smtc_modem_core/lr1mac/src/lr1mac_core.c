@@ -41,6 +41,7 @@
 
 #include "smtc_modem_hal_dbg_trace.h"
 #include "lr1mac_utilities.h"
+#include "modem_context_cache.h"
 #include "smtc_modem_hal.h"
 #include "smtc_real.h"
 #include "smtc_real_defs.h"
@@ -51,6 +52,10 @@
 #if defined( ADD_RELAY_TX )
 #include "relay_tx_api.h"
 #endif
+
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+#include "lr1mac_session_journal.h"
+#endif
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE MACROS-----------------------------------------------------------
@@ -87,6 +92,12 @@ static const char* smtc_name_lr_fhss_cr[] = { "CR 5/6", "CR 2/3", "CR 1/2", "CR
  *-----------------------------------------------------------------------------------
  *--- PRIVATE VARIABLES -------------------------------------------------------------
  */
+
+// LoRaWAN contexts of all the stacks, written through as they hold the nonces
+static uint8_t               lr1mac_nvm_ctx_shadow[NUMBER_OF_STACKS * sizeof( lr1_mac_nvm_context_t )];
+static modem_context_cache_t lr1mac_nvm_ctx_cache =
+    MODEM_CONTEXT_CACHE_INIT( CONTEXT_LORAWAN_STACK, lr1mac_nvm_ctx_shadow, 0 );
+
 /*
  *-----------------------------------------------------------------------------------
  *--- PRIVATE FUNCTIONS DECLARATION -------------------------------------------------
@@ -529,6 +540,18 @@ status_lorawan_t lr1mac_core_join( lr1_stack_mac_t* lr1_mac_obj, uint32_t target
     return OKLORAWAN;
 }
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+status_lorawan_t lr1mac_core_session_restore( lr1_stack_mac_t* lr1_mac_obj )
+{
+    if( ( lr1_mac_obj->lr1mac_state != LWPSTATE_IDLE ) || ( lr1_mac_obj->join_status != NOT_JOINED ) ||
+        ( lr1_mac_obj->activation_mode != ACTIVATION_MODE_OTAA ) )
+    {
+        return ERRORLORAWAN;
+    }
+    return lr1mac_session_journal_restore( lr1_mac_obj );
+}
+#endif
+
 /**************************************************/
 /*          LoraWan  IsJoined  Method             */
 /**************************************************/
@@ -542,6 +565,12 @@ join_status_t lr1_mac_joined_status_get( lr1_stack_mac_t* lr1_mac_obj )
 /**************************************************/
 void lr1mac_core_join_status_clear( lr1_stack_mac_t* lr1_mac_obj )
 {
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+    if( lr1_mac_obj->join_status == JOINED )
+    {
+        lr1mac_session_journal_close( lr1_mac_obj );
+    }
+#endif
     lr1_mac_obj->join_status = NOT_JOINED;
     lr1mac_core_abort( lr1_mac_obj );
     smtc_real_init_join_snapshot_channel_mask( lr1_mac_obj->real );
@@ -790,8 +819,8 @@ void lr1mac_core_context_save( lr1_stack_mac_t* lr1_mac_obj )
 {
     lr1_mac_nvm_context_t ctx = { 0 };
 
-    smtc_modem_hal_context_restore( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
-                                    sizeof( ctx ) );
+    modem_context_cache_restore( &lr1mac_nvm_ctx_cache, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
+                                 sizeof( ctx ) );
 
     if( ( ctx.devnonce != lr1_mac_obj->dev_nonce ) ||
         ( memcmp( ctx.join_nonce, lr1_mac_obj->join_nonce, sizeof( ctx.join_nonce ) ) != 0 ) ||
@@ -805,21 +834,16 @@ void lr1mac_core_context_save( lr1_stack_mac_t* lr1_mac_obj )
         ctx.region                = lr1_mac_obj->real->region_type;
         ctx.crc                   = lr1mac_utilities_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-        smtc_modem_hal_context_store( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
-                                      sizeof( ctx ) );
-
-        // dummy context reading to ensure context store is done before exiting the function
-        lr1_mac_nvm_context_t dummy_context = { 0 };
-        smtc_modem_hal_context_restore( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ),
-                                        ( uint8_t* ) &dummy_context, sizeof( dummy_context ) );
+        modem_context_cache_store( &lr1mac_nvm_ctx_cache, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
+                                   sizeof( ctx ) );
     }
 }
 
 status_lorawan_t lr1mac_core_context_load( lr1_stack_mac_t* lr1_mac_obj )
 {
     lr1_mac_nvm_context_t ctx = { 0 };
-    smtc_modem_hal_context_restore( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
-                                    sizeof( ctx ) );
+    modem_context_cache_restore( &lr1mac_nvm_ctx_cache, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
+                                 sizeof( ctx ) );
 
     if( lr1mac_utilities_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
     {
@@ -839,18 +863,16 @@ status_lorawan_t lr1mac_core_context_load( lr1_stack_mac_t* lr1_mac_obj )
 
 void lr1mac_core_context_factory_reset( lr1_stack_mac_t* lr1_mac_obj )
 {
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+    lr1mac_session_journal_close( lr1_mac_obj );
+#endif
     lr1_mac_nvm_context_t ctx = { 0 };
     ctx.ctx_version           = LORAWAN_NVM_CTX_VERSION;
     memset( ctx.join_nonce, 0xFF, sizeof( ctx.join_nonce ) );
     ctx.crc = lr1mac_utilities_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-    smtc_modem_hal_context_store( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
-                                  sizeof( ctx ) );
-
-    // dummy context reading to ensure context store is done before exiting the function
-    lr1_mac_nvm_context_t dummy_context = { 0 };
-    smtc_modem_hal_context_restore( CONTEXT_LORAWAN_STACK, lr1_mac_obj->stack_id * sizeof( ctx ),
-                                    ( uint8_t* ) &dummy_context, sizeof( dummy_context ) );
+    modem_context_cache_store( &lr1mac_nvm_ctx_cache, lr1_mac_obj->stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
+                               sizeof( ctx ) );
 }
 
 /**************************************************/
@@ -1255,6 +1277,10 @@ static void lr1mac_mac_update( lr1_stack_mac_t* lr1_mac_obj )
     if( lr1_mac_obj->valid_rx_packet == JOIN_ACCEPT_PACKET )
     {
         SMTC_MODEM_HAL_TRACE_PRINTF( " update join procedure\n" );
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+        // MIC has been removed, a CFList follows the 13 first bytes
+        bool is_join_cflist_present = ( lr1_mac_obj->rx_down_data.rx_payload_size > 13 );
+#endif
         if( lr1_stack_mac_join_accept( lr1_mac_obj ) == OKLORAWAN )
         {
             lr1_mac_obj->rx_down_data.rx_payload_size              = 0;
@@ -1269,6 +1295,9 @@ static void lr1mac_mac_update( lr1_stack_mac_t* lr1_mac_obj )
             smtc_real_set_dr_distribution( lr1_mac_obj->real, lr1_mac_obj->adr_mode_select_tmp,
                                            &lr1_mac_obj->nb_trans );
             lr1mac_core_context_save( lr1_mac_obj );
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+            lr1mac_session_journal_open( lr1_mac_obj, is_join_cflist_present );
+#endif
         }
         else
         {
@@ -1282,6 +1311,9 @@ static void lr1mac_mac_update( lr1_stack_mac_t* lr1_mac_obj )
     }
 
     lr1_stack_mac_update( lr1_mac_obj );
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+    lr1mac_session_journal_update( lr1_mac_obj );
+#endif
 
     /// If those MAC commands are not acked, set as not requested ///
     if( lr1_mac_obj->link_check_user_req == USER_MAC_REQ_SENT )
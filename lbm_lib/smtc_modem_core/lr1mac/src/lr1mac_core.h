@@ -84,6 +84,16 @@ void lr1mac_core_init( lr1_stack_mac_t* lr1_mac_obj, smtc_real_t* real,
  */
 status_lorawan_t lr1mac_core_join( lr1_stack_mac_t* lr1_mac_obj, uint32_t target_time_ms );
 
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+/**
+ * @brief Resume the OTAA session recorded in the session journal instead of joining
+ *
+ * @param lr1_mac_obj
+ * @return status_lorawan_t OKLORAWAN if the device is joined with the restored session
+ */
+status_lorawan_t lr1mac_core_session_restore( lr1_stack_mac_t* lr1_mac_obj );
+#endif
+
 /**
  * @brief Reset the join status to NotJoined
  *
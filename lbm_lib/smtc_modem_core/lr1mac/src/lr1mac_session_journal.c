@@ -0,0 +1,408 @@
+/*!
+ * \file      lr1mac_session_journal.c
+ *
+ * \brief     Wear-leveled journal of the LoRaWAN session, restored after a reset
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2025. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+
+#include <string.h>
+
+#include "lr1mac_session_journal.h"
+#include "circularfs.h"
+#include "modem_crc.h"
+#include "smtc_modem_crypto.h"
+#include "smtc_secure_element.h"
+#include "smtc_modem_hal.h"
+#include "smtc_modem_hal_dbg_trace.h"
+#include "smtc_real.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE MACROS-----------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE CONSTANTS -------------------------------------------------------
+ */
+
+/**
+ * @brief Version of the journal entries, to be incremented when lr1mac_session_journal_entry_t changes
+ */
+#define SESSION_JOURNAL_VERSION 1
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE TYPES -----------------------------------------------------------
+ */
+
+/**
+ * @brief Session of one stack, as recorded in the journal
+ *
+ * @remark The session keys are never recorded, they are derived again from the root keys at restore
+ */
+typedef struct lr1mac_session_journal_session_s
+{
+    uint8_t  deveui[SMTC_SE_EUI_SIZE];
+    uint8_t  joineui[SMTC_SE_EUI_SIZE];
+    uint32_t dev_addr;
+    uint32_t fcnt_up_reserved;  // first uplink frame counter not covered by the journal
+    uint32_t fcnt_dwn;
+    uint32_t rx2_frequency;
+    uint32_t join_tx_frequency;
+    uint8_t  cf_list[16];
+    uint8_t  join_nonce[6];
+    uint16_t dev_nonce;
+    uint8_t  rx1_delay_s;
+    uint8_t  rx1_dr_offset;
+    uint8_t  rx2_data_rate;
+    uint8_t  join_tx_data_rate;
+    uint8_t  region;
+    uint8_t  is_open;
+    uint8_t  is_cflist_present;
+    uint8_t  rfu;
+} lr1mac_session_journal_session_t;
+
+/**
+ * @brief Journal entry, the sessions of all the stacks are written together so the newest entry is always complete
+ */
+typedef struct lr1mac_session_journal_entry_s
+{
+    lr1mac_session_journal_session_t session[NUMBER_OF_STACKS];
+    uint32_t                         crc;
+} lr1mac_session_journal_entry_t;
+
+/**
+ * @brief Journal object
+ */
+typedef struct lr1mac_session_journal_s
+{
+    struct circularfs_flash_partition flash;
+    struct circularfs                 fs;
+    lr1mac_session_journal_entry_t    entry;  // copy of the newest entry
+    bool                              is_loaded;
+    bool                              is_active[NUMBER_OF_STACKS];  // the recorded session is the running one
+} lr1mac_session_journal_t;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE VARIABLES -------------------------------------------------------
+ */
+
+static lr1mac_session_journal_t session_journal;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
+ */
+
+/**
+ * @brief Scan the journal on first use and keep its newest valid entry in RAM
+ */
+static void session_journal_load( void );
+
+/**
+ * @brief Append the RAM entry to the journal
+ */
+static void session_journal_append( void );
+
+/**
+ * @brief Erase a flash page of the journal
+ *
+ * @param [in] flash   Flash partition
+ * @param [in] address Address of the page
+ * @return int32_t     0
+ */
+static int32_t op_sector_erase( struct circularfs_flash_partition* flash, uint32_t address );
+
+/**
+ * @brief Write data in the journal
+ *
+ * @param [in] flash   Flash partition
+ * @param [in] address Address of the data
+ * @param [in] data    Buffer containing the data
+ * @param [in] size    Buffer length
+ * @return int32_t     size
+ */
+static int32_t op_program( struct circularfs_flash_partition* flash, uint32_t address, const void* data,
+                           uint32_t size );
+
+/**
+ * @brief Read data from the journal
+ *
+ * @param [in] flash   Flash partition
+ * @param [in] address Address of the data
+ * @param [out] data   Buffer to fill
+ * @param [in] size    Buffer length
+ * @return int32_t     size
+ */
+static int32_t op_read( struct circularfs_flash_partition* flash, uint32_t address, void* data, uint32_t size );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
+ */
+
+void lr1mac_session_journal_open( lr1_stack_mac_t* lr1_mac, bool is_cflist_present )
+{
+    session_journal_load( );
+
+    lr1mac_session_journal_session_t* session = &session_journal.entry.session[lr1_mac->stack_id];
+
+    memset( session, 0, sizeof( lr1mac_session_journal_session_t ) );
+    smtc_secure_element_get_deveui( session->deveui, lr1_mac->stack_id );
+    smtc_secure_element_get_joineui( session->joineui, lr1_mac->stack_id );
+    session->dev_addr          = lr1_mac->dev_addr;
+    session->fcnt_up_reserved  = lr1_mac->fcnt_up + SESSION_JOURNAL_FCNT_UP_STEP;
+    session->fcnt_dwn          = lr1_mac->fcnt_dwn;
+    session->rx2_frequency     = lr1_mac->rx2_frequency;
+    session->join_tx_frequency = lr1_mac->tx_frequency;
+    memcpy( session->cf_list, lr1_mac->cf_list, sizeof( session->cf_list ) );
+    memcpy( session->join_nonce, lr1_mac->join_nonce, sizeof( session->join_nonce ) );
+    session->dev_nonce         = lr1_mac->dev_nonce;
+    session->rx1_delay_s       = lr1_mac->rx1_delay_s;
+    session->rx1_dr_offset     = lr1_mac->rx1_dr_offset;
+    session->rx2_data_rate     = lr1_mac->rx2_data_rate;
+    session->join_tx_data_rate = lr1_mac->tx_data_rate;
+    session->region            = lr1_mac->real->region_type;
+    session->is_open           = true;
+    session->is_cflist_present = is_cflist_present;
+
+    session_journal.is_active[lr1_mac->stack_id] = true;
+    session_journal_append( );
+}
+
+void lr1mac_session_journal_reserve( lr1_stack_mac_t* lr1_mac )
+{
+    if( session_journal.is_active[lr1_mac->stack_id] == false )
+    {
+        return;
+    }
+
+    lr1mac_session_journal_session_t* session = &session_journal.entry.session[lr1_mac->stack_id];
+
+    if( lr1_mac->fcnt_up >= session->fcnt_up_reserved )
+    {
+        session->fcnt_up_reserved = lr1_mac->fcnt_up + SESSION_JOURNAL_FCNT_UP_STEP;
+        session->fcnt_dwn         = lr1_mac->fcnt_dwn;
+        session_journal_append( );
+    }
+}
+
+void lr1mac_session_journal_update( lr1_stack_mac_t* lr1_mac )
+{
+    if( session_journal.is_active[lr1_mac->stack_id] == false )
+    {
+        return;
+    }
+
+    lr1mac_session_journal_session_t* session = &session_journal.entry.session[lr1_mac->stack_id];
+
+    // Every downlink frame counter is recorded: a counter restored from an older record would accept replayed frames
+    if( ( session->fcnt_dwn != lr1_mac->fcnt_dwn ) || ( session->rx2_frequency != lr1_mac->rx2_frequency ) ||
+        ( session->rx1_delay_s != lr1_mac->rx1_delay_s ) || ( session->rx1_dr_offset != lr1_mac->rx1_dr_offset ) ||
+        ( session->rx2_data_rate != lr1_mac->rx2_data_rate ) )
+    {
+        session->fcnt_dwn      = lr1_mac->fcnt_dwn;
+        session->rx2_frequency = lr1_mac->rx2_frequency;
+        session->rx1_delay_s   = lr1_mac->rx1_delay_s;
+        session->rx1_dr_offset = lr1_mac->rx1_dr_offset;
+        session->rx2_data_rate = lr1_mac->rx2_data_rate;
+        session_journal_append( );
+    }
+}
+
+void lr1mac_session_journal_close( lr1_stack_mac_t* lr1_mac )
+{
+    session_journal_load( );
+    session_journal.is_active[lr1_mac->stack_id] = false;
+
+    lr1mac_session_journal_session_t* session = &session_journal.entry.session[lr1_mac->stack_id];
+
+    if( session->is_open == true )
+    {
+        session->is_open = false;
+        session_journal_append( );
+    }
+}
+
+status_lorawan_t lr1mac_session_journal_restore( lr1_stack_mac_t* lr1_mac )
+{
+    session_journal_load( );
+
+    lr1mac_session_journal_session_t* session = &session_journal.entry.session[lr1_mac->stack_id];
+    uint8_t                           deveui[SMTC_SE_EUI_SIZE];
+    uint8_t                           joineui[SMTC_SE_EUI_SIZE];
+
+    smtc_secure_element_get_deveui( deveui, lr1_mac->stack_id );
+    smtc_secure_element_get_joineui( joineui, lr1_mac->stack_id );
+
+    // The session shall come from the last join of this device, as recorded in the LoRaWAN context
+    if( ( session->is_open == false ) || ( memcmp( session->deveui, deveui, sizeof( deveui ) ) != 0 ) ||
+        ( memcmp( session->joineui, joineui, sizeof( joineui ) ) != 0 ) ||
+        ( session->region != lr1_mac->real->region_type ) || ( session->dev_nonce != lr1_mac->dev_nonce ) ||
+        ( memcmp( session->join_nonce, lr1_mac->join_nonce, sizeof( session->join_nonce ) ) != 0 ) )
+    {
+        SMTC_MODEM_HAL_TRACE_PRINTF( "No session to restore\n" );
+        return ERRORLORAWAN;
+    }
+
+    if( smtc_modem_crypto_derive_skeys( &session->join_nonce[0], &session->join_nonce[3], session->dev_nonce,
+                                        lr1_mac->stack_id ) != SMTC_MODEM_CRYPTO_RC_SUCCESS )
+    {
+        SMTC_MODEM_HAL_TRACE_WARNING( "Session keys derivation failed\n" );
+        return ERRORLORAWAN;
+    }
+
+    lr1_stack_mac_region_config( lr1_mac );
+    lr1_stack_mac_session_init( lr1_mac );
+    smtc_real_config_session( lr1_mac->real );
+
+    bool is_valid_join_cflist = false;
+    if( session->is_cflist_present == true )
+    {
+        memcpy( lr1_mac->cf_list, session->cf_list, sizeof( lr1_mac->cf_list ) );
+        is_valid_join_cflist = ( smtc_real_update_cflist( lr1_mac->real, lr1_mac->cf_list ) == OKLORAWAN );
+    }
+    if( is_valid_join_cflist == false )
+    {
+        smtc_real_init_after_join_snapshot_channel_mask( lr1_mac->real, session->join_tx_data_rate,
+                                                         session->join_tx_frequency );
+    }
+
+    lr1_mac->dev_addr      = session->dev_addr;
+    lr1_mac->fcnt_up       = session->fcnt_up_reserved;
+    lr1_mac->fcnt_dwn      = session->fcnt_dwn;
+    lr1_mac->rx2_frequency = session->rx2_frequency;
+    lr1_mac->rx1_delay_s   = session->rx1_delay_s;
+    lr1_mac->rx1_dr_offset = session->rx1_dr_offset;
+    lr1_mac->rx2_data_rate = session->rx2_data_rate;
+    lr1_mac->join_status   = JOINED;
+
+    // Same datarate as after a join accept: the first uplink is sent with the join datarate
+    lr1_mac->tx_data_rate_adr = session->join_tx_data_rate;
+    smtc_real_set_dr_distribution( lr1_mac->real, lr1_mac->adr_mode_select, &lr1_mac->nb_trans );
+
+    SMTC_MODEM_HAL_TRACE_PRINTF( "Session restored DevAddr= %x FCntUp= %u FCntDown= %u\n", lr1_mac->dev_addr,
+                                 lr1_mac->fcnt_up, lr1_mac->fcnt_dwn );
+
+    // The counters up to fcnt_up_reserved may have been used before the reset, reserve the next ones
+    session_journal.is_active[lr1_mac->stack_id] = true;
+    lr1mac_session_journal_reserve( lr1_mac );
+    return OKLORAWAN;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
+ */
+
+static void session_journal_load( void )
+{
+    if( session_journal.is_loaded == true )
+    {
+        return;
+    }
+
+    session_journal.flash.sector_size   = smtc_modem_hal_flash_get_page_size( );
+    session_journal.flash.sector_offset = 0;
+    session_journal.flash.sector_count  = smtc_modem_hal_session_journal_get_number_of_pages( );
+    session_journal.flash.sector_erase  = op_sector_erase;
+    session_journal.flash.program       = op_program;
+    session_journal.flash.read          = op_read;
+
+    memset( &session_journal.entry, 0, sizeof( session_journal.entry ) );
+    session_journal.is_loaded = true;
+
+    if( session_journal.flash.sector_count < 3 )
+    {
+        SMTC_MODEM_HAL_PANIC( "Session journal needs at least 3 flash pages\n" );
+    }
+    circularfs_init( &session_journal.fs, &session_journal.flash, SESSION_JOURNAL_VERSION,
+                     sizeof( lr1mac_session_journal_entry_t ) );
+
+    if( circularfs_scan( &session_journal.fs ) != 0 )
+    {
+        SMTC_MODEM_HAL_TRACE_PRINTF( "Session journal # no valid journal found, formatting.\n" );
+        circularfs_format( &session_journal.fs, true );
+        return;
+    }
+
+    // Entries are fetched oldest first, the last valid one is the current state
+    lr1mac_session_journal_entry_t entry;
+    circularfs_rewind( &session_journal.fs );
+    while( circularfs_fetch( &session_journal.fs, &entry ) == 0 )
+    {
+        if( modem_crc32( ( uint8_t* ) &entry, sizeof( entry ) - sizeof( entry.crc ) ) == entry.crc )
+        {
+            memcpy( &session_journal.entry, &entry, sizeof( entry ) );
+        }
+    }
+    circularfs_rewind( &session_journal.fs );
+}
+
+static void session_journal_append( void )
+{
+    session_journal.entry.crc = modem_crc32( ( uint8_t* ) &session_journal.entry,
+                                             sizeof( session_journal.entry ) - sizeof( session_journal.entry.crc ) );
+
+    if( circularfs_append( &session_journal.fs, &session_journal.entry ) != 0 )
+    {
+        SMTC_MODEM_HAL_TRACE_WARNING( "Session journal # append failed\n" );
+    }
+}
+
+static int32_t op_sector_erase( struct circularfs_flash_partition* flash, uint32_t address )
+{
+    ( void ) flash;
+    smtc_modem_hal_context_flash_pages_erase( CONTEXT_SESSION_JOURNAL, address, 1 );
+    return 0;
+}
+
+static int32_t op_program( struct circularfs_flash_partition* flash, uint32_t address, const void* data, uint32_t size )
+{
+    ( void ) flash;
+    smtc_modem_hal_context_store( CONTEXT_SESSION_JOURNAL, address, data, size );
+    return size;
+}
+
+static int32_t op_read( struct circularfs_flash_partition* flash, uint32_t address, void* data, uint32_t size )
+{
+    ( void ) flash;
+    smtc_modem_hal_context_restore( CONTEXT_SESSION_JOURNAL, address, data, size );
+    return size;
+}
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -0,0 +1,129 @@
+/*!
+ * \file      lr1mac_session_journal.h
+ *
+ * \brief     Wear-leveled journal of the LoRaWAN session, restored after a reset
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2025. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LR1MAC_SESSION_JOURNAL_H__
+#define __LR1MAC_SESSION_JOURNAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ *-----------------------------------------------------------------------------------
+ * --- DEPENDENCIES -----------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "lr1_stack_mac_layer.h"
+
+/*
+ *-----------------------------------------------------------------------------------
+ * --- PUBLIC MACROS ----------------------------------------------------------------
+ */
+
+/*
+ *-----------------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS -------------------------------------------------------------
+ */
+
+/**
+ * @brief Number of uplink frame counters reserved by each journal record
+ *
+ * @remark The uplink frame counter is written only once every SESSION_JOURNAL_FCNT_UP_STEP uplinks. After a reset the
+ * session resumes at the end of the reserved range, thus up to SESSION_JOURNAL_FCNT_UP_STEP counters can be skipped.
+ * The downlink frame counter is written after each accepted unicast downlink, so no downlink can be replayed after a
+ * reset.
+ */
+#ifndef SESSION_JOURNAL_FCNT_UP_STEP
+#define SESSION_JOURNAL_FCNT_UP_STEP 32
+#endif
+
+/*
+ *-----------------------------------------------------------------------------------
+ * --- PUBLIC TYPES -----------------------------------------------------------------
+ */
+
+/*
+ *-----------------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS PROTOTYPES --------------------------------------------------
+ */
+
+/**
+ * @brief Record the session opened by a join accept
+ *
+ * @param [in] lr1_mac           The lr1mac object
+ * @param [in] is_cflist_present The join accept carried a CFList, kept in lr1_mac->cf_list
+ */
+void lr1mac_session_journal_open( lr1_stack_mac_t* lr1_mac, bool is_cflist_present );
+
+/**
+ * @brief Reserve a new range of uplink frame counters when the current one is used, to be called before building an
+ * uplink frame
+ *
+ * @param [in] lr1_mac The lr1mac object
+ */
+void lr1mac_session_journal_reserve( lr1_stack_mac_t* lr1_mac );
+
+/**
+ * @brief Record the downlink frame counter and the Rx parameters when they changed, to be called after each accepted
+ * downlink (class A, B or C)
+ *
+ * @param [in] lr1_mac The lr1mac object
+ */
+void lr1mac_session_journal_update( lr1_stack_mac_t* lr1_mac );
+
+/**
+ * @brief Record the end of the session (leave network or factory reset)
+ *
+ * @param [in] lr1_mac The lr1mac object
+ */
+void lr1mac_session_journal_close( lr1_stack_mac_t* lr1_mac );
+
+/**
+ * @brief Resume the last session recorded in the journal
+ *
+ * @remark The session is resumed only if it has not been closed and if it belongs to the last join of the stack with
+ * the current DevEUI, JoinEUI and region. The session keys are derived again from the root keys.
+ *
+ * @param [in] lr1_mac The lr1mac object
+ * @return status_lorawan_t OKLORAWAN if the session has been resumed, ERRORLORAWAN otherwise
+ */
+status_lorawan_t lr1mac_session_journal_restore( lr1_stack_mac_t* lr1_mac );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __LR1MAC_SESSION_JOURNAL_H__
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -39,26 +39,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>  // for memset
 
 #include "lr1mac_utilities.h"
 #include "lr1mac_defs.h"
+#include "modem_crc.h"
 
 #include "smtc_modem_hal.h"
 #include "smtc_modem_hal_dbg_trace.h"
 
 uint32_t lr1mac_utilities_crc( uint8_t* buf, int len )
 {
-    uint32_t crc = 0xFFFFFFFA;
-    while( len-- > 0 )
-    {
-        crc = crc ^ *buf++;
-        for( int i = 0; i < 8; i++ )
-        {
-            uint32_t mask = -( crc & 1 );
-            crc           = ( crc >> 1 ) ^ ( 0xEDB88320 & mask );
-        }
-    }
-    return ~crc + 3;
+    // Seed and offset differ from the standard CRC-32, kept for the contexts already stored
+    return modem_crc32_final( modem_crc32_update( 0xFFFFFFFA, buf, len ) ) + 3;
 }
 
 uint32_t lr1mac_utilities_get_symb_time_us( const uint16_t nb_symb, const ral_lora_sf_t sf, const ral_lora_bw_t bw )
@@ -164,6 +157,76 @@ uint8_t SMTC_ARE_CLR_BYTE16( uint16_t* array, uint8_t length )
     return true;
 }
 
+void lr1mac_utilities_build_dr_channel_mask( uint32_t* dr_channel_mask, uint8_t nb_dr,
+                                             const uint8_t*  channel_index_enabled,
+                                             const uint16_t* dr_bitfield_tx_channel, uint8_t nb_channel )
+{
+    uint8_t nb_words = SMTC_NB_WORD32( nb_channel );
+
+    memset( dr_channel_mask, 0, nb_dr * nb_words * sizeof( uint32_t ) );
+
+    for( uint8_t i = 0; i < nb_channel; i++ )
+    {
+        if( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED )
+        {
+            for( uint8_t dr = 0; dr < nb_dr; dr++ )
+            {
+                if( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], dr ) == 1 )
+                {
+                    dr_channel_mask[( dr * nb_words ) + ( i / 32 )] |= ( 1UL << ( i % 32 ) );
+                }
+            }
+        }
+    }
+}
+
+uint32_t lr1mac_utilities_get_word32_from_bit8( const uint8_t* array, uint8_t length, uint8_t word_idx )
+{
+    uint32_t word = 0;
+
+    for( uint8_t i = 0; i < 4; i++ )
+    {
+        uint8_t byte_idx = ( word_idx * 4 ) + i;
+        if( byte_idx < length )
+        {
+            word |= ( uint32_t ) array[byte_idx] << ( 8 * i );
+        }
+    }
+    return word;
+}
+
+uint8_t lr1mac_utilities_bit32_count( const uint32_t* array, uint8_t nb_words )
+{
+    uint8_t count = 0;
+
+    for( uint8_t i = 0; i < nb_words; i++ )
+    {
+        count += __builtin_popcount( array[i] );
+    }
+    return count;
+}
+
+uint8_t lr1mac_utilities_bit32_get_nth( const uint32_t* array, uint8_t nb_words, uint8_t n )
+{
+    for( uint8_t i = 0; i < nb_words; i++ )
+    {
+        uint32_t word  = array[i];
+        uint8_t  count = __builtin_popcount( word );
+
+        if( n < count )
+        {
+            // Clear the n lowest bits set, the nth bit set is then the lowest one
+            while( n-- > 0 )
+            {
+                word &= word - 1;
+            }
+            return ( i * 32 ) + __builtin_ctz( word );
+        }
+        n -= count;
+    }
+    return 0xFF;
+}
+
 status_lorawan_t lr1mac_rx_payload_min_size_check( uint8_t rx_payload_size )
 {
     status_lorawan_t status = OKLORAWAN;
@@ -99,6 +99,11 @@ void    SMTC_SET_BIT16( uint16_t* array, uint8_t index );
 void    SMTC_CLR_BIT16( uint16_t* array, uint8_t index );
 void    SMTC_PUT_BIT16( uint16_t* array, uint8_t index, uint8_t bit );
 uint8_t SMTC_ARE_CLR_BYTE16( uint16_t* array, uint8_t length );
+
+/*!
+ * \brief Number of 32-bit words needed to store a bit array of nb_bits bits
+ */
+#define SMTC_NB_WORD32( nb_bits ) ( ( ( nb_bits ) + 31 ) / 32 )
 /*
  *-----------------------------------------------------------------------------------
  *--- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------------
@@ -117,6 +122,48 @@ uint32_t lr1mac_utilities_crc( uint8_t* buf, int len );
  */
 uint32_t lr1mac_utilities_get_symb_time_us( const uint16_t nb_symb, const ral_lora_sf_t sf, const ral_lora_bw_t bw );
 
+/*!
+ * \brief Build, for each datarate, the bit array of the enabled tx channels that support this datarate
+ *
+ * \param [out] dr_channel_mask        dr_channel_mask[dr * nb_words + word], SMTC_NB_WORD32( nb_channel ) words by dr
+ * \param [in]  nb_dr                  Number of datarates stored in dr_channel_mask
+ * \param [in]  channel_index_enabled  Enabled channels bit array (8-bit words)
+ * \param [in]  dr_bitfield_tx_channel Datarates supported by each channel
+ * \param [in]  nb_channel             Number of tx channels
+ */
+void lr1mac_utilities_build_dr_channel_mask( uint32_t* dr_channel_mask, uint8_t nb_dr,
+                                             const uint8_t*  channel_index_enabled,
+                                             const uint16_t* dr_bitfield_tx_channel, uint8_t nb_channel );
+
+/*!
+ * \brief Get a 32-bit word of a bit array stored on 8-bit words
+ *
+ * \param [in] array    Bit array (8-bit words)
+ * \param [in] length   Number of 8-bit words in array
+ * \param [in] word_idx Index of the 32-bit word
+ * \return uint32_t     32-bit word, bits out of the array are cleared
+ */
+uint32_t lr1mac_utilities_get_word32_from_bit8( const uint8_t* array, uint8_t length, uint8_t word_idx );
+
+/*!
+ * \brief Count the bits set in a bit array stored on 32-bit words
+ *
+ * \param [in] array    Bit array
+ * \param [in] nb_words Number of 32-bit words in array
+ * \return uint8_t      Number of bits set
+ */
+uint8_t lr1mac_utilities_bit32_count( const uint32_t* array, uint8_t nb_words );
+
+/*!
+ * \brief Get the index of the nth bit set (starting from 0) in a bit array stored on 32-bit words
+ *
+ * \param [in] array    Bit array
+ * \param [in] nb_words Number of 32-bit words in array
+ * \param [in] n        Rank of the bit set
+ * \return uint8_t      Bit index, 0xFF if less than n + 1 bits are set
+ */
+uint8_t lr1mac_utilities_bit32_get_nth( const uint32_t* array, uint8_t nb_words, uint8_t n );
+
 /*!
  * \brief is valid Rx payload min size
  *
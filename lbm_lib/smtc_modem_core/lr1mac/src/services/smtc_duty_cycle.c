@@ -99,6 +99,36 @@ static bool smtc_duty_cycle_get_band( smtc_dtc_t* dtc_obj, uint32_t freq_hz, uin
  */
 static uint32_t smtc_duty_cycle_get_band_consumed_time_ms( smtc_dtc_t* dtc_obj, uint8_t band );
 
+/**
+ * @brief Get the time to wait until enough Time On Air is available on a band
+ *
+ * @remark The cumulated TOA expires index by index, the oldest first, the returned time is the end of the index
+ *         that releases enough TOA
+ *
+ * @param dtc_obj                   Contains the duty cycle context
+ * @param band                      Band requested
+ * @param rtc_time_now              Current time in milliseconds
+ * @param toa_ms                    Time On Air that shall be available
+ * @return uint32_t                 Return the time to wait, 0 if available now, UINT32_MAX if never available
+ */
+static uint32_t smtc_duty_cycle_band_get_free_time_ms( smtc_dtc_t* dtc_obj, uint8_t band, uint32_t rtc_time_now,
+                                                        uint32_t toa_ms );
+
+/**
+ * @brief Erase the TOA saved in an index and remove it from the band sum
+ *
+ * @param dtc_band                  Band context
+ * @param idx                       Index to erase
+ */
+static inline void smtc_duty_cycle_erase_index( smtc_dtc_band_t* dtc_band, uint8_t idx );
+
+/**
+ * @brief Erase all the TOA saved in a band
+ *
+ * @param dtc_band                  Band context
+ */
+static inline void smtc_duty_cycle_erase_band( smtc_dtc_band_t* dtc_band );
+
 /**
  * @brief Compute Index in array of TOA with the a given timestamp in millisecond
  *
@@ -229,7 +259,7 @@ void smtc_duty_cycle_sum( uint32_t freq_hz, uint32_t toa_ms )
     if( smtc_duty_cycle_time_diff( rtc_time_now, dtc_obj_ptr->bands[band].toa_timestamp_ms ) >= SMTC_DTC_PERIOD_MS )
     {
         // Erase band cumulated TOA
-        memset( dtc_obj_ptr->bands[band].toa_sum_ms, 0, sizeof( dtc_obj_ptr->bands[band].toa_sum_ms ) );
+        smtc_duty_cycle_erase_band( &dtc_obj_ptr->bands[band] );
     }
     else
     {
@@ -250,14 +280,18 @@ void smtc_duty_cycle_sum( uint32_t freq_hz, uint32_t toa_ms )
                 {
                     i = 0;
                 }
-                dtc_obj_ptr->bands[band].toa_sum_ms[i] = 0;
+                smtc_duty_cycle_erase_index( &dtc_obj_ptr->bands[band], i );
             }
         }
     }
     // Save the new TOA
+    smtc_duty_cycle_erase_index( &dtc_obj_ptr->bands[band], idx_new );
     dtc_obj_ptr->bands[band].toa_sum_ms[idx_new] = toa_ms;
     dtc_obj_ptr->bands[band].toa_timestamp_ms    = rtc_time_now;
     dtc_obj_ptr->bands[band].index_previous      = idx_new;
+
+    // Add the saved value (stored on 16 bits) to the band sum
+    dtc_obj_ptr->bands[band].toa_sum_total += dtc_obj_ptr->bands[band].toa_sum_ms[idx_new];
 }
 
 void smtc_duty_cycle_update( void )
@@ -283,13 +317,14 @@ void smtc_duty_cycle_update( void )
         if( smtc_duty_cycle_time_diff( rtc_time_now, dtc_obj_ptr->bands[band].toa_timestamp_ms ) >= SMTC_DTC_PERIOD_MS )
         {
             // Erase band cumulated TOA, it's been over 1h
-            memset( dtc_obj_ptr->bands[band].toa_sum_ms, 0, sizeof( dtc_obj_ptr->bands[band].toa_sum_ms ) );
+            smtc_duty_cycle_erase_band( &dtc_obj_ptr->bands[band] );
             dtc_obj_ptr->bands[band].toa_timestamp_ms = rtc_time_now;
             dtc_obj_ptr->bands[band].index_previous   = idx_new;
         }
-        else
+        else if( idx_new != idx_previous )
         {
-            // Erase obsolete data between last saved and the current
+            // Erase obsolete data between last saved and the current, then move the band to the current index so the
+            // next calls only erase the indexes expired in the meantime
             uint8_t i = idx_previous;
             while( i != idx_new )
             {
@@ -298,13 +333,10 @@ void smtc_duty_cycle_update( void )
                 {
                     i = 0;
                 }
-                // If equal do not erase the TOA
-                if( ( i != idx_new ) ||
-                    ( ( i == idx_new ) && ( timestamp_diff >= ( SMTC_DTC_SECONDS_BY_UNIT * 1000 ) ) ) )
-                {
-                    dtc_obj_ptr->bands[band].toa_sum_ms[i] = 0;
-                }
+                smtc_duty_cycle_erase_index( &dtc_obj_ptr->bands[band], i );
             }
+            dtc_obj_ptr->bands[band].toa_timestamp_ms = rtc_time_now;
+            dtc_obj_ptr->bands[band].index_previous   = idx_new;
         }
     }
 }
@@ -469,50 +501,16 @@ int32_t smtc_duty_cycle_get_next_free_time_ms( uint8_t number_of_tx_freq, uint32
     }
     else
     {
-        // All bands reached the max available TOA, search for the next nearest TOA available slot
+        // All bands reached the max available TOA, search when the first band will be free again
         uint32_t next_available_slot_ms_tmp = ~0;
         uint32_t rtc_time_now               = smtc_modem_hal_get_time_in_ms( );
 
         for( uint8_t j = 0; j < tmp_band_dtc_full_index; j++ )
         {
-            uint8_t band = tmp_band_dtc_full[j];
-
-            uint8_t idx_previous = dtc_obj_ptr->bands[band].index_previous;
-            // compute index by delta to manage rtc_ms wrapping
-            uint32_t timestamp_diff =
-                smtc_duty_cycle_time_diff( rtc_time_now, dtc_obj_ptr->bands[band].toa_timestamp_ms );
-            uint8_t idx_new = smtc_duty_cycle_compute_index( timestamp_diff, idx_previous );
-
-            // compute time between now and the end of this index
+            // A band is free as soon as at least 1ms is available
             uint32_t next_available_slot_ms =
-                ( SMTC_DTC_SECONDS_BY_UNIT * 1000UL ) - ( rtc_time_now % ( SMTC_DTC_SECONDS_BY_UNIT * 1000UL ) );
+                smtc_duty_cycle_band_get_free_time_ms( dtc_obj_ptr, tmp_band_dtc_full[j], rtc_time_now, 1 );
 
-            uint8_t idx_empty_counter = 0;
-
-            uint8_t i = idx_new;
-            do
-            {
-                i++;
-                if( i >= SMTC_DTC_TOA_BUFF_SIZE )
-                {
-                    i = 0;
-                }
-                if( dtc_obj_ptr->bands[band].toa_sum_ms[i] != 0 )
-                {
-                    break;
-                }
-                if( i != idx_previous )
-                {
-                    idx_empty_counter++;
-                }
-
-                if( idx_empty_counter > SMTC_DTC_TOA_BUFF_SIZE )
-                {
-                    SMTC_MODEM_HAL_PANIC( );
-                }
-            } while( i != idx_previous );
-
-            next_available_slot_ms += idx_empty_counter * SMTC_DTC_SECONDS_BY_UNIT * 1000UL;
             if( next_available_slot_ms_tmp > next_available_slot_ms )
             {
                 next_available_slot_ms_tmp = next_available_slot_ms;
@@ -524,6 +522,33 @@ int32_t smtc_duty_cycle_get_next_free_time_ms( uint8_t number_of_tx_freq, uint32
     return ret;
 }
 
+int32_t smtc_duty_cycle_get_toa_free_time_ms( uint32_t freq_hz, uint32_t toa_ms )
+{
+    if( dtc_obj_ptr == NULL )
+    {
+        return 0;
+    }
+    if( ( dtc_obj_ptr->enabled != SMTC_DTC_ENABLED ) || ( dtc_obj_ptr->number_of_bands == 0 ) )
+    {
+        return 0;
+    }
+
+    uint8_t band;
+    if( smtc_duty_cycle_get_band( dtc_obj_ptr, freq_hz, &band ) == false )
+    {
+        return 0;
+    }
+
+    uint32_t free_time_ms =
+        smtc_duty_cycle_band_get_free_time_ms( dtc_obj_ptr, band, smtc_modem_hal_get_time_in_ms( ), toa_ms );
+
+    if( free_time_ms == UINT32_MAX )
+    {
+        return -1;
+    }
+    return ( int32_t ) free_time_ms;
+}
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
@@ -544,15 +569,62 @@ static bool smtc_duty_cycle_get_band( smtc_dtc_t* dtc_obj, uint32_t freq_hz, uin
 
 static uint32_t smtc_duty_cycle_get_band_consumed_time_ms( smtc_dtc_t* dtc_obj, uint8_t band )
 {
-    uint32_t toa_ms = 0;
-    for( uint8_t i = 0; i < SMTC_DTC_TOA_BUFF_SIZE; i++ )
+    // Convert to the resolution
+    return dtc_obj->bands[band].toa_sum_total * smtc_dtc_resolution_ms;
+}
+
+static uint32_t smtc_duty_cycle_band_get_free_time_ms( smtc_dtc_t* dtc_obj, uint8_t band, uint32_t rtc_time_now,
+                                                        uint32_t toa_ms )
+{
+    smtc_dtc_band_t* dtc_band   = &dtc_obj->bands[band];
+    uint32_t         budget_ms  = SMTC_DTC_PERIOD_MS / dtc_band->duty_cycle_regulation;
+    uint32_t         consumed   = dtc_band->toa_sum_total * smtc_dtc_resolution_ms;
+    uint32_t         unit_ms    = SMTC_DTC_SECONDS_BY_UNIT * 1000UL;
+    uint32_t         end_idx_ms = unit_ms - ( rtc_time_now % unit_ms );
+
+    if( toa_ms > budget_ms )
     {
-        toa_ms += dtc_obj->bands[band].toa_sum_ms[i];
+        return UINT32_MAX;
+    }
+    if( consumed + toa_ms <= budget_ms )
+    {
+        return 0;
     }
 
-    // Convert to the resolution
-    toa_ms *= smtc_dtc_resolution_ms;
-    return toa_ms;
+    // compute index by delta to manage rtc_ms wrapping
+    uint32_t timestamp_diff = smtc_duty_cycle_time_diff( rtc_time_now, dtc_band->toa_timestamp_ms );
+    uint8_t  idx_new        = smtc_duty_cycle_compute_index( timestamp_diff, dtc_band->index_previous );
+
+    // The index following the current one is the oldest and expires at the end of the current index, the current index
+    // expires last
+    uint8_t i = idx_new;
+    for( uint8_t k = 0; k < SMTC_DTC_TOA_BUFF_SIZE; k++ )
+    {
+        i++;
+        if( i >= SMTC_DTC_TOA_BUFF_SIZE )
+        {
+            i = 0;
+        }
+        consumed -= dtc_band->toa_sum_ms[i] * smtc_dtc_resolution_ms;
+        if( consumed + toa_ms <= budget_ms )
+        {
+            return end_idx_ms + ( k * unit_ms );
+        }
+    }
+    // Not reachable, the whole band is expired after one period
+    return end_idx_ms + ( ( SMTC_DTC_TOA_BUFF_SIZE - 1 ) * unit_ms );
+}
+
+static inline void smtc_duty_cycle_erase_index( smtc_dtc_band_t* dtc_band, uint8_t idx )
+{
+    dtc_band->toa_sum_total -= dtc_band->toa_sum_ms[idx];
+    dtc_band->toa_sum_ms[idx] = 0;
+}
+
+static inline void smtc_duty_cycle_erase_band( smtc_dtc_band_t* dtc_band )
+{
+    memset( dtc_band->toa_sum_ms, 0, sizeof( dtc_band->toa_sum_ms ) );
+    dtc_band->toa_sum_total = 0;
 }
 
 static inline uint8_t smtc_duty_cycle_compute_index( uint32_t timestamp_ms, uint8_t idx_previous )
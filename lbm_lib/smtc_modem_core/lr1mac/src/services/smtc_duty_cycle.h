@@ -102,6 +102,7 @@ typedef struct smtc_dtc_band_s
     uint32_t toa_timestamp_ms;       // last access to the array when adding the TOA or reset all TOA
     uint8_t  index_previous;
     uint16_t toa_sum_ms[SMTC_DTC_TOA_BUFF_SIZE];  // Store all TOA by step of SMTC_DTC_SECONDS_BY_UNIT
+    uint32_t toa_sum_total;                       // Sum of toa_sum_ms, kept up to date when an index is written or erased
 } smtc_dtc_band_t;
 
 typedef struct smtc_dtc_s
@@ -230,6 +231,18 @@ bool smtc_duty_cycle_is_band_free( smtc_dtc_t* dtc_obj, uint8_t band );
  * @return int32_t                  milliseconds, if > 0: the next slot availble, else the available time
  */
 int32_t smtc_duty_cycle_get_next_free_time_ms( uint8_t number_of_tx_freq, uint32_t* tx_freq_list );
+
+/**
+ * @brief Get the time to wait before a Time On Air is accepted on a frequency
+ *
+ * @remark  smtc_duty_cycle_update() must be called before this function to have a right value
+ *
+ * @param freq_hz                   Frequency used for the packet
+ * @param toa_ms                    Packet Time On Air in milliseconds
+ * @return int32_t                  milliseconds, 0: accepted now, if > 0: time to wait, if < 0: never accepted on
+ *                                  this band (TOA greater than the band budget)
+ */
+int32_t smtc_duty_cycle_get_toa_free_time_ms( uint32_t freq_hz, uint32_t toa_ms );
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,24 @@ static smtc_lbt_t lbt_obj_declare[NUMBER_OF_STACKS];
 #define LBT_SNIFF_DURATION_MS_DEFAULT ( 5 )
 #define LBT_THRESHOLD_DBM_DEFAULT ( int16_t )( -80 )
 #define LBT_BW_HZ__DEFAULT ( 200000 )
+
+/**
+ * @brief Take one rssi sample of the channel under listen
+ *
+ * @param [in] rp pointer to the radio planner running the lbt task
+ * @return true if the sample is above the lbt threshold
+ */
+static bool smtc_lbt_sample_rssi( radio_planner_t* rp );
+
+#if defined( ADD_LBT_TIMER_SAMPLING )
+/**
+ * @brief Radio planner task alarm taking the rssi samples until the channel is found busy or the listen ends
+ *
+ * @param [in] rp_void pointer to the radio planner running the lbt task
+ */
+static void smtc_lbt_sample_callback_for_rp( void* rp_void );
+#endif
+
 void smtc_lbt_init( smtc_lbt_t* lbt_obj, radio_planner_t* rp, uint8_t lbt_id_rp,
                     void ( *free_callback )( void* free_context ), void*   free_context,
                     void ( *busy_callback )( void* busy_context ), void*   busy_context,
@@ -52,22 +70,24 @@ void smtc_lbt_init( smtc_lbt_t* lbt_obj, radio_planner_t* rp, uint8_t lbt_id_rp,
     {
         SMTC_MODEM_HAL_PANIC( "lbt bad init\n" );
     }
-    lbt_obj->rp                 = rp;
-    lbt_obj->lbt_id4rp          = lbt_id_rp;  //@none protection if this id already used by un other task
-    lbt_obj->free_callback      = free_callback;
-    lbt_obj->free_context       = free_context;
-    lbt_obj->busy_callback      = busy_callback;
-    lbt_obj->busy_context       = busy_context;
-    lbt_obj->abort_callback     = abort_callback;
-    lbt_obj->abort_context      = abort_context;
-    lbt_obj->rssi_inst          = 0;
-    lbt_obj->rssi_accu          = 0;
-    lbt_obj->rssi_nb_of_meas    = 0;
-    lbt_obj->is_at_time         = false;
-    lbt_obj->enabled            = false;
-    lbt_obj->listen_duration_ms = LBT_SNIFF_DURATION_MS_DEFAULT + LAP_OF_TIME_TO_GET_A_RSSI_VALID;
-    lbt_obj->threshold          = LBT_THRESHOLD_DBM_DEFAULT;
-    lbt_obj->bw_hz              = LBT_BW_HZ__DEFAULT;
+    lbt_obj->rp                     = rp;
+    lbt_obj->lbt_id4rp              = lbt_id_rp;  //@none protection if this id already used by un other task
+    lbt_obj->free_callback          = free_callback;
+    lbt_obj->free_context           = free_context;
+    lbt_obj->busy_callback          = busy_callback;
+    lbt_obj->busy_context           = busy_context;
+    lbt_obj->abort_callback         = abort_callback;
+    lbt_obj->abort_context          = abort_context;
+    lbt_obj->rssi_inst              = 0;
+    lbt_obj->rssi_accu              = 0;
+    lbt_obj->rssi_nb_of_meas        = 0;
+    lbt_obj->listen_rssi_accu       = 0;
+    lbt_obj->listen_rssi_nb_of_meas = 0;
+    lbt_obj->is_at_time             = false;
+    lbt_obj->enabled                = false;
+    lbt_obj->listen_duration_ms     = LBT_SNIFF_DURATION_MS_DEFAULT + LAP_OF_TIME_TO_GET_A_RSSI_VALID;
+    lbt_obj->threshold              = LBT_THRESHOLD_DBM_DEFAULT;
+    lbt_obj->bw_hz                  = LBT_BW_HZ__DEFAULT;
     rp_release_hook( rp, lbt_id_rp );
     rp_hook_init( rp, lbt_id_rp, ( void ( * )( void* ) )( smtc_lbt_rp_callback ), lbt_obj );
 }
@@ -104,7 +124,6 @@ void smtc_lbt_launch_callback_for_rp( void* rp_void )
 {
     radio_planner_t* rp = ( radio_planner_t* ) rp_void;
     uint8_t          id = rp->radio_task_id;
-    int16_t          rssi_tmp;
     smtc_modem_hal_start_radio_tcxo( );
     smtc_modem_hal_set_ant_switch( false );
     SMTC_MODEM_HAL_PANIC_ON_FAILURE( ral_set_pkt_type( &( rp->radio->ral ), rp->radio_params[id].pkt_type ) ==
@@ -117,6 +136,15 @@ void smtc_lbt_launch_callback_for_rp( void* rp_void )
     SMTC_MODEM_HAL_PANIC_ON_FAILURE( ral_set_rx( &( rp->radio->ral ), RAL_RX_TIMEOUT_CONTINUOUS_MODE ) ==
                                      RAL_STATUS_OK );
 
+    smtc_lbt_t* lbt_obj             = ( smtc_lbt_t* ) rp->hooks[id];
+    lbt_obj->listen_rssi_accu       = 0;
+    lbt_obj->listen_rssi_nb_of_meas = 0;
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    lbt_obj->carrier_sense_time_ms = smtc_modem_hal_get_time_in_ms( );
+    rp_stats_set_rx_timestamp( &rp->stats, lbt_obj->carrier_sense_time_ms + LAP_OF_TIME_TO_GET_A_RSSI_VALID );
+    // The radio stays in rx while the MCU is released, the planner waits for the samples to complete the task
+    rp_task_set_alarm( rp, LAP_OF_TIME_TO_GET_A_RSSI_VALID, smtc_lbt_sample_callback_for_rp );
+#else
     uint32_t carrier_sense_time = smtc_modem_hal_get_time_in_ms( );
     while( ( int32_t ) ( carrier_sense_time + LAP_OF_TIME_TO_GET_A_RSSI_VALID - smtc_modem_hal_get_time_in_ms( ) ) > 0 )
     {  // delay LAP_OF_TIME_TO_GET_A_RSSI_VALID ms
@@ -124,13 +152,8 @@ void smtc_lbt_launch_callback_for_rp( void* rp_void )
     rp_stats_set_rx_timestamp( &rp->stats, smtc_modem_hal_get_time_in_ms( ) );
     do
     {
-        SMTC_MODEM_HAL_PANIC_ON_FAILURE( ral_get_rssi_inst( &( rp->radio->ral ), &rssi_tmp ) == RAL_STATUS_OK );
-        ( ( smtc_lbt_t* ) rp->hooks[id] )->rssi_inst = rssi_tmp;
-        ( ( smtc_lbt_t* ) rp->hooks[id] )->rssi_accu += rssi_tmp;
-        ( ( smtc_lbt_t* ) rp->hooks[id] )->rssi_nb_of_meas++;
-        if( rssi_tmp >= rp->radio_params[id].lbt_threshold )
+        if( smtc_lbt_sample_rssi( rp ) == true )
         {
-            //   SMTC_MODEM_HAL_TRACE_PRINTF( "lbt rssi: %d dBm\n", rssi_tmp );
             rp->status[id] = RP_STATUS_LBT_BUSY_CHANNEL;
             rp_radio_irq_callback( rp_void );
             rp_callback( rp_void );
@@ -138,12 +161,61 @@ void smtc_lbt_launch_callback_for_rp( void* rp_void )
         }
     } while( ( int32_t ) ( carrier_sense_time + rp->radio_params[id].rx.timeout_in_ms -
                            smtc_modem_hal_get_time_in_ms( ) ) > 0 );
-    // SMTC_MODEM_HAL_TRACE_PRINTF( "lbt rssi: %d thre= %d dBm\n", rssi_tmp, rp->radio_params[id].lbt_threshold );
     rp->status[id] = RP_STATUS_LBT_FREE_CHANNEL;
     rp_radio_irq_callback( rp_void );
     rp_callback( rp_void );
+#endif
+}
+
+static bool smtc_lbt_sample_rssi( radio_planner_t* rp )
+{
+    uint8_t     id      = rp->radio_task_id;
+    smtc_lbt_t* lbt_obj = ( smtc_lbt_t* ) rp->hooks[id];
+    int16_t     rssi_tmp;
+
+    SMTC_MODEM_HAL_PANIC_ON_FAILURE( ral_get_rssi_inst( &( rp->radio->ral ), &rssi_tmp ) == RAL_STATUS_OK );
+    lbt_obj->rssi_inst = rssi_tmp;
+    lbt_obj->rssi_accu += rssi_tmp;
+    lbt_obj->rssi_nb_of_meas++;
+    lbt_obj->listen_rssi_accu += rssi_tmp;
+    if( lbt_obj->listen_rssi_nb_of_meas < UINT16_MAX )
+    {
+        lbt_obj->listen_rssi_nb_of_meas++;
+    }
+    // SMTC_MODEM_HAL_TRACE_PRINTF( "lbt rssi: %d thre= %d dBm\n", rssi_tmp, rp->radio_params[id].lbt_threshold );
+    return ( rssi_tmp >= rp->radio_params[id].lbt_threshold );
 }
 
+#if defined( ADD_LBT_TIMER_SAMPLING )
+static void smtc_lbt_sample_callback_for_rp( void* rp_void )
+{
+    radio_planner_t* rp      = ( radio_planner_t* ) rp_void;
+    uint8_t          id      = rp->radio_task_id;
+    smtc_lbt_t*      lbt_obj = ( smtc_lbt_t* ) rp->hooks[id];
+
+    if( smtc_lbt_sample_rssi( rp ) == true )
+    {
+        rp->status[id] = RP_STATUS_LBT_BUSY_CHANNEL;
+        rp_radio_irq_callback( rp_void );
+        return;
+    }
+
+    int32_t remaining_ms = ( int32_t ) ( lbt_obj->carrier_sense_time_ms + rp->radio_params[id].rx.timeout_in_ms -
+                                         smtc_modem_hal_get_time_in_ms( ) );
+    if( remaining_ms > 0 )
+    {
+        rp_task_set_alarm( rp, ( remaining_ms < LBT_SAMPLING_PERIOD_MS ) ? remaining_ms : LBT_SAMPLING_PERIOD_MS,
+                           smtc_lbt_sample_callback_for_rp );
+    }
+    else
+    {
+        // Completion is handled by the rp_callback that called this alarm
+        rp->status[id] = RP_STATUS_LBT_FREE_CHANNEL;
+        rp_radio_irq_callback( rp_void );
+    }
+}
+#endif
+
 void smtc_lbt_listen_channel( smtc_lbt_t* lbt_obj, uint32_t freq, bool is_at_time, uint32_t target_time_ms,
                               uint32_t tx_duration_ms )
 {
@@ -237,6 +309,16 @@ void smtc_lbt_rp_callback( smtc_lbt_t* lbt_obj )
     }
 }
 
+bool smtc_lbt_get_listen_rssi( smtc_lbt_t* lbt_obj, int16_t* rssi_dbm )
+{
+    if( lbt_obj->listen_rssi_nb_of_meas == 0 )
+    {
+        return false;
+    }
+    *rssi_dbm = ( int16_t ) ( lbt_obj->listen_rssi_accu / ( int32_t ) lbt_obj->listen_rssi_nb_of_meas );
+    return true;
+}
+
 smtc_lbt_t* smtc_lbt_get_obj( uint8_t stack_id )
 {
     if( stack_id < NUMBER_OF_STACKS )
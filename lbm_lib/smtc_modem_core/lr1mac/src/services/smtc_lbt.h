@@ -48,6 +48,11 @@ extern "C" {
  * ============================================================================
  */
 #define LAP_OF_TIME_TO_GET_A_RSSI_VALID 2  // duration to stabilize the radio after rx cmd in ms
+#if defined( ADD_LBT_TIMER_SAMPLING )
+#ifndef LBT_SAMPLING_PERIOD_MS
+#define LBT_SAMPLING_PERIOD_MS 1  // interval between two rssi samples in ms, the MCU can sleep in between
+#endif
+#endif
 typedef struct smtc_lbt_s
 {
     radio_planner_t* rp;
@@ -65,7 +70,12 @@ typedef struct smtc_lbt_s
     int16_t  rssi_inst;
     int32_t  rssi_accu;
     uint32_t rssi_nb_of_meas;
+    int32_t  listen_rssi_accu;        // rssi accumulated during the last listen
+    uint16_t listen_rssi_nb_of_meas;  // number of rssi measured during the last listen
     bool     enabled;
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    uint32_t carrier_sense_time_ms;
+#endif
     /* data */
 } smtc_lbt_t;
 
@@ -152,6 +162,15 @@ void smtc_lbt_rp_callback( smtc_lbt_t* lbt_obj );
  */
 void smtc_lbt_launch_callback_for_rp( void* rp_void );
 
+/**
+ * @brief Get the average rssi measured during the last listen
+ *
+ * @param [in]  lbt_obj  pointer to lbt_obj itself
+ * @param [out] rssi_dbm average rssi in dBm
+ * @return false if no rssi has been measured during the last listen
+ */
+bool smtc_lbt_get_listen_rssi( smtc_lbt_t* lbt_obj, int16_t* rssi_dbm );
+
 /**
  * @brief return the lbt obj pointer with stack id as parameter
  * task
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The band context is static: the module is built within the test
+#include "smtc_duty_cycle.c"
+
+// Previous implementation, see smtc_duty_cycle_ref.c
+void          ref_smtc_duty_cycle_init( void );
+void          ref_smtc_duty_cycle_config( uint8_t number_of_bands, uint8_t band_idx, uint16_t duty_cycle_regulation,
+                                          uint32_t freq_min, uint32_t freq_max );
+smtc_dtc_rc_t ref_smtc_duty_cycle_enable_set( smtc_dtc_enablement_type_t enable );
+void          ref_smtc_duty_cycle_sum( uint32_t freq_hz, uint32_t toa_ms );
+void          ref_smtc_duty_cycle_update( void );
+int32_t       ref_smtc_duty_cycle_band_get_available_toa_ms( smtc_dtc_t* dtc_obj, uint8_t band );
+bool          ref_smtc_duty_cycle_is_channel_free( uint32_t freq_hz );
+int32_t       ref_smtc_duty_cycle_get_next_free_time_ms( uint8_t number_of_tx_freq, uint32_t* tx_freq_list );
+smtc_dtc_t*   ref_smtc_duty_cycle_get_obj( void );
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static uint32_t now_ms;
+
+uint32_t smtc_modem_hal_get_time_in_ms( void )
+{
+    return now_ms;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define WEEK_MS ( 7UL * 24 * 3600 * 1000 )
+#define NB_FREQ 8
+
+// EU868 bands, as configured by the region
+static const uint16_t band_dtc[SMTC_DTC_BANDS_MAX]     = { 1000, 100, 100, 1000, 10, 100, 1000 };
+static const uint32_t band_freq[SMTC_DTC_BANDS_MAX][2] = {
+    { 863000000, 865000000 }, { 865000000, 868000001 }, { 868000001, 868600001 }, { 868700000, 869200001 },
+    { 869400000, 869650001 }, { 869700000, 870000001 }, { 863000000, 870000001 },
+};
+static uint32_t freqs[NB_FREQ] = { 868100000, 868300000, 868500000, 867100000,
+                                   867300000, 869525000, 864100000, 869800000 };
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static void setup( uint32_t start_ms )
+{
+    now_ms = start_ms;
+    smtc_duty_cycle_init( );
+    ref_smtc_duty_cycle_init( );
+    for( uint8_t b = 0; b < SMTC_DTC_BANDS_MAX; b++ )
+    {
+        smtc_duty_cycle_config( SMTC_DTC_BANDS_MAX, b, band_dtc[b], band_freq[b][0], band_freq[b][1] );
+        ref_smtc_duty_cycle_config( SMTC_DTC_BANDS_MAX, b, band_dtc[b], band_freq[b][0], band_freq[b][1] );
+    }
+    smtc_duty_cycle_enable_set( SMTC_DTC_ENABLED );
+    ref_smtc_duty_cycle_enable_set( SMTC_DTC_ENABLED );
+}
+
+static bool running_sum_is_ok( void )
+{
+    for( uint8_t b = 0; b < SMTC_DTC_BANDS_MAX; b++ )
+    {
+        uint32_t sum = 0;
+        for( uint8_t i = 0; i < SMTC_DTC_TOA_BUFF_SIZE; i++ )
+        {
+            sum += dtc_obj_ptr->bands[b].toa_sum_ms[i];
+        }
+        if( sum != dtc_obj_ptr->bands[b].toa_sum_total )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The band is still full 1 ms before the returned free time, and free at it
+ */
+static bool free_time_is_exact( uint8_t nb_freq, uint32_t* freq_list, int32_t free_time_ms )
+{
+    // The bands are updated by the lookup, they are restored to go back in time
+    smtc_dtc_t save_obj = *dtc_obj_ptr;
+    uint32_t   save_ms  = now_ms;
+    bool       ok;
+
+    now_ms       = save_ms + free_time_ms - 1;
+    ok           = smtc_duty_cycle_get_next_free_time_ms( nb_freq, freq_list ) > 0;
+    *dtc_obj_ptr = save_obj;
+    now_ms       = save_ms + free_time_ms;
+    ok           = ok && ( smtc_duty_cycle_get_next_free_time_ms( nb_freq, freq_list ) <= 0 );
+    *dtc_obj_ptr = save_obj;
+    now_ms       = save_ms;
+    return ok;
+}
+
+typedef struct replay_stat_s
+{
+    uint32_t steps;
+    uint32_t same;   // both implementations return the same free time
+    uint32_t later;  // the previous implementation woke up before the band was free
+    uint32_t errors;
+} replay_stat_t;
+
+/**
+ * Replay a week of uplinks with changing traffic patterns on both implementations
+ */
+static void replay_week( uint32_t seed, uint32_t start_ms, bool compare, replay_stat_t* stat )
+{
+    rnd_state = seed;
+    setup( start_ms + rnd( ) );
+
+    uint32_t end  = now_ms + WEEK_MS;
+    uint8_t  mode = rnd( ) % 4;
+
+    while( ( int32_t ) ( end - now_ms ) > 0 )
+    {
+        stat->steps++;
+        if( running_sum_is_ok( ) == false )
+        {
+            stat->errors++;
+        }
+        if( rnd( ) % 5000 == 0 )
+        {
+            mode = rnd( ) % 4;
+        }
+
+        // Mode 1 only uses the 10% band, mode 2 sends bursts on all bands, mode 3 sends long frames
+        uint8_t   nb_freq   = ( mode == 0 ) ? 3 : ( ( mode == 1 ) ? 1 : ( ( mode == 2 ) ? NB_FREQ : 5 ) );
+        uint32_t* freq_list = ( mode == 1 ) ? &freqs[5] : freqs;
+        int32_t   free_ms   = smtc_duty_cycle_get_next_free_time_ms( nb_freq, freq_list );
+
+        if( compare == true )
+        {
+            int32_t ref_free_ms = ref_smtc_duty_cycle_get_next_free_time_ms( nb_freq, freq_list );
+
+            for( uint8_t i = 0; i < NB_FREQ; i++ )
+            {
+                if( smtc_duty_cycle_is_channel_free( freqs[i] ) != ref_smtc_duty_cycle_is_channel_free( freqs[i] ) )
+                {
+                    stat->errors++;
+                }
+            }
+            for( uint8_t b = 0; b < SMTC_DTC_BANDS_MAX; b++ )
+            {
+                if( smtc_duty_cycle_band_get_available_toa_ms( dtc_obj_ptr, b ) !=
+                    ref_smtc_duty_cycle_band_get_available_toa_ms( ref_smtc_duty_cycle_get_obj( ), b ) )
+                {
+                    stat->errors++;
+                }
+            }
+            // Same available time, or same band release unless the previous one returned a too early bucket
+            if( ( free_ms <= 0 ) || ( ref_free_ms <= 0 ) )
+            {
+                stat->errors += ( free_ms != ref_free_ms ) ? 1 : 0;
+            }
+            else if( free_ms == ref_free_ms )
+            {
+                stat->same++;
+            }
+            else if( free_ms > ref_free_ms )
+            {
+                stat->later++;
+            }
+            else
+            {
+                stat->errors++;
+            }
+        }
+
+        if( free_ms > 0 )
+        {
+            if( free_time_is_exact( nb_freq, freq_list, free_ms ) == false )
+            {
+                stat->errors++;
+            }
+            // Either wake up at the returned time or at any time
+            now_ms += ( ( rnd( ) % 2 ) == 0 ) ? ( uint32_t ) free_ms : 1 + rnd( ) % 200000;
+            continue;
+        }
+
+        // Send an uplink on a random channel of the list
+        uint32_t freq = freq_list[rnd( ) % nb_freq];
+        smtc_duty_cycle_update( );
+        ref_smtc_duty_cycle_update( );
+        if( smtc_duty_cycle_is_channel_free( freq ) == true )
+        {
+            uint32_t toa = 30 + rnd( ) % ( ( mode == 3 ) ? 6000 : 1500 );
+            smtc_duty_cycle_sum( freq, toa );
+            ref_smtc_duty_cycle_sum( freq, toa );
+        }
+        now_ms += ( mode == 2 ) ? rnd( ) % 20000 : rnd( ) % 300000;
+    }
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies over a week of uplinks per seed that both implementations agree on channel states and available time,
+ * and that the next free time is the same unless the previous implementation woke up while the band was still full.
+ */
+void test_week_replay_matches_previous( )
+{
+    replay_stat_t stat = { 0 };
+
+    for( uint32_t seed = 1; seed <= 16; seed++ )
+    {
+        replay_week( seed, 1000, true, &stat );
+    }
+    printf( "     %u steps, full bands: %u same free time, %u previously too early\n", stat.steps, stat.same,
+            stat.later );
+    print_result( "test_week_replay_matches_previous", ( stat.errors == 0 ) && ( stat.same > 0 ) );
+}
+
+/**
+ * Verifies the running sum and the exact free time across the 32-bit RTC wrap.
+ */
+void test_week_replay_rtc_wrap( )
+{
+    replay_stat_t stat = { 0 };
+
+    for( uint32_t seed = 1; seed <= 4; seed++ )
+    {
+        replay_week( seed, 0xFFFFFFFFu - 200000000u, false, &stat );
+    }
+    print_result( "test_week_replay_rtc_wrap", stat.errors == 0 );
+}
+
+/**
+ * Verifies that the time returned for a ToA is the first time the ToA is accepted on the band.
+ */
+void test_toa_free_time_exact( )
+{
+    uint32_t freq   = 868100000;
+    bool     passed = true;
+
+    rnd_state = 7;
+    setup( 1000 );
+    for( uint32_t i = 0; i < 20000; i++ )
+    {
+        uint32_t toa_ms = 30 + rnd( ) % 3000;
+
+        smtc_duty_cycle_update( );
+        int32_t free_ms = smtc_duty_cycle_get_toa_free_time_ms( freq, toa_ms );
+        if( free_ms == 0 )
+        {
+            passed = passed && smtc_duty_cycle_is_toa_accepted( dtc_obj_ptr, freq, toa_ms );
+            smtc_duty_cycle_sum( freq, toa_ms );
+        }
+        else if( free_ms > 0 )
+        {
+            smtc_dtc_t save_obj = *dtc_obj_ptr;
+            uint32_t   save_ms  = now_ms;
+
+            now_ms = save_ms + free_ms - 1;
+            smtc_duty_cycle_update( );
+            passed       = passed && !smtc_duty_cycle_is_toa_accepted( dtc_obj_ptr, freq, toa_ms );
+            *dtc_obj_ptr = save_obj;
+            now_ms       = save_ms + free_ms;
+            smtc_duty_cycle_update( );
+            passed       = passed && smtc_duty_cycle_is_toa_accepted( dtc_obj_ptr, freq, toa_ms );
+            *dtc_obj_ptr = save_obj;
+            now_ms       = save_ms;
+        }
+        now_ms += rnd( ) % 60000;
+    }
+    // A ToA larger than the budget of the 1% band is never accepted
+    passed = passed && ( smtc_duty_cycle_get_toa_free_time_ms( freq, 40000 ) < 0 );
+    print_result( "test_toa_free_time_exact", passed );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_week_replay_matches_previous( );
+    test_week_replay_rtc_wrap( );
+    test_toa_free_time_exact( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
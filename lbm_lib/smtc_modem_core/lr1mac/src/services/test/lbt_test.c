@@ -0,0 +1,564 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The planner and lbt objects are used as is: both modules are built within the test
+#include "radio_planner.c"
+#include "smtc_lbt.c"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+#define NO_EVENT UINT64_MAX
+
+// Simulated clock in us, each time read costs some MCU time
+static uint64_t now_us;
+static uint64_t sleep_us;
+
+// Single modem timer
+static uint64_t timer_deadline_us = NO_EVENT;
+static void ( *timer_callback )( void* );
+static void* timer_context;
+
+// Radio irq of the task preempting the lbt
+static uint64_t radio_irq_us = NO_EVENT;
+
+// Replay log of the rssi samples
+#define SAMPLES_MAX 500000
+static uint64_t sample_time_us[SAMPLES_MAX];
+static bool     sample_busy[SAMPLES_MAX];
+static uint32_t nb_samples;
+
+// Interferer seed
+static uint32_t seed;
+
+uint32_t smtc_modem_hal_get_time_in_ms( void )
+{
+    now_us += 5;
+    return ( uint32_t ) ( now_us / 1000 );
+}
+
+void smtc_modem_hal_start_timer( const uint32_t milliseconds, void ( *callback )( void* context ), void* context )
+{
+    timer_deadline_us = ( now_us / 1000 + milliseconds ) * 1000;
+    timer_callback    = callback;
+    timer_context     = context;
+}
+
+void smtc_modem_hal_stop_timer( void )
+{
+    timer_deadline_us = NO_EVENT;
+}
+
+void smtc_modem_hal_user_lbm_irq( void )
+{
+}
+
+void smtc_modem_hal_start_radio_tcxo( void )
+{
+}
+
+void smtc_modem_hal_stop_radio_tcxo( void )
+{
+}
+
+void smtc_modem_hal_set_ant_switch( bool is_tx_on )
+{
+}
+
+uint32_t smtc_modem_hal_get_radio_tcxo_startup_delay_ms( void )
+{
+    return 0;
+}
+
+bool smtc_modem_external_stack_currently_use_radio( void )
+{
+    return false;
+}
+
+void smtc_duty_cycle_sum( uint32_t freq_hz, uint32_t toa_ms )
+{
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+/**
+ * Deterministic interferer: 4 ms slots, 30% of them busy, replayed from the seed
+ */
+static bool channel_is_busy( uint64_t time_us )
+{
+    uint32_t h = ( uint32_t ) ( time_us / 4000 ) * 2654435761u ^ seed;
+
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return ( h % 10 ) < 3;
+}
+
+static ral_status_t radio_get_rssi_inst( const void* context, int16_t* rssi_in_dbm )
+{
+    now_us += 40;
+    if( nb_samples < SAMPLES_MAX )
+    {
+        sample_time_us[nb_samples] = now_us;
+        sample_busy[nb_samples]    = channel_is_busy( now_us );
+        nb_samples++;
+    }
+    *rssi_in_dbm = channel_is_busy( now_us ) ? -60 : -110;
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_get_and_clear_irq_status( const void* context, ral_irq_t* irq )
+{
+    *irq = RAL_IRQ_TX_DONE;
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_sleep( const void* context, const bool retain_config )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_standby( const void* context, ral_standby_cfg_t standby_cfg )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_rx( const void* context, const uint32_t timeout_in_ms )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_clear_irq_status( const void* context, const ral_irq_t irq )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_dio_irq_params( const void* context, const ral_irq_t irq )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_rf_freq( const void* context, const uint32_t freq_in_hz )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_pkt_type( const void* context, const ral_pkt_type_t pkt_type )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_set_gfsk_mod_params( const void* context, const ral_gfsk_mod_params_t* params )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_cfg_rx_boosted( const void* context, const bool enable_boost_mode )
+{
+    return RAL_STATUS_OK;
+}
+
+static ral_status_t radio_get_gfsk_rx_consumption_in_ua( const void* context, const uint32_t br_in_bps,
+                                                         const uint32_t bw_dsb_in_hz, const bool rx_boosted,
+                                                         uint32_t* pwr_consumption_in_ua )
+{
+    *pwr_consumption_in_ua = 5000;
+    return RAL_STATUS_OK;
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define LBT_HOOK_ID RP_HOOK_ID_LBT
+#define OTHER_HOOK_ID RP_HOOK_ID_LR1MAC_STACK
+#define SNIFF_DURATION_MS 5
+#define THRESHOLD_DBM -80
+#define FREQ_HZ 923200000
+#if defined( ADD_LBT_TIMER_SAMPLING )
+#define SAMPLING_PERIOD_MS LBT_SAMPLING_PERIOD_MS
+#else
+#define SAMPLING_PERIOD_MS 0
+#endif
+
+static radio_planner_t rp;
+static ralf_t          radio;
+static smtc_lbt_t      lbt;
+
+static uint32_t nb_free;
+static uint32_t nb_busy;
+static uint32_t nb_abort;
+static uint32_t nb_other_launch;
+static uint32_t nb_other_done;
+
+static void on_free( void* context )
+{
+    nb_free++;
+}
+
+static void on_busy( void* context )
+{
+    nb_busy++;
+}
+
+static void on_abort( void* context )
+{
+    nb_abort++;
+}
+
+static uint32_t nb_lbt_results( void )
+{
+    return nb_free + nb_busy + nb_abort;
+}
+
+#if defined( ADD_LBT_TIMER_SAMPLING )
+static void other_launch( void* rp_void )
+{
+    nb_other_launch++;
+    // The task ends with a radio irq after 10 ms
+    radio_irq_us = now_us + 10000;
+}
+
+static void other_done( void* context )
+{
+    nb_other_done++;
+}
+#endif
+
+static void setup( uint32_t interferer_seed )
+{
+    memset( &radio, 0, sizeof( radio ) );
+    radio.ral.driver.get_rssi_inst                 = radio_get_rssi_inst;
+    radio.ral.driver.get_and_clear_irq_status      = radio_get_and_clear_irq_status;
+    radio.ral.driver.set_sleep                     = radio_set_sleep;
+    radio.ral.driver.set_standby                   = radio_set_standby;
+    radio.ral.driver.set_rx                        = radio_set_rx;
+    radio.ral.driver.clear_irq_status              = radio_clear_irq_status;
+    radio.ral.driver.set_dio_irq_params            = radio_set_dio_irq_params;
+    radio.ral.driver.set_rf_freq                   = radio_set_rf_freq;
+    radio.ral.driver.set_pkt_type                  = radio_set_pkt_type;
+    radio.ral.driver.set_gfsk_mod_params           = radio_set_gfsk_mod_params;
+    radio.ral.driver.cfg_rx_boosted                = radio_cfg_rx_boosted;
+    radio.ral.driver.get_gfsk_rx_consumption_in_ua = radio_get_gfsk_rx_consumption_in_ua;
+
+    seed              = interferer_seed;
+    now_us            = 1000000;
+    sleep_us          = 0;
+    timer_deadline_us = NO_EVENT;
+    radio_irq_us      = NO_EVENT;
+    nb_samples        = 0;
+    nb_free           = 0;
+    nb_busy           = 0;
+    nb_abort          = 0;
+    nb_other_launch   = 0;
+    nb_other_done     = 0;
+
+    rp_init( &rp, &radio );
+    smtc_lbt_init( &lbt, &rp, LBT_HOOK_ID, on_free, NULL, on_busy, NULL, on_abort, NULL );
+    smtc_lbt_set_parameters( &lbt, SNIFF_DURATION_MS, THRESHOLD_DBM, 200000 );
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    rp_hook_init( &rp, OTHER_HOOK_ID, other_done, NULL );
+#endif
+}
+
+/**
+ * Replay the HAL events, sleeping until the next one, until the condition is met or the time is over
+ */
+static void run_until( uint32_t* counter, uint32_t target, uint64_t end_us )
+{
+    while( ( ( counter == NULL ) || ( *counter < target ) ) && ( now_us < end_us ) )
+    {
+        if( rp_get_irq_flag( &rp ) == true )
+        {
+            rp_callback( &rp );
+            continue;
+        }
+
+        uint64_t next_us = ( timer_deadline_us < radio_irq_us ) ? timer_deadline_us : radio_irq_us;
+        if( next_us >= end_us )
+        {
+            if( end_us > now_us )
+            {
+                sleep_us += end_us - now_us;
+                now_us = end_us;
+            }
+            break;
+        }
+        if( next_us > now_us )
+        {
+            sleep_us += next_us - now_us;
+            now_us = next_us;
+        }
+        if( next_us == radio_irq_us )
+        {
+            radio_irq_us = NO_EVENT;
+            rp_radio_irq_callback( &rp );
+        }
+        else
+        {
+            timer_deadline_us = NO_EVENT;
+            timer_callback( timer_context );
+        }
+        rp_callback( &rp );
+    }
+}
+
+static void listen( void )
+{
+    smtc_lbt_listen_channel( &lbt, FREQ_HZ, false, smtc_modem_hal_get_time_in_ms( ), 0 );
+}
+
+/**
+ * Check the decision against the replayed samples: busy on the first busy sample, free when all the samples of the
+ * listen are free and cover it without gap
+ */
+static bool decision_is_valid( uint32_t first, uint32_t last, bool is_busy )
+{
+    if( last <= first )
+    {
+        return false;
+    }
+    for( uint32_t i = first; i < last; i++ )
+    {
+        if( ( sample_busy[i] == true ) && ( i != last - 1 ) )
+        {
+            return false;
+        }
+        if( ( i > first ) && ( ( sample_time_us[i] - sample_time_us[i - 1] ) > ( SAMPLING_PERIOD_MS + 1 ) * 1000 ) )
+        {
+            return false;
+        }
+    }
+    if( is_busy == true )
+    {
+        return sample_busy[last - 1];
+    }
+    return ( sample_busy[last - 1] == false ) &&
+           ( ( sample_time_us[last - 1] - sample_time_us[first] ) >=
+             ( SNIFF_DURATION_MS - SAMPLING_PERIOD_MS - 1 ) * 1000 );
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies over many listens replayed against an interferer that each decision matches the rssi samples, and
+ * reports the time the MCU is awake during the listens.
+ */
+void test_listen_decisions( )
+{
+    bool     passed    = true;
+    uint64_t listen_us = 0;
+    uint64_t asleep_us = 0;
+
+    setup( 1 );
+    for( uint32_t k = 0; k < 2000; k++ )
+    {
+        uint32_t first_sample = nb_samples;
+        uint32_t nb_busy_prev = nb_busy;
+        uint64_t start_us;
+        uint64_t start_sleep_us;
+
+        // Next attempt
+        now_us += 7919;
+        start_us       = now_us;
+        start_sleep_us = sleep_us;
+        listen( );
+        run_until( NULL, 0, now_us + 50000 );
+        passed = passed && ( nb_lbt_results( ) == k + 1 ) && ( nb_abort == 0 );
+        passed = passed && decision_is_valid( first_sample, nb_samples, nb_busy > nb_busy_prev );
+        // Only the listen itself is counted, not the time slept after it
+        listen_us += sample_time_us[nb_samples - 1] - start_us;
+        asleep_us += sleep_us - start_sleep_us - ( now_us - sample_time_us[nb_samples - 1] );
+    }
+    printf( "     %u free, %u busy, %u samples, MCU awake %.1f ms of %.1f ms of listen\n", nb_free, nb_busy, nb_samples,
+            ( listen_us - asleep_us ) / 1000.0, listen_us / 1000.0 );
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    // The MCU sleeps between the samples
+    passed = passed && ( ( listen_us - asleep_us ) * 4 < listen_us );
+#endif
+    print_result( "test_listen_decisions", passed && ( nb_free > 0 ) && ( nb_busy > 0 ) );
+}
+
+#if defined( ADD_LBT_TIMER_SAMPLING )
+/**
+ * Verifies that the sampling alarm of an lbt task aborted during the listen is dropped: no sample and no decision
+ * once the abort is reported, and the next listen runs normally.
+ */
+void test_alarm_after_abort( )
+{
+    bool passed = true;
+
+    setup( 7 );
+    for( uint32_t k = 0; k < 200; k++ )
+    {
+        uint32_t target     = nb_samples + 2;
+        uint32_t nb_results = nb_lbt_results( );
+        uint32_t nb_free_prev  = nb_free;
+        uint32_t nb_abort_prev = nb_abort;
+        uint32_t nb_samples_at_abort;
+
+        now_us += 3001;
+        listen( );
+        run_until( &nb_samples, target, now_us + 50000 );
+        if( nb_lbt_results( ) != nb_results )
+        {
+            // The channel was found busy on the first samples, nothing to abort
+            continue;
+        }
+        rp_task_abort( &rp, LBT_HOOK_ID );
+        run_until( &nb_abort, nb_abort_prev + 1, now_us + 50000 );
+        nb_samples_at_abort = nb_samples;
+        passed              = passed && ( nb_abort == nb_abort_prev + 1 );
+
+        // The alarm of the aborted task expires meanwhile
+        run_until( NULL, 0, now_us + 20000 );
+        passed = passed && ( nb_samples == nb_samples_at_abort ) && ( nb_free == nb_free_prev ) &&
+                 ( nb_lbt_results( ) == nb_results + 1 );
+    }
+
+    // The planner is not disturbed
+    uint32_t first_sample = nb_samples;
+    uint32_t nb_results   = nb_lbt_results( );
+    uint32_t nb_busy_prev = nb_busy;
+
+    listen( );
+    run_until( NULL, 0, now_us + 50000 );
+    passed = passed && ( nb_lbt_results( ) == nb_results + 1 ) &&
+             decision_is_valid( first_sample, nb_samples, nb_busy > nb_busy_prev );
+    print_result( "test_alarm_after_abort", passed );
+}
+
+/**
+ * Verifies that the sampling alarm of an lbt task preempted by a scheduled task is dropped: no sample is taken while
+ * the other task runs nor after it, the preempting task completes and the next listen runs normally.
+ */
+void test_alarm_after_preemption( )
+{
+    bool passed = true;
+
+    setup( 11 );
+    for( uint32_t k = 0; k < 200; k++ )
+    {
+        uint32_t          target        = nb_samples + 2;
+        uint32_t          nb_results    = nb_lbt_results( );
+        uint32_t          nb_abort_prev = nb_abort;
+        uint32_t          nb_launch     = nb_other_launch;
+        uint32_t          nb_done       = nb_other_done;
+        uint32_t          nb_samples_at_preemption;
+        rp_task_t         task   = { 0 };
+        rp_radio_params_t params = { 0 };
+
+        now_us += 3001;
+        listen( );
+        run_until( &nb_samples, target, now_us + 50000 );
+        if( nb_lbt_results( ) != nb_results )
+        {
+            // The channel was found busy on the first samples, nothing to preempt
+            continue;
+        }
+
+        // A scheduled task starts during the listen
+        task.hook_id               = OTHER_HOOK_ID;
+        task.type                  = RP_TASK_TYPE_USER;
+        task.state                 = RP_TASK_STATE_SCHEDULE;
+        task.start_time_ms         = smtc_modem_hal_get_time_in_ms( ) + 1;
+        task.duration_time_ms      = 10;
+        task.launch_task_callbacks = other_launch;
+        passed = passed && ( rp_task_enqueue( &rp, &task, NULL, 0, &params ) == RP_HOOK_STATUS_OK );
+        run_until( &nb_other_launch, nb_launch + 1, now_us + 50000 );
+        nb_samples_at_preemption = nb_samples;
+        passed                   = passed && ( nb_other_launch == nb_launch + 1 );
+
+        // The alarm of the preempted task expires while the other task runs, the abort is reported once the radio is
+        // released
+        run_until( &nb_other_done, nb_done + 1, now_us + 50000 );
+        passed = passed && ( nb_other_done == nb_done + 1 ) && ( nb_samples == nb_samples_at_preemption ) &&
+                 ( nb_abort == nb_abort_prev + 1 ) && ( nb_lbt_results( ) == nb_results + 1 );
+        run_until( NULL, 0, now_us + 20000 );
+        passed = passed && ( nb_samples == nb_samples_at_preemption ) && ( nb_lbt_results( ) == nb_results + 1 );
+    }
+
+    uint32_t first_sample = nb_samples;
+    uint32_t nb_results   = nb_lbt_results( );
+    uint32_t nb_busy_prev = nb_busy;
+
+    listen( );
+    run_until( NULL, 0, now_us + 50000 );
+    passed = passed && ( nb_lbt_results( ) == nb_results + 1 ) &&
+             decision_is_valid( first_sample, nb_samples, nb_busy > nb_busy_prev );
+    print_result( "test_alarm_after_preemption", passed && ( nb_abort > 0 ) );
+}
+
+/**
+ * Verifies that a listen started right after an abort, before the alarm of the aborted task expires, is sampled
+ * once per period and not twice.
+ */
+void test_alarm_after_relaunch( )
+{
+    bool passed = true;
+
+    setup( 13 );
+    for( uint32_t k = 0; k < 200; k++ )
+    {
+        uint32_t target     = nb_samples + 2;
+        uint32_t nb_results = nb_lbt_results( );
+
+        now_us += 3001;
+        listen( );
+        run_until( &nb_samples, target, now_us + 50000 );
+        if( nb_lbt_results( ) != nb_results )
+        {
+            continue;
+        }
+        rp_task_abort( &rp, LBT_HOOK_ID );
+        run_until( &nb_abort, nb_abort + 1, now_us + 50000 );
+
+        uint32_t first_sample = nb_samples;
+        uint32_t nb_busy_prev = nb_busy;
+
+        listen( );
+        run_until( NULL, 0, now_us + 50000 );
+        passed = passed && ( nb_lbt_results( ) == nb_results + 2 ) &&
+                 decision_is_valid( first_sample, nb_samples, nb_busy > nb_busy_prev );
+        for( uint32_t i = first_sample + 1; i < nb_samples; i++ )
+        {
+            passed = passed && ( ( sample_time_us[i] - sample_time_us[i - 1] ) > 500 );
+        }
+    }
+    print_result( "test_alarm_after_relaunch", passed );
+}
+#endif
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_listen_decisions( );
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    test_alarm_after_abort( );
+    test_alarm_after_preemption( );
+    test_alarm_after_relaunch( );
+#endif
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
@@ -64,6 +64,7 @@
 #define snapshot_channel_tx_mask real->region.au915.snapshot_channel_tx_mask
 #define snapshot_bank_tx_mask real->region.au915.snapshot_bank_tx_mask
 #define tx_channel_idx real->region.au915.tx_channel_idx
+#define dr_channel_mask real->region.au915.dr_channel_mask
 
 /*
  * -----------------------------------------------------------------------------
@@ -99,6 +100,50 @@ typedef enum ch_mask_after_join_e
  */
 static void region_au_915_channel_mask_set_after_join( smtc_real_t* real );
 
+/**
+ * @brief Rebuild the enabled tx channels bit array of each datarate
+ *
+ * @remark Shall be called each time channel_index_enabled or dr_bitfield_tx_channel is modified
+ *
+ * @param real
+ */
+static void region_au_915_update_dr_channel_mask( smtc_real_t* real );
+
+/**
+ * @brief Number of ChMask blocks carried by the CFList of the join accept
+ *
+ * @param real
+ * @return uint8_t
+ */
+static uint8_t region_au_915_get_number_of_chmask_in_cflist( smtc_real_t* real );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_au_915_ops = {
+    .config                                = region_au_915_config,
+    .get_number_of_chmask_in_cflist        = region_au_915_get_number_of_chmask_in_cflist,
+    .get_next_channel                      = region_au_915_get_next_channel,
+    .get_join_next_channel                 = region_au_915_get_join_next_channel,
+    .mask_channel_used_for_tx              = region_au_915_mask_channel_used_for_tx,
+    .init_join_snapshot_channel_mask       = region_au_915_init_join_snapshot_channel_mask,
+    .init_after_join_snapshot_channel_mask = region_au_915_init_after_join_snapshot_channel_mask,
+    .set_channel_mask                      = region_au_915_set_channel_mask,
+    .build_channel_mask                    = region_au_915_build_channel_mask,
+    .are_all_default_channels_enabled      = region_au_915_are_all_default_channels_enabled,
+    .enable_all_channels_with_valid_freq   = region_au_915_enable_all_channels_with_valid_freq,
+    .is_tx_dr_acceptable                   = region_au_915_is_acceptable_tx_dr,
+    .get_tx_frequency_channel              = region_au_915_get_tx_frequency_channel,
+    .get_rx1_frequency_channel             = region_au_915_get_rx1_frequency_channel,
+    .get_modulation_type_from_datarate     = region_au_915_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                      = region_au_915_lora_dr_to_sf_bw,
+    .lr_fhss_dr_to_cr_bw                   = region_au_915_lr_fhss_dr_to_cr_bw,
+    .get_rx_beacon_frequency_channel       = region_au_915_get_rx_beacon_frequency_channel,
+    .get_rx_ping_slot_frequency_channel    = region_au_915_get_rx_ping_slot_frequency_channel,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -165,6 +210,7 @@ void region_au_915_init( smtc_real_t* real )
     // Enable all channels
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_AU915 );
     memset( &snapshot_channel_tx_mask[0], 0xFF, BANK_MAX_AU915 );
+    memset( dr_channel_mask, 0, sizeof( dr_channel_mask ) );
 
     snapshot_bank_tx_mask = 0;
 }
@@ -206,12 +252,12 @@ void region_au_915_config( smtc_real_t* real )
         SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "%s", ( ( i % 8 ) == 7 ) ? "---\n" : "" );
     }
 #endif
+    region_au_915_update_dr_channel_mask( real );
 
     first_ch_mask_received = ch_mask_after_join_init;
 }
 
-status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr,
-                                                    bool uplink_dwell_time )
+status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr )
 {
     status_lorawan_t status                      = ERRORLORAWAN;
     uint8_t          number_channels_125_enabled = 0;
@@ -252,7 +298,7 @@ status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t d
         }
     }
 
-    if( uplink_dwell_time == true )
+    if( real_ctx.uplink_dwell_time_ctx == true )
     {
         if( dr < real_const.const_min_tx_dr_limit )
         {
@@ -269,7 +315,7 @@ status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t d
 
 status_lorawan_t region_au_915_get_join_next_channel( smtc_real_t* real, uint8_t* out_tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                      uint8_t* active_channel_nb )
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
     au_915_channels_bank_t bank_tmp_cnt = 0;
     uint8_t                active_channel_index[NUMBER_OF_TX_CHANNEL_AU_915];
@@ -392,17 +438,18 @@ status_lorawan_t region_au_915_get_next_channel( smtc_real_t* real, uint8_t tx_d
         region_au_915_init_after_join_snapshot_channel_mask( real, tx_data_rate, *out_tx_frequency );
     }
 
+    // Search all active channels: enabled channels supporting the datarate and not already used in the snapshot
     *active_channel_nb = 0;
-    uint8_t active_channel_index[NUMBER_OF_TX_CHANNEL_AU_915];
-    for( uint8_t i = 0; i < NUMBER_OF_TX_CHANNEL_AU_915; i++ )
+    uint32_t active_channel_mask[NUMBER_OF_WORD32_TX_CHANNEL_AU_915] = { 0 };
+    if( tx_data_rate < NUMBER_OF_TX_DR_AU_915 )
     {
-        if( ( SMTC_GET_BIT8( snapshot_channel_tx_mask, i ) == CHANNEL_ENABLED ) &&
-            ( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED ) &&
-            ( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 ) )
+        for( uint8_t i = 0; i < NUMBER_OF_WORD32_TX_CHANNEL_AU_915; i++ )
         {
-            active_channel_index[*active_channel_nb] = i;
-            ( *active_channel_nb )++;
+            active_channel_mask[i] =
+                dr_channel_mask[tx_data_rate][i] &
+                lr1mac_utilities_get_word32_from_bit8( snapshot_channel_tx_mask, BANK_MAX_AU915, i );
         }
+        *active_channel_nb = lr1mac_utilities_bit32_count( active_channel_mask, NUMBER_OF_WORD32_TX_CHANNEL_AU_915 );
     }
     if( *active_channel_nb == 0 )
     {
@@ -410,7 +457,8 @@ status_lorawan_t region_au_915_get_next_channel( smtc_real_t* real, uint8_t tx_d
     }
 
     uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
-    uint8_t channel_idx = active_channel_index[temp];
+    uint8_t channel_idx =
+        lr1mac_utilities_bit32_get_nth( active_channel_mask, NUMBER_OF_WORD32_TX_CHANNEL_AU_915, temp );
     if( channel_idx >= NUMBER_OF_TX_CHANNEL_AU_915 )
     {
         SMTC_MODEM_HAL_TRACE_ERROR( "INVALID CHANNEL  active channel = %d and random channel = %d \n",
@@ -651,6 +699,7 @@ void region_au_915_enable_all_channels_with_valid_freq( smtc_real_t* real )
         SMTC_PUT_BIT8( channel_index_enabled, i, CHANNEL_ENABLED );
         dr_bitfield_tx_channel[i] = DEFAULT_TX_DR_500_BIT_FIELD_AU_915;
     }
+    region_au_915_update_dr_channel_mask( real );
 }
 
 modulation_type_t region_au_915_get_modulation_type_from_datarate( uint8_t datarate )
@@ -733,11 +782,18 @@ uint32_t region_au_915_get_rx_ping_slot_frequency_channel( smtc_real_t* real, ui
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
+
+static uint8_t region_au_915_get_number_of_chmask_in_cflist( smtc_real_t* real )
+{
+    return 5;
+}
+
 static void region_au_915_channel_mask_set_after_join( smtc_real_t* real )
 {
     // Copy all unwrapped channels in channel enable and in snapshot
     memcpy( channel_index_enabled, unwrapped_channel_mask, BANK_MAX_AU915 );
     memcpy( snapshot_channel_tx_mask, unwrapped_channel_mask, BANK_MAX_AU915 );
+    region_au_915_update_dr_channel_mask( real );
 
 #if ( BSP_DBG_TRACE == BSP_FEATURE_ON )
     SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "Ch 125kHz\n" );
@@ -757,4 +813,10 @@ static void region_au_915_channel_mask_set_after_join( smtc_real_t* real )
     first_ch_mask_received++;
 }
 
+static void region_au_915_update_dr_channel_mask( smtc_real_t* real )
+{
+    lr1mac_utilities_build_dr_channel_mask( &dr_channel_mask[0][0], NUMBER_OF_TX_DR_AU_915, channel_index_enabled,
+                                            dr_bitfield_tx_channel, NUMBER_OF_TX_CHANNEL_AU_915 );
+}
+
 /* --- EOF ------------------------------------------------------------------ */
@@ -61,6 +61,11 @@ extern "C" {
  * --- PUBLIC CONSTANTS --------------------------------------------------------
  */
 
+/**
+ * @brief Region operations, bound by smtc_real_init( )
+ */
+extern const smtc_real_region_ops_t region_au_915_ops;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC TYPES ------------------------------------------------------------
@@ -100,7 +105,7 @@ status_lorawan_t region_au_915_get_next_channel( smtc_real_t* real, uint8_t tx_d
  */
 status_lorawan_t region_au_915_get_join_next_channel( smtc_real_t* real, uint8_t* out_tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                      uint8_t* active_channel_nb );
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb );
 /**
  * \brief
  * \remark
@@ -159,8 +164,7 @@ void region_au_915_enable_all_channels_with_valid_freq( smtc_real_t* real );
  * \param [IN]  none
  * \param [OUT] return
  */
-status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr,
-                                                    bool uplink_dwell_time );
+status_lorawan_t region_au_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr );
 
 /**
  * @brief Get the corresponding RF modulation from a Datarate
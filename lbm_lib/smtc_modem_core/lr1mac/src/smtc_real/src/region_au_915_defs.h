@@ -56,6 +56,7 @@ extern "C" {
 
 /* clang-format off */
 #define NUMBER_OF_TX_CHANNEL_AU_915         (72)            // TX 64 125KHz + 8 500KHz channels
+#define NUMBER_OF_WORD32_TX_CHANNEL_AU_915  ( ( NUMBER_OF_TX_CHANNEL_AU_915 + 31 ) / 32 )  // TX channels bit array size in words
 #define NUMBER_OF_RX_CHANNEL_AU_915         (8)             // RX 8 500KHz channels
 #define JOIN_ACCEPT_DELAY1_AU_915           (5)             // define in seconds
 #define JOIN_ACCEPT_DELAY2_AU_915           (6)             // define in seconds
@@ -160,6 +161,8 @@ typedef struct region_au915_context_s
     uint8_t  dr_distribution[NUMBER_OF_TX_DR_AU_915];
     uint8_t  join_dr_distribution[NUMBER_OF_TX_DR_AU_915];
     uint8_t  custom_dr_distribution_init[NUMBER_OF_TX_DR_AU_915];
+    // Enabled tx channels by datarate, rebuilt when channel_index_enabled or dr_bitfield_tx_channel change
+    uint32_t dr_channel_mask[NUMBER_OF_TX_DR_AU_915][NUMBER_OF_WORD32_TX_CHANNEL_AU_915];
     uint8_t  first_ch_mask_received;
     uint8_t  tx_channel_idx;
 
@@ -59,6 +59,7 @@
 #define unwrapped_channel_mask real->region.cn470.unwrapped_channel_mask
 #define activated_by_join_channel real->region.cn470.activated_by_join_channel
 #define activated_channel_plan real->region.cn470.activated_channel_plan
+#define dr_channel_mask real->region.cn470.dr_channel_mask
 
 /*
  * -----------------------------------------------------------------------------
@@ -92,6 +93,39 @@ static const char* smtc_real_channel_plan_cn470_str[] = {
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
+/**
+ * @brief Rebuild the enabled tx channels bit array of each datarate
+ *
+ * @remark Shall be called each time channel_index_enabled or dr_bitfield_tx_channel is modified
+ *
+ * @param real
+ */
+static void region_cn_470_update_dr_channel_mask( smtc_real_t* real );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_cn_470_ops = {
+    .config                              = region_cn_470_config,
+    .config_session                      = region_cn_470_config_session,
+    .get_number_of_chmask_in_cflist      = region_cn_470_get_number_of_chmask_in_cflist,
+    .get_next_channel                    = region_cn_470_get_next_channel,
+    .get_join_next_channel               = region_cn_470_get_join_next_channel,
+    .set_channel_mask                    = region_cn_470_set_channel_mask,
+    .build_channel_mask                  = region_cn_470_build_channel_mask,
+    .are_all_default_channels_enabled    = region_cn_470_are_all_default_channels_enabled,
+    .enable_all_channels_with_valid_freq = region_cn_470_enable_all_channels_with_valid_freq,
+    .get_tx_frequency_channel            = region_cn_470_get_tx_frequency_channel,
+    .get_rx1_frequency_channel           = region_cn_470_get_rx1_frequency_channel,
+    .get_modulation_type_from_datarate   = region_cn_470_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                    = region_cn_470_lora_dr_to_sf_bw,
+    .fsk_dr_to_bitrate                   = region_cn_470_fsk_dr_to_bitrate,
+    .get_rx_beacon_frequency_channel     = region_cn_470_get_rx_beacon_frequency_channel,
+    .get_rx_ping_slot_frequency_channel  = region_cn_470_get_rx_ping_slot_frequency_channel,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -159,6 +193,7 @@ void region_cn_470_init( smtc_real_t* real )
 
     // Enable all unwrapped channels
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_CN470 );
+    memset( dr_channel_mask, 0, sizeof( dr_channel_mask ) );
 }
 
 void region_cn_470_config( smtc_real_t* real )
@@ -198,6 +233,7 @@ void region_cn_470_config( smtc_real_t* real )
         SMTC_MODEM_HAL_PANIC( );
     }
 #endif
+    region_cn_470_update_dr_channel_mask( real );
 }
 
 void region_cn_470_config_session( smtc_real_t* real )
@@ -295,9 +331,10 @@ void region_cn_470_config_session( smtc_real_t* real )
         SMTC_MODEM_HAL_PANIC( );
     }
 #endif
+    region_cn_470_update_dr_channel_mask( real );
 }
 
-status_lorawan_t region_cn_470_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
+status_lorawan_t region_cn_470_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
                                                       uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
@@ -310,7 +347,7 @@ status_lorawan_t region_cn_470_get_join_next_channel( smtc_real_t* real, uint8_t
         if( ( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED ) &&
             ( common_join_channel_cn_470[i][0] != 0 ) )
         {
-            if( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 )
+            if( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], *tx_data_rate ) == 1 )
             {
                 active_channel_index[*active_channel_nb] = i;
                 ( *active_channel_nb )++;
@@ -348,18 +385,10 @@ status_lorawan_t region_cn_470_get_next_channel( smtc_real_t* real, uint8_t tx_d
                                                  uint32_t* out_rx1_frequency, uint8_t* active_channel_nb )
 {
     *active_channel_nb = 0;
-    uint8_t active_channel_index[NUMBER_OF_TX_CHANNEL_CN_470];
-
-    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    if( tx_data_rate < NUMBER_OF_TX_DR_CN_470 )
     {
-        if( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED )
-        {
-            if( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 )
-            {
-                active_channel_index[*active_channel_nb] = i;
-                ( *active_channel_nb )++;
-            }
-        }
+        *active_channel_nb =
+            lr1mac_utilities_bit32_count( dr_channel_mask[tx_data_rate], NUMBER_OF_WORD32_TX_CHANNEL_CN_470 );
     }
 
     if( *active_channel_nb == 0 )
@@ -368,8 +397,8 @@ status_lorawan_t region_cn_470_get_next_channel( smtc_real_t* real, uint8_t tx_d
         return ERRORLORAWAN;
     }
     uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
-    uint8_t channel_idx = 0;
-    channel_idx         = active_channel_index[temp];
+    uint8_t channel_idx =
+        lr1mac_utilities_bit32_get_nth( dr_channel_mask[tx_data_rate], NUMBER_OF_WORD32_TX_CHANNEL_CN_470, temp );
     if( channel_idx >= real_const.const_number_of_tx_channel )
     {
         SMTC_MODEM_HAL_TRACE_ERROR( "INVALID CHANNEL  active channel = %d and random channel = %d \n",
@@ -525,6 +554,14 @@ void region_cn_470_enable_all_channels_with_valid_freq( smtc_real_t* real )
         dr_bitfield_tx_channel[i] = DEFAULT_TX_DR_BIT_FIELD_CN_470;
     }
 #endif
+    region_cn_470_update_dr_channel_mask( real );
+}
+
+void region_cn_470_set_channel_mask( smtc_real_t* real )
+{
+    // Copy all unwrapped channels in channel enable
+    memcpy( channel_index_enabled, unwrapped_channel_mask, BANK_MAX_CN470 );
+    region_cn_470_update_dr_channel_mask( real );
 }
 
 modulation_type_t region_cn_470_get_modulation_type_from_datarate( uint8_t datarate )
@@ -759,4 +796,10 @@ uint32_t region_cn_470_get_rx_ping_slot_frequency_channel( smtc_real_t* real, ui
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+static void region_cn_470_update_dr_channel_mask( smtc_real_t* real )
+{
+    lr1mac_utilities_build_dr_channel_mask( &dr_channel_mask[0][0], NUMBER_OF_TX_DR_CN_470, channel_index_enabled,
+                                            dr_bitfield_tx_channel, real_const.const_number_of_tx_channel );
+}
+
 /* --- EOF ------------------------------------------------------------------ */
@@ -60,6 +60,7 @@ extern uint32_t freq_tx_cn470_mono_channel_mhz;
 
 /* clang-format off */
 #define NUMBER_OF_TX_CHANNEL_CN_470         (64)            // Max Tx channels required for a group
+#define NUMBER_OF_WORD32_TX_CHANNEL_CN_470  ( ( NUMBER_OF_TX_CHANNEL_CN_470 + 31 ) / 32 )  // TX channels bit array size in words
 #define NUMBER_OF_RX_CHANNEL_CN_470         (64)            // Max Rx channels required for a group
 #define JOIN_ACCEPT_DELAY1_CN_470           (5)             // define in seconds
 #define JOIN_ACCEPT_DELAY2_CN_470           (6)             // define in seconds
@@ -205,6 +206,8 @@ typedef struct region_cn470_context_s
     uint8_t                   custom_dr_distribution_init[NUMBER_OF_TX_DR_CN_470];
     uint8_t                   channel_index_enabled[BANK_MAX_CN470];  // Contain the index of the activated channel only
     uint8_t                   unwrapped_channel_mask[BANK_MAX_CN470];
+    // Enabled tx channels by datarate, rebuilt when channel_index_enabled or dr_bitfield_tx_channel change
+    uint32_t                  dr_channel_mask[NUMBER_OF_TX_DR_CN_470][NUMBER_OF_WORD32_TX_CHANNEL_CN_470];
     uint8_t                   activated_by_join_channel;  // Channel used to join
     channel_plan_type_cn470_t activated_channel_plan;
 
@@ -59,6 +59,7 @@
 #define unwrapped_channel_mask real->region.cn470_rp_1_0.unwrapped_channel_mask
 
 #define snapshot_bank_tx_mask real->region.cn470_rp_1_0.snapshot_bank_tx_mask
+#define dr_channel_mask real->region.cn470_rp_1_0.dr_channel_mask
 // Private region_cn_470_rp_1_0 utilities declaration
 //
 
@@ -85,6 +86,37 @@ uint32_t freq_tx_cn470_mono_channel_mhz = 471100000;
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
+/**
+ * @brief Rebuild the enabled tx channels bit array of each datarate
+ *
+ * @remark Shall be called each time channel_index_enabled or dr_bitfield_tx_channel is modified
+ *
+ * @param real
+ */
+static void region_cn_470_rp_1_0_update_dr_channel_mask( smtc_real_t* real );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_cn_470_rp_1_0_ops = {
+    .config                              = region_cn_470_rp_1_0_config,
+    .get_number_of_chmask_in_cflist      = region_cn_470_rp_1_0_get_number_of_chmask_in_cflist,
+    .get_next_channel                    = region_cn_470_rp_1_0_get_next_channel,
+    .get_join_next_channel               = region_cn_470_rp_1_0_get_join_next_channel,
+    .set_channel_mask                    = region_cn_470_rp_1_0_set_channel_mask,
+    .build_channel_mask                  = region_cn_470_rp_1_0_build_channel_mask,
+    .are_all_default_channels_enabled    = region_cn_470_rp_1_0_are_all_default_channels_enabled,
+    .enable_all_channels_with_valid_freq = region_cn_470_rp_1_0_enable_all_channels_with_valid_freq,
+    .get_tx_frequency_channel            = region_cn_470_rp_1_0_get_tx_frequency_channel,
+    .get_rx1_frequency_channel           = region_cn_470_rp_1_0_get_rx1_frequency_channel,
+    .get_modulation_type_from_datarate   = region_cn_470_rp_1_0_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                    = region_cn_470_rp_1_0_lora_dr_to_sf_bw,
+    .get_rx_beacon_frequency_channel     = region_cn_470_rp_1_0_get_rx_beacon_frequency_channel,
+    .get_rx_ping_slot_frequency_channel  = region_cn_470_rp_1_0_get_rx_ping_slot_frequency_channel,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -152,6 +184,7 @@ void region_cn_470_rp_1_0_init( smtc_real_t* real )
 
     // Enable all unwrapped channels
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_CN470_RP_1_0 );
+    memset( dr_channel_mask, 0, sizeof( dr_channel_mask ) );
 
     snapshot_bank_tx_mask = BANK_0_125_CN470_RP_1_0;
 }
@@ -181,11 +214,12 @@ void region_cn_470_rp_1_0_config( smtc_real_t* real )
         SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "%s", ( ( i % 8 ) == 7 ) ? "---\n" : "" );
     }
 #endif
+    region_cn_470_rp_1_0_update_dr_channel_mask( real );
 }
 
-status_lorawan_t region_cn_470_rp_1_0_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
+status_lorawan_t region_cn_470_rp_1_0_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
                                                              uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                             uint8_t* active_channel_nb )
+                                                             uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
 #if defined( HYBRID_CN470_MONO_CHANNEL )
     uint8_t err           = true;
@@ -223,7 +257,7 @@ status_lorawan_t region_cn_470_rp_1_0_get_join_next_channel( smtc_real_t* real,
         for( uint8_t i = snapshot_bank_tx_mask * 8; i < ( ( snapshot_bank_tx_mask * 8 ) + 8 ); i++ )
         {
             if( ( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED ) &&
-                ( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 ) )
+                ( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], *tx_data_rate ) == 1 ) )
             {
                 active_channel_index[*active_channel_nb] = i;
                 ( *active_channel_nb )++;
@@ -285,18 +319,10 @@ status_lorawan_t region_cn_470_rp_1_0_get_next_channel( smtc_real_t* real, uint8
     return OKLORAWAN;
 #endif
     *active_channel_nb = 0;
-    uint8_t active_channel_index[NUMBER_OF_TX_CHANNEL_CN_470_RP_1_0];
-
-    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    if( tx_data_rate < NUMBER_OF_TX_DR_CN_470_RP_1_0 )
     {
-        if( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED )
-        {
-            if( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 )
-            {
-                active_channel_index[*active_channel_nb] = i;
-                ( *active_channel_nb )++;
-            }
-        }
+        *active_channel_nb =
+            lr1mac_utilities_bit32_count( dr_channel_mask[tx_data_rate], NUMBER_OF_WORD32_TX_CHANNEL_CN_470_RP_1_0 );
     }
 
     if( *active_channel_nb == 0 )
@@ -305,8 +331,8 @@ status_lorawan_t region_cn_470_rp_1_0_get_next_channel( smtc_real_t* real, uint8
         return ERRORLORAWAN;
     }
     uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
-    uint8_t channel_idx = 0;
-    channel_idx         = active_channel_index[temp];
+    uint8_t channel_idx = lr1mac_utilities_bit32_get_nth( dr_channel_mask[tx_data_rate],
+                                                          NUMBER_OF_WORD32_TX_CHANNEL_CN_470_RP_1_0, temp );
     if( channel_idx >= real_const.const_number_of_tx_channel )
     {
         SMTC_MODEM_HAL_TRACE_ERROR( "INVALID CHANNEL  active channel = %d and random channel = %d \n",
@@ -398,6 +424,14 @@ void region_cn_470_rp_1_0_enable_all_channels_with_valid_freq( smtc_real_t* real
         SMTC_PUT_BIT8( channel_index_enabled, i, CHANNEL_ENABLED );
         dr_bitfield_tx_channel[i] = DEFAULT_TX_DR_BIT_FIELD_CN_470_RP_1_0;
     }
+    region_cn_470_rp_1_0_update_dr_channel_mask( real );
+}
+
+void region_cn_470_rp_1_0_set_channel_mask( smtc_real_t* real )
+{
+    // Copy all unwrapped channels in channel enable
+    memcpy( channel_index_enabled, unwrapped_channel_mask, BANK_MAX_CN470_RP_1_0 );
+    region_cn_470_rp_1_0_update_dr_channel_mask( real );
 }
 
 modulation_type_t region_cn_470_rp_1_0_get_modulation_type_from_datarate( uint8_t datarate )
@@ -455,4 +489,11 @@ uint32_t region_cn_470_rp_1_0_get_rx_ping_slot_frequency_channel( smtc_real_t* r
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+static void region_cn_470_rp_1_0_update_dr_channel_mask( smtc_real_t* real )
+{
+    lr1mac_utilities_build_dr_channel_mask( &dr_channel_mask[0][0], NUMBER_OF_TX_DR_CN_470_RP_1_0,
+                                            channel_index_enabled, dr_bitfield_tx_channel,
+                                            real_const.const_number_of_tx_channel );
+}
+
 /* --- EOF ------------------------------------------------------------------ */
@@ -61,6 +61,11 @@ extern "C" {
  * --- PUBLIC CONSTANTS --------------------------------------------------------
  */
 
+/**
+ * @brief Region operations, bound by smtc_real_init( )
+ */
+extern const smtc_real_region_ops_t region_cn_470_rp_1_0_ops;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC TYPES ------------------------------------------------------------
@@ -107,9 +112,9 @@ status_lorawan_t region_cn_470_rp_1_0_get_next_channel( smtc_real_t* real, uint8
  * \param [IN]  none
  * \param [OUT] return
  */
-status_lorawan_t region_cn_470_rp_1_0_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
+status_lorawan_t region_cn_470_rp_1_0_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
                                                              uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                             uint8_t* active_channel_nb );
+                                                             uint32_t* out_rx2_frequency, uint8_t* active_channel_nb );
 /**
  * \brief
  * \remark
@@ -134,6 +139,14 @@ bool region_cn_470_rp_1_0_are_all_default_channels_enabled( smtc_real_t* real );
  */
 void region_cn_470_rp_1_0_enable_all_channels_with_valid_freq( smtc_real_t* real );
 
+/**
+ * \brief Apply the unwrapped channel mask to the enabled channels
+ * \remark
+ * \param [IN]  none
+ * \param [OUT] return
+ */
+void region_cn_470_rp_1_0_set_channel_mask( smtc_real_t* real );
+
 /**
  * @brief Get the corresponding RF modulation from a Datarate
  *
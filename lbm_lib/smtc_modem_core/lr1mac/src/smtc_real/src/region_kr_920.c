@@ -42,6 +42,7 @@
 #include "smtc_modem_hal.h"
 #include "region_kr_920_defs.h"
 #include "region_kr_920.h"
+#include "smtc_real.h"
 #include "smtc_modem_hal_dbg_trace.h"
 
 /*
@@ -81,6 +82,33 @@
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
+/**
+ * @brief Clamp the tx power to the maximum EIRP allowed for the frequency and the datarate
+ *
+ * @param real
+ * @param tx_power
+ * @param tx_frequency
+ * @param datarate
+ * @return int8_t
+ */
+static int8_t region_kr_920_clamp_output_power_eirp_vs_freq_and_dr( smtc_real_t* real, int8_t tx_power,
+                                                                    uint32_t tx_frequency, uint8_t datarate );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_kr_920_ops = {
+    .config                                 = region_kr_920_config,
+    .get_next_channel                       = region_kr_920_get_next_channel,
+    .get_join_next_channel                  = region_kr_920_get_join_next_channel,
+    .build_channel_mask                     = region_kr_920_build_channel_mask,
+    .clamp_output_power_eirp_vs_freq_and_dr = region_kr_920_clamp_output_power_eirp_vs_freq_and_dr,
+    .get_modulation_type_from_datarate      = region_kr_920_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                       = region_kr_920_lora_dr_to_sf_bw,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -174,11 +202,12 @@ void region_kr_920_config( smtc_real_t* real )
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_KR920 );
 }
 
-status_lorawan_t region_kr_920_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
+status_lorawan_t region_kr_920_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                      uint8_t* active_channel_nb )
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
-    return region_kr_920_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency, active_channel_nb );
+    return region_kr_920_get_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
+                                           active_channel_nb );
 }
 
 status_lorawan_t region_kr_920_get_next_channel( smtc_real_t* real, uint8_t tx_data_rate, uint32_t* out_tx_frequency,
@@ -204,7 +233,12 @@ status_lorawan_t region_kr_920_get_next_channel( smtc_real_t* real, uint8_t tx_d
         SMTC_MODEM_HAL_TRACE_WARNING( "NO CHANNELS AVAILABLE \n" );
         return ERRORLORAWAN;
     }
-    uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
+    uint8_t nb_candidate_channel = *active_channel_nb;
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    // Leave out the channels that LBT or CAD found busy far more often than the others
+    nb_candidate_channel = smtc_real_channel_occupancy_filter( real, active_channel_index, nb_candidate_channel );
+#endif
+    uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( nb_candidate_channel - 1 ) ) ) % nb_candidate_channel;
     uint8_t channel_idx = 0;
     channel_idx         = active_channel_index[temp];
     if( channel_idx >= real_const.const_number_of_tx_channel )
@@ -311,4 +345,17 @@ void region_kr_920_lora_dr_to_sf_bw( uint8_t in_dr, uint8_t* out_sf, lr1mac_band
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+static int8_t region_kr_920_clamp_output_power_eirp_vs_freq_and_dr( smtc_real_t* real, int8_t tx_power,
+                                                                    uint32_t tx_frequency, uint8_t datarate )
+{
+    if( tx_frequency < 922000000 )
+    {
+        return MIN( tx_power, 10 );  // if freq < 922MHz, Max output power is limited to 10 dBm
+    }
+    else
+    {
+        return MIN( tx_power, TX_POWER_EIRP_KR_920 );  // else Max output power is limited to 14 dBm
+    }
+}
+
 /* --- EOF ------------------------------------------------------------------ */
@@ -61,6 +61,11 @@ extern "C" {
  * --- PUBLIC CONSTANTS --------------------------------------------------------
  */
 
+/**
+ * @brief Region operations, bound by smtc_real_init( )
+ */
+extern const smtc_real_region_ops_t region_kr_920_ops;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC TYPES ------------------------------------------------------------
@@ -94,9 +99,9 @@ status_lorawan_t region_kr_920_get_next_channel( smtc_real_t* real, uint8_t tx_d
  * \param [IN]  none
  * \param [OUT] return
  */
-status_lorawan_t region_kr_920_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
+status_lorawan_t region_kr_920_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                      uint8_t* active_channel_nb );
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb );
 /**
  * \brief
  * \remark
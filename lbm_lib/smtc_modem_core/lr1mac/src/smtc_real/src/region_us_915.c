@@ -63,6 +63,7 @@
 #define snapshot_channel_tx_mask real->region.us915.snapshot_channel_tx_mask
 #define snapshot_bank_tx_mask real->region.us915.snapshot_bank_tx_mask
 #define tx_channel_idx real->region.us915.tx_channel_idx
+#define dr_channel_mask real->region.us915.dr_channel_mask
 
 /*
  * -----------------------------------------------------------------------------
@@ -98,6 +99,63 @@ typedef enum ch_mask_after_join_e
  */
 static void region_us_915_channel_mask_set_after_join( smtc_real_t* real );
 
+/**
+ * @brief Rebuild the enabled tx channels bit array of each datarate
+ *
+ * @remark Shall be called each time channel_index_enabled or dr_bitfield_tx_channel is modified
+ *
+ * @param real
+ */
+static void region_us_915_update_dr_channel_mask( smtc_real_t* real );
+
+/**
+ * @brief Number of ChMask blocks carried by the CFList of the join accept
+ *
+ * @param real
+ * @return uint8_t
+ */
+static uint8_t region_us_915_get_number_of_chmask_in_cflist( smtc_real_t* real );
+
+/**
+ * @brief Clamp the tx power to the maximum EIRP allowed for the frequency and the datarate
+ *
+ * @param real
+ * @param tx_power
+ * @param tx_frequency
+ * @param datarate
+ * @return int8_t
+ */
+static int8_t region_us_915_clamp_output_power_eirp_vs_freq_and_dr( smtc_real_t* real, int8_t tx_power,
+                                                                    uint32_t tx_frequency, uint8_t datarate );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_us_915_ops = {
+    .config                                 = region_us_915_config,
+    .get_number_of_chmask_in_cflist         = region_us_915_get_number_of_chmask_in_cflist,
+    .get_next_channel                       = region_us_915_get_next_channel,
+    .get_join_next_channel                  = region_us_915_get_join_next_channel,
+    .mask_channel_used_for_tx               = region_us_915_mask_channel_used_for_tx,
+    .init_join_snapshot_channel_mask        = region_us_915_init_join_snapshot_channel_mask,
+    .init_after_join_snapshot_channel_mask  = region_us_915_init_after_join_snapshot_channel_mask,
+    .set_channel_mask                       = region_us_915_set_channel_mask,
+    .build_channel_mask                     = region_us_915_build_channel_mask,
+    .are_all_default_channels_enabled       = region_us_915_are_all_default_channels_enabled,
+    .enable_all_channels_with_valid_freq    = region_us_915_enable_all_channels_with_valid_freq,
+    .is_tx_dr_acceptable                    = region_us_915_is_acceptable_tx_dr,
+    .get_tx_frequency_channel               = region_us_915_get_tx_frequency_channel,
+    .get_rx1_frequency_channel              = region_us_915_get_rx1_frequency_channel,
+    .clamp_output_power_eirp_vs_freq_and_dr = region_us_915_clamp_output_power_eirp_vs_freq_and_dr,
+    .get_modulation_type_from_datarate      = region_us_915_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                       = region_us_915_lora_dr_to_sf_bw,
+    .lr_fhss_dr_to_cr_bw                    = region_us_915_lr_fhss_dr_to_cr_bw,
+    .get_rx_beacon_frequency_channel        = region_us_915_get_rx_beacon_frequency_channel,
+    .get_rx_ping_slot_frequency_channel     = region_us_915_get_rx_ping_slot_frequency_channel,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -163,6 +221,7 @@ void region_us_915_init( smtc_real_t* real )
     // Enable all channels
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_US915 );
     memset( &snapshot_channel_tx_mask[0], 0xFF, BANK_MAX_US915 );
+    memset( dr_channel_mask, 0, sizeof( dr_channel_mask ) );
 
     snapshot_bank_tx_mask = 0;
 }
@@ -204,6 +263,7 @@ void region_us_915_config( smtc_real_t* real )
         SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "%s", ( ( i % 8 ) == 7 ) ? "---\n" : "" );
     }
 #endif
+    region_us_915_update_dr_channel_mask( real );
 
     first_ch_mask_received = ch_mask_after_join_init;
 }
@@ -258,7 +318,7 @@ status_lorawan_t region_us_915_is_acceptable_tx_dr( smtc_real_t* real, uint8_t d
 
 status_lorawan_t region_us_915_get_join_next_channel( smtc_real_t* real, uint8_t* out_tx_data_rate,
                                                       uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                      uint8_t* active_channel_nb )
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
     us_915_channels_bank_t bank_tmp_cnt = 0;
     uint8_t                active_channel_index[NUMBER_OF_TX_CHANNEL_US_915];
@@ -388,18 +448,18 @@ status_lorawan_t region_us_915_get_next_channel( smtc_real_t* real, uint8_t tx_d
         region_us_915_init_after_join_snapshot_channel_mask( real, tx_data_rate, *out_tx_frequency );
     }
 
-    // Seach all active channels and put in array to be randomly select
+    // Search all active channels: enabled channels supporting the datarate and not already used in the snapshot
     *active_channel_nb = 0;
-    uint8_t active_channel_index[NUMBER_OF_TX_CHANNEL_US_915];
-    for( uint8_t i = 0; i < NUMBER_OF_TX_CHANNEL_US_915; i++ )
+    uint32_t active_channel_mask[NUMBER_OF_WORD32_TX_CHANNEL_US_915] = { 0 };
+    if( tx_data_rate < NUMBER_OF_TX_DR_US_915 )
     {
-        if( ( SMTC_GET_BIT8( snapshot_channel_tx_mask, i ) == CHANNEL_ENABLED ) &&
-            ( SMTC_GET_BIT8( channel_index_enabled, i ) == CHANNEL_ENABLED ) &&
-            ( SMTC_GET_BIT16( &dr_bitfield_tx_channel[i], tx_data_rate ) == 1 ) )
+        for( uint8_t i = 0; i < NUMBER_OF_WORD32_TX_CHANNEL_US_915; i++ )
         {
-            active_channel_index[*active_channel_nb] = i;
-            ( *active_channel_nb )++;
+            active_channel_mask[i] =
+                dr_channel_mask[tx_data_rate][i] &
+                lr1mac_utilities_get_word32_from_bit8( snapshot_channel_tx_mask, BANK_MAX_US915, i );
         }
+        *active_channel_nb = lr1mac_utilities_bit32_count( active_channel_mask, NUMBER_OF_WORD32_TX_CHANNEL_US_915 );
     }
     if( *active_channel_nb == 0 )
     {
@@ -408,7 +468,8 @@ status_lorawan_t region_us_915_get_next_channel( smtc_real_t* real, uint8_t tx_d
 
     // Select a channel in array
     uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
-    uint8_t channel_idx = active_channel_index[temp];
+    uint8_t channel_idx =
+        lr1mac_utilities_bit32_get_nth( active_channel_mask, NUMBER_OF_WORD32_TX_CHANNEL_US_915, temp );
     if( channel_idx >= NUMBER_OF_TX_CHANNEL_US_915 )
     {
         SMTC_MODEM_HAL_TRACE_ERROR( "INVALID CHANNEL  active channel = %d and random channel = %d \n",
@@ -650,6 +711,7 @@ void region_us_915_enable_all_channels_with_valid_freq( smtc_real_t* real )
         SMTC_PUT_BIT8( channel_index_enabled, i, CHANNEL_ENABLED );
         dr_bitfield_tx_channel[i] = DEFAULT_TX_DR_500_BIT_FIELD_US_915;
     }
+    region_us_915_update_dr_channel_mask( real );
 }
 
 modulation_type_t region_us_915_get_modulation_type_from_datarate( uint8_t datarate )
@@ -734,11 +796,32 @@ uint32_t region_us_915_get_rx_ping_slot_frequency_channel( smtc_real_t* real, ui
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+static uint8_t region_us_915_get_number_of_chmask_in_cflist( smtc_real_t* real )
+{
+    return 5;
+}
+
+static int8_t region_us_915_clamp_output_power_eirp_vs_freq_and_dr( smtc_real_t* real, int8_t tx_power,
+                                                                    uint32_t tx_frequency, uint8_t datarate )
+{
+    if( datarate == DR4 )
+    {
+        return MIN( tx_power, 26 );
+    }
+    else if( ( datarate < NUMBER_OF_TX_DR_US_915 ) &&
+             ( lr1mac_utilities_bit32_count( dr_channel_mask[datarate], NUMBER_OF_WORD32_TX_CHANNEL_US_915 ) < 50 ) )
+    {
+        return MIN( tx_power, 21 );
+    }
+    return tx_power;
+}
+
 static void region_us_915_channel_mask_set_after_join( smtc_real_t* real )
 {
     // Copy all unwrapped channels in channel enable and in snapshot
     memcpy( channel_index_enabled, unwrapped_channel_mask, BANK_MAX_US915 );
     memcpy( snapshot_channel_tx_mask, unwrapped_channel_mask, BANK_MAX_US915 );
+    region_us_915_update_dr_channel_mask( real );
 
 #if ( BSP_DBG_TRACE == BSP_FEATURE_ON )
     SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "Ch 125kHz\n" );
@@ -758,4 +841,10 @@ static void region_us_915_channel_mask_set_after_join( smtc_real_t* real )
     first_ch_mask_received++;
 }
 
+static void region_us_915_update_dr_channel_mask( smtc_real_t* real )
+{
+    lr1mac_utilities_build_dr_channel_mask( &dr_channel_mask[0][0], NUMBER_OF_TX_DR_US_915, channel_index_enabled,
+                                            dr_bitfield_tx_channel, NUMBER_OF_TX_CHANNEL_US_915 );
+}
+
 /* --- EOF ------------------------------------------------------------------ */
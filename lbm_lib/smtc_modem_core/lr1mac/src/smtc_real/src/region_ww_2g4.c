@@ -41,6 +41,7 @@
 #include "smtc_modem_hal.h"
 #include "region_ww_2g4_defs.h"
 #include "region_ww_2g4.h"
+#include "smtc_real.h"
 #include "smtc_modem_hal_dbg_trace.h"
 
 /*
@@ -80,6 +81,20 @@
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+const smtc_real_region_ops_t region_ww_2g4_ops = {
+    .config                            = region_ww_2g4_config,
+    .get_next_channel                  = region_ww_2g4_get_next_channel,
+    .get_join_next_channel             = region_ww_2g4_get_join_next_channel,
+    .build_channel_mask                = region_ww_2g4_build_channel_mask,
+    .get_modulation_type_from_datarate = region_ww_2g4_get_modulation_type_from_datarate,
+    .lora_dr_to_sf_bw                  = region_ww_2g4_lora_dr_to_sf_bw,
+};
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -179,11 +194,12 @@ void region_ww_2g4_config( smtc_real_t* real )
     memset( &unwrapped_channel_mask[0], 0xFF, BANK_MAX_WW_2G4 );
 }
 
-status_lorawan_t region_ww_2g4_get_join_next_channel( smtc_real_t* real, uint8_t tx_data_rate,
-                                                     uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
-                                                     uint8_t* active_channel_nb )
+status_lorawan_t region_ww_2g4_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate,
+                                                      uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
+                                                      uint32_t* out_rx2_frequency, uint8_t* active_channel_nb )
 {
-    return region_ww_2g4_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency, active_channel_nb );
+    return region_ww_2g4_get_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
+                                           active_channel_nb );
 }
 
 status_lorawan_t region_ww_2g4_get_next_channel( smtc_real_t* real, uint8_t tx_data_rate, uint32_t* out_tx_frequency,
@@ -208,7 +224,12 @@ status_lorawan_t region_ww_2g4_get_next_channel( smtc_real_t* real, uint8_t tx_d
         SMTC_MODEM_HAL_TRACE_WARNING( "NO CHANNELS AVAILABLE \n" );
         return ERRORLORAWAN;
     }
-    uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( *active_channel_nb - 1 ) ) ) % *active_channel_nb;
+    uint8_t nb_candidate_channel = *active_channel_nb;
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    // Leave out the channels that LBT or CAD found busy far more often than the others
+    nb_candidate_channel = smtc_real_channel_occupancy_filter( real, active_channel_index, nb_candidate_channel );
+#endif
+    uint8_t temp = ( smtc_modem_hal_get_random_nb_in_range( 0, ( nb_candidate_channel - 1 ) ) ) % nb_candidate_channel;
     uint8_t channel_idx = 0;
     channel_idx         = active_channel_index[temp];
     if( channel_idx >= real_const.const_number_of_tx_channel )
@@ -125,11 +125,17 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
     // Init all real_const.const_xxx to 0
     memset( &( real_const ), 0, sizeof( smtc_real_const_t ) );
 
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    // Frequencies of the previous region are meaningless in the new one
+    memset( real->channel_occupancy, 0, sizeof( real->channel_occupancy ) );
+#endif
+
     switch( real->region_type )
     {
 #if defined( REGION_WW_2G4 )
     case SMTC_REAL_REGION_WW_2G4:
     {
+        real->region_ops = &region_ww_2g4_ops;
         region_ww_2g4_init( real );
         break;
     }
@@ -137,6 +143,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_EU_868 )
     case SMTC_REAL_REGION_EU_868:
     {
+        real->region_ops = &region_eu_868_ops;
         region_eu_868_init( real );
         break;
     }
@@ -144,22 +151,26 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_AS_923 )
     case SMTC_REAL_REGION_AS_923:
     {
+        real->region_ops = &region_as_923_ops;
         region_as_923_init( real, 1 );
         break;
     }
     case SMTC_REAL_REGION_AS_923_GRP2:
     {
+        real->region_ops = &region_as_923_ops;
         region_as_923_init( real, 2 );
         break;
     }
     case SMTC_REAL_REGION_AS_923_GRP3:
     {
+        real->region_ops = &region_as_923_ops;
         region_as_923_init( real, 3 );
         break;
     }
 #if defined( RP2_103 )
     case SMTC_REAL_REGION_AS_923_GRP4:
     {
+        real->region_ops = &region_as_923_ops;
         region_as_923_init( real, 4 );
         break;
     }
@@ -168,6 +179,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_US_915 )
     case SMTC_REAL_REGION_US_915:
     {
+        real->region_ops = &region_us_915_ops;
         region_us_915_init( real );
         break;
     }
@@ -175,6 +187,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_AU_915 )
     case SMTC_REAL_REGION_AU_915:
     {
+        real->region_ops = &region_au_915_ops;
         region_au_915_init( real );
         break;
     }
@@ -182,6 +195,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_CN_470 )
     case SMTC_REAL_REGION_CN_470:
     {
+        real->region_ops = &region_cn_470_ops;
         region_cn_470_init( real );
         break;
     }
@@ -189,6 +203,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_CN_470_RP_1_0 )
     case SMTC_REAL_REGION_CN_470_RP_1_0:
     {
+        real->region_ops = &region_cn_470_rp_1_0_ops;
         region_cn_470_rp_1_0_init( real );
         break;
     }
@@ -196,6 +211,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_IN_865 )
     case SMTC_REAL_REGION_IN_865:
     {
+        real->region_ops = &region_in_865_ops;
         region_in_865_init( real );
         break;
     }
@@ -203,6 +219,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_KR_920 )
     case SMTC_REAL_REGION_KR_920:
     {
+        real->region_ops = &region_kr_920_ops;
         region_kr_920_init( real );
         break;
     }
@@ -210,6 +227,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 #if defined( REGION_RU_864 )
     case SMTC_REAL_REGION_RU_864:
     {
+        real->region_ops = &region_ru_864_ops;
         region_ru_864_init( real );
         break;
     }
@@ -224,87 +242,7 @@ void smtc_real_init( smtc_real_t* real, smtc_real_region_types_t region_type )
 
 void smtc_real_config( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-    {
-        region_ww_2g4_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-    {
-        region_eu_868_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-    {
-        region_as_923_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        region_au_915_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        region_cn_470_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        region_cn_470_rp_1_0_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-    {
-        region_in_865_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-    {
-        region_kr_920_config( real );
-        break;
-    }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-    {
-        region_ru_864_config( real );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
+    real->region_ops->config( real );
 
     uplink_dwell_time_ctx   = real_const.const_uplink_dwell_time;
     downlink_dwell_time_ctx = false;
@@ -312,61 +250,9 @@ void smtc_real_config( smtc_real_t* real )
 
 void smtc_real_config_session( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_US_915 ) || \
-    defined( REGION_AU_915 ) || defined( REGION_IN_865 ) || defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-    {
-        // Not used for these regions
-        break;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        region_cn_470_config_session( real );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
+    if( real->region_ops->config_session != NULL )
     {
-        // Not used for these regions
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
+        real->region_ops->config_session( real );
     }
 }
 
@@ -608,1928 +494,655 @@ status_lorawan_t smtc_real_update_cflist( smtc_real_t* real, uint8_t* cf_list )
 
 uint8_t smtc_real_get_number_of_chmask_in_cflist( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
+    if( real->region_ops->get_number_of_chmask_in_cflist == NULL )
     {
         return 0;
     }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        return 5;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_get_number_of_chmask_in_cflist( real );
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_get_number_of_chmask_in_cflist( real );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
+    return real->region_ops->get_number_of_chmask_in_cflist( real );
 }
 
 status_lorawan_t smtc_real_get_next_channel( smtc_real_t* real, uint8_t tx_data_rate, uint32_t* out_tx_frequency,
                                              uint32_t* out_rx1_frequency, uint8_t* out_nb_available_tx_channel )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-    {
-        return region_ww_2g4_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
+    return real->region_ops->get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
                                                out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
+}
+
+status_lorawan_t smtc_real_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate, uint32_t* out_tx_frequency,
+                                                  uint32_t* out_rx1_frequency, uint32_t* out_rx2_frequency,
+                                                  uint8_t* out_nb_available_tx_channel )
+{
+    return real->region_ops->get_join_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
+                                                    out_rx2_frequency, out_nb_available_tx_channel );
+}
+
+void smtc_real_mask_channel_used_for_tx( smtc_real_t* real )
+{
+    // Mask the channel used, to be remove for the next selection (only for regions with a channel snapshot)
+    if( real->region_ops->mask_channel_used_for_tx != NULL )
     {
-        return region_eu_868_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        real->region_ops->mask_channel_used_for_tx( real );
     }
-#endif
+}
+
+uint8_t smtc_real_get_rx1_datarate_config( smtc_real_t* real, uint8_t tx_data_rate, uint8_t rx1_dr_offset )
+{
+    uint8_t max   = real_const.const_number_of_tx_dr * real_const.const_number_rx1_dr_offset;
+    uint8_t index = ( tx_data_rate * real_const.const_number_rx1_dr_offset ) + rx1_dr_offset;
+
 #if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
+    if( real->region_type == SMTC_REAL_REGION_AS_923 )
     {
-        return region_as_923_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        max *= ( downlink_dwell_time_ctx + 1 );
+        index += ( downlink_dwell_time_ctx * real_const.const_number_of_tx_dr * real_const.const_number_rx1_dr_offset );
     }
 #endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+
+    if( index >= max )
     {
-        return region_us_915_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+    return real_const.const_datarate_offsets[index];
+}
+
+int8_t smtc_real_convert_power_cmd( smtc_real_t* real, uint8_t power_cmd, uint8_t max_erp_dbm )
+{
+    if( power_cmd > real_const.const_max_tx_power_idx )
     {
-        return region_au_915_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        SMTC_MODEM_HAL_TRACE_WARNING( "INVALID %d \n", power_cmd );
+        return max_erp_dbm;
     }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
+    else
     {
-        return region_cn_470_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        return ( max_erp_dbm - ( 2 * power_cmd ) );
     }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
+}
+
+void smtc_real_set_channel_mask( smtc_real_t* real )
+{
+    if( real->region_ops->set_channel_mask != NULL )
     {
-        return region_cn_470_rp_1_0_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                      out_nb_available_tx_channel );
+        real->region_ops->set_channel_mask( real );
+        return;
     }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
+
+    // Copy all unwrapped channels in channel enable
+    memcpy( channel_index_enabled_ctx, unwrapped_channel_mask_ctx, real_const.const_number_of_channel_bank );
+
+#if ( MODEM_HAL_DBG_TRACE == MODEM_HAL_FEATURE_ON )
+    char channels_str[real_const.const_number_of_tx_channel * 3 + 1];
+    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
     {
-        return region_in_865_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
+        sprintf( channels_str + i * 3, "%d  ", SMTC_GET_BIT8( channel_index_enabled_ctx, i ) );
     }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-    {
-        return region_kr_920_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-    {
-        return region_ru_864_get_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                               out_nb_available_tx_channel );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-status_lorawan_t smtc_real_get_join_next_channel( smtc_real_t* real, uint8_t* tx_data_rate, uint32_t* out_tx_frequency,
-                                                  uint32_t* out_rx1_frequency, uint32_t* out_rx2_frequency,
-                                                  uint8_t* out_nb_available_tx_channel )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-    {
-        return region_ww_2g4_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-    {
-        return region_eu_868_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-    {
-        return region_as_923_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        return region_us_915_get_join_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        return region_au_915_get_join_next_channel( real, tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_rx2_frequency, out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                           out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-    {
-        return region_in_865_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-    {
-        return region_kr_920_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-    {
-        return region_ru_864_get_join_next_channel( real, *tx_data_rate, out_tx_frequency, out_rx1_frequency,
-                                                    out_nb_available_tx_channel );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-void smtc_real_mask_channel_used_for_tx( smtc_real_t* real )
-{
-    // Mask the channel used, to be remove for the next selection
-
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 ) || defined( REGION_CN_470 ) ||                             \
-    defined( REGION_CN_470_RP_1_0 )
-    {
-        // Not used for these regions
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-        region_us_915_mask_channel_used_for_tx( real );
-        break;
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-        region_au_915_mask_channel_used_for_tx( real );
-        break;
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-uint8_t smtc_real_get_rx1_datarate_config( smtc_real_t* real, uint8_t tx_data_rate, uint8_t rx1_dr_offset )
-{
-    uint8_t max   = real_const.const_number_of_tx_dr * real_const.const_number_rx1_dr_offset;
-    uint8_t index = ( tx_data_rate * real_const.const_number_rx1_dr_offset ) + rx1_dr_offset;
-
-#if defined( REGION_AS_923 )
-    if( real->region_type == SMTC_REAL_REGION_AS_923 )
-    {
-        max *= ( downlink_dwell_time_ctx + 1 );
-        index += ( downlink_dwell_time_ctx * real_const.const_number_of_tx_dr * real_const.const_number_rx1_dr_offset );
-    }
-#endif
-
-    if( index >= max )
-    {
-        SMTC_MODEM_HAL_PANIC( );
-    }
-    return real_const.const_datarate_offsets[index];
-}
-
-int8_t smtc_real_convert_power_cmd( smtc_real_t* real, uint8_t power_cmd, uint8_t max_erp_dbm )
-{
-    if( power_cmd > real_const.const_max_tx_power_idx )
-    {
-        SMTC_MODEM_HAL_TRACE_WARNING( "INVALID %d \n", power_cmd );
-        return max_erp_dbm;
-    }
-    else
-    {
-        return ( max_erp_dbm - ( 2 * power_cmd ) );
-    }
-}
-
-void smtc_real_set_channel_mask( smtc_real_t* real )
-{
-#if ( MODEM_HAL_DBG_TRACE == MODEM_HAL_FEATURE_ON )
-    char channels_str[real_const.const_number_of_tx_channel * 3 + 1];
-#endif
-
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_CN_470 ) || \
-    defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) || defined( REGION_KR_920 ) ||                      \
-    defined( REGION_RU_864 )
-        // Copy all unwrapped channels in channel enable
-        memcpy( channel_index_enabled_ctx, unwrapped_channel_mask_ctx, real_const.const_number_of_channel_bank );
-
-#if ( MODEM_HAL_DBG_TRACE == MODEM_HAL_FEATURE_ON )
-        for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
-        {
-            sprintf( channels_str + i * 3, "%d  ", SMTC_GET_BIT8( channel_index_enabled_ctx, i ) );
-        }
-        channels_str[real_const.const_number_of_tx_channel * 3] = '\0';
-        SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( " %s\n", channels_str );
-#endif  // MODEM_HAL_DBG_TRACE == MODEM_HAL_FEATURE_ON
-        break;
-#endif
-
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_set_channel_mask( real );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        region_au_915_set_channel_mask( real );
-        break;
-    }
-#endif
-
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-void smtc_real_init_channel_mask( smtc_real_t* real )
-{
-    memset( unwrapped_channel_mask_ctx, 0xFF, real_const.const_number_of_channel_bank );
-}
-
-void smtc_real_init_join_snapshot_channel_mask( smtc_real_t* real )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_CN_470 ) || \
-    defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) || defined( REGION_KR_920 ) ||                      \
-    defined( REGION_RU_864 )
-    {
-        // Not used for these regions
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_init_join_snapshot_channel_mask( real );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        region_au_915_init_join_snapshot_channel_mask( real );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-void smtc_real_init_after_join_snapshot_channel_mask( smtc_real_t* real, uint8_t tx_data_rate, uint32_t tx_frequency )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_CN_470 ) || \
-    defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) || defined( REGION_KR_920 ) ||                      \
-    defined( REGION_RU_864 )
-    {
-        // Not used for these regions
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_init_after_join_snapshot_channel_mask( real, tx_data_rate, tx_frequency );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        region_au_915_init_after_join_snapshot_channel_mask( real, tx_data_rate, tx_frequency );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-status_channel_t smtc_real_build_channel_mask( smtc_real_t* real, uint8_t ch_mask_cntl, uint16_t ch_mask )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-    {
-        return region_ww_2g4_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-    {
-        return region_eu_868_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-    {
-        return region_as_923_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        return region_us_915_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        return region_au_915_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-    {
-        return region_in_865_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-    {
-        return region_kr_920_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-    {
-        return region_ru_864_build_channel_mask( real, ch_mask_cntl, ch_mask );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERROR_CHANNEL;  // never reach => avoid warning
-}
-
-uint8_t smtc_real_decrement_dr_simulation( smtc_real_t* real, uint8_t tx_data_rate_adr )
-{
-    bool    is_valid_dr          = false;
-    uint8_t data_rate_simulation = tx_data_rate_adr;
-
-    // while( ( data_rate_simulation > real_const.const_min_tx_dr ) && ( is_valid_dr == 0 ) )
-    while( data_rate_simulation > real_const.const_min_tx_dr )
-    {
-        uint8_t index = ( uplink_dwell_time_ctx * real_const.const_number_of_tx_dr ) + data_rate_simulation;
-        if( index > ( real_const.const_max_tx_dr * ( uplink_dwell_time_ctx + 1 ) ) )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        data_rate_simulation = real_const.const_datarate_backoff[index];
-
-        // Check if new DR is valid for at least 1 enabled channel
-        if( smtc_real_is_tx_dr_acceptable( real, data_rate_simulation, false ) == OKLORAWAN )
-        {
-            is_valid_dr = true;
-            break;
-        }
-    }
-
-    // no lower valid DR found
-    if( is_valid_dr == false )
-    {
-        return tx_data_rate_adr;
-    }
-
-    return data_rate_simulation;
-}
-
-void smtc_real_decrement_dr( smtc_real_t* real, dr_strategy_t adr_mode_select, uint8_t* tx_data_rate_adr,
-                             int8_t* tx_power, uint8_t* nb_trans, uint8_t* no_downlink_limit_bitfield )
-{
-    if( adr_mode_select != STATIC_ADR_MODE )
-    {
-        return;
-    }
-
-    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + 1 * ADR_ACK_DELAY (typ. 32)
-    // Set output power to default
-    if( *tx_power < real_const.const_tx_power_dbm )
-    {
-        *tx_power = real_const.const_tx_power_dbm;
-        return;
-    }
-
-    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + 2 * ADR_ACK_DELAY (typ. 32)
-    // Decrement DR by 1
-
-    if( *tx_data_rate_adr != smtc_real_get_min_tx_channel_dr(
-                                 real ) )  // Check if actual DR isn't already the min on actually enabled channels
-    {
-        // Check if we can decrement DR using ADR back-off table
-        uint8_t dr_tmp = smtc_real_decrement_dr_simulation( real, *tx_data_rate_adr );
-        if( *tx_data_rate_adr != dr_tmp )
-        {
-            *tx_data_rate_adr = dr_tmp;
-            return;
-        }
-    }
-
-    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + N * ADR_ACK_DELAY (typ. 32)
-    // We are in the lowest possible DR for actually enabled channels
-    // Set NbTrans to 1 and re-enable default channels (if not already the case)
-
-    if( ( *nb_trans != 1 ) || ( !smtc_real_are_all_default_channels_enabled( real ) ) )
-    {
-        // nb_trans must set to 1 and all default channels re-enabled
-        *nb_trans = 1;
-        smtc_real_enable_all_channels_with_valid_freq( real );
-        // When all channels are once again available, a lower datarate could be available (in case where only DR6 and
-        // DR7 were present previously, or if user created channels w/ min DR different than default one)
-        *tx_data_rate_adr = smtc_real_decrement_dr_simulation( real, *tx_data_rate_adr );
-        return;
-    }
-
-    // If we arrive here, it means we already tried everything to regain connectivity
-    *no_downlink_limit_bitfield |= 1 << SMTC_REAL_ADR_BACKOFF_END;
-}
-
-// Return true if all default channels were already enabled, false otherwise
-bool smtc_real_are_all_default_channels_enabled( smtc_real_t* real )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-    {
-        for( uint8_t i = 0; i < real_const.const_number_of_boot_tx_channel; i++ )
-        {
-            if( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == 0 )  // If at least 1 default ch is disabled
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_are_all_default_channels_enabled( real );
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_are_all_default_channels_enabled( real );
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        return region_us_915_are_all_default_channels_enabled( real );
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        return region_au_915_are_all_default_channels_enabled( real );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        return false;  // Never reached
-    }
-}
-
-// Enable all default channels, and set their DR range to default one
-void smtc_real_enable_all_channels_with_valid_freq( smtc_real_t* real )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-    {
-        for( uint8_t i = 0; i < real_const.const_number_of_boot_tx_channel; i++ )
-        {
-            SMTC_PUT_BIT8( channel_index_enabled_ctx, i, CHANNEL_ENABLED );
-            dr_bitfield_tx_channel_ctx[i] = real_const.const_default_tx_dr_bit_field;
-        }
-        break;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        region_cn_470_enable_all_channels_with_valid_freq( real );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        region_cn_470_rp_1_0_enable_all_channels_with_valid_freq( real );
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_enable_all_channels_with_valid_freq( real );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        region_au_915_enable_all_channels_with_valid_freq( real );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-status_lorawan_t smtc_real_is_rx1_dr_offset_valid( smtc_real_t* real, uint8_t rx1_dr_offset )
-{
-    status_lorawan_t status = OKLORAWAN;
-    if( rx1_dr_offset >= real_const.const_number_rx1_dr_offset )
-    {
-        status = ERRORLORAWAN;
-        SMTC_MODEM_HAL_TRACE_WARNING( "RECEIVE AN INVALID Rx1 DR OFFSET \n" );
-    }
-    return ( status );
-}
-
-status_lorawan_t smtc_real_is_rx_dr_valid( smtc_real_t* real, uint8_t dr )
-{
-    if( ( dr >= real_const.const_min_rx_dr ) && ( dr <= real_const.const_max_rx_dr ) )
-    {
-        if( SMTC_GET_BIT16( &real_const.const_dr_bitfield, dr ) == 1 )
-        {
-            return ( OKLORAWAN );
-        }
-    }
-    SMTC_MODEM_HAL_TRACE_WARNING( "Invalid Rx datarate %d\n", dr );
-
-    return ( ERRORLORAWAN );
-}
-
-status_lorawan_t smtc_real_is_tx_dr_valid( smtc_real_t* real, uint8_t dr )
-{
-    if( ( dr >= real_const.const_min_tx_dr ) && ( dr <= real_const.const_max_tx_dr ) )
-    {
-        if( SMTC_GET_BIT16( &real_const.const_dr_bitfield, dr ) == 1 )
-        {
-            return ( OKLORAWAN );
-        }
-    }
-    SMTC_MODEM_HAL_TRACE_WARNING( "Invalid Tx datarate %d\n", dr );
-
-    return ( ERRORLORAWAN );
-}
-
-status_lorawan_t smtc_real_is_tx_dr_acceptable( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_CN_470 ) || \
-    defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) || defined( REGION_KR_920 ) ||                      \
-    defined( REGION_RU_864 )
-    {
-        uint8_t* ch_mask_to_check =
-            ( is_ch_mask_from_link_adr == true ) ? unwrapped_channel_mask_ctx : channel_index_enabled_ctx;
-
-        if( uplink_dwell_time_ctx == true )
-        {
-            if( dr < real_const.const_min_tx_dr_limit )
-            {
-                return ERRORLORAWAN;
-            }
-        }
-
-        for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
-        {
-            if( SMTC_GET_BIT8( ch_mask_to_check, i ) == CHANNEL_ENABLED )
-            {
-                SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "ch%d - dr field 0x%04x\n", i, dr_bitfield_tx_channel_ctx[i] );
-                if( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 )
-                {
-                    return ( OKLORAWAN );
-                }
-            }
-        }
-
-        SMTC_MODEM_HAL_TRACE_WARNING( "Not acceptable data rate\n" );
-        return ( ERRORLORAWAN );
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-        return region_us_915_is_acceptable_tx_dr( real, dr, is_ch_mask_from_link_adr );
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-        return region_au_915_is_acceptable_tx_dr( real, dr, is_ch_mask_from_link_adr, uplink_dwell_time_ctx );
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-status_lorawan_t smtc_real_is_nwk_received_tx_frequency_valid( smtc_real_t* real, uint32_t frequency )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-    {
-        status_lorawan_t status = OKLORAWAN;
-        if( frequency == 0 )
-        {
-            return ( status );
-        }
-        status = smtc_real_is_frequency_valid( real, frequency );
-        return ( status );
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        return ( ERRORLORAWAN );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-status_lorawan_t smtc_real_is_channel_index_valid( smtc_real_t* real, uint8_t channel_index )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-    {
-        status_lorawan_t status = OKLORAWAN;
-        if( ( channel_index < real_const.const_number_of_boot_tx_channel ) ||
-            ( channel_index >= real_const.const_number_of_tx_channel ) )
-        {
-            status = ERRORLORAWAN;
-            SMTC_MODEM_HAL_TRACE_WARNING( "RECEIVE AN INVALID Channel Index Cmd = %d\n", channel_index );
-        }
-        return ( status );
-    }
-#endif
-
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        return ( ERRORLORAWAN );
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-status_lorawan_t smtc_real_is_payload_size_valid( smtc_real_t* real, uint8_t dr, uint8_t size,
-                                                  direction_frame_t direction_frame, uint8_t tx_fopts_current_length )
-{
-    bool dwell_time_enabled = ( direction_frame == UP_LINK ) ? uplink_dwell_time_ctx : downlink_dwell_time_ctx;
-    if( ( real_const.const_tx_param_setup_req_supported == false ) && ( dwell_time_enabled != 0 ) )
-    {
-        SMTC_MODEM_HAL_PANIC( );
-    }
-
-    uint8_t index = ( dwell_time_enabled * real_const.const_number_of_tx_dr ) + dr;
-
-#if defined( REGION_AU_915 )
-    if( real->region_type == SMTC_REAL_REGION_AU_915 )
-    {
-        // *2 because the array contains Tx and Rx datarate
-        index = ( dwell_time_enabled * real_const.const_number_of_tx_dr * 2 ) + dr;
-    }
-#endif
-
-    status_lorawan_t status = ( ( size + tx_fopts_current_length ) > ( real_const.const_max_payload_m[index] - 8 ) )
-                                  ? ERRORLORAWAN
-                                  : OKLORAWAN;
-    if( status == ERRORLORAWAN )
-    {
-        SMTC_MODEM_HAL_TRACE_PRINTF( "Invalid size (data:%d + FOpts:%d) > %d for dr: %d\n", size,
-                                     tx_fopts_current_length, ( real_const.const_max_payload_m[index] - 8 ), dr );
-    }
-    return ( status );
-}
-
-void smtc_real_set_tx_frequency_channel( smtc_real_t* real, uint32_t tx_freq, uint8_t channel_index )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_tx_channel )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        else
-        {
-            tx_frequency_channel_ctx[channel_index] = tx_freq;
-        }
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        // Not supported
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-status_lorawan_t smtc_real_set_rx1_frequency_channel( smtc_real_t* real, uint32_t rx_freq, uint8_t channel_index )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_rx_channel )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        else
-        {
-            rx1_frequency_channel_ctx[channel_index] = rx_freq;
-        }
-        return OKLORAWAN;
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        // Not supported
-        return ERRORLORAWAN;
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return ERRORLORAWAN;  // never reach => avoid warning
-}
-
-void smtc_real_set_channel_dr( smtc_real_t* real, uint8_t channel_index, uint8_t dr_min, uint8_t dr_max )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_tx_channel )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        else
-        {
-            dr_bitfield_tx_channel_ctx[channel_index] = 0;
-            for( uint8_t i = dr_min; i <= dr_max; i++ )
-            {
-                uint8_t tmp_dr = SMTC_GET_BIT16( &real_const.const_dr_bitfield, i );
-                SMTC_PUT_BIT16( &dr_bitfield_tx_channel_ctx[channel_index], i, tmp_dr );
-            }
-        }
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        // Not supported
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-void smtc_real_set_channel_enabled( smtc_real_t* real, uint8_t enable, uint8_t channel_index )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_tx_channel )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        else
-        {
-            SMTC_PUT_BIT8( channel_index_enabled_ctx, channel_index, enable );
-        }
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_US_915 ) || defined( REGION_AU_915 )
-    {
-        // Not supported
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-}
-
-uint32_t smtc_real_get_tx_channel_frequency( smtc_real_t* real, uint8_t channel_index )
-{
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_tx_channel )
-        {
-            SMTC_MODEM_HAL_PANIC( );
-        }
-        return ( tx_frequency_channel_ctx[channel_index] );
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_get_tx_frequency_channel( real, channel_index );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_get_tx_frequency_channel( real, channel_index );
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+    channels_str[real_const.const_number_of_tx_channel * 3] = '\0';
+    SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( " %s\n", channels_str );
+#endif  // MODEM_HAL_DBG_TRACE == MODEM_HAL_FEATURE_ON
+}
+
+void smtc_real_init_channel_mask( smtc_real_t* real )
+{
+    memset( unwrapped_channel_mask_ctx, 0xFF, real_const.const_number_of_channel_bank );
+}
+
+void smtc_real_init_join_snapshot_channel_mask( smtc_real_t* real )
+{
+    if( real->region_ops->init_join_snapshot_channel_mask != NULL )
     {
-        return region_us_915_get_tx_frequency_channel( real, channel_index );
-        break;
+        real->region_ops->init_join_snapshot_channel_mask( real );
     }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+}
+
+void smtc_real_init_after_join_snapshot_channel_mask( smtc_real_t* real, uint8_t tx_data_rate, uint32_t tx_frequency )
+{
+    if( real->region_ops->init_after_join_snapshot_channel_mask != NULL )
     {
-        return region_au_915_get_tx_frequency_channel( real, channel_index );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
+        real->region_ops->init_after_join_snapshot_channel_mask( real, tx_data_rate, tx_frequency );
     }
-    return ERRORLORAWAN;  // never reach => avoid warning
 }
 
-uint32_t smtc_real_get_rx1_channel_frequency( smtc_real_t* real, uint8_t channel_index )
+status_channel_t smtc_real_build_channel_mask( smtc_real_t* real, uint8_t ch_mask_cntl, uint16_t ch_mask )
 {
-    switch( real->region_type )
+    return real->region_ops->build_channel_mask( real, ch_mask_cntl, ch_mask );
+}
+
+uint8_t smtc_real_decrement_dr_simulation( smtc_real_t* real, uint8_t tx_data_rate_adr )
+{
+    bool    is_valid_dr          = false;
+    uint8_t data_rate_simulation = tx_data_rate_adr;
+
+    // while( ( data_rate_simulation > real_const.const_min_tx_dr ) && ( is_valid_dr == 0 ) )
+    while( data_rate_simulation > real_const.const_min_tx_dr )
     {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_KR_920 ) || defined( REGION_RU_864 )
-        if( channel_index >= real_const.const_number_of_rx_channel )
+        uint8_t index = ( uplink_dwell_time_ctx * real_const.const_number_of_tx_dr ) + data_rate_simulation;
+        if( index > ( real_const.const_max_tx_dr * ( uplink_dwell_time_ctx + 1 ) ) )
         {
             SMTC_MODEM_HAL_PANIC( );
         }
-        return ( rx1_frequency_channel_ctx[channel_index] );
-        break;
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
+        data_rate_simulation = real_const.const_datarate_backoff[index];
+
+        // Check if new DR is valid for at least 1 enabled channel
+        if( smtc_real_is_tx_dr_acceptable( real, data_rate_simulation, false ) == OKLORAWAN )
+        {
+            is_valid_dr = true;
+            break;
+        }
+    }
+
+    // no lower valid DR found
+    if( is_valid_dr == false )
     {
-        return region_cn_470_get_rx1_frequency_channel( real, channel_index );
-        break;
+        return tx_data_rate_adr;
     }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
+
+    return data_rate_simulation;
+}
+
+void smtc_real_decrement_dr( smtc_real_t* real, dr_strategy_t adr_mode_select, uint8_t* tx_data_rate_adr,
+                             int8_t* tx_power, uint8_t* nb_trans, uint8_t* no_downlink_limit_bitfield )
+{
+    if( adr_mode_select != STATIC_ADR_MODE )
     {
-        return region_cn_470_rp_1_0_get_rx1_frequency_channel( real, channel_index );
-        break;
+        return;
     }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+
+    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + 1 * ADR_ACK_DELAY (typ. 32)
+    // Set output power to default
+    if( *tx_power < real_const.const_tx_power_dbm )
     {
-        return region_us_915_get_rx1_frequency_channel( real, channel_index );
-        break;
+        *tx_power = real_const.const_tx_power_dbm;
+        return;
     }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+
+    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + 2 * ADR_ACK_DELAY (typ. 32)
+    // Decrement DR by 1
+
+    if( *tx_data_rate_adr != smtc_real_get_min_tx_channel_dr(
+                                 real ) )  // Check if actual DR isn't already the min on actually enabled channels
     {
-        return region_au_915_get_rx1_frequency_channel( real, channel_index );
-        break;
+        // Check if we can decrement DR using ADR back-off table
+        uint8_t dr_tmp = smtc_real_decrement_dr_simulation( real, *tx_data_rate_adr );
+        if( *tx_data_rate_adr != dr_tmp )
+        {
+            *tx_data_rate_adr = dr_tmp;
+            return;
+        }
     }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
+
+    // AdrACKCnt is already > ADR_ACK_LIMIT (typ. 64) + N * ADR_ACK_DELAY (typ. 32)
+    // We are in the lowest possible DR for actually enabled channels
+    // Set NbTrans to 1 and re-enable default channels (if not already the case)
+
+    if( ( *nb_trans != 1 ) || ( !smtc_real_are_all_default_channels_enabled( real ) ) )
+    {
+        // nb_trans must set to 1 and all default channels re-enabled
+        *nb_trans = 1;
+        smtc_real_enable_all_channels_with_valid_freq( real );
+        // When all channels are once again available, a lower datarate could be available (in case where only DR6 and
+        // DR7 were present previously, or if user created channels w/ min DR different than default one)
+        *tx_data_rate_adr = smtc_real_decrement_dr_simulation( real, *tx_data_rate_adr );
+        return;
     }
-    return ERRORLORAWAN;  // never reach => avoid warning
+
+    // If we arrive here, it means we already tried everything to regain connectivity
+    *no_downlink_limit_bitfield |= 1 << SMTC_REAL_ADR_BACKOFF_END;
 }
 
-// Search for minimal DR, on any enabled channel
-uint8_t smtc_real_get_min_tx_channel_dr( smtc_real_t* real )
+// Return true if all default channels were already enabled, false otherwise
+bool smtc_real_are_all_default_channels_enabled( smtc_real_t* real )
 {
-    uint8_t min_dr = real_const.const_max_tx_dr;  // start with the max dr and search a dr inferior
+    if( real->region_ops->are_all_default_channels_enabled != NULL )
+    {
+        return real->region_ops->are_all_default_channels_enabled( real );
+    }
 
-    // Iterate on all actually enabled channels
-    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    for( uint8_t i = 0; i < real_const.const_number_of_boot_tx_channel; i++ )
     {
-        if( ( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED ) )
+        if( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == 0 )  // If at least 1 default ch is disabled
         {
-            // Iterate on all valid DRs for this region
-            for( uint8_t dr = real_const.const_min_tx_dr; dr <= real_const.const_max_tx_dr; dr++ )
-            {
-                // If DR is valid for this channel and lower than actual minimum
-                if( ( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 ) && ( min_dr > dr ) )
-                {
-                    min_dr = dr;
-                }
-            }
-
-            if( min_dr == real_const.const_min_tx_dr )
-            {
-                break;  // DR found is the smallest on this region
-            }
+            return false;
         }
     }
+    return true;
+}
 
-    if( uplink_dwell_time_ctx == true )
+// Enable all default channels, and set their DR range to default one
+void smtc_real_enable_all_channels_with_valid_freq( smtc_real_t* real )
+{
+    if( real->region_ops->enable_all_channels_with_valid_freq != NULL )
     {
-        min_dr = MAX( min_dr, real_const.const_min_tx_dr_limit );
+        real->region_ops->enable_all_channels_with_valid_freq( real );
+        return;
     }
 
-    return ( min_dr );
+    for( uint8_t i = 0; i < real_const.const_number_of_boot_tx_channel; i++ )
+    {
+        SMTC_PUT_BIT8( channel_index_enabled_ctx, i, CHANNEL_ENABLED );
+        dr_bitfield_tx_channel_ctx[i] = real_const.const_default_tx_dr_bit_field;
+    }
 }
 
-uint8_t smtc_real_get_max_tx_channel_dr( smtc_real_t* real )
+status_lorawan_t smtc_real_is_rx1_dr_offset_valid( smtc_real_t* real, uint8_t rx1_dr_offset )
 {
-    uint8_t max_dr = real_const.const_min_tx_dr;  // start with the min dr and search a dr superior
-    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    status_lorawan_t status = OKLORAWAN;
+    if( rx1_dr_offset >= real_const.const_number_rx1_dr_offset )
     {
-        if( ( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED ) )
-        {
-            for( uint8_t dr = 0; dr <= real_const.const_max_tx_dr; dr++ )
-            {
-                if( ( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 ) && ( max_dr < dr ) )
-                {
-                    max_dr = dr;
-                }
-            }
+        status = ERRORLORAWAN;
+        SMTC_MODEM_HAL_TRACE_WARNING( "RECEIVE AN INVALID Rx1 DR OFFSET \n" );
+    }
+    return ( status );
+}
 
-            if( max_dr == real_const.const_max_tx_dr )
-            {
-                break;  // DR found is the bigest
-            }
+status_lorawan_t smtc_real_is_rx_dr_valid( smtc_real_t* real, uint8_t dr )
+{
+    if( ( dr >= real_const.const_min_rx_dr ) && ( dr <= real_const.const_max_rx_dr ) )
+    {
+        if( SMTC_GET_BIT16( &real_const.const_dr_bitfield, dr ) == 1 )
+        {
+            return ( OKLORAWAN );
         }
     }
+    SMTC_MODEM_HAL_TRACE_WARNING( "Invalid Rx datarate %d\n", dr );
 
-    return ( max_dr );
+    return ( ERRORLORAWAN );
 }
 
-uint16_t smtc_real_mask_tx_dr_channel( smtc_real_t* real )
+status_lorawan_t smtc_real_is_tx_dr_valid( smtc_real_t* real, uint8_t dr )
 {
-    uint16_t dr_mask = 0;
-    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    if( ( dr >= real_const.const_min_tx_dr ) && ( dr <= real_const.const_max_tx_dr ) )
     {
-        if( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED )
+        if( SMTC_GET_BIT16( &real_const.const_dr_bitfield, dr ) == 1 )
         {
-            dr_mask |= dr_bitfield_tx_channel_ctx[i];
+            return ( OKLORAWAN );
         }
     }
+    SMTC_MODEM_HAL_TRACE_WARNING( "Invalid Tx datarate %d\n", dr );
 
-    return dr_mask;
+    return ( ERRORLORAWAN );
 }
 
-uint16_t smtc_real_mask_tx_dr_channel_up_dwell_time_check( smtc_real_t* real )
+status_lorawan_t smtc_real_is_tx_dr_acceptable( smtc_real_t* real, uint8_t dr, bool is_ch_mask_from_link_adr )
 {
-    uint16_t dr_mask = smtc_real_mask_tx_dr_channel( real );
+    if( real->region_ops->is_tx_dr_acceptable != NULL )
+    {
+        return real->region_ops->is_tx_dr_acceptable( real, dr, is_ch_mask_from_link_adr );
+    }
+
+    uint8_t* ch_mask_to_check =
+        ( is_ch_mask_from_link_adr == true ) ? unwrapped_channel_mask_ctx : channel_index_enabled_ctx;
+
     if( uplink_dwell_time_ctx == true )
     {
-        for( uint8_t i = 0; i < real_const.const_min_tx_dr_limit; i++ )
+        if( dr < real_const.const_min_tx_dr_limit )
         {
-            dr_mask &= ~( 1U << i );  // Clear bit directly
+            return ERRORLORAWAN;
+        }
+    }
+
+    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    {
+        if( SMTC_GET_BIT8( ch_mask_to_check, i ) == CHANNEL_ENABLED )
+        {
+            SMTC_MODEM_HAL_TRACE_PRINTF_DEBUG( "ch%d - dr field 0x%04x\n", i, dr_bitfield_tx_channel_ctx[i] );
+            if( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 )
+            {
+                return ( OKLORAWAN );
+            }
         }
     }
 
-    return dr_mask;
+    SMTC_MODEM_HAL_TRACE_WARNING( "Not acceptable data rate\n" );
+    return ( ERRORLORAWAN );
 }
 
-uint8_t smtc_real_get_preamble_len( const smtc_real_t* real, uint8_t sf )
+status_lorawan_t smtc_real_is_nwk_received_tx_frequency_valid( smtc_real_t* real, uint32_t frequency )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
+    // Channels can only be defined by the network in regions supporting NewChannelReq
+    if( real_const.const_new_channel_req_supported == false )
     {
-        if( ( sf == 5 ) || ( sf == 6 ) )
-        {
-            return 12;
-        }
-        else
-        {
-            return 8;
-        }
-        break;
+        return ( ERRORLORAWAN );
     }
-#endif
-    default:
-        return 8;
-        break;
+    if( frequency == 0 )
+    {
+        return ( OKLORAWAN );
     }
+    return ( smtc_real_is_frequency_valid( real, frequency ) );
 }
 
-status_lorawan_t smtc_real_is_channel_mask_for_mobile_mode( const smtc_real_t* real )
+status_lorawan_t smtc_real_is_channel_index_valid( smtc_real_t* real, uint8_t channel_index )
 {
-    status_lorawan_t status        = ERRORLORAWAN;
-    uint8_t          min_mobile_dr = real_const.const_min_tx_dr;
-    uint8_t          max_mobile_dr = real_const.const_max_tx_dr;
+    if( real_const.const_new_channel_req_supported == false )
+    {
+        return ( ERRORLORAWAN );
+    }
 
-    // search min datarate init
-    for( int i = 0; i < real_const.const_number_of_tx_dr; i++ )
+    status_lorawan_t status = OKLORAWAN;
+    if( ( channel_index < real_const.const_number_of_boot_tx_channel ) ||
+        ( channel_index >= real_const.const_number_of_tx_channel ) )
     {
-        if( dr_distribution_init_ctx[i] > 0 )
-        {
-            min_mobile_dr = i;
-            break;
-        }
+        status = ERRORLORAWAN;
+        SMTC_MODEM_HAL_TRACE_WARNING( "RECEIVE AN INVALID Channel Index Cmd = %d\n", channel_index );
     }
-    if( uplink_dwell_time_ctx == true )
+    return ( status );
+}
+
+status_lorawan_t smtc_real_is_payload_size_valid( smtc_real_t* real, uint8_t dr, uint8_t size,
+                                                  direction_frame_t direction_frame, uint8_t tx_fopts_current_length )
+{
+    bool dwell_time_enabled = ( direction_frame == UP_LINK ) ? uplink_dwell_time_ctx : downlink_dwell_time_ctx;
+    if( ( real_const.const_tx_param_setup_req_supported == false ) && ( dwell_time_enabled != 0 ) )
     {
-        min_mobile_dr = MAX( min_mobile_dr, real_const.const_min_tx_dr_limit );
+        SMTC_MODEM_HAL_PANIC( );
     }
 
-    // search max datarate init
-    for( int i = real_const.const_number_of_tx_dr - 1; i <= 0; i-- )
+    uint8_t index = ( dwell_time_enabled * real_const.const_number_of_tx_dr ) + dr;
+
+#if defined( REGION_AU_915 )
+    if( real->region_type == SMTC_REAL_REGION_AU_915 )
     {
-        if( dr_distribution_init_ctx[i] > 0 )
-        {
-            max_mobile_dr = i;
-            break;
-        }
+        // *2 because the array contains Tx and Rx datarate
+        index = ( dwell_time_enabled * real_const.const_number_of_tx_dr * 2 ) + dr;
     }
+#endif
 
-    for( int i = 0; i < real_const.const_number_of_tx_channel; i++ )
+    status_lorawan_t status = ( ( size + tx_fopts_current_length ) > ( real_const.const_max_payload_m[index] - 8 ) )
+                                  ? ERRORLORAWAN
+                                  : OKLORAWAN;
+    if( status == ERRORLORAWAN )
     {
-        if( SMTC_GET_BIT8( unwrapped_channel_mask_ctx, i ) == CHANNEL_ENABLED )
-        {
-            for( uint8_t dr = real_const.const_min_tx_dr; dr <= real_const.const_max_tx_dr; dr++ )
-            {
-                if( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 )
-                {
-                    if( ( dr >= min_mobile_dr ) && ( dr <= max_mobile_dr ) )
-                    {
-                        return ( OKLORAWAN );
-                    }
-                }
-            }
-        }
+        SMTC_MODEM_HAL_TRACE_PRINTF( "Invalid size (data:%d + FOpts:%d) > %d for dr: %d\n", size,
+                                     tx_fopts_current_length, ( real_const.const_max_payload_m[index] - 8 ), dr );
     }
-    SMTC_MODEM_HAL_TRACE_WARNING( "Not acceptable data rate in mobile mode\n" );
     return ( status );
 }
 
-modulation_type_t smtc_real_get_modulation_type_from_datarate( smtc_real_t* real, uint8_t datarate )
+void smtc_real_set_tx_frequency_channel( smtc_real_t* real, uint32_t tx_freq, uint8_t channel_index )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
+    if( real_const.const_new_channel_req_supported == false )
     {
-        return region_ww_2g4_get_modulation_type_from_datarate( datarate );
-        break;
+        // Not supported
+        return;
     }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
+    if( channel_index >= real_const.const_number_of_tx_channel )
     {
-        return region_eu_868_get_modulation_type_from_datarate( datarate );
-        break;
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
+    else
     {
-        return region_as_923_get_modulation_type_from_datarate( datarate );
-        break;
+        tx_frequency_channel_ctx[channel_index] = tx_freq;
     }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+}
+
+status_lorawan_t smtc_real_set_rx1_frequency_channel( smtc_real_t* real, uint32_t rx_freq, uint8_t channel_index )
+{
+    if( real_const.const_new_channel_req_supported == false )
     {
-        return region_us_915_get_modulation_type_from_datarate( datarate );
-        break;
+        // Not supported
+        return ERRORLORAWAN;
     }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+    if( channel_index >= real_const.const_number_of_rx_channel )
     {
-        return region_au_915_get_modulation_type_from_datarate( datarate );
-        break;
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
+    else
     {
-        return region_cn_470_get_modulation_type_from_datarate( datarate );
-        break;
+        rx1_frequency_channel_ctx[channel_index] = rx_freq;
     }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
+    return OKLORAWAN;
+}
+
+void smtc_real_set_channel_dr( smtc_real_t* real, uint8_t channel_index, uint8_t dr_min, uint8_t dr_max )
+{
+    if( real_const.const_new_channel_req_supported == false )
     {
-        return region_cn_470_rp_1_0_get_modulation_type_from_datarate( datarate );
-        break;
+        // Not supported
+        return;
     }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
+    if( channel_index >= real_const.const_number_of_tx_channel )
     {
-        return region_in_865_get_modulation_type_from_datarate( datarate );
-        break;
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
+    else
     {
-        return region_kr_920_get_modulation_type_from_datarate( datarate );
-        break;
+        dr_bitfield_tx_channel_ctx[channel_index] = 0;
+        for( uint8_t i = dr_min; i <= dr_max; i++ )
+        {
+            uint8_t tmp_dr = SMTC_GET_BIT16( &real_const.const_dr_bitfield, i );
+            SMTC_PUT_BIT16( &dr_bitfield_tx_channel_ctx[channel_index], i, tmp_dr );
+        }
     }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
+}
+
+void smtc_real_set_channel_enabled( smtc_real_t* real, uint8_t enable, uint8_t channel_index )
+{
+    if( real_const.const_new_channel_req_supported == false )
     {
-        return region_ru_864_get_modulation_type_from_datarate( datarate );
-        break;
+        // Not supported
+        return;
     }
-#endif
-    default:
+    if( channel_index >= real_const.const_number_of_tx_channel )
+    {
         SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    else
+    {
+        SMTC_PUT_BIT8( channel_index_enabled_ctx, channel_index, enable );
+    }
 }
-void smtc_real_lora_dr_to_sf_bw( smtc_real_t* real, uint8_t in_dr, uint8_t* out_sf, lr1mac_bandwidth_t* out_bw )
+
+uint32_t smtc_real_get_tx_channel_frequency( smtc_real_t* real, uint8_t channel_index )
 {
-    switch( real->region_type )
+    if( real->region_ops->get_tx_frequency_channel != NULL )
     {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
+        return real->region_ops->get_tx_frequency_channel( real, channel_index );
+    }
+    if( channel_index >= real_const.const_number_of_tx_channel )
     {
-        region_ww_2g4_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
+    return ( tx_frequency_channel_ctx[channel_index] );
+}
+
+uint32_t smtc_real_get_rx1_channel_frequency( smtc_real_t* real, uint8_t channel_index )
+{
+    if( real->region_ops->get_rx1_frequency_channel != NULL )
     {
-        region_eu_868_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        return real->region_ops->get_rx1_frequency_channel( real, channel_index );
     }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
+    if( channel_index >= real_const.const_number_of_rx_channel )
     {
-        region_as_923_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        SMTC_MODEM_HAL_PANIC( );
     }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+    return ( rx1_frequency_channel_ctx[channel_index] );
+}
+
+// Search for minimal DR, on any enabled channel
+uint8_t smtc_real_get_min_tx_channel_dr( smtc_real_t* real )
+{
+    uint8_t min_dr = real_const.const_max_tx_dr;  // start with the max dr and search a dr inferior
+
+    // Iterate on all actually enabled channels
+    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
     {
-        region_us_915_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        if( ( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED ) )
+        {
+            // Iterate on all valid DRs for this region
+            for( uint8_t dr = real_const.const_min_tx_dr; dr <= real_const.const_max_tx_dr; dr++ )
+            {
+                // If DR is valid for this channel and lower than actual minimum
+                if( ( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 ) && ( min_dr > dr ) )
+                {
+                    min_dr = dr;
+                }
+            }
+
+            if( min_dr == real_const.const_min_tx_dr )
+            {
+                break;  // DR found is the smallest on this region
+            }
+        }
     }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+
+    if( uplink_dwell_time_ctx == true )
     {
-        region_au_915_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        min_dr = MAX( min_dr, real_const.const_min_tx_dr_limit );
     }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
+
+    return ( min_dr );
+}
+
+uint8_t smtc_real_get_max_tx_channel_dr( smtc_real_t* real )
+{
+    uint8_t max_dr = real_const.const_min_tx_dr;  // start with the min dr and search a dr superior
+    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
     {
-        region_cn_470_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        if( ( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED ) )
+        {
+            for( uint8_t dr = 0; dr <= real_const.const_max_tx_dr; dr++ )
+            {
+                if( ( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 ) && ( max_dr < dr ) )
+                {
+                    max_dr = dr;
+                }
+            }
+
+            if( max_dr == real_const.const_max_tx_dr )
+            {
+                break;  // DR found is the bigest
+            }
+        }
     }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
+
+    return ( max_dr );
+}
+
+uint16_t smtc_real_mask_tx_dr_channel( smtc_real_t* real )
+{
+    uint16_t dr_mask = 0;
+    for( uint8_t i = 0; i < real_const.const_number_of_tx_channel; i++ )
     {
-        region_cn_470_rp_1_0_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        if( SMTC_GET_BIT8( channel_index_enabled_ctx, i ) == CHANNEL_ENABLED )
+        {
+            dr_mask |= dr_bitfield_tx_channel_ctx[i];
+        }
     }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
+
+    return dr_mask;
+}
+
+uint16_t smtc_real_mask_tx_dr_channel_up_dwell_time_check( smtc_real_t* real )
+{
+    uint16_t dr_mask = smtc_real_mask_tx_dr_channel( real );
+    if( uplink_dwell_time_ctx == true )
     {
-        region_in_865_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
+        for( uint8_t i = 0; i < real_const.const_min_tx_dr_limit; i++ )
+        {
+            dr_mask &= ~( 1U << i );  // Clear bit directly
+        }
     }
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
+
+    return dr_mask;
+}
+
+uint8_t smtc_real_get_preamble_len( const smtc_real_t* real, uint8_t sf )
+{
+    switch( real->region_type )
     {
-        region_kr_920_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
-        break;
-    }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
+#if defined( REGION_WW_2G4 )
+    case SMTC_REAL_REGION_WW_2G4:
     {
-        region_ru_864_lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
+        if( ( sf == 5 ) || ( sf == 6 ) )
+        {
+            return 12;
+        }
+        else
+        {
+            return 8;
+        }
         break;
     }
 #endif
     default:
-        SMTC_MODEM_HAL_PANIC( );
+        return 8;
         break;
     }
 }
 
-void smtc_real_fsk_dr_to_bitrate( smtc_real_t* real, uint8_t in_dr, uint8_t* out_bitrate )
+status_lorawan_t smtc_real_is_channel_mask_for_mobile_mode( const smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
+    status_lorawan_t status        = ERRORLORAWAN;
+    uint8_t          min_mobile_dr = real_const.const_min_tx_dr;
+    uint8_t          max_mobile_dr = real_const.const_max_tx_dr;
+
+    // search min datarate init
+    for( int i = 0; i < real_const.const_number_of_tx_dr; i++ )
     {
-        region_eu_868_fsk_dr_to_bitrate( in_dr, out_bitrate );
-        break;
+        if( dr_distribution_init_ctx[i] > 0 )
+        {
+            min_mobile_dr = i;
+            break;
+        }
     }
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
+    if( uplink_dwell_time_ctx == true )
     {
-        region_as_923_fsk_dr_to_bitrate( in_dr, out_bitrate );
-        break;
+        min_mobile_dr = MAX( min_mobile_dr, real_const.const_min_tx_dr_limit );
     }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
+
+    // search max datarate init
+    for( int i = real_const.const_number_of_tx_dr - 1; i <= 0; i-- )
     {
-        region_cn_470_fsk_dr_to_bitrate( in_dr, out_bitrate );
-        break;
+        if( dr_distribution_init_ctx[i] > 0 )
+        {
+            max_mobile_dr = i;
+            break;
+        }
     }
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
+
+    for( int i = 0; i < real_const.const_number_of_tx_channel; i++ )
     {
-        region_in_865_fsk_dr_to_bitrate( in_dr, out_bitrate );
-        break;
+        if( SMTC_GET_BIT8( unwrapped_channel_mask_ctx, i ) == CHANNEL_ENABLED )
+        {
+            for( uint8_t dr = real_const.const_min_tx_dr; dr <= real_const.const_max_tx_dr; dr++ )
+            {
+                if( SMTC_GET_BIT16( &dr_bitfield_tx_channel_ctx[i], dr ) == 1 )
+                {
+                    if( ( dr >= min_mobile_dr ) && ( dr <= max_mobile_dr ) )
+                    {
+                        return ( OKLORAWAN );
+                    }
+                }
+            }
+        }
     }
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
+    SMTC_MODEM_HAL_TRACE_WARNING( "Not acceptable data rate in mobile mode\n" );
+    return ( status );
+}
+
+modulation_type_t smtc_real_get_modulation_type_from_datarate( smtc_real_t* real, uint8_t datarate )
+{
+    return real->region_ops->get_modulation_type_from_datarate( datarate );
+}
+void smtc_real_lora_dr_to_sf_bw( smtc_real_t* real, uint8_t in_dr, uint8_t* out_sf, lr1mac_bandwidth_t* out_bw )
+{
+    real->region_ops->lora_dr_to_sf_bw( in_dr, out_sf, out_bw );
+}
+
+void smtc_real_fsk_dr_to_bitrate( smtc_real_t* real, uint8_t in_dr, uint8_t* out_bitrate )
+{
+    if( real->region_ops->fsk_dr_to_bitrate == NULL )
     {
-        region_ru_864_fsk_dr_to_bitrate( in_dr, out_bitrate );
-        break;
-    }
-#endif
-    default:
         SMTC_MODEM_HAL_PANIC( );
-        break;
     }
+    real->region_ops->fsk_dr_to_bitrate( in_dr, out_bitrate );
 }
 
 void smtc_real_lr_fhss_dr_to_cr_bw( smtc_real_t* real, uint8_t in_dr, lr_fhss_v1_cr_t* out_cr, lr_fhss_v1_bw_t* out_bw )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-    {
-        region_eu_868_lr_fhss_dr_to_cr_bw( in_dr, out_cr, out_bw );
-        break;
-    }
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        region_us_915_lr_fhss_dr_to_cr_bw( in_dr, out_cr, out_bw );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
+    if( real->region_ops->lr_fhss_dr_to_cr_bw == NULL )
     {
-        region_au_915_lr_fhss_dr_to_cr_bw( in_dr, out_cr, out_bw );
-        break;
-    }
-#endif
-    default:
         SMTC_MODEM_HAL_PANIC( );
-        break;
     }
+    real->region_ops->lr_fhss_dr_to_cr_bw( in_dr, out_cr, out_bw );
 }
 
 lr_fhss_hc_t smtc_real_lr_fhss_get_header_count( lr_fhss_v1_cr_t in_cr )
@@ -2597,81 +1210,11 @@ uint8_t smtc_real_get_number_of_enabled_channels_for_a_datarate( smtc_real_t* re
 int8_t smtc_real_clamp_output_power_eirp_vs_freq_and_dr( smtc_real_t* real, int8_t tx_power, uint32_t tx_frequency,
                                                          uint8_t datarate )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_AU_915 ) || \
-    defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) ||                      \
-    defined( REGION_RU_864 )
-    {
-        return tx_power;
-        break;
-    }
-#endif
-
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
+    if( real->region_ops->clamp_output_power_eirp_vs_freq_and_dr == NULL )
     {
-        if( datarate == DR4 )
-        {
-            return MIN( tx_power, 26 );
-        }
-        else if( smtc_real_get_number_of_enabled_channels_for_a_datarate( real, datarate ) < 50 )
-        {
-            return MIN( tx_power, 21 );
-        }
         return tx_power;
-        break;
-    }
-#endif
-
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-    {
-        if( tx_frequency < 922000000 )
-        {
-            return MIN( tx_power, 10 );  // if freq < 922MHz, Max output power is limited to 10 dBm
-        }
-        else
-        {
-            return MIN( tx_power, TX_POWER_EIRP_KR_920 );  // else Max output power is limited to 14 dBm
-        }
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    return real->region_ops->clamp_output_power_eirp_vs_freq_and_dr( real, tx_power, tx_frequency, datarate );
 }
 
 bool smtc_real_get_current_enabled_frequency_list_for_a_datarate( smtc_real_t* real, uint8_t datarate,
@@ -2762,69 +1305,20 @@ void smtc_real_set_sync_word( smtc_real_t* real, uint8_t sync_word )
 
 uint8_t* smtc_real_get_gfsk_sync_word( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_CN_470 ) || \
-    defined( REGION_CN_470_RP_1_0 ) || defined( REGION_IN_865 ) || defined( REGION_RU_864 )
+    if( real_const.const_sync_word_gfsk == NULL )
     {
-        return ( uint8_t* ) real_const.const_sync_word_gfsk;
-        break;
-    }
-#endif
-    default:
         SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    return ( uint8_t* ) real_const.const_sync_word_gfsk;
 }
 
 uint8_t* smtc_real_get_lr_fhss_sync_word( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_EU_868 ) || defined( REGION_AU_915 ) || defined( REGION_US_915 )
+    if( real_const.const_sync_word_lr_fhss == NULL )
     {
-        return ( uint8_t* ) real_const.const_sync_word_lr_fhss;
-        break;
-    }
-#endif
-    default:
         SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    return ( uint8_t* ) real_const.const_sync_word_lr_fhss;
 }
 
 bool smtc_real_is_dtc_supported( const smtc_real_t* real )
@@ -2899,202 +1393,25 @@ uint8_t smtc_real_get_beacon_dr( smtc_real_t* real )
 
 bool smtc_real_is_beacon_hopping( smtc_real_t* real )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_RU_864 ) || defined( SMTC_REAL_REGION_KR_920 )
-    {
-        return false;
-        break;
-    }
-#endif
-
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-#endif
-#if defined( REGION_US_915 ) || defined( REGION_AU_915 ) || defined( REGION_CN_470 ) || defined( REGION_CN_470_RP_1_0 )
-    {
-        return true;
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
-    }
-    return 0;  // never reach => avoid warning
+    return ( real->region_ops->get_rx_beacon_frequency_channel != NULL );
 }
 
 uint32_t smtc_real_get_beacon_frequency( smtc_real_t* real, uint32_t gps_time_s )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_RU_864 ) || defined( SMTC_REAL_REGION_KR_920 )
+    if( real->region_ops->get_rx_beacon_frequency_channel == NULL )
     {
         return real_const.const_beacon_frequency;
-        break;
-    }
-#endif
-
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        return region_us_915_get_rx_beacon_frequency_channel( real, gps_time_s );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        return region_au_915_get_rx_beacon_frequency_channel( real, gps_time_s );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_get_rx_beacon_frequency_channel( real, gps_time_s );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_get_rx_beacon_frequency_channel( real, gps_time_s );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    return real->region_ops->get_rx_beacon_frequency_channel( real, gps_time_s );
 }
 
 uint32_t smtc_real_get_ping_slot_frequency( smtc_real_t* real, uint32_t gps_time_s, uint32_t dev_addr )
 {
-    switch( real->region_type )
-    {
-#if defined( REGION_WW_2G4 )
-    case SMTC_REAL_REGION_WW_2G4:
-#endif
-#if defined( REGION_EU_868 )
-    case SMTC_REAL_REGION_EU_868:
-#endif
-#if defined( REGION_AS_923 )
-    case SMTC_REAL_REGION_AS_923:
-    case SMTC_REAL_REGION_AS_923_GRP2:
-    case SMTC_REAL_REGION_AS_923_GRP3:
-#if defined( RP2_103 )
-    case SMTC_REAL_REGION_AS_923_GRP4:
-#endif
-#endif
-#if defined( REGION_IN_865 )
-    case SMTC_REAL_REGION_IN_865:
-#endif
-#if defined( REGION_RU_864 )
-    case SMTC_REAL_REGION_RU_864:
-#endif
-#if defined( REGION_KR_920 )
-    case SMTC_REAL_REGION_KR_920:
-#endif
-#if defined( REGION_WW_2G4 ) || defined( REGION_EU_868 ) || defined( REGION_AS_923 ) || defined( REGION_IN_865 ) || \
-    defined( REGION_RU_864 ) || defined( SMTC_REAL_REGION_KR_920 )
+    if( real->region_ops->get_rx_ping_slot_frequency_channel == NULL )
     {
         return real_const.const_ping_slot_frequency;
-        break;
-    }
-#endif
-
-#if defined( REGION_US_915 )
-    case SMTC_REAL_REGION_US_915:
-    {
-        return region_us_915_get_rx_ping_slot_frequency_channel( real, gps_time_s, dev_addr );
-        break;
-    }
-#endif
-#if defined( REGION_AU_915 )
-    case SMTC_REAL_REGION_AU_915:
-    {
-        return region_au_915_get_rx_ping_slot_frequency_channel( real, gps_time_s, dev_addr );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470 )
-    case SMTC_REAL_REGION_CN_470:
-    {
-        return region_cn_470_get_rx_ping_slot_frequency_channel( real, gps_time_s, dev_addr );
-        break;
-    }
-#endif
-#if defined( REGION_CN_470_RP_1_0 )
-    case SMTC_REAL_REGION_CN_470_RP_1_0:
-    {
-        return region_cn_470_rp_1_0_get_rx_ping_slot_frequency_channel( real, gps_time_s, dev_addr );
-        break;
-    }
-#endif
-    default:
-        SMTC_MODEM_HAL_PANIC( );
-        break;
     }
-    return 0;  // never reach => avoid warning
+    return real->region_ops->get_rx_ping_slot_frequency_channel( real, gps_time_s, dev_addr );
 }
 
 uint8_t smtc_real_get_ping_slot_datarate( smtc_real_t* real )
@@ -3245,6 +1562,132 @@ void smtc_real_get_rx_window_parameters( smtc_real_t* real, uint8_t datarate, ui
 #endif
 }
 
+#if defined( ADD_CHANNEL_OCCUPANCY )
+/**
+ * @brief Forget the oldest senses of a channel not sensed for SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S
+ */
+static void smtc_real_channel_occupancy_age( smtc_real_channel_occupancy_t* occupancy, uint32_t now_s )
+{
+    if( ( now_s - occupancy->last_sense_s ) > SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S )
+    {
+        occupancy->busy_history &= ( 1UL << SMTC_REAL_CHANNEL_OCCUPANCY_AGED_SENSES ) - 1;
+        occupancy->nb_senses = MIN( occupancy->nb_senses, SMTC_REAL_CHANNEL_OCCUPANCY_AGED_SENSES );
+    }
+}
+
+void smtc_real_channel_occupancy_update( smtc_real_t* real, uint32_t frequency_hz, bool busy, bool rssi_valid,
+                                         int16_t rssi_dbm )
+{
+    smtc_real_channel_occupancy_t* entry  = NULL;
+    smtc_real_channel_occupancy_t* oldest = &real->channel_occupancy[0];
+
+    for( uint8_t i = 0; i < SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS; i++ )
+    {
+        smtc_real_channel_occupancy_t* occupancy = &real->channel_occupancy[i];
+        if( occupancy->frequency_hz == frequency_hz )
+        {
+            entry = occupancy;
+            break;
+        }
+        if( ( oldest->frequency_hz != 0 ) &&
+            ( ( occupancy->frequency_hz == 0 ) || ( occupancy->last_sense_s < oldest->last_sense_s ) ) )
+        {
+            oldest = occupancy;
+        }
+    }
+    if( entry == NULL )
+    {
+        entry = oldest;
+        memset( entry, 0, sizeof( smtc_real_channel_occupancy_t ) );
+        entry->frequency_hz = frequency_hz;
+    }
+    else
+    {
+        smtc_real_channel_occupancy_age( entry, smtc_modem_hal_get_time_in_s( ) );
+    }
+
+    // Bits older than the 32 most recent senses are shifted out of the window
+    entry->busy_history = ( entry->busy_history << 1 ) | ( ( busy == true ) ? 1 : 0 );
+    if( entry->nb_senses < 32 )
+    {
+        entry->nb_senses++;
+    }
+    entry->last_sense_s = smtc_modem_hal_get_time_in_s( );
+
+    if( rssi_valid == true )
+    {
+        if( entry->nb_rssi < SMTC_REAL_CHANNEL_OCCUPANCY_RSSI_WEIGHT )
+        {
+            entry->nb_rssi++;
+        }
+        entry->rssi_avg_x16 += ( ( rssi_dbm * 16 ) - entry->rssi_avg_x16 ) / entry->nb_rssi;
+    }
+}
+
+bool smtc_real_channel_occupancy_get( smtc_real_t* real, uint8_t index, smtc_real_channel_occupancy_t* occupancy )
+{
+    if( ( index >= SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS ) || ( real->channel_occupancy[index].frequency_hz == 0 ) )
+    {
+        return false;
+    }
+    *occupancy = real->channel_occupancy[index];
+    smtc_real_channel_occupancy_age( occupancy, smtc_modem_hal_get_time_in_s( ) );
+    return true;
+}
+
+uint8_t smtc_real_channel_occupancy_get_busy_ratio( const smtc_real_channel_occupancy_t* occupancy )
+{
+    if( occupancy->nb_senses == 0 )
+    {
+        return 0;
+    }
+    return ( uint8_t ) ( ( __builtin_popcount( occupancy->busy_history ) * 100 ) / occupancy->nb_senses );
+}
+
+/**
+ * @brief Busy ratio used to rank a channel, 0 while it has not been sensed enough or not sensed for long
+ */
+static uint8_t smtc_real_channel_occupancy_get_rank( smtc_real_t* real, uint32_t frequency_hz, uint32_t now_s )
+{
+    for( uint8_t i = 0; i < SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS; i++ )
+    {
+        const smtc_real_channel_occupancy_t* occupancy = &real->channel_occupancy[i];
+        if( occupancy->frequency_hz == frequency_hz )
+        {
+            if( ( occupancy->nb_senses < SMTC_REAL_CHANNEL_OCCUPANCY_MIN_SENSES ) ||
+                ( ( now_s - occupancy->last_sense_s ) > SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S ) )
+            {
+                return 0;
+            }
+            return smtc_real_channel_occupancy_get_busy_ratio( occupancy );
+        }
+    }
+    return 0;
+}
+
+uint8_t smtc_real_channel_occupancy_filter( smtc_real_t* real, uint8_t* channel_index, uint8_t nb_channel )
+{
+    uint32_t now_s       = smtc_modem_hal_get_time_in_s( );
+    uint8_t  lowest_rank = 100;
+    uint8_t  nb_kept     = 0;
+
+    for( uint8_t i = 0; i < nb_channel; i++ )
+    {
+        uint8_t rank = smtc_real_channel_occupancy_get_rank( real, tx_frequency_channel_ctx[channel_index[i]], now_s );
+        lowest_rank  = MIN( lowest_rank, rank );
+    }
+    for( uint8_t i = 0; i < nb_channel; i++ )
+    {
+        if( smtc_real_channel_occupancy_get_rank( real, tx_frequency_channel_ctx[channel_index[i]], now_s ) <
+            ( lowest_rank + SMTC_REAL_CHANNEL_OCCUPANCY_SKIP_MARGIN ) )
+        {
+            channel_index[nb_kept++] = channel_index[i];
+        }
+    }
+    return nb_kept;
+}
+#endif
+
 void smtc_real_get_rx_start_time_offset_ms( smtc_real_t* real, uint8_t datarate, int8_t board_delay_ms,
                                             uint16_t rx_window_symb, int32_t* rx_offset_ms )
 {
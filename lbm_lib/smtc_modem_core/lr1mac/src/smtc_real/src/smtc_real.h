@@ -798,6 +798,50 @@ void smtc_real_get_rx_window_parameters( smtc_real_t* real, uint8_t datarate, ui
 void smtc_real_get_rx_start_time_offset_ms( smtc_real_t* real, uint8_t datarate, int8_t board_delay_ms,
                                             uint16_t rx_window_symb, int32_t* rx_offset_ms );
 
+#if defined( ADD_CHANNEL_OCCUPANCY )
+/**
+ * @brief Record the outcome of a LBT or CAD sense in the statistics of the sensed channel
+ *
+ * @param [in] real         pointer to the real object
+ * @param [in] frequency_hz sensed frequency
+ * @param [in] busy         true if the channel was found busy
+ * @param [in] rssi_valid   true if rssi_dbm holds the average rssi measured during the sense (LBT only)
+ * @param [in] rssi_dbm     average rssi measured during the sense
+ */
+void smtc_real_channel_occupancy_update( smtc_real_t* real, uint32_t frequency_hz, bool busy, bool rssi_valid,
+                                         int16_t rssi_dbm );
+
+/**
+ * @brief Get the statistics of a tracked channel
+ *
+ * @param [in]  real      pointer to the real object
+ * @param [in]  index     index of the tracked channel, from 0 to SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS - 1
+ * @param [out] occupancy statistics of the channel
+ * @return false if no channel is tracked at this index
+ */
+bool smtc_real_channel_occupancy_get( smtc_real_t* real, uint8_t index, smtc_real_channel_occupancy_t* occupancy );
+
+/**
+ * @brief Return the percentage of the senses of a channel that found it busy
+ *
+ * @param [in] occupancy statistics of the channel
+ * @return busy ratio in percent
+ */
+uint8_t smtc_real_channel_occupancy_get_busy_ratio( const smtc_real_channel_occupancy_t* occupancy );
+
+/**
+ * @brief Leave out of a list of candidate channels the ones found busy far more often than the least busy one
+ *
+ * @remark Channels without enough senses are always kept, so that they get sensed
+ *
+ * @param [in]     real          pointer to the real object
+ * @param [in,out] channel_index candidate channel indexes, the kept ones are moved to the beginning
+ * @param [in]     nb_channel    number of candidate channels
+ * @return number of kept channels, at least one if nb_channel is not 0
+ */
+uint8_t smtc_real_channel_occupancy_filter( smtc_real_t* real, uint8_t* channel_index, uint8_t nb_channel );
+#endif
+
 #ifdef __cplusplus
 }
 #endif
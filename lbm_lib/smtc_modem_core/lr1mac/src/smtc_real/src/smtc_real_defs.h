@@ -46,6 +46,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "ral_defs.h"
+#include "lr1mac_defs.h"
 
 #if defined( REGION_EU_868 )
 #include "region_eu_868_defs.h"
@@ -303,11 +304,85 @@ typedef struct smtc_real_const_s
     bool            const_uplink_dwell_time;
 } smtc_real_const_t;
 
+struct smtc_real_s;
+
+/**
+ * Region operations, bound once by smtc_real_init( )
+ *
+ * Operations marked optional are left NULL by the regions with a fixed channel plan (EU868 like), the REAL then
+ * applies the common behaviour based on real_const and real_ctx
+ */
+typedef struct smtc_real_region_ops_s
+{
+    void ( *config )( struct smtc_real_s* real );
+    // optional
+    void ( *config_session )( struct smtc_real_s* real );
+    // optional, no ChMask in CFList
+    uint8_t ( *get_number_of_chmask_in_cflist )( struct smtc_real_s* real );
+    status_lorawan_t ( *get_next_channel )( struct smtc_real_s* real, uint8_t tx_data_rate, uint32_t* out_tx_frequency,
+                                            uint32_t* out_rx1_frequency, uint8_t* out_nb_available_tx_channel );
+    status_lorawan_t ( *get_join_next_channel )( struct smtc_real_s* real, uint8_t* tx_data_rate,
+                                                 uint32_t* out_tx_frequency, uint32_t* out_rx1_frequency,
+                                                 uint32_t* out_rx2_frequency, uint8_t* out_nb_available_tx_channel );
+    // optional, no tx channel snapshot
+    void ( *mask_channel_used_for_tx )( struct smtc_real_s* real );
+    void ( *init_join_snapshot_channel_mask )( struct smtc_real_s* real );
+    void ( *init_after_join_snapshot_channel_mask )( struct smtc_real_s* real, uint8_t tx_data_rate,
+                                                     uint32_t tx_frequency );
+    // optional, unwrapped channel mask copied as is
+    void ( *set_channel_mask )( struct smtc_real_s* real );
+    status_channel_t ( *build_channel_mask )( struct smtc_real_s* real, uint8_t ch_mask_cntl, uint16_t ch_mask );
+    // optional, default channels are the boot channels
+    bool ( *are_all_default_channels_enabled )( struct smtc_real_s* real );
+    void ( *enable_all_channels_with_valid_freq )( struct smtc_real_s* real );
+    // optional, datarate accepted by at least one enabled channel
+    status_lorawan_t ( *is_tx_dr_acceptable )( struct smtc_real_s* real, uint8_t dr, bool is_ch_mask_from_link_adr );
+    // optional, frequencies read from the channel frequency arrays
+    uint32_t ( *get_tx_frequency_channel )( struct smtc_real_s* real, uint8_t channel_index );
+    uint32_t ( *get_rx1_frequency_channel )( struct smtc_real_s* real, uint8_t channel_index );
+    // optional, no EIRP limitation
+    int8_t ( *clamp_output_power_eirp_vs_freq_and_dr )( struct smtc_real_s* real, int8_t tx_power,
+                                                        uint32_t tx_frequency, uint8_t datarate );
+    modulation_type_t ( *get_modulation_type_from_datarate )( uint8_t datarate );
+    void ( *lora_dr_to_sf_bw )( uint8_t in_dr, uint8_t* out_sf, lr1mac_bandwidth_t* out_bw );
+    // optional, no FSK datarate
+    void ( *fsk_dr_to_bitrate )( uint8_t in_dr, uint8_t* out_bitrate );
+    // optional, no LR-FHSS datarate
+    void ( *lr_fhss_dr_to_cr_bw )( uint8_t in_dr, lr_fhss_v1_cr_t* out_cr, lr_fhss_v1_bw_t* out_bw );
+    // optional, no beacon and ping slot frequency hopping
+    uint32_t ( *get_rx_beacon_frequency_channel )( struct smtc_real_s* real, uint32_t gps_time_s );
+    uint32_t ( *get_rx_ping_slot_frequency_channel )( struct smtc_real_s* real, uint32_t gps_time_s,
+                                                      uint32_t dev_addr );
+} smtc_real_region_ops_t;
+
+#if defined( ADD_CHANNEL_OCCUPANCY )
+#define SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS 16   // channels tracked, the least recently sensed one is recycled
+#define SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S 600    // a channel not sensed for this long is tried again
+#define SMTC_REAL_CHANNEL_OCCUPANCY_AGED_SENSES 8    // senses a channel keeps once it has not been sensed for long
+#define SMTC_REAL_CHANNEL_OCCUPANCY_MIN_SENSES 4     // senses needed before a channel can be left out
+#define SMTC_REAL_CHANNEL_OCCUPANCY_SKIP_MARGIN 40   // busy ratio points above the least busy channel to leave it out
+#define SMTC_REAL_CHANNEL_OCCUPANCY_RSSI_WEIGHT 8    // number of LBT rssi the running average is made of
+
+typedef struct smtc_real_channel_occupancy_s
+{
+    uint32_t frequency_hz;  // 0 if the entry is unused
+    uint32_t busy_history;  // one bit per sense, most recent in bit 0, set if the channel was busy
+    uint32_t last_sense_s;  // time of the most recent sense
+    int16_t  rssi_avg_x16;  // running average of the LBT rssi in 1/16 dBm
+    uint8_t  nb_senses;     // number of senses in busy_history, up to 32
+    uint8_t  nb_rssi;       // number of LBT rssi in rssi_avg_x16, up to SMTC_REAL_CHANNEL_OCCUPANCY_RSSI_WEIGHT
+} smtc_real_channel_occupancy_t;
+#endif
+
 typedef struct smtc_real_s
 {
-    smtc_real_region_types_t region_type;
-    smtc_real_const_t        real_const;
-    smtc_real_ctx_t          real_ctx;
+    smtc_real_region_types_t      region_type;
+    const smtc_real_region_ops_t* region_ops;
+    smtc_real_const_t             real_const;
+    smtc_real_ctx_t               real_ctx;
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    smtc_real_channel_occupancy_t channel_occupancy[SMTC_REAL_CHANNEL_OCCUPANCY_NB_CHANNELS];
+#endif
 
     union smtc_real_region_u
     {
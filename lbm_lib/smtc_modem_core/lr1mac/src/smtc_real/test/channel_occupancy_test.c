@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smtc_real.h"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static uint32_t now_s;
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+uint32_t smtc_modem_hal_get_time_in_s( void )
+{
+    return now_s;
+}
+
+uint32_t smtc_modem_hal_get_random_nb_in_range( const uint32_t val_1, const uint32_t val_2 )
+{
+    return val_1 + rnd( ) % ( val_2 - val_1 + 1 );
+}
+
+void smtc_duty_cycle_update( void )
+{
+}
+
+bool smtc_duty_cycle_is_channel_free( uint32_t freq_hz )
+{
+    return true;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define NB_CHANNELS 8
+#define UPLINK_PERIOD_S 60
+
+static smtc_real_t real;
+
+/**
+ * EU868 with the 3 default channels and 5 channels added by the network
+ */
+static void setup( uint32_t seed )
+{
+    memset( &real, 0, sizeof( real ) );
+    rnd_state = seed;
+    now_s     = 1000;
+    smtc_real_init( &real, SMTC_REAL_REGION_EU_868 );
+    smtc_real_config( &real );
+    for( uint8_t i = 3; i < NB_CHANNELS; i++ )
+    {
+        smtc_real_set_tx_frequency_channel( &real, 867100000 + ( i - 3 ) * 200000, i );
+        smtc_real_set_rx1_frequency_channel( &real, 867100000 + ( i - 3 ) * 200000, i );
+        smtc_real_set_channel_enabled( &real, 1, i );
+    }
+}
+
+/**
+ * Channel index picked for the next uplink
+ */
+static uint8_t pick_channel( void )
+{
+    uint32_t tx_frequency;
+    uint32_t rx1_frequency;
+    uint8_t  nb_available;
+    uint8_t  channel = 0;
+
+    if( smtc_real_get_next_channel( &real, 0, &tx_frequency, &rx1_frequency, &nb_available ) != OKLORAWAN )
+    {
+        return NB_CHANNELS;
+    }
+    while( ( channel < NB_CHANNELS ) && ( smtc_real_get_tx_channel_frequency( &real, channel ) != tx_frequency ) )
+    {
+        channel++;
+    }
+    return channel;
+}
+
+static void sense( uint8_t channel, bool busy )
+{
+    smtc_real_channel_occupancy_update( &real, smtc_real_get_tx_channel_frequency( &real, channel ), busy, true,
+                                        busy ? -70 : -110 );
+}
+
+/**
+ * Number of times a channel is picked out of nb_picks, without sensing
+ */
+static uint32_t count_picks( uint8_t channel, uint32_t nb_picks )
+{
+    uint32_t count = 0;
+
+    for( uint32_t i = 0; i < nb_picks; i++ )
+    {
+        count += ( pick_channel( ) == channel ) ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * Uplinks with LBT against an interferer, a busy channel makes the modem pick a channel again. Returns the number of
+ * LBT and counts the uplinks sent on each channel.
+ */
+static uint32_t run_uplinks( const uint8_t busy_percent[NB_CHANNELS], uint32_t nb_uplinks,
+                             uint32_t nb_sent[NB_CHANNELS] )
+{
+    uint32_t nb_lbt = 0;
+
+    for( uint32_t u = 0; u < nb_uplinks; u++ )
+    {
+        bool busy;
+
+        now_s += UPLINK_PERIOD_S;
+        do
+        {
+            uint8_t channel = pick_channel( );
+
+            busy = ( rnd( ) % 100 ) < busy_percent[channel];
+            sense( channel, busy );
+            nb_lbt++;
+            if( busy == false )
+            {
+                nb_sent[channel]++;
+            }
+        } while( busy == true );
+    }
+    return nb_lbt;
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies against an interferer sharing 3 of the 8 channels that the busy channels are left out once they have been
+ * sensed, so that the uplinks move to the quiet channels and need fewer LBT.
+ */
+void test_busy_channels_left_out( )
+{
+    const uint8_t busy_percent[NB_CHANNELS] = { 5, 70, 5, 5, 60, 5, 80, 5 };
+    uint32_t      nb_sent[NB_CHANNELS]      = { 0 };
+    uint32_t      nb_lbt;
+    uint32_t      min_quiet = UINT32_MAX;
+    uint32_t      max_busy  = 0;
+    bool          passed    = true;
+
+    setup( 1 );
+    // Warm up, the channels are not sensed enough yet
+    run_uplinks( busy_percent, 100, nb_sent );
+    memset( nb_sent, 0, sizeof( nb_sent ) );
+    nb_lbt = run_uplinks( busy_percent, 3000, nb_sent );
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        if( busy_percent[i] > 50 )
+        {
+            max_busy = ( nb_sent[i] > max_busy ) ? nb_sent[i] : max_busy;
+        }
+        else
+        {
+            min_quiet = ( nb_sent[i] < min_quiet ) ? nb_sent[i] : min_quiet;
+        }
+    }
+    printf( "     %.2f LBT per uplink, uplinks per channel:", ( double ) nb_lbt / 3000 );
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        printf( " %u", nb_sent[i] );
+    }
+    printf( "\n" );
+    // Without the filter each channel gets 1/8 of the picks and an uplink needs about 1.4 LBT
+    passed = passed && ( max_busy * 3 < min_quiet );
+    passed = passed && ( nb_lbt * 100 < 3000 * 125 );
+    print_result( "test_busy_channels_left_out", passed );
+}
+
+/**
+ * Verifies that a channel is not left out before SMTC_REAL_CHANNEL_OCCUPANCY_MIN_SENSES senses, is left out from
+ * then on, and that the filter never leaves out every channel.
+ */
+void test_min_senses( )
+{
+    bool passed = true;
+
+    setup( 2 );
+    for( uint8_t i = 0; i < SMTC_REAL_CHANNEL_OCCUPANCY_MIN_SENSES - 1; i++ )
+    {
+        sense( 4, true );
+    }
+    passed = passed && ( count_picks( 4, 800 ) > 0 );
+    sense( 4, true );
+    passed = passed && ( count_picks( 4, 800 ) == 0 );
+
+    // A channel found busy as often as the others is kept
+    setup( 3 );
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        for( uint8_t j = 0; j < 32; j++ )
+        {
+            sense( i, true );
+        }
+    }
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        passed = passed && ( count_picks( i, 800 ) > 0 );
+    }
+    passed = passed && ( count_picks( NB_CHANNELS, 800 ) == 0 );
+    print_result( "test_min_senses", passed );
+}
+
+/**
+ * Verifies that a busy channel not sensed for SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S is tried again with only its
+ * most recent senses, and that it goes back to a fair share of the uplinks once the interferer has left.
+ */
+void test_staleness_recovery( )
+{
+    uint8_t                       busy_percent[NB_CHANNELS] = { 5, 5, 5, 5, 100, 5, 5, 5 };
+    uint32_t                      nb_sent[NB_CHANNELS]      = { 0 };
+    smtc_real_channel_occupancy_t occupancy;
+    uint32_t                      nb_uplinks_to_recover = 0;
+    uint32_t                      nb_retries            = 0;
+    uint32_t                      last_sense_s;
+    bool                          passed                = true;
+
+    setup( 4 );
+    for( uint8_t j = 0; j < 32; j++ )
+    {
+        sense( 4, true );
+    }
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        if( i != 4 )
+        {
+            sense( i, false );
+            sense( i, false );
+            sense( i, false );
+            sense( i, false );
+        }
+    }
+    passed = passed && ( count_picks( 4, 800 ) == 0 );
+    now_s += SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S;
+    passed = passed && ( count_picks( 4, 800 ) == 0 );
+    now_s += 1;
+    passed = passed && ( count_picks( 4, 800 ) > 0 );
+    passed = passed && smtc_real_channel_occupancy_get( &real, 0, &occupancy ) &&
+             ( occupancy.nb_senses == SMTC_REAL_CHANNEL_OCCUPANCY_AGED_SENSES );
+
+    // The interferer leaves, the channel is tried again once per staleness period until its busy ratio is low
+    busy_percent[4] = 5;
+    last_sense_s    = occupancy.last_sense_s;
+    do
+    {
+        run_uplinks( busy_percent, 1, nb_sent );
+        nb_uplinks_to_recover++;
+        smtc_real_channel_occupancy_get( &real, 0, &occupancy );
+        if( occupancy.last_sense_s != last_sense_s )
+        {
+            passed       = passed && ( ( occupancy.last_sense_s - last_sense_s ) > SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S );
+            last_sense_s = occupancy.last_sense_s;
+            nb_retries++;
+        }
+    } while( ( nb_uplinks_to_recover < 1000 ) &&
+             ( ( nb_retries == 0 ) || ( ( now_s - last_sense_s ) > SMTC_REAL_CHANNEL_OCCUPANCY_MAX_AGE_S ) ||
+               ( count_picks( 4, 100 ) == 0 ) ) );
+    printf( "     back on the channel after %u retries and %u min\n", nb_retries,
+            ( nb_uplinks_to_recover * UPLINK_PERIOD_S ) / 60 );
+    passed = passed && ( nb_retries > 0 ) && ( nb_retries <= SMTC_REAL_CHANNEL_OCCUPANCY_AGED_SENSES );
+
+    // Then it gets its share of the uplinks
+    memset( nb_sent, 0, sizeof( nb_sent ) );
+    run_uplinks( busy_percent, 800, nb_sent );
+    passed = passed && ( nb_sent[4] > 800 / NB_CHANNELS / 2 );
+    print_result( "test_staleness_recovery", passed );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_busy_channels_left_out( );
+    test_min_senses( );
+    test_staleness_recovery( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
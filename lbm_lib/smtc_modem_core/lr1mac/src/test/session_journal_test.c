@@ -0,0 +1,436 @@
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The journal object is static: the module is built within the test
+#include "lr1mac_session_journal.c"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+#define PAGE_SIZE 2048
+#define NB_PAGES 4
+
+/**
+ * NOR flash model of the journal pages: program only clears bits, a power cut leaves the program or the erase
+ * partially done
+ */
+static uint8_t  flash[PAGE_SIZE * NB_PAGES];
+static jmp_buf  power_cut;
+static int32_t  power_cut_countdown = -1;  // flash operations before the power cut, -1 for none
+static uint32_t nb_programs;
+static uint32_t nb_erases;
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static void flash_operation( uint8_t* dst, const uint8_t* src, uint32_t size )
+{
+    if( ( power_cut_countdown > 0 ) && ( --power_cut_countdown == 0 ) )
+    {
+        uint32_t done = rnd( ) % ( size + 1 );
+        for( uint32_t i = 0; i < done; i++ )
+        {
+            dst[i] = ( src == NULL ) ? 0xFF : ( dst[i] & src[i] );
+        }
+        longjmp( power_cut, 1 );
+    }
+}
+
+void smtc_modem_hal_context_store( const modem_context_type_t ctx_type, uint32_t offset, const uint8_t* buffer,
+                                   const uint32_t size )
+{
+    if( ( ctx_type != CONTEXT_SESSION_JOURNAL ) || ( ( offset + size ) > sizeof( flash ) ) )
+    {
+        printf( "store out of the journal\n" );
+        exit( 2 );
+    }
+    flash_operation( &flash[offset], buffer, size );
+    for( uint32_t i = 0; i < size; i++ )
+    {
+        flash[offset + i] &= buffer[i];
+    }
+    nb_programs++;
+}
+
+void smtc_modem_hal_context_restore( const modem_context_type_t ctx_type, uint32_t offset, uint8_t* buffer,
+                                     const uint32_t size )
+{
+    if( ( ctx_type != CONTEXT_SESSION_JOURNAL ) || ( ( offset + size ) > sizeof( flash ) ) )
+    {
+        printf( "restore out of the journal\n" );
+        exit( 2 );
+    }
+    memcpy( buffer, &flash[offset], size );
+}
+
+void smtc_modem_hal_context_flash_pages_erase( const modem_context_type_t ctx_type, uint32_t offset, uint8_t nb_page )
+{
+    offset -= offset % PAGE_SIZE;
+    flash_operation( &flash[offset], NULL, PAGE_SIZE );
+    memset( &flash[offset], 0xFF, PAGE_SIZE * nb_page );
+    nb_erases++;
+}
+
+uint16_t smtc_modem_hal_flash_get_page_size( void )
+{
+    return PAGE_SIZE;
+}
+
+uint16_t smtc_modem_hal_session_journal_get_number_of_pages( void )
+{
+    return NB_PAGES;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+smtc_se_return_code_t smtc_secure_element_get_deveui( uint8_t deveui[SMTC_SE_EUI_SIZE], uint8_t stack_id )
+{
+    memset( deveui, 0x11 + stack_id, SMTC_SE_EUI_SIZE );
+    return SMTC_SE_RC_SUCCESS;
+}
+
+smtc_se_return_code_t smtc_secure_element_get_joineui( uint8_t joineui[SMTC_SE_EUI_SIZE], uint8_t stack_id )
+{
+    memset( joineui, 0x22, SMTC_SE_EUI_SIZE );
+    return SMTC_SE_RC_SUCCESS;
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_derive_skeys( const uint8_t join_nonce[LORAWAN_JOIN_NONCE_SIZE],
+                                                                const uint8_t net_id[LORAWAN_NET_ID_SIZE],
+                                                                uint16_t dev_nonce, uint8_t stack_id )
+{
+    return SMTC_MODEM_CRYPTO_RC_SUCCESS;
+}
+
+void lr1_stack_mac_region_config( lr1_stack_mac_t* lr1_mac )
+{
+    lr1_mac->rx2_frequency = 869525000;
+}
+
+void lr1_stack_mac_session_init( lr1_stack_mac_t* lr1_mac )
+{
+    lr1_mac->fcnt_up  = 0;
+    lr1_mac->fcnt_dwn = ~0;
+}
+
+void smtc_real_config_session( smtc_real_t* real )
+{
+}
+
+status_lorawan_t smtc_real_update_cflist( smtc_real_t* real, uint8_t* cf_list )
+{
+    return OKLORAWAN;
+}
+
+void smtc_real_init_after_join_snapshot_channel_mask( smtc_real_t* real, uint8_t tx_data_rate, uint32_t tx_frequency )
+{
+}
+
+void smtc_real_set_dr_distribution( smtc_real_t* real, uint8_t adr_mode, uint8_t* nb_trans )
+{
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+static smtc_real_t     real[NUMBER_OF_STACKS];
+static lr1_stack_mac_t mac[NUMBER_OF_STACKS];
+
+/**
+ * What really happened on air and in the LoRaWAN context, it survives the power cuts
+ */
+typedef struct device_s
+{
+    uint16_t dev_nonce;       // last join, written in the LoRaWAN context before the journal
+    bool     is_open;         // the session is open in the journal
+    bool     is_uncertain;    // the session was being opened or closed when the power was cut
+    bool     has_sent;        // an uplink was sent in the session of sent_dev_nonce
+    uint16_t sent_dev_nonce;  // join of the last uplink sent
+    uint32_t last_fcnt_up;    // last uplink frame counter sent on air
+    uint32_t last_fcnt_dwn;   // last downlink frame counter accepted
+    uint32_t prev_fcnt_dwn;   // previous one, the power may have been cut while recording the last one
+} device_t;
+
+static device_t device[NUMBER_OF_STACKS];
+
+typedef struct journal_stat_s
+{
+    uint32_t cuts;
+    uint32_t restores;
+    uint32_t joins;
+    uint32_t uplinks;
+    uint32_t downlinks;
+    uint32_t closed_restored;  // a closed session was restored
+    uint32_t fcnt_up_reused;   // a restored session would send an uplink counter already sent
+    uint32_t fcnt_dwn_errors;  // the restored downlink counter is not the last accepted one
+} journal_stat_t;
+
+/**
+ * Reset: the RAM state is lost, the LoRaWAN context gives back the last join nonces
+ */
+static void reboot( void )
+{
+    memset( &session_journal, 0, sizeof( session_journal ) );
+    for( uint8_t i = 0; i < NUMBER_OF_STACKS; i++ )
+    {
+        memset( &mac[i], 0, sizeof( mac[i] ) );
+        mac[i].real              = &real[i];
+        mac[i].stack_id          = i;
+        mac[i].dev_nonce         = device[i].dev_nonce;
+        mac[i].join_nonce[0]     = ( uint8_t ) device[i].dev_nonce;
+        mac[i].real->region_type = 1;
+        mac[i].join_status       = NOT_JOINED;
+    }
+}
+
+static void join( uint8_t stack_id )
+{
+    lr1_stack_mac_t* lr1_mac = &mac[stack_id];
+    device_t*        dev     = &device[stack_id];
+
+    // The nonce is stored in the LoRaWAN context before the session is recorded in the journal
+    dev->dev_nonce         = dev->dev_nonce + 1;
+    dev->is_uncertain      = true;
+    lr1_mac->dev_nonce     = dev->dev_nonce;
+    lr1_mac->join_nonce[0] = ( uint8_t ) dev->dev_nonce;
+    lr1_mac->dev_addr      = rnd( );
+    lr1_mac->fcnt_up       = 0;
+    lr1_mac->fcnt_dwn      = ~0;
+    lr1_mac->rx2_frequency = 869525000;
+    lr1_mac->join_status   = JOINED;
+    lr1mac_session_journal_open( lr1_mac, ( rnd( ) & 1 ) == 1 );
+    dev->is_open       = true;
+    dev->is_uncertain  = false;
+    dev->has_sent      = false;
+    dev->last_fcnt_dwn = ~0;
+    dev->prev_fcnt_dwn = ~0;
+}
+
+static void restore_or_join( uint8_t stack_id, journal_stat_t* stat )
+{
+    lr1_stack_mac_t* lr1_mac = &mac[stack_id];
+    device_t*        dev     = &device[stack_id];
+
+    if( lr1mac_session_journal_restore( lr1_mac ) != OKLORAWAN )
+    {
+        stat->joins++;
+        join( stack_id );
+        return;
+    }
+
+    stat->restores++;
+    if( ( dev->is_open == false ) && ( dev->is_uncertain == false ) )
+    {
+        stat->closed_restored++;
+    }
+    if( ( dev->has_sent == true ) && ( lr1_mac->dev_nonce == dev->sent_dev_nonce ) &&
+        ( lr1_mac->fcnt_up <= dev->last_fcnt_up ) )
+    {
+        stat->fcnt_up_reused++;
+    }
+    // A downlink counter being recorded when the power was cut may be lost, the frame was not handled yet
+    if( ( dev->is_uncertain == false ) && ( lr1_mac->fcnt_dwn != dev->last_fcnt_dwn ) &&
+        ( lr1_mac->fcnt_dwn != dev->prev_fcnt_dwn ) )
+    {
+        stat->fcnt_dwn_errors++;
+    }
+    dev->is_open       = true;
+    dev->is_uncertain  = false;
+    dev->last_fcnt_dwn = lr1_mac->fcnt_dwn;
+    dev->prev_fcnt_dwn = lr1_mac->fcnt_dwn;
+}
+
+/**
+ * One device step: restore or join, send an uplink, receive a downlink or leave the network
+ */
+static void device_step( journal_stat_t* stat )
+{
+    uint8_t          stack_id = rnd( ) % NUMBER_OF_STACKS;
+    lr1_stack_mac_t* lr1_mac  = &mac[stack_id];
+    device_t*        dev      = &device[stack_id];
+    uint32_t         action   = rnd( ) % 100;
+
+    if( lr1_mac->join_status != JOINED )
+    {
+        restore_or_join( stack_id, stat );
+    }
+    else if( action < 80 )
+    {
+        // The counter is reserved before the frame is built and sent
+        lr1mac_session_journal_reserve( lr1_mac );
+        dev->has_sent       = true;
+        dev->sent_dev_nonce = lr1_mac->dev_nonce;
+        dev->last_fcnt_up   = lr1_mac->fcnt_up;
+        lr1_mac->fcnt_up++;
+        stat->uplinks++;
+    }
+    else if( action < 97 )
+    {
+        dev->prev_fcnt_dwn = lr1_mac->fcnt_dwn;
+        lr1_mac->fcnt_dwn += 1 + rnd( ) % 3;
+        dev->last_fcnt_dwn = lr1_mac->fcnt_dwn;
+        if( ( rnd( ) % 20 ) == 0 )
+        {
+            lr1_mac->rx2_frequency = 869000000 + ( rnd( ) % 10 ) * 100000;
+        }
+        lr1mac_session_journal_update( lr1_mac );
+        dev->prev_fcnt_dwn = dev->last_fcnt_dwn;
+        stat->downlinks++;
+    }
+    else if( action < 98 )
+    {
+        // Leave the network
+        dev->is_uncertain = true;
+        lr1mac_session_journal_close( lr1_mac );
+        dev->is_open         = false;
+        dev->is_uncertain    = false;
+        lr1_mac->join_status = NOT_JOINED;
+    }
+}
+
+/**
+ * Run the devices with a power cut after a random number of flash operations, then reboot, many times
+ */
+static void power_cut_replay( uint32_t seed, uint32_t rounds, journal_stat_t* stat )
+{
+    rnd_state = seed;
+    memset( flash, 0xFF, sizeof( flash ) );
+    memset( device, 0, sizeof( device ) );
+    reboot( );
+
+    for( uint32_t round = 0; round < rounds; round++ )
+    {
+        power_cut_countdown = 1 + rnd( ) % 400;
+        if( setjmp( power_cut ) == 0 )
+        {
+            for( uint16_t step = 0; step < 300; step++ )
+            {
+                device_step( stat );
+            }
+        }
+        else
+        {
+            stat->cuts++;
+        }
+        power_cut_countdown = -1;
+        reboot( );
+    }
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies over random power cuts inside programs and erases that a restored session never reuses an uplink frame
+ * counter, that a closed session is never restored, and that the restored downlink counter is the last accepted one.
+ */
+void test_power_cuts( )
+{
+    journal_stat_t stat = { 0 };
+
+    for( uint32_t seed = 1; seed <= 4; seed++ )
+    {
+        power_cut_replay( seed, 5000, &stat );
+    }
+    printf( "     %u power cuts, %u restores, %u joins, %u uplinks\n", stat.cuts, stat.restores, stat.joins,
+            stat.uplinks );
+    print_result( "test_power_cuts", ( stat.closed_restored == 0 ) && ( stat.fcnt_up_reused == 0 ) &&
+                                         ( stat.fcnt_dwn_errors == 0 ) && ( stat.cuts > 0 ) && ( stat.restores > 0 ) );
+}
+
+/**
+ * Verifies that a session is restored after a reset with its counters, and that it is not once closed.
+ */
+void test_restore_and_close( )
+{
+    bool passed;
+
+    rnd_state = 1;
+    memset( flash, 0xFF, sizeof( flash ) );
+    memset( device, 0, sizeof( device ) );
+    reboot( );
+    join( 0 );
+    for( uint8_t i = 0; i < 40; i++ )
+    {
+        lr1mac_session_journal_reserve( &mac[0] );
+        mac[0].fcnt_up++;
+    }
+    mac[0].fcnt_dwn = 7;
+    lr1mac_session_journal_update( &mac[0] );
+
+    reboot( );
+    passed = ( lr1mac_session_journal_restore( &mac[0] ) == OKLORAWAN ) && ( mac[0].fcnt_up >= 40 ) &&
+             ( mac[0].fcnt_up <= 40 + SESSION_JOURNAL_FCNT_UP_STEP ) && ( mac[0].fcnt_dwn == 7 );
+    // The other stack has no session
+    passed = passed && ( lr1mac_session_journal_restore( &mac[1] ) == ERRORLORAWAN );
+
+    lr1mac_session_journal_close( &mac[0] );
+    reboot( );
+    passed = passed && ( lr1mac_session_journal_restore( &mac[0] ) == ERRORLORAWAN );
+    print_result( "test_restore_and_close", passed );
+}
+
+/**
+ * Measures the flash wear of a Class C device: one journal entry per accepted downlink.
+ */
+void test_downlink_wear( )
+{
+    uint32_t nb_downlinks = 100000;
+    uint32_t nb_pages_filled;
+
+    rnd_state = 1;
+    memset( flash, 0xFF, sizeof( flash ) );
+    memset( device, 0, sizeof( device ) );
+    reboot( );
+    join( 0 );
+
+    nb_erases = 0;
+    for( uint32_t i = 0; i < nb_downlinks; i++ )
+    {
+        mac[0].fcnt_dwn++;
+        lr1mac_session_journal_update( &mac[0] );
+    }
+    nb_pages_filled = nb_downlinks / session_journal.fs.slots_per_sector;
+    printf( "     %u bytes per entry, %u entries per page, %u downlinks: %u page erases\n",
+            ( uint32_t ) sizeof( lr1mac_session_journal_entry_t ), ( uint32_t ) session_journal.fs.slots_per_sector,
+            nb_downlinks, nb_erases );
+    // Each downlink appends one entry: a page is erased each time a page of entries is filled
+    print_result( "test_downlink_wear",
+                  ( nb_erases + NB_PAGES >= nb_pages_filled ) && ( nb_erases <= nb_pages_filled + NB_PAGES ) );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_power_cuts( );
+    test_restore_and_close( );
+    test_downlink_wear( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
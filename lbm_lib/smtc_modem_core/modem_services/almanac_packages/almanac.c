@@ -157,6 +157,8 @@ void almanac_services_init( uint8_t* service_id, uint8_t task_id,
     almanac_obj.rp_hook_id                     = RP_HOOK_ID_DIRECT_RP_ACCESS_4_ALMANAC + CURRENT_STACK;
     rp_hook_init( modem_get_rp( ), almanac_obj.rp_hook_id, ( void ( * )( void* ) )( rp_end_almanac_callback ),
                   modem_get_rp( ) );
+    modem_downlink_set_filter( almanac_service_downlink_handler, CURRENT_STACK, MODEM_DOWNLINK_FILTER_DM_FPORT,
+                               DM_PORT );
 }
 
 void almanac_service_on_launch( void* context )
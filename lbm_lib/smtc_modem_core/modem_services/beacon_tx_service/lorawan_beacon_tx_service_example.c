@@ -130,6 +130,7 @@ void lorawan_beacon_tx_example_service_init( uint8_t* service_id, uint8_t task_i
     rp_hook_init( modem_get_rp( ), RP_HOOK_ID_DIRECT_RP_ACCESS, ( void ( * )( void* ) )( end_user_beacon_callback ),
                   modem_get_rp( ) );
     //  lorawan_beacon_tx_example_add_task (CURRENT_STACK);
+    modem_downlink_set_windows( lorawan_beacon_tx_example_service_downlink_handler, MODEM_DOWNLINK_WINDOWS_NONE );
 }
 
 void lorawan_beacon_tx_example_service_on_launch( void* context_callback )
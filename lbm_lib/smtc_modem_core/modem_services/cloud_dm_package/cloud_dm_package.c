@@ -40,6 +40,7 @@
 #include <stdint.h>   // C99 types
 #include <stdbool.h>  // bool type
 #include "modem_core.h"
+#include "modem_context_cache.h"
 #include "smtc_modem_api.h"
 #include "smtc_modem_hal.h"
 #include "smtc_modem_hal_dbg_trace.h"
@@ -572,6 +573,8 @@ dm_rc_t cloud_dm_set_dm_port( uint8_t stack_id, uint8_t port )
         if( ctx->dm_port != port )
         {
             ctx->dm_port = port;
+            // services listening to device management downlinks follow the new port
+            modem_downlink_set_dm_fport( stack_id, port );
             // modem_store_context( );  // TODO do we still store context ?
         }
         return DM_OK;
@@ -1221,7 +1224,7 @@ static dm_rc_t dm_reset( cloud_dm_t* ctx, dm_reset_code_t reset_code, uint16_t r
         case DM_RESET_MODEM:
         case DM_RESET_APP_MCU:
         case DM_RESET_BOTH:
-            // lorawan_api_context_save( );  // TODO save context
+            modem_context_cache_flush_all( );
             smtc_modem_hal_reset_mcu( );
             break;
         default:
@@ -131,6 +131,29 @@
 // number of words per chunk
 #define CHUNK_NW ( 2 )
 
+#if( CHUNK_NW != 2 )
+#error "The chunk generation is unrolled for chunks of 2 words"
+#endif
+
+// number of chunks generated at once for a fragment
+#define CHUNK_BATCH_NB ( 16 )
+
+#if defined( ADD_LFU_STREAMED )
+// Streamed file cache: number of windows and window size in bytes. The windows shall cover one group of 32 chunks
+// (256 bytes not aligned on a window) for a chunk generation to read each window once.
+#ifndef FILE_UPLOAD_CACHE_NB_WINDOWS
+#define FILE_UPLOAD_CACHE_NB_WINDOWS ( 5 )
+#endif
+#ifndef FILE_UPLOAD_CACHE_WINDOW_SIZE
+#define FILE_UPLOAD_CACHE_WINDOW_SIZE ( 64 )
+#endif
+#define FILE_UPLOAD_CACHE_WINDOW_INVALID ( 0xFFFFFFFF )
+
+#if( ( FILE_UPLOAD_CACHE_WINDOW_SIZE % 16 ) != 0 )
+#error "FILE_UPLOAD_CACHE_WINDOW_SIZE shall be a multiple of 16"
+#endif
+#endif  // ADD_LFU_STREAMED
+
 #define FILE_UPLOAD_TOKEN 0x0E
 #define FILE_UPLOAD_DIRECTION 0x40
 
@@ -147,13 +170,30 @@
  */
 typedef enum lfu_state_e
 {
-    LFU_NOT_INIT = 0,     //!< The file upload is not initialized
-    LFU_INIT_AND_FILLED,  //!< The file upload is initialized and filled with data
-    LFU_START_REQUESTED,  //!< A start was requested by user but the service is waiting to be launched by supervisor
-    LFU_ON_GOING,         //!< The upload is in progress
-    LFU_FINISHED,         //!< The upload process is finished
+    LFU_NOT_INIT = 0,      //!< The file upload is not initialized
+    LFU_INIT_AND_FILLING,  //!< The streamed file upload is initialized and waits for the file data
+    LFU_INIT_AND_FILLED,   //!< The file upload is initialized and filled with data
+    LFU_START_REQUESTED,   //!< A start was requested by user but the service is waiting to be launched by supervisor
+    LFU_ON_GOING,          //!< The upload is in progress
+    LFU_FINISHED,          //!< The upload process is finished
 } lfu_state_t;
 
+typedef struct file_upload_sha256_s
+{
+    uint32_t state[8];   // intermediate hash value
+    uint8_t  block[64];  // pending bytes of the current block
+    uint32_t len;        // number of bytes hashed so far
+} file_upload_sha256_t;
+
+#if defined( ADD_LFU_STREAMED )
+typedef struct file_upload_window_s
+{
+    uint32_t offset;    // offset of the window in the file
+    uint32_t last_use;  // cache tick of the last access to the window
+    uint32_t data[FILE_UPLOAD_CACHE_WINDOW_SIZE / 4];
+} file_upload_window_t;
+#endif
+
 typedef struct file_upload_s
 {
     uint8_t   sid;                   // Session Id (2bits)
@@ -161,13 +201,23 @@ typedef struct file_upload_s
     uint8_t   port;                  // applicative port on which the upload is done
     bool      encrypt_with_appskey;  // file upload encryption option
     uint8_t   session_counter;       // session counter
-    uint32_t* file_buf;              // data buffer
+    uint32_t* file_buf;              // data buffer, NULL for a streamed file
     uint32_t  file_len;              // file len
     uint32_t  header[3];             // Current file upload header
     uint16_t  cct;                   // chunk count
     uint16_t  cntx;                  // chunk transmission count
     uint8_t   fntx;                  // frame transmission count
-
+#if defined( ADD_LFU_STREAMED )
+    uint8_t                       stack_id;       // stack used to encrypt a streamed file
+    uint16_t                      dev_nonce;      // DevNonce of the session whose AppSKey encrypts a streamed file
+    smtc_modem_file_upload_read_t read_callback;  // read callback of a streamed file
+    uint32_t                      cache_tick;     // streamed file cache access counter
+    union
+    {
+        file_upload_sha256_t sha256;  // hash of a streamed file while it is written
+        file_upload_window_t window[FILE_UPLOAD_CACHE_NB_WINDOWS];  // cache of a streamed file while it is uploaded
+    } stream;
+#endif
 } file_upload_t;
 
 typedef struct lfu_ctx_s
@@ -225,6 +275,49 @@ file_upload_return_code_t file_upload_process_file_done_frame( file_upload_t* fi
  */
 file_upload_return_code_t file_upload_prepare_upload( lfu_ctx_t* ctx );
 
+/**
+ * @brief Common part of the file upload session creation
+ *
+ * @param [in] ctx            Pointer to LFU context
+ * @param [in] file_len       size of file
+ * @param [in] average_delay  average delay between each uplink frame
+ * @param [in] port           applicative where the data will be forwarded
+ * @param [in] encryption     Encryption with appskey option
+ * @return file_upload_return_code_t
+ */
+static file_upload_return_code_t file_upload_session_init( lfu_ctx_t* ctx, uint32_t file_len, uint16_t average_delay,
+                                                           uint8_t port, bool encryption );
+
+/**
+ * @brief Build the nonce used to encrypt the file
+ *
+ * @param [in]  file_upload Pointer to File Upload context
+ * @param [in]  plain_hash  First word of the hash over plain data
+ * @param [out] nonce       Nonce
+ */
+static void file_upload_build_nonce( const file_upload_t* file_upload, uint32_t plain_hash, uint8_t nonce[14] );
+
+#if defined( ADD_LFU_STREAMED )
+/**
+ * @brief Get the streamed file cache window containing a file offset, reading it on a miss in place of the least
+ * recently used window
+ *
+ * @param [in] file_upload Pointer to File Upload context
+ * @param [in] offset      Offset in the file
+ * @return file_upload_window_t* Window holding the (encrypted if requested) file data
+ */
+static file_upload_window_t* file_upload_get_window( file_upload_t* file_upload, uint32_t offset );
+#endif
+
+/**
+ * @brief Read a file word, zero padded past the end of the file
+ *
+ * @param [in] file_upload Pointer to File Upload context
+ * @param [in] word        Index of the 32-bit word in the file
+ * @return uint32_t File word
+ */
+static uint32_t file_upload_read_word( file_upload_t* file_upload, uint32_t word );
+
 /**
  * @brief File upload fragment generation
  *
@@ -248,8 +341,33 @@ bool file_upload_is_data_remaining( file_upload_t* file_upload );
 // Algo
 static uint32_t phash( uint32_t x );
 static uint32_t checkbits( uint32_t cid, uint32_t cct, uint32_t i );
-static void     function_xor( uint32_t* dst, uint32_t* src, int32_t nw );
-static void     gen_chunk( file_upload_t* file_upload, uint32_t* dst, uint32_t* src, uint32_t cct, uint32_t cid );
+static void     xor_chunk( uint32_t* dst, const uint32_t* src );
+static void     get_src_chunk( file_upload_t* file_upload, uint32_t* dst, uint32_t i );
+static void     gen_chunks( file_upload_t* file_upload, uint32_t* dst, uint32_t nb_chunks, uint32_t cct, uint32_t cid );
+
+/**
+ * @brief Start an incremental SHA256 computation
+ *
+ * @param [in] ctx SHA256 context
+ */
+static void sha256_init( file_upload_sha256_t* ctx );
+
+/**
+ * @brief Hash the next bytes of the message
+ *
+ * @param [in] ctx SHA256 context
+ * @param [in] msg input buffer
+ * @param [in] len input buffer length
+ */
+static void sha256_update( file_upload_sha256_t* ctx, const uint8_t* msg, uint32_t len );
+
+/**
+ * @brief End an incremental SHA256 computation
+ *
+ * @param [in] ctx  SHA256 context
+ * @param [in] hash Contains the computed hash
+ */
+static void sha256_final( file_upload_sha256_t* ctx, uint32_t* hash );
 
 /**
  * @brief Compute SHA256
@@ -290,6 +408,7 @@ void lfu_services_init( uint8_t* service_id, uint8_t task_id,
     memset( &ctx->lfu, 0, sizeof( file_upload_t ) );
 
     SMTC_MODEM_HAL_TRACE_WARNING( "%s\n", __func__ );
+    modem_downlink_set_filter( lfu_service_downlink_handler, CURRENT_STACK, MODEM_DOWNLINK_FILTER_DM_FPORT, DM_PORT );
 }
 
 /*
@@ -305,45 +424,85 @@ file_upload_return_code_t file_upload_init( uint8_t stack_id, const uint8_t* fil
     lfu_ctx_t* ctx = lfu_get_ctx_from_stack_id( stack_id, &service_id );
     SMTC_MODEM_HAL_PANIC_ON_FAILURE( ctx != NULL );
 
-    if( file_len > FILE_UPLOAD_MAX_SIZE )
+    file_upload_return_code_t rc = file_upload_session_init( ctx, file_len, average_delay, port, encryption );
+    if( rc != FILE_UPLOAD_OK )
     {
-        SMTC_MODEM_HAL_TRACE_ERROR( "FileUpload is too large (%d > %d )\n", file_len, FILE_UPLOAD_MAX_SIZE );
-        return FILE_UPLOAD_ERROR_SIZE;
+        return rc;
     }
-    if( file_len == 0 )
+
+    ctx->lfu.file_buf = ( uint32_t* ) file;
+
+    ctx->state = LFU_INIT_AND_FILLED;
+    return FILE_UPLOAD_OK;
+}
+
+#if defined( ADD_LFU_STREAMED )
+file_upload_return_code_t file_upload_init_streamed( uint8_t stack_id, smtc_modem_file_upload_read_t read_callback,
+                                                     uint32_t file_len, uint16_t average_delay, uint8_t port,
+                                                     bool encryption )
+{
+    IS_VALID_STACK_ID( stack_id );
+    uint8_t    service_id;
+    lfu_ctx_t* ctx = lfu_get_ctx_from_stack_id( stack_id, &service_id );
+    SMTC_MODEM_HAL_PANIC_ON_FAILURE( ctx != NULL );
+
+    file_upload_return_code_t rc = file_upload_session_init( ctx, file_len, average_delay, port, encryption );
+    if( rc != FILE_UPLOAD_OK )
     {
-        SMTC_MODEM_HAL_TRACE_ERROR( "File Upload size shall be different from 0\n" );
-        return FILE_UPLOAD_ERROR_SIZE;
+        return rc;
     }
-    if( ctx->state != LFU_NOT_INIT )
+
+    ctx->lfu.file_buf      = NULL;
+    ctx->lfu.read_callback = read_callback;
+    ctx->lfu.stack_id      = stack_id;
+    sha256_init( &ctx->lfu.stream.sha256 );
+
+    // the session can be started once the whole file has been given to file_upload_write()
+    ctx->state = LFU_INIT_AND_FILLING;
+    return FILE_UPLOAD_OK;
+}
+
+file_upload_return_code_t file_upload_write( uint8_t stack_id, const uint8_t* data, uint32_t len )
+{
+    IS_VALID_STACK_ID( stack_id );
+    uint8_t    service_id;
+    lfu_ctx_t* ctx = lfu_get_ctx_from_stack_id( stack_id, &service_id );
+    SMTC_MODEM_HAL_PANIC_ON_FAILURE( ctx != NULL );
+
+    if( ctx->state != LFU_INIT_AND_FILLING )
     {
-        SMTC_MODEM_HAL_TRACE_ERROR( "File Upload still in going\n" );
-        return FILE_UPLOAD_ERROR_BUSY;
+        SMTC_MODEM_HAL_TRACE_ERROR( "No streamed File Upload waiting for data\n" );
+        return FILE_UPLOAD_ERROR_NOT_INIT;
+    }
+    if( len > ( ctx->lfu.file_len - ctx->lfu.stream.sha256.len ) )
+    {
+        SMTC_MODEM_HAL_TRACE_ERROR( "File Upload data exceeds the file size\n" );
+        return FILE_UPLOAD_ERROR_SIZE;
     }
 
-    uint16_t sz_tmp = file_len + FILE_UPLOAD_HEADER_SIZE;
-    uint32_t cct    = ( sz_tmp + ( ( 4 * CHUNK_NW ) - 1 ) ) / ( 4 * CHUNK_NW );
+    // the hash over plain data is computed while the file is written
+    sha256_update( &ctx->lfu.stream.sha256, data, len );
 
-    ctx->lfu.sid                  = UPLOAD_SID & 0x3;
-    ctx->lfu.session_counter      = ( ctx->lfu.session_counter + 1 ) & 0xf;
-    ctx->lfu.encrypt_with_appskey = encryption;
-    ctx->lfu.average_delay        = average_delay;
-    ctx->lfu.port                 = port;
-    ctx->lfu.file_len             = file_len;
-    ctx->lfu.file_buf             = ( uint32_t* ) file;
-    ctx->lfu.cct                  = cct;
-    ctx->lfu.cntx                 = 0;
-    ctx->lfu.fntx                 = 0;
-    ctx->lfu.header[0] =
-        ( port ) + ( encryption << 8 ) + ( ( file_len & 0xFF ) << 16 ) + ( ( ( file_len & 0xFF00 ) >> 8 ) << 24 );
-
-    ctx->state = LFU_INIT_AND_FILLED;
+    if( ctx->lfu.stream.sha256.len == ctx->lfu.file_len )
+    {
+        uint32_t hash[8];
+        sha256_final( &ctx->lfu.stream.sha256, hash );
+        ctx->lfu.header[1] = hash[0];
+        ctx->lfu.header[2] = hash[1];
 
-    SMTC_MODEM_HAL_TRACE_PRINTF( "File Upload Init done: cipher_mode: %d, size:%d, average_delay:%d, index:%d\n",
-                                 encryption, file_len, average_delay, port );
+        // hash context is no longer needed, its memory is now used by the file cache
+        for( uint8_t i = 0; i < FILE_UPLOAD_CACHE_NB_WINDOWS; i++ )
+        {
+            ctx->lfu.stream.window[i].offset   = FILE_UPLOAD_CACHE_WINDOW_INVALID;
+            ctx->lfu.stream.window[i].last_use = 0;
+        }
+        ctx->lfu.cache_tick = 0;
 
+        ctx->state = LFU_INIT_AND_FILLED;
+    }
     return FILE_UPLOAD_OK;
 }
+#endif  // ADD_LFU_STREAMED
 
 file_upload_return_code_t file_upload_start( uint8_t stack_id )
 {
@@ -357,6 +516,11 @@ file_upload_return_code_t file_upload_start( uint8_t stack_id )
         SMTC_MODEM_HAL_TRACE_ERROR( "FileUpload still in progress..\n" );
         return FILE_UPLOAD_ERROR_BUSY;
     }
+    if( ctx->state == LFU_INIT_AND_FILLING )
+    {
+        SMTC_MODEM_HAL_TRACE_ERROR( "File upload session not filled\n" );
+        return FILE_UPLOAD_ERROR_NOT_INIT;
+    }
     if( ctx->state != LFU_INIT_AND_FILLED )
     {
         SMTC_MODEM_HAL_TRACE_ERROR( "File upload session not initialized\n" );
@@ -452,6 +616,19 @@ static void lfu_service_on_launch( void* service_id )
         SMTC_MODEM_HAL_TRACE_ERROR( "No File upload on going \n" );
         return;
     }
+#if defined( ADD_LFU_STREAMED )
+    // an encrypted streamed file is encrypted window by window while it is read, all with the AppSKey of the session
+    // that started the upload
+    if( ( lfu_ctx[idx].lfu.file_buf == NULL ) && ( lfu_ctx[idx].lfu.encrypt_with_appskey == true ) &&
+        ( lfu_ctx[idx].lfu.dev_nonce != lorawan_api_devnonce_get( lfu_ctx[idx].stack_id ) ) )
+    {
+        SMTC_MODEM_HAL_TRACE_WARNING( "File upload aborted, the stack joined again \n" );
+        lfu_ctx[idx].state = LFU_NOT_INIT;
+        increment_asynchronous_msgnumber( SMTC_MODEM_EVENT_UPLOAD_DONE, SMTC_MODEM_EVENT_UPLOAD_DONE_ABORTED,
+                                          lfu_ctx[idx].stack_id );
+        return;
+    }
+#endif
     uint32_t max_payload_size = lorawan_api_next_max_payload_length_get( lfu_ctx[idx].stack_id );
     file_upload_chunk_size    = file_upload_get_fragment( &lfu_ctx[idx].lfu, file_upload_chunk_payload,
                                                        ( max_payload_size > 100 ) ? 100 : max_payload_size,
@@ -593,9 +770,84 @@ static void lfu_add_task( lfu_ctx_t* ctx, uint32_t delay_in_s )
 }
 
 // LFU functionalities
+static file_upload_return_code_t file_upload_session_init( lfu_ctx_t* ctx, uint32_t file_len, uint16_t average_delay,
+                                                           uint8_t port, bool encryption )
+{
+    if( file_len > FILE_UPLOAD_MAX_SIZE )
+    {
+        SMTC_MODEM_HAL_TRACE_ERROR( "FileUpload is too large (%d > %d )\n", file_len, FILE_UPLOAD_MAX_SIZE );
+        return FILE_UPLOAD_ERROR_SIZE;
+    }
+    if( file_len == 0 )
+    {
+        SMTC_MODEM_HAL_TRACE_ERROR( "File Upload size shall be different from 0\n" );
+        return FILE_UPLOAD_ERROR_SIZE;
+    }
+    if( ctx->state != LFU_NOT_INIT )
+    {
+        SMTC_MODEM_HAL_TRACE_ERROR( "File Upload still in going\n" );
+        return FILE_UPLOAD_ERROR_BUSY;
+    }
+
+    uint16_t sz_tmp = file_len + FILE_UPLOAD_HEADER_SIZE;
+    uint32_t cct    = ( sz_tmp + ( ( 4 * CHUNK_NW ) - 1 ) ) / ( 4 * CHUNK_NW );
+
+    ctx->lfu.sid                  = UPLOAD_SID & 0x3;
+    ctx->lfu.session_counter      = ( ctx->lfu.session_counter + 1 ) & 0xf;
+    ctx->lfu.encrypt_with_appskey = encryption;
+    ctx->lfu.average_delay        = average_delay;
+    ctx->lfu.port                 = port;
+    ctx->lfu.file_len             = file_len;
+    ctx->lfu.cct                  = cct;
+    ctx->lfu.cntx                 = 0;
+    ctx->lfu.fntx                 = 0;
+    ctx->lfu.header[0] =
+        ( port ) + ( encryption << 8 ) + ( ( file_len & 0xFF ) << 16 ) + ( ( ( file_len & 0xFF00 ) >> 8 ) << 24 );
+
+    SMTC_MODEM_HAL_TRACE_PRINTF( "File Upload Init done: cipher_mode: %d, size:%d, average_delay:%d, index:%d\n",
+                                 encryption, file_len, average_delay, port );
+
+    return FILE_UPLOAD_OK;
+}
+
 file_upload_return_code_t file_upload_prepare_upload( lfu_ctx_t* ctx )
 {
     uint32_t hash[8];
+
+#if defined( ADD_LFU_STREAMED )
+    if( ctx->lfu.file_buf == NULL )
+    {
+        // streamed file: the hash over plain data was computed while the file was written
+        if( ctx->lfu.encrypt_with_appskey == true )
+        {
+            // the upload is aborted if the stack joins again, as the AppSKey would change
+            ctx->lfu.dev_nonce = lorawan_api_devnonce_get( ctx->stack_id );
+
+            // hash over plain data (first byte), also used by the cache to encrypt the windows
+            ctx->lfu.header[2] = ctx->lfu.header[1];
+
+            // compute hash over encrypted data, read back window by window
+            file_upload_sha256_t sha256_ctx;
+            sha256_init( &sha256_ctx );
+            for( uint32_t offset = 0; offset < ctx->lfu.file_len; offset += FILE_UPLOAD_CACHE_WINDOW_SIZE )
+            {
+                file_upload_window_t* window = file_upload_get_window( &ctx->lfu, offset );
+                uint32_t              size   = ctx->lfu.file_len - offset;
+                if( size > FILE_UPLOAD_CACHE_WINDOW_SIZE )
+                {
+                    size = FILE_UPLOAD_CACHE_WINDOW_SIZE;
+                }
+                sha256_update( &sha256_ctx, ( uint8_t* ) window->data, size );
+            }
+            sha256_final( &sha256_ctx, hash );
+
+            // hash over encrypted data (first byte)
+            ctx->lfu.header[1] = hash[0];
+        }
+        return FILE_UPLOAD_OK;
+    }
+#endif
+
     sha256( hash, ( unsigned char* ) ctx->lfu.file_buf, ctx->lfu.file_len );
     ctx->lfu.header[1] = hash[0];
     ctx->lfu.header[2] = hash[1];
@@ -603,19 +855,8 @@ file_upload_return_code_t file_upload_prepare_upload( lfu_ctx_t* ctx )
     if( ctx->lfu.encrypt_with_appskey == true )
     {
         // encrypt using AppSKey with "upload" category and file size and hash as diversification data
-        uint8_t nonce[14] = { 0 };
-
-        nonce[0] = 0x01;
-
-        nonce[5]  = FILE_UPLOAD_DIRECTION;
-        nonce[6]  = ctx->lfu.file_len & 0xFF;
-        nonce[7]  = ( ctx->lfu.file_len >> 8 ) & 0xFF;
-        nonce[8]  = ( ctx->lfu.file_len >> 16 ) & 0xFF;
-        nonce[9]  = ( ctx->lfu.file_len >> 24 ) & 0xFF;
-        nonce[10] = hash[0] & 0xFF;
-        nonce[11] = ( hash[0] >> 8 ) & 0xFF;
-        nonce[12] = ( hash[0] >> 16 ) & 0xFF;
-        nonce[13] = ( hash[0] >> 24 ) & 0xFF;
+        uint8_t nonce[14];
+        file_upload_build_nonce( &ctx->lfu, hash[0], nonce );
         if( smtc_modem_crypto_service_encrypt( ( uint8_t* ) ctx->lfu.file_buf, ctx->lfu.file_len, nonce,
                                                ( uint8_t* ) ctx->lfu.file_buf,
                                                ctx->stack_id ) != SMTC_MODEM_CRYPTO_RC_SUCCESS )
@@ -634,6 +875,98 @@ file_upload_return_code_t file_upload_prepare_upload( lfu_ctx_t* ctx )
     return FILE_UPLOAD_OK;
 }
 
+static void file_upload_build_nonce( const file_upload_t* file_upload, uint32_t plain_hash, uint8_t nonce[14] )
+{
+    memset( nonce, 0, 14 );
+
+    nonce[0] = 0x01;
+
+    nonce[5]  = FILE_UPLOAD_DIRECTION;
+    nonce[6]  = file_upload->file_len & 0xFF;
+    nonce[7]  = ( file_upload->file_len >> 8 ) & 0xFF;
+    nonce[8]  = ( file_upload->file_len >> 16 ) & 0xFF;
+    nonce[9]  = ( file_upload->file_len >> 24 ) & 0xFF;
+    nonce[10] = plain_hash & 0xFF;
+    nonce[11] = ( plain_hash >> 8 ) & 0xFF;
+    nonce[12] = ( plain_hash >> 16 ) & 0xFF;
+    nonce[13] = ( plain_hash >> 24 ) & 0xFF;
+}
+
+#if defined( ADD_LFU_STREAMED )
+static file_upload_window_t* file_upload_get_window( file_upload_t* file_upload, uint32_t offset )
+{
+    uint32_t              window_offset = offset - ( offset % FILE_UPLOAD_CACHE_WINDOW_SIZE );
+    file_upload_window_t* lru           = &file_upload->stream.window[0];
+
+    file_upload->cache_tick++;
+    for( uint8_t i = 0; i < FILE_UPLOAD_CACHE_NB_WINDOWS; i++ )
+    {
+        file_upload_window_t* window = &file_upload->stream.window[i];
+        if( window->offset == window_offset )
+        {
+            window->last_use = file_upload->cache_tick;
+            return window;
+        }
+        if( window->last_use < lru->last_use )
+        {
+            lru = window;
+        }
+    }
+
+    // cache miss: read the window in place of the least recently used one, zero padded past the end of the file
+    uint32_t size = file_upload->file_len - window_offset;
+    if( size > FILE_UPLOAD_CACHE_WINDOW_SIZE )
+    {
+        size = FILE_UPLOAD_CACHE_WINDOW_SIZE;
+    }
+    memset( lru->data, 0, FILE_UPLOAD_CACHE_WINDOW_SIZE );
+    file_upload->read_callback( window_offset, ( uint8_t* ) lru->data, size );
+
+    if( file_upload->encrypt_with_appskey == true )
+    {
+        // windows are aligned on AES blocks, so each of them can be encrypted on its own
+        uint8_t nonce[14];
+        file_upload_build_nonce( file_upload, file_upload->header[2], nonce );
+        if( smtc_modem_crypto_service_encrypt_from_block( ( uint8_t* ) lru->data, size, nonce, window_offset / 16,
+                                                          ( uint8_t* ) lru->data,
+                                                          file_upload->stack_id ) != SMTC_MODEM_CRYPTO_RC_SUCCESS )
+        {
+            SMTC_MODEM_HAL_PANIC( "Encryption of lfu failed\n" );
+        }
+    }
+
+    lru->offset   = window_offset;
+    lru->last_use = file_upload->cache_tick;
+    return lru;
+}
+#endif  // ADD_LFU_STREAMED
+
+static uint32_t file_upload_read_word( file_upload_t* file_upload, uint32_t word )
+{
+    uint32_t offset = word * 4;
+    uint32_t value  = 0;
+
+    if( offset >= file_upload->file_len )
+    {
+        // padding of the last chunk
+        return 0;
+    }
+
+    if( file_upload->file_buf != NULL )
+    {
+        uint32_t size = file_upload->file_len - offset;
+        memcpy( &value, ( uint8_t* ) file_upload->file_buf + offset, ( size > 4 ) ? 4 : size );
+    }
+#if defined( ADD_LFU_STREAMED )
+    else
+    {
+        file_upload_window_t* window = file_upload_get_window( file_upload, offset );
+        value                        = window->data[( offset % FILE_UPLOAD_CACHE_WINDOW_SIZE ) / 4];
+    }
+#endif
+    return value;
+}
+
 int32_t file_upload_get_fragment( file_upload_t* file_upload, uint8_t* buf, int32_t len, uint32_t fcnt )
 {
     if( ( len - 3 ) < ( CHUNK_NW * 4 ) )
@@ -649,16 +982,21 @@ int32_t file_upload_get_fragment( file_upload_t* file_upload, uint8_t* buf, int3
     buf[n++]      = FILE_UPLOAD_TOKEN;
     buf[n++]      = d;
     buf[n++]      = d >> 8;
-    uint32_t  cid = phash( fcnt );
-    uint32_t* src = &file_upload->file_buf[0];
+    uint32_t cid = phash( fcnt );
 
     while( len >= ( CHUNK_NW * 4 ) )
     {
-        uint32_t tmp[CHUNK_NW];
-        gen_chunk( file_upload, tmp, src, file_upload->cct, cid++ );
-        memcpy( buf + n, tmp, CHUNK_NW * 4 );
-        n += ( CHUNK_NW * 4 );
-        len -= ( CHUNK_NW * 4 );
+        uint32_t tmp[CHUNK_BATCH_NB * CHUNK_NW];
+        uint32_t nb_chunks = len / ( CHUNK_NW * 4 );
+        if( nb_chunks > CHUNK_BATCH_NB )
+        {
+            nb_chunks = CHUNK_BATCH_NB;
+        }
+        gen_chunks( file_upload, tmp, nb_chunks, file_upload->cct, cid );
+        memcpy( buf + n, tmp, nb_chunks * CHUNK_NW * 4 );
+        cid += nb_chunks;
+        n += nb_chunks * CHUNK_NW * 4;
+        len -= nb_chunks * CHUNK_NW * 4;
     }
     if( n > 0 )
     {
@@ -698,42 +1036,69 @@ file_upload_return_code_t file_upload_process_file_done_frame( file_upload_t* fi
     }
 }
 
-static void gen_chunk( file_upload_t* file_upload, uint32_t* dst, uint32_t* src, uint32_t cct, uint32_t cid )
+static void get_src_chunk( file_upload_t* file_upload, uint32_t* dst, uint32_t i )
 {
-    memset( dst, 0, CHUNK_NW * 4 );
-    uint32_t bits = 0;  // initialized to make compiler happy
-    for( uint32_t i = 0; i < cct; i++ )
+    if( i == 0 )
+    {
+        dst[0] = file_upload->header[0];
+        dst[1] = file_upload->header[1];
+    }
+    else if( i == 1 )
+    {
+        dst[0] = file_upload->header[2];
+        dst[1] = file_upload_read_word( file_upload, 0 );
+    }
+    else
     {
-        if( ( i & 31 ) == 0 )
+        uint32_t word   = ( CHUNK_NW * i ) - 3;
+        uint32_t offset = word * 4;
+
+        if( ( file_upload->file_buf != NULL ) && ( ( offset + ( CHUNK_NW * 4 ) ) <= file_upload->file_len ) )
         {
-            bits = checkbits( cid, cct, i >> 5 );
+            memcpy( dst, ( uint8_t* ) file_upload->file_buf + offset, CHUNK_NW * 4 );
         }
-        if( bits == 0 )
+#if defined( ADD_LFU_STREAMED )
+        else if( ( file_upload->file_buf == NULL ) &&
+                 ( ( offset % FILE_UPLOAD_CACHE_WINDOW_SIZE ) <= ( FILE_UPLOAD_CACHE_WINDOW_SIZE - ( CHUNK_NW * 4 ) ) ) )
         {
-            continue;
+            // the whole chunk lies in a single window
+            file_upload_window_t* window = file_upload_get_window( file_upload, offset );
+            memcpy( dst, &window->data[( offset % FILE_UPLOAD_CACHE_WINDOW_SIZE ) / 4], CHUNK_NW * 4 );
         }
-        if( bits & 1 )
+#endif
+        else
         {
-            if( i == 0 )
-            {
-                uint32_t tmp[2];
-                tmp[0] = file_upload->header[0];
-                tmp[1] = file_upload->header[1];
-                function_xor( dst, tmp, CHUNK_NW );
-            }
-            else if( i == 1 )
+            for( uint32_t j = 0; j < CHUNK_NW; j++ )
             {
-                uint32_t tmp[2];
-                tmp[0] = file_upload->header[2];
-                tmp[1] = *( src );
-                function_xor( dst, tmp, CHUNK_NW );
+                dst[j] = file_upload_read_word( file_upload, word + j );
             }
-            else
+        }
+    }
+}
+
+static void gen_chunks( file_upload_t* file_upload, uint32_t* dst, uint32_t nb_chunks, uint32_t cct, uint32_t cid )
+{
+    memset( dst, 0, nb_chunks * CHUNK_NW * 4 );
+
+    // chunks are generated together, one group of 32 source chunks at a time, so that a streamed file is read once per
+    // group from the cache instead of once per generated chunk
+    for( uint32_t group = 0; group < ( ( cct + 31 ) >> 5 ); group++ )
+    {
+        uint32_t first = group << 5;
+        uint32_t mask  = ( ( cct - first ) < 32 ) ? ( ( 1UL << ( cct - first ) ) - 1 ) : 0xFFFFFFFF;
+
+        for( uint32_t n = 0; n < nb_chunks; n++ )
+        {
+            // only visit the source chunks whose checkbit is set
+            uint32_t bits = checkbits( cid + n, cct, group ) & mask;
+            while( bits != 0 )
             {
-                function_xor( dst, src + ( CHUNK_NW * i ) - 3, CHUNK_NW );
+                uint32_t tmp[CHUNK_NW];
+                get_src_chunk( file_upload, tmp, first + __builtin_ctz( bits ) );
+                xor_chunk( dst + ( n * CHUNK_NW ), tmp );
+                bits &= bits - 1;
             }
         }
-        bits >>= 1;
     }
 }
 
@@ -752,12 +1117,10 @@ static uint32_t checkbits( uint32_t cid, uint32_t cct, uint32_t i )
     return phash( cid * ncw + i );
 }
 
-static void function_xor( uint32_t* dst, uint32_t* src, int32_t nw )
+static void xor_chunk( uint32_t* dst, const uint32_t* src )
 {
-    while( nw-- > 0 )
-    {
-        *dst++ ^= *src++;
-    }
+    dst[0] ^= src[0];
+    dst[1] ^= src[1];
 }
 
 static void sha256_do( uint32_t* state, const uint8_t* block )
@@ -817,51 +1180,74 @@ static void sha256_do( uint32_t* state, const uint8_t* block )
     state[7] += h;
 }
 
-static void sha256( uint32_t* hash, const uint8_t* msg, uint32_t len )
+static void sha256_init( file_upload_sha256_t* ctx )
+{
+    static const uint32_t h0[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    memcpy( ctx->state, h0, sizeof( h0 ) );
+    ctx->len = 0;
+}
+
+static void sha256_update( file_upload_sha256_t* ctx, const uint8_t* msg, uint32_t len )
 {
-    uint32_t state[8] = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
+    uint32_t fill = ctx->len & 63;
 
-    uint32_t bitlen = len << 3;
-    while( 1 )
+    ctx->len += len;
+    if( fill != 0 )
     {
-        if( len < 64 )
-        {
-            union
-            {
-                uint8_t  bytes[64];
-                uint32_t words[16];
-            } tmp;
-            memset( tmp.words, 0, sizeof( tmp ) );
-            memcpy( tmp.bytes, msg, len );
-            tmp.bytes[len] = 0x80;
-            if( len < 56 )
-            {
-            last:
-                tmp.words[15] = ENDIAN_n2b32( bitlen );
-                sha256_do( state, tmp.bytes );
-                int i;
-                for( i = 0; i < 8; i++ )
-                {
-                    hash[i] = ENDIAN_n2b32( state[i] );
-                }
-                break;
-            }
-            else
-            {
-                sha256_do( state, tmp.bytes );
-                memset( tmp.words, 0, sizeof( tmp ) );
-                goto last;
-            }
-        }
-        else
+        // complete the pending block first
+        uint32_t size = ( len < ( 64 - fill ) ) ? len : ( 64 - fill );
+        memcpy( &ctx->block[fill], msg, size );
+        msg += size;
+        len -= size;
+        if( ( fill + size ) < 64 )
         {
-            sha256_do( state, msg );
-            msg += 64;
-            len -= 64;
+            return;
         }
+        sha256_do( ctx->state, ctx->block );
+    }
+    while( len >= 64 )
+    {
+        sha256_do( ctx->state, msg );
+        msg += 64;
+        len -= 64;
+    }
+    memcpy( ctx->block, msg, len );
+}
+
+static void sha256_final( file_upload_sha256_t* ctx, uint32_t* hash )
+{
+    uint32_t fill   = ctx->len & 63;
+    uint32_t bitlen = ctx->len << 3;
+
+    ctx->block[fill++] = 0x80;
+    if( fill > 56 )
+    {
+        memset( &ctx->block[fill], 0, 64 - fill );
+        sha256_do( ctx->state, ctx->block );
+        fill = 0;
+    }
+    memset( &ctx->block[fill], 0, 60 - fill );
+    ctx->block[60] = ( bitlen >> 24 ) & 0xFF;
+    ctx->block[61] = ( bitlen >> 16 ) & 0xFF;
+    ctx->block[62] = ( bitlen >> 8 ) & 0xFF;
+    ctx->block[63] = bitlen & 0xFF;
+    sha256_do( ctx->state, ctx->block );
+
+    for( uint8_t i = 0; i < 8; i++ )
+    {
+        hash[i] = ENDIAN_n2b32( ctx->state[i] );
     }
 }
 
+static void sha256( uint32_t* hash, const uint8_t* msg, uint32_t len )
+{
+    file_upload_sha256_t ctx;
+
+    sha256_init( &ctx );
+    sha256_update( &ctx, msg, len );
+    sha256_final( &ctx, hash );
+}
+
 /* --- EOF ------------------------------------------------------------------ */
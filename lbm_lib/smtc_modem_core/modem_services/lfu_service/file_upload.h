@@ -115,6 +115,35 @@ void lfu_services_init( uint8_t* service_id, uint8_t task_id,
 file_upload_return_code_t file_upload_init( uint8_t stack_id, const uint8_t* file, uint32_t file_len,
                                             uint16_t average_delay, uint8_t port, bool encryption );
 
+#if defined( ADD_LFU_STREAMED )
+/**
+ * @brief Create a file upload session whose file is read through a callback
+ *
+ * @remark The file content shall then be given with file_upload_write() before the session can be started
+ *
+ * @param [in] stack_id       Stack Identifier
+ * @param [in] read_callback  Callback used to read the file
+ * @param [in] file_len       size of file
+ * @param [in] average_delay  average delay between each uplink frame
+ * @param [in] port           applicative where the data will be forwarded
+ * @param [in] encryption     Encryption with appskey option
+ * @return file_upload_return_code_t
+ */
+file_upload_return_code_t file_upload_init_streamed( uint8_t stack_id, smtc_modem_file_upload_read_t read_callback,
+                                                     uint32_t file_len, uint16_t average_delay, uint8_t port,
+                                                     bool encryption );
+
+/**
+ * @brief Hash the next part of the file of a streamed session
+ *
+ * @param [in] stack_id Stack Identifier
+ * @param [in] data     File data
+ * @param [in] len      size of data
+ * @return file_upload_return_code_t
+ */
+file_upload_return_code_t file_upload_write( uint8_t stack_id, const uint8_t* data, uint32_t len );
+#endif
+
 /**
  * @brief Start uploading
  *
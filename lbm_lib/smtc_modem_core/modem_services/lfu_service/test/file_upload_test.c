@@ -0,0 +1,432 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// The service context is static: the module is built within the test
+#include "file_upload.c"
+
+// Previous implementation, see file_upload_ref.c
+void ref_lfu_services_init( uint8_t* service_id, uint8_t task_id,
+                            uint8_t ( **downlink_callback )( lr1_stack_mac_down_data_t* ),
+                            void ( **on_launch_callback )( void* ), void ( **on_update_callback )( void* ),
+                            void** context_callback );
+file_upload_return_code_t ref_file_upload_init( uint8_t stack_id, const uint8_t* file, uint32_t file_len,
+                                                uint16_t average_delay, uint8_t port, bool encryption );
+file_upload_return_code_t ref_file_upload_start( uint8_t stack_id );
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static uint16_t dev_nonce = 5;
+static uint32_t fcnt_up;
+static uint32_t max_payload_length = 100;
+static uint8_t  tx_payload[242];
+static uint8_t  tx_payload_size;
+static uint8_t  tx_fport;
+static uint32_t nb_tx_requests;
+static uint32_t nb_aborted_events;
+
+static uint32_t keystream( const uint8_t nonce[14], uint32_t block, uint32_t i )
+{
+    uint32_t x = block * 16 + i;
+    for( uint8_t k = 0; k < 14; k++ )
+    {
+        x = x * 31 + nonce[k];
+    }
+    return phash( x );
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt_from_block( const uint8_t* clear_buff, uint16_t len,
+                                                                              uint8_t nonce[14], uint16_t block_index,
+                                                                              uint8_t* enc_buff, uint8_t stack_id )
+{
+    // AES-CTR model: each byte only depends on the nonce and on its block and position
+    for( uint16_t i = 0; i < len; i++ )
+    {
+        enc_buff[i] = clear_buff[i] ^ ( uint8_t ) keystream( nonce, block_index + ( i >> 4 ), i & 15 );
+    }
+    return SMTC_MODEM_CRYPTO_RC_SUCCESS;
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt( const uint8_t* clear_buff, uint16_t len,
+                                                                   uint8_t nonce[14], uint8_t* enc_buff,
+                                                                   uint8_t stack_id )
+{
+    return smtc_modem_crypto_service_encrypt_from_block( clear_buff, len, nonce, 0, enc_buff, stack_id );
+}
+
+status_lorawan_t tx_protocol_manager_request( tx_protocol_manager_tx_type_t tx_type, uint8_t fport,
+                                              bool fport_present, const uint8_t* payload, uint8_t payload_size,
+                                              lr1mac_layer_param_t packet_type, uint32_t target_time_ms,
+                                              uint8_t stack_id )
+{
+    nb_tx_requests++;
+    tx_fport        = fport;
+    tx_payload_size = payload_size;
+    if( payload_size > 0 )
+    {
+        memcpy( tx_payload, payload, payload_size );
+    }
+    return OKLORAWAN;
+}
+
+void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id )
+{
+    if( ( event_type == SMTC_MODEM_EVENT_UPLOAD_DONE ) && ( status == SMTC_MODEM_EVENT_UPLOAD_DONE_ABORTED ) )
+    {
+        nb_aborted_events++;
+    }
+}
+
+uint16_t lorawan_api_devnonce_get( uint8_t stack_id )
+{
+    return dev_nonce;
+}
+
+join_status_t lorawan_api_isjoined( uint8_t stack_id )
+{
+    return JOINED;
+}
+
+uint32_t lorawan_api_next_max_payload_length_get( uint8_t stack_id )
+{
+    return max_payload_length;
+}
+
+uint32_t lorawan_api_fcnt_up_get( uint8_t stack_id )
+{
+    return fcnt_up;
+}
+
+task_valid_t modem_supervisor_add_task( smodem_task* task )
+{
+    return TASK_VALID;
+}
+
+task_valid_t modem_supervisor_remove_task( uint16_t id )
+{
+    return TASK_VALID;
+}
+
+void modem_downlink_set_filter( modem_downlink_handler_t handler, uint8_t stack_id, modem_downlink_filter_t filter,
+                                uint8_t fport )
+{
+}
+
+uint32_t smtc_modem_hal_get_random_nb_in_range( const uint32_t val_1, const uint32_t val_2 )
+{
+    return val_1;
+}
+
+uint32_t smtc_modem_hal_get_time_in_s( void )
+{
+    return 0;
+}
+
+uint32_t smtc_modem_hal_get_time_in_ms( void )
+{
+    return 0;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define FILE_SIZE_MAX 8180
+
+// Streamed file in flash, the access time is modeled as a fixed cost per read plus a cost per byte
+#define FLASH_READ_LATENCY_US 10.0
+#define FLASH_BYTE_LATENCY_US 1.0
+
+static uint8_t  flash[FILE_SIZE_MAX];
+static uint32_t nb_flash_reads;
+static uint32_t nb_flash_bytes;
+
+static void flash_read( uint32_t offset, uint8_t* buffer, uint16_t size )
+{
+    nb_flash_reads++;
+    nb_flash_bytes += size;
+    memcpy( buffer, &flash[offset], size );
+}
+
+static const uint32_t sizes[] = { 1, 3, 4, 5, 12, 55, 56, 63, 64, 65, 100, 250, 1000, 2048, 4095, FILE_SIZE_MAX };
+
+typedef enum upload_mode_e
+{
+    UPLOAD_RAM,
+    UPLOAD_STREAMED,
+} upload_mode_t;
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+typedef struct service_s
+{
+    uint8_t id;
+    uint8_t ( *downlink )( lr1_stack_mac_down_data_t* );
+    void ( *on_launch )( void* );
+    void ( *on_update )( void* );
+    void* context;
+} service_t;
+
+static service_t service;
+static service_t ref_service;
+
+// Files given to each implementation, encrypted in place in RAM mode
+static uint8_t file[FILE_SIZE_MAX];
+static uint8_t ref_file[FILE_SIZE_MAX];
+
+static double now_us( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+/**
+ * Start the same upload on both implementations, the current one reading the file from RAM or from flash
+ */
+static bool start_uploads( upload_mode_t mode, uint32_t len, bool encryption )
+{
+    // A file in RAM is read by words: the bytes after the end are zero, as the streamed mode pads the last word
+    memset( flash, 0, sizeof( flash ) );
+    for( uint32_t i = 0; i < len; i++ )
+    {
+        flash[i] = ( uint8_t ) rnd( );
+    }
+    memcpy( file, flash, sizeof( file ) );
+    memcpy( ref_file, flash, sizeof( ref_file ) );
+
+    lfu_services_init( &service.id, 0, &service.downlink, &service.on_launch, &service.on_update, &service.context );
+    ref_lfu_services_init( &ref_service.id, 0, &ref_service.downlink, &ref_service.on_launch, &ref_service.on_update,
+                           &ref_service.context );
+
+    if( ref_file_upload_init( 0, ref_file, len, 10, 7, encryption ) != FILE_UPLOAD_OK )
+    {
+        return false;
+    }
+    if( mode == UPLOAD_RAM )
+    {
+        if( file_upload_init( 0, file, len, 10, 7, encryption ) != FILE_UPLOAD_OK )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if( file_upload_init_streamed( 0, flash_read, len, 10, 7, encryption ) != FILE_UPLOAD_OK )
+        {
+            return false;
+        }
+        // The application gives the file in random pieces
+        for( uint32_t offset = 0; offset < len; )
+        {
+            uint32_t size = 1 + rnd( ) % 300;
+
+            size = ( size > ( len - offset ) ) ? ( len - offset ) : size;
+            if( file_upload_write( 0, &flash[offset], size ) != FILE_UPLOAD_OK )
+            {
+                return false;
+            }
+            offset += size;
+        }
+    }
+    return ( file_upload_start( 0 ) == FILE_UPLOAD_OK ) && ( ref_file_upload_start( 0 ) == FILE_UPLOAD_OK );
+}
+
+/**
+ * Number of frames to send twice the chunks of the file and a few frames more
+ */
+static uint32_t get_nb_frames( uint32_t len )
+{
+    return 2 * ( ( len + FILE_UPLOAD_HEADER_SIZE + 7 ) / 8 ) / 12 + 3;
+}
+
+/**
+ * Send the frames of the upload on both implementations and compare them byte per byte
+ */
+static bool frames_are_identical( uint32_t len )
+{
+    uint8_t  ref_payload[242];
+    uint8_t  ref_payload_size;
+    uint8_t  ref_fport;
+    uint32_t nb_frames = get_nb_frames( len );
+
+    for( uint32_t i = 0; i < nb_frames; i++ )
+    {
+        fcnt_up            = 3 + i * 7 + rnd( ) % 7;
+        max_payload_length = ( ( rnd( ) % 4 ) == 0 ) ? 5 + rnd( ) % 100 : 242;
+
+        ref_service.on_launch( ref_service.context );
+        ref_payload_size = tx_payload_size;
+        ref_fport        = tx_fport;
+        memcpy( ref_payload, tx_payload, ref_payload_size );
+
+        service.on_launch( service.context );
+        if( ( tx_payload_size != ref_payload_size ) || ( tx_fport != ref_fport ) ||
+            ( memcmp( tx_payload, ref_payload, ref_payload_size ) != 0 ) )
+        {
+            printf( "     len %u frame %u differs\n", len, i );
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool uploads_are_identical( upload_mode_t mode )
+{
+    bool passed = true;
+
+    rnd_state = 1;
+    for( uint8_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ )
+    {
+        for( uint8_t encryption = 0; encryption < 2; encryption++ )
+        {
+            passed = passed && start_uploads( mode, sizes[i], encryption == 1 );
+            passed = passed && frames_are_identical( sizes[i] );
+        }
+    }
+    return passed;
+}
+
+/**
+ * Time the fragments of each implementation and count the flash accesses of the streamed mode
+ */
+static void bench( void )
+{
+    rnd_state = 1;
+    printf( "\n  size enc | previous RAM | RAM us/frag | streamed us/frag reads/frag B/frag -> with flash us/frag\n" );
+    for( uint8_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ )
+    {
+        for( uint8_t encryption = 0; encryption < 2; encryption++ )
+        {
+            uint32_t len       = sizes[i];
+            uint32_t nb_frames = get_nb_frames( len );
+            double   ref_us    = 0;
+            double   ram_us    = 0;
+            double   stream_us = 0;
+            double   t0;
+
+            for( uint8_t mode = UPLOAD_RAM; mode <= UPLOAD_STREAMED; mode++ )
+            {
+                start_uploads( mode, len, encryption == 1 );
+                // The first frame prepares the upload, it is not counted
+                ref_service.on_launch( ref_service.context );
+                service.on_launch( service.context );
+                nb_flash_reads = 0;
+                nb_flash_bytes = 0;
+                for( uint32_t f = 1; f < nb_frames; f++ )
+                {
+                    fcnt_up = 3 + f * 7;
+                    t0      = now_us( );
+                    ref_service.on_launch( ref_service.context );
+                    ref_us += ( mode == UPLOAD_RAM ) ? now_us( ) - t0 : 0;
+                    t0 = now_us( );
+                    service.on_launch( service.context );
+                    *( ( mode == UPLOAD_RAM ) ? &ram_us : &stream_us ) += now_us( ) - t0;
+                }
+            }
+            nb_frames -= 1;
+            printf( "  %4u %u   | %12.1f | %11.1f | %16.1f %10.1f %6.0f -> %14.1f\n", len, encryption,
+                    ref_us / nb_frames, ram_us / nb_frames, stream_us / nb_frames,
+                    ( double ) nb_flash_reads / nb_frames, ( double ) nb_flash_bytes / nb_frames,
+                    ( stream_us + FLASH_READ_LATENCY_US * nb_flash_reads + FLASH_BYTE_LATENCY_US * nb_flash_bytes ) /
+                        nb_frames );
+        }
+    }
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies that the frames of a file uploaded from RAM, plain or encrypted, are the ones of the previous
+ * implementation for every file size.
+ */
+void test_ram_upload_identical( )
+{
+    print_result( "test_ram_upload_identical", uploads_are_identical( UPLOAD_RAM ) );
+}
+
+/**
+ * Verifies that the frames of a file streamed from flash, plain or encrypted, are the ones of the previous
+ * implementation uploading the same file from RAM.
+ */
+void test_streamed_upload_identical( )
+{
+    print_result( "test_streamed_upload_identical", uploads_are_identical( UPLOAD_STREAMED ) );
+}
+
+/**
+ * Verifies that an encrypted streamed upload is aborted once the stack joined again, and a plain one is not.
+ */
+void test_streamed_upload_rejoin( )
+{
+    bool passed = true;
+
+    rnd_state = 3;
+    for( uint8_t encryption = 0; encryption < 2; encryption++ )
+    {
+        uint32_t nb_events = nb_aborted_events;
+
+        passed = passed && start_uploads( UPLOAD_STREAMED, 1000, encryption == 1 );
+        service.on_launch( service.context );
+        dev_nonce++;
+        nb_tx_requests = 0;
+        nb_flash_reads = 0;
+        service.on_launch( service.context );
+        if( encryption == 1 )
+        {
+            passed = passed && ( lfu_ctx[0].state == LFU_NOT_INIT ) && ( nb_aborted_events == nb_events + 1 ) &&
+                     ( nb_tx_requests == 0 ) && ( nb_flash_reads == 0 );
+        }
+        else
+        {
+            passed = passed && ( lfu_ctx[0].state == LFU_ON_GOING ) && ( nb_aborted_events == nb_events ) &&
+                     ( nb_tx_requests == 1 );
+        }
+    }
+    print_result( "test_streamed_upload_rejoin", passed );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( int argc, char** argv )
+{
+    test_ram_upload_identical( );
+    test_streamed_upload_identical( );
+    test_streamed_upload_rejoin( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    if( ( argc > 1 ) && ( strcmp( argv[1], "bench" ) == 0 ) )
+    {
+        bench( );
+    }
+
+    return failed_count == 0 ? 0 : 1;
+}
@@ -40,6 +40,7 @@
 #include <stdint.h>   // C99 types
 #include <stdbool.h>  // bool type
 #include "circularfs.h"
+#include "modem_crc.h"
 #include "modem_core.h"
 #include "smtc_modem_hal.h"
 #include "smtc_modem_hal_dbg_trace.h"
@@ -58,9 +59,30 @@
 #define FIFO_BURST_SENDING ( false )
 
 /**
- * @brief Version of data structure in FiFo
+ * @brief Version of data structure in FiFo: variable-length records packed in slots
  */
-#define LOG_ENTRY_VERSION ( 1 )
+#define LOG_ENTRY_VERSION ( 2 )
+
+/**
+ * @brief Version of the FiFo holding one store_and_forward_flash_data_t per slot, sent before being migrated
+ */
+#define LOG_ENTRY_VERSION_FIXED_SIZE ( 1 )
+
+/**
+ * @brief Size in bytes of the data area of a slot holding records, multiple of 8
+ */
+#ifndef STORE_AND_FORWARD_RECORD_SLOT_SIZE
+#define STORE_AND_FORWARD_RECORD_SLOT_SIZE ( 256 )
+#endif
+
+#if ( ( STORE_AND_FORWARD_RECORD_SLOT_SIZE % 8 ) != 0 )
+#error "STORE_AND_FORWARD_RECORD_SLOT_SIZE shall be a multiple of 8"
+#endif
+
+/**
+ * @brief Bytes stored before the payload in a record: fport and confirmed flag
+ */
+#define ENTRY_RECORD_HEADER_SIZE ( 2 )
 
 /**
  * @brief data length in byte in FiFo
@@ -81,6 +103,16 @@
 #define STORE_AND_FORWARD_DELAY_MAX_S ( 3600 )
 #endif
 
+/**
+ * @brief Size in bytes of the RAM index of the circular file system
+ *
+ * Disabled by default (0), define it (e.g. 256) to speed up the slot scans at the cost of RAM. The index needs 2 bytes
+ * per flash page plus 2 bits per slot, the file system falls back to flash reads when the partition is too large for it.
+ */
+#ifndef STORE_AND_FORWARD_INDEX_SIZE
+#define STORE_AND_FORWARD_INDEX_SIZE ( 0 )
+#endif
+
 #define CURRENT_STACK ( task_id / NUMBER_OF_TASKS )
 #define NUMBER_MAX_OF_STORE_AND_FORWARD_OBJ 1  // modify in case of multiple obj
 
@@ -167,7 +199,20 @@ typedef struct store_and_forward_flash_s
     bool     sending_with_ack;
     uint8_t  ack_period_count;
 
+    bool fixed_size_entries;  // FiFo still in LOG_ENTRY_VERSION_FIXED_SIZE format
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+    bool     aggregation;                // several records are packed in one uplink
+    uint32_t aggregation_max_latency_s;  // delay allowed to gather records before the first uplink
+    bool     aggregation_deadline_set;
+    uint32_t aggregation_deadline_s;
+    uint8_t  frame[SMTC_MODEM_MAX_LORAWAN_PAYLOAD_LENGTH];  // aggregated uplink, kept until the stack sends it
+#endif
+
     struct circularfs fs;
+#if ( STORE_AND_FORWARD_INDEX_SIZE > 0 )
+    uint32_t fs_index[( STORE_AND_FORWARD_INDEX_SIZE + 3 ) / 4];
+#endif
 
 } store_and_forward_flash_t;
 
@@ -223,6 +268,92 @@ static uint8_t store_and_forward_flash_service_downlink_handler( lr1_stack_mac_d
 static store_and_forward_flash_t* store_and_forward_flash_get_ctx_from_stack_id( uint8_t  stack_id,
                                                                                  uint8_t* service_id );
 
+/**
+ * @brief Initialize the file system object, with records or with fixed size entries
+ *
+ * @param [in] ctx                  Object context
+ * @param [in] fixed_size_entries   Use the LOG_ENTRY_VERSION_FIXED_SIZE format
+ */
+static void store_and_forward_flash_fs_init( store_and_forward_flash_t* ctx, bool fixed_size_entries );
+
+/**
+ * @brief Format the FiFo with records once all the fixed size entries are sent
+ *
+ * @param [in] ctx  Object context
+ */
+static void store_and_forward_flash_migrate( store_and_forward_flash_t* ctx );
+
+/**
+ * @brief Store an entry in the FiFo
+ *
+ * @param [in] ctx    Object context
+ * @param [in] entry  Entry to store
+ * @return int32_t    Zero on success, -1 on failure
+ */
+static int32_t store_and_forward_flash_append_entry( store_and_forward_flash_t*      ctx,
+                                                     store_and_forward_flash_data_t* entry );
+
+/**
+ * @brief Fetch the next entry of the FiFo
+ *
+ * @param [in]  ctx        Object context
+ * @param [out] entry      Fetched entry
+ * @param [out] is_crc_ok  Integrity of the fetched entry
+ * @return int32_t         Zero if an entry is fetched, -1 if the FiFo is empty
+ */
+static int32_t store_and_forward_flash_fetch_entry( store_and_forward_flash_t*      ctx,
+                                                    store_and_forward_flash_data_t* entry, bool* is_crc_ok );
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+/**
+ * @brief Read the next entry of the FiFo without fetching it (records only)
+ *
+ * @param [in]  ctx        Object context
+ * @param [out] entry      Next entry
+ * @param [out] is_crc_ok  Integrity of the entry
+ * @return int32_t         Zero if an entry is read, -1 if the FiFo is empty
+ */
+static int32_t store_and_forward_flash_peek_entry( store_and_forward_flash_t*      ctx,
+                                                   store_and_forward_flash_data_t* entry, bool* is_crc_ok );
+#endif
+
+/**
+ * @brief Decode a record read from the FiFo
+ *
+ * @param [in]  record  Record content
+ * @param [in]  size    Record size
+ * @param [out] entry   Decoded entry
+ * @return bool         True if the record holds a payload
+ */
+static bool store_and_forward_flash_decode_record( const uint8_t* record, int32_t size,
+                                                   store_and_forward_flash_data_t* entry );
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+/**
+ * @brief Pack the following entries with the same fport after a fetched entry in the aggregation frame
+ *
+ * Each payload is prefixed by its length, the first one included so that every aggregated uplink has the same framing.
+ * Packing stops at the first entry that uses another fport or does not fit in the next uplink, packed entries are
+ * fetched.
+ *
+ * @param [in]     ctx    Object context
+ * @param [in,out] entry  First entry, confirmed if one of the packed entries is confirmed
+ * @return uint8_t        Length of the frame
+ */
+static uint8_t store_and_forward_flash_aggregate( store_and_forward_flash_t* ctx, store_and_forward_flash_data_t* entry );
+#endif
+
+/**
+ * @brief Compute the delay before the first uplink of newly stored data
+ *
+ * With aggregation, the deadline is set by the first data stored in an empty FiFo and is not postponed by the next
+ * ones.
+ *
+ * @param [in] ctx  Object context
+ * @return uint32_t Delay in seconds
+ */
+static uint32_t store_and_forward_flash_compute_first_delay_s( store_and_forward_flash_t* ctx );
+
 /**
  * @brief Compute the next delay to send the next tentative
  *
@@ -263,15 +394,6 @@ static int32_t op_program( struct circularfs_flash_partition* flash, uint32_t ad
  */
 static int32_t op_read( struct circularfs_flash_partition* flash, uint32_t address, void* data, uint32_t size );
 
-/**
- * @brief Compute crc
- *
- * @param [in] buf          input buffer
- * @param [in] len          input buffer length
- * @return [out] uint32_t   computed crc
- */
-static uint32_t crc_store_and_fwd( const uint8_t* buf, int len );
-
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -302,8 +424,7 @@ void store_and_forward_flash_services_init( uint8_t* service_id, uint8_t task_id
     ctx->enabled     = false;
     ctx->initialized = true;
 
-    /* Always call circularfs_init first. */
-    circularfs_init( &ctx->fs, &flash_obj, LOG_ENTRY_VERSION, sizeof( store_and_forward_flash_data_t ) );
+    store_and_forward_flash_fs_init( ctx, false );
     // SMTC_MODEM_HAL_TRACE_PRINTF( "# format filesystem...\n" );
     // circularfs_format( &ctx->fs );
 
@@ -316,8 +437,20 @@ void store_and_forward_flash_services_init( uint8_t* service_id, uint8_t task_id
     }
     else
     {
-        SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd # no valid filesystem found, formatting.\n" );
-        circularfs_format( &ctx->fs, false );
+        /* Entries stored before the records format are kept and sent, the FiFo is migrated once empty */
+        store_and_forward_flash_fs_init( ctx, true );
+        if( ( circularfs_scan( &ctx->fs ) == 0 ) && ( circularfs_count_estimate( &ctx->fs ) > 0 ) )
+        {
+            SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd # found version %d filesystem, usage: %d/%d\n",
+                                         LOG_ENTRY_VERSION_FIXED_SIZE, circularfs_count_estimate( &ctx->fs ),
+                                         circularfs_capacity( &ctx->fs ) );
+        }
+        else
+        {
+            SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd # no valid filesystem found, formatting.\n" );
+            store_and_forward_flash_fs_init( ctx, false );
+            circularfs_format( &ctx->fs, false );
+        }
     }
 
     circularfs_dump( &ctx->fs );
@@ -361,6 +494,29 @@ store_and_forward_flash_rc_t store_and_forward_flash_set_state( uint8_t
     return STORE_AND_FORWARD_FLASH_RC_OK;
 }
 
+store_and_forward_flash_rc_t store_and_forward_flash_set_aggregation( uint8_t stack_id, bool enabled,
+                                                                      uint32_t max_latency_s )
+{
+    IS_VALID_STACK_ID( stack_id );
+    uint8_t                    service_id;
+    store_and_forward_flash_t* ctx = store_and_forward_flash_get_ctx_from_stack_id( stack_id, &service_id );
+
+    if( ( ctx == NULL ) || ( max_latency_s > STORE_AND_FORWARD_DELAY_MAX_S ) )
+    {
+        return STORE_AND_FORWARD_FLASH_RC_INVALID;
+    }
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+    ctx->aggregation               = enabled;
+    ctx->aggregation_max_latency_s = max_latency_s;
+    ctx->aggregation_deadline_set  = false;
+    return STORE_AND_FORWARD_FLASH_RC_OK;
+#else
+    // Aggregation not built, only disabling it is accepted
+    return ( enabled == false ) ? STORE_AND_FORWARD_FLASH_RC_OK : STORE_AND_FORWARD_FLASH_RC_INVALID;
+#endif
+}
+
 store_and_forward_flash_rc_t store_and_forward_flash_add_data( uint8_t stack_id, uint8_t fport, bool confirmed,
                                                                const uint8_t* payload, uint8_t payload_length )
 
@@ -379,6 +535,14 @@ store_and_forward_flash_rc_t store_and_forward_flash_add_data( uint8_t stack_id,
         return STORE_AND_FORWARD_FLASH_RC_INVALID;
     }
 
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+    // An aggregated payload always carries its length prefix, it must fit with it in the smallest uplink
+    if( ( ctx->aggregation == true ) && ( payload_length > ( DATA_SIZE_MAX - 1 ) ) )
+    {
+        return STORE_AND_FORWARD_FLASH_RC_INVALID;
+    }
+#endif
+
     if( ( fport == 0 ) || ( fport >= 224 ) )
     {
         return STORE_AND_FORWARD_FLASH_RC_INVALID;
@@ -391,14 +555,15 @@ store_and_forward_flash_rc_t store_and_forward_flash_add_data( uint8_t stack_id,
     }
 #endif
 
+    store_and_forward_flash_migrate( ctx );
+
     store_and_forward_flash_data_t entry = { 0 };
     memcpy( entry.data, payload, payload_length );
     entry.data_len  = payload_length;
     entry.fport     = fport;
     entry.confirmed = confirmed;
-    entry.crc       = crc_store_and_fwd( ( uint8_t* ) &entry, sizeof( entry ) - sizeof( entry.crc ) ) & 0xFFFF;
 
-    if( circularfs_append( &ctx->fs, &entry ) != 0 )
+    if( store_and_forward_flash_append_entry( ctx, &entry ) != 0 )
     {
         SMTC_MODEM_HAL_TRACE_WARNING( "Store and fwd fifo problem\n" );
         return STORE_AND_FORWARD_FLASH_RC_FAIL;
@@ -411,7 +576,7 @@ store_and_forward_flash_rc_t store_and_forward_flash_add_data( uint8_t stack_id,
     {
         if( lorawan_api_isjoined( ctx->stack_id ) == JOINED )
         {
-            store_and_forward_flash_add_task( ctx, 0 );
+            store_and_forward_flash_add_task( ctx, store_and_forward_flash_compute_first_delay_s( ctx ) );
         }
     }
 
@@ -427,6 +592,7 @@ void store_and_forward_flash_clear_data( uint8_t stack_id )
     store_and_forward_flash_t* ctx = store_and_forward_flash_get_ctx_from_stack_id( stack_id, &service_id );
 
     SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd # format filesystem...\n" );
+    store_and_forward_flash_fs_init( ctx, false );
     circularfs_format( &ctx->fs, true );
 }
 
@@ -503,20 +669,20 @@ static void store_and_forward_flash_service_on_launch( void* service_id )
     // TODO check payload len and adjust the datarate with custom profile
     // uint8_t max_payload = lorawan_api_next_max_payload_length_get( stack_id );
 
-    store_and_forward_flash_data_t entry = { 0 };
+    store_and_forward_flash_data_t entry       = { 0 };
+    uint8_t*                       payload     = entry.data;
+    uint8_t                        payload_len = 0;
 
     // circularfs_dump( &store_and_forward_flash_obj[idx].fs );
 
     // While there are available data and a wrong CRC get the next data
     do
     {
-        fetch_status = circularfs_fetch( &store_and_forward_flash_obj[idx].fs, &entry );
+        fetch_status = store_and_forward_flash_fetch_entry( &store_and_forward_flash_obj[idx], &entry, &is_crc_ok );
         if( fetch_status == 0 )
         {
-            if( ( crc_store_and_fwd( ( uint8_t* ) &entry, sizeof( entry ) - sizeof( entry.crc ) ) & 0xFFFF ) ==
-                entry.crc )
+            if( is_crc_ok == true )
             {
-                is_crc_ok = true;
                 if( store_and_forward_flash_obj[idx].sending_try_cpt == 0 )
                 {
                     store_and_forward_flash_obj[idx].sending_first_try_timestamp_s = rtc_ms / 1000;
@@ -541,6 +707,17 @@ static void store_and_forward_flash_service_on_launch( void* service_id )
 
     if( ( entry.data_len > 0 ) && ( is_crc_ok == true ) )
     {
+        payload_len = entry.data_len;
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+        if( ( store_and_forward_flash_obj[idx].aggregation == true ) &&
+            ( store_and_forward_flash_obj[idx].fixed_size_entries == false ) )
+        {
+            payload_len = store_and_forward_flash_aggregate( &store_and_forward_flash_obj[idx], &entry );
+            payload     = store_and_forward_flash_obj[idx].frame;
+            store_and_forward_flash_obj[idx].aggregation_deadline_set = false;
+        }
+#endif
+
         store_and_forward_flash_obj[idx].sending_with_ack = entry.confirmed;
 
         if( store_and_forward_flash_obj[idx].ack_period_count >= STORE_AND_FORWARD_ACK_PERIOD )
@@ -574,7 +751,7 @@ static void store_and_forward_flash_service_on_launch( void* service_id )
 #endif
 
         status_lorawan_t send_status = tx_protocol_manager_request(
-            TX_PROTOCOL_TRANSMIT_LORA, entry.fport, true, entry.data, entry.data_len,
+            TX_PROTOCOL_TRANSMIT_LORA, entry.fport, true, payload, payload_len,
             ( store_and_forward_flash_obj[idx].sending_with_ack == true ) ? CONF_DATA_UP : UNCONF_DATA_UP, rtc_ms,
             stack_id );
 
@@ -677,6 +854,7 @@ static uint8_t store_and_forward_flash_service_downlink_handler( lr1_stack_mac_d
                     ctx->sending_try_cpt  = 0;
                     ctx->ack_period_count = 0;
                     circularfs_discard( &ctx->fs );
+                    store_and_forward_flash_migrate( ctx );
                 }
                 else
                 {
@@ -743,6 +921,174 @@ static uint32_t store_and_forward_flash_compute_next_delay_s( store_and_forward_
     return delay_s + smtc_modem_hal_get_random_nb_in_range( 0, 60 );
 }
 
+static void store_and_forward_flash_fs_init( store_and_forward_flash_t* ctx, bool fixed_size_entries )
+{
+    /* Always call circularfs_init first. */
+    if( fixed_size_entries == true )
+    {
+        circularfs_init( &ctx->fs, &flash_obj, LOG_ENTRY_VERSION_FIXED_SIZE, sizeof( store_and_forward_flash_data_t ) );
+    }
+    else
+    {
+        circularfs_init_records( &ctx->fs, &flash_obj, LOG_ENTRY_VERSION, STORE_AND_FORWARD_RECORD_SLOT_SIZE );
+    }
+    ctx->fixed_size_entries = fixed_size_entries;
+
+#if ( STORE_AND_FORWARD_INDEX_SIZE > 0 )
+    if( circularfs_set_index( &ctx->fs, ctx->fs_index, sizeof( ctx->fs_index ) ) != 0 )
+    {
+        SMTC_MODEM_HAL_TRACE_WARNING( "Store and fwd # index needs %u bytes, disabled\n",
+                                      circularfs_get_index_size( &ctx->fs ) );
+    }
+#endif
+}
+
+static void store_and_forward_flash_migrate( store_and_forward_flash_t* ctx )
+{
+    if( ( ctx->fixed_size_entries == true ) && ( circularfs_count_estimate( &ctx->fs ) == 0 ) )
+    {
+        SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd # version %d entries sent, formatting filesystem...\n",
+                                     LOG_ENTRY_VERSION_FIXED_SIZE );
+        store_and_forward_flash_fs_init( ctx, false );
+        circularfs_format( &ctx->fs, true );
+    }
+}
+
+static int32_t store_and_forward_flash_append_entry( store_and_forward_flash_t*      ctx,
+                                                     store_and_forward_flash_data_t* entry )
+{
+    if( ctx->fixed_size_entries == true )
+    {
+        entry->crc = modem_crc32( ( uint8_t* ) entry, sizeof( *entry ) - sizeof( entry->crc ) ) & 0xFFFF;
+        return circularfs_append( &ctx->fs, entry );
+    }
+
+    // Only the payload is stored, the record integrity is checked by circularfs
+    uint8_t record[ENTRY_RECORD_HEADER_SIZE + DATA_SIZE_MAX];
+    record[0] = entry->fport;
+    record[1] = entry->confirmed;
+    memcpy( &record[ENTRY_RECORD_HEADER_SIZE], entry->data, entry->data_len );
+    return circularfs_append_record( &ctx->fs, record, ENTRY_RECORD_HEADER_SIZE + entry->data_len );
+}
+
+static int32_t store_and_forward_flash_fetch_entry( store_and_forward_flash_t*      ctx,
+                                                    store_and_forward_flash_data_t* entry, bool* is_crc_ok )
+{
+    if( ctx->fixed_size_entries == true )
+    {
+        int32_t  fetch_status = circularfs_fetch( &ctx->fs, entry );
+        uint32_t crc          = modem_crc32( ( uint8_t* ) entry, sizeof( *entry ) - sizeof( entry->crc ) );
+
+        *is_crc_ok = ( fetch_status == 0 ) && ( ( crc & 0xFFFF ) == entry->crc );
+        return fetch_status;
+    }
+
+    uint8_t record[ENTRY_RECORD_HEADER_SIZE + DATA_SIZE_MAX];
+    int32_t size = circularfs_fetch_record( &ctx->fs, record, sizeof( record ) );
+    if( size < 0 )
+    {
+        return -1;
+    }
+
+    *is_crc_ok = store_and_forward_flash_decode_record( record, size, entry );
+    return 0;
+}
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+static int32_t store_and_forward_flash_peek_entry( store_and_forward_flash_t*      ctx,
+                                                   store_and_forward_flash_data_t* entry, bool* is_crc_ok )
+{
+    uint8_t record[ENTRY_RECORD_HEADER_SIZE + DATA_SIZE_MAX];
+    int32_t size = circularfs_peek_record( &ctx->fs, record, sizeof( record ) );
+    if( size < 0 )
+    {
+        return -1;
+    }
+
+    *is_crc_ok = store_and_forward_flash_decode_record( record, size, entry );
+    return 0;
+}
+#endif
+
+static bool store_and_forward_flash_decode_record( const uint8_t* record, int32_t size,
+                                                   store_and_forward_flash_data_t* entry )
+{
+    if( size <= ENTRY_RECORD_HEADER_SIZE )
+    {
+        return false;
+    }
+
+    entry->fport     = record[0];
+    entry->confirmed = record[1];
+    entry->data_len  = size - ENTRY_RECORD_HEADER_SIZE;
+    memcpy( entry->data, &record[ENTRY_RECORD_HEADER_SIZE], entry->data_len );
+    return true;
+}
+
+#if defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+static uint8_t store_and_forward_flash_aggregate( store_and_forward_flash_t* ctx, store_and_forward_flash_data_t* entry )
+{
+    store_and_forward_flash_data_t next        = { 0 };
+    bool                           is_crc_ok   = false;
+    uint8_t                        frame_len   = 0;
+    uint32_t                       max_payload = lorawan_api_next_max_payload_length_get( ctx->stack_id );
+
+    if( max_payload > sizeof( ctx->frame ) )
+    {
+        max_payload = sizeof( ctx->frame );
+    }
+
+    ctx->frame[frame_len++] = entry->data_len;
+    memcpy( &ctx->frame[frame_len], entry->data, entry->data_len );
+    frame_len += entry->data_len;
+
+    while( store_and_forward_flash_peek_entry( ctx, &next, &is_crc_ok ) == 0 )
+    {
+        if( is_crc_ok == true )
+        {
+            if( ( next.fport != entry->fport ) || ( ( frame_len + 1u + next.data_len ) > max_payload ) )
+            {
+                break;
+            }
+
+            ctx->frame[frame_len++] = next.data_len;
+            memcpy( &ctx->frame[frame_len], next.data, next.data_len );
+            frame_len += next.data_len;
+            if( next.confirmed == true )
+            {
+                entry->confirmed = true;
+            }
+        }
+        // Fetch the packed entry, or drop the malformed one
+        store_and_forward_flash_fetch_entry( ctx, &next, &is_crc_ok );
+    }
+
+    SMTC_MODEM_HAL_TRACE_PRINTF( "Store and fwd aggregated %u bytes\n", frame_len );
+    return frame_len;
+}
+#endif
+
+static uint32_t store_and_forward_flash_compute_first_delay_s( store_and_forward_flash_t* ctx )
+{
+#if !defined( ADD_STORE_AND_FORWARD_AGGREGATION )
+    ( void ) ctx;
+    return 0;
+#else
+    if( ( ctx->aggregation == false ) || ( ctx->fixed_size_entries == true ) )
+    {
+        return 0;
+    }
+
+    uint32_t now_s = smtc_modem_hal_get_time_in_s( );
+    if( ctx->aggregation_deadline_set == false )
+    {
+        ctx->aggregation_deadline_set = true;
+        ctx->aggregation_deadline_s   = now_s + ctx->aggregation_max_latency_s;
+    }
+    return ( ( int32_t ) ( ctx->aggregation_deadline_s - now_s ) > 0 ) ? ( ctx->aggregation_deadline_s - now_s ) : 0;
+#endif
+}
+
 static int32_t op_sector_erase( struct circularfs_flash_partition* flash, uint32_t address )
 {
     ( void ) flash;
@@ -768,18 +1114,4 @@ static int32_t op_read( struct circularfs_flash_partition* flash, uint32_t addre
     return size;
 }
 
-static uint32_t crc_store_and_fwd( const uint8_t* buf, int len )
-{
-    uint32_t crc = 0xFFFFFFFF;
-    while( len-- > 0 )
-    {
-        crc = crc ^ *buf++;
-        for( int i = 0; i < 8; i++ )
-        {
-            uint32_t mask = -( crc & 1 );
-            crc           = ( crc >> 1 ) ^ ( 0xEDB88320 & mask );
-        }
-    }
-    return ~crc;
-}
 /* --- EOF ------------------------------------------------------------------ */
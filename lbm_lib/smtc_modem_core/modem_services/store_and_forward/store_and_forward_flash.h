@@ -121,6 +121,18 @@ store_and_forward_flash_rc_t store_and_forward_flash_set_state( uint8_t
  */
 store_and_forward_flash_state_t store_and_forward_flash_get_state( uint8_t stack_id );
 
+/**
+ * @brief Configure the aggregation of several data in one uplink
+ *
+ * @param [in] stack_id       Stack identifier
+ * @param [in] enabled        Pack the data with the same fport that fit in the next uplink, each one prefixed by its
+ *                            length
+ * @param [in] max_latency_s  Delay allowed to gather data before the first uplink
+ * @return store_and_forward_flash_rc_t
+ */
+store_and_forward_flash_rc_t store_and_forward_flash_set_aggregation( uint8_t stack_id, bool enabled,
+                                                                      uint32_t max_latency_s );
+
 /**
  * @brief Add data to the NVM FiFo
  *
@@ -145,7 +157,7 @@ void store_and_forward_flash_clear_data( uint8_t stack_id );
  * @brief Get the fifo capacity and the number of free slots before data loss by overwriting the slot already in use
  *
  * @param [in]  stack_id  Stack identifier
- * @param [out] capacity  Capacity of the fifo (number of slot)
+ * @param [out] capacity  Capacity of the fifo (number of slot, a slot holds several records)
  * @param [out] free_slot Number of free slot
  * @return store_and_forward_flash_rc_t
  */
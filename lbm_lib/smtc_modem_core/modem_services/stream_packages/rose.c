@@ -205,6 +205,129 @@ STATIC int32_t diluteRedCnt( rose_t* ROSE, uint16_t n )
     return ROSE->redcnt * ( ROSE->wl - n ) / ROSE->wl;
 }
 
+#if defined( ROSE_COEFF_CACHE )
+// Set in mask the coefficients of redundancy unit i of frame fcntup:
+// the same wl/2 distinct units as picked by the default generator below.
+// mask shall be cleared.
+//
+STATIC void genCoeffMask( uint32_t wl, uint32_t fcntup, int i, uint32_t* mask )
+{
+    uint32_t wlx     = wl + ( ( ( wl - 1 ) & wl ) == 0 );  // fixup if wl=2^i => wlx = wl+1
+    uint32_t nbCoeff = 0;
+    uint32_t x       = 1 + ( 1001 * ( fcntup ^ ( i << 8 ) ) );
+    while( nbCoeff < wl / 2 )
+    {  // 50% 1-bits
+        uint32_t r = 1 << 16;
+        while( r >= wl )
+        {  // only relevant for m=1
+            x = prbs23( x );
+            r = x % wlx;
+        }
+        uint32_t rb = 1UL << ( r & 31 );
+        if( ( mask[r >> 5] & rb ) == 0 )
+        {
+            nbCoeff += 1;
+            mask[r >> 5] |= rb;
+        }
+    }
+}
+
+// Write into dest the XOR of the redundancy pool units selected by mask.
+// If clear is true, mask is cleared on the way for the next unit.
+//
+STATIC void xorCoeffUnits( rose_t* ROSE, uint8_t* dest, uint32_t* mask, bool clear )
+{
+    const uint8_t* redp = ROSE->fifo;  // redundancy pool
+    int            sz   = ROSE->unitsz;
+    int            nw   = ( ROSE->wl + 31 ) / 32;
+
+    if( sz == 1 )
+    {
+        uint8_t acc = 0;
+        for( int w = 0; w < nw; w++ )
+        {
+            uint32_t       bits = mask[w];
+            const uint8_t* src  = &redp[w * 32];
+            if( clear )
+            {
+                mask[w] = 0;
+            }
+            while( bits != 0 )
+            {
+                acc ^= src[__builtin_ctz( bits )];
+                bits &= bits - 1;
+            }
+        }
+        dest[0] = acc;
+    }
+    else
+    {
+        // units are at most 8 bytes: XOR them as two words
+        uint32_t acc[2] = { 0, 0 };
+        uint32_t tmp[2] = { 0, 0 };
+        for( int w = 0; w < nw; w++ )
+        {
+            uint32_t       bits = mask[w];
+            const uint8_t* src  = &redp[w * 32 * sz];
+            if( clear )
+            {
+                mask[w] = 0;
+            }
+            while( bits != 0 )
+            {
+                memcpy( tmp, &src[__builtin_ctz( bits ) * sz], sz );
+                acc[0] ^= tmp[0];
+                acc[1] ^= tmp[1];
+                bits &= bits - 1;
+            }
+        }
+        memcpy( dest, acc, sz );
+    }
+}
+
+void ROSE_prepareCoeffs( rose_t* ROSE, uint32_t fcntup )
+{
+    rose_coeff_cache_t* cache = &ROSE->coeff_cache;
+    if( cache->wl == ROSE->wl && cache->fcntup == fcntup )
+    {
+        return;
+    }
+    memset( cache->mask, 0, sizeof( cache->mask ) );
+    for( int i = 0; i < ROSE_COEFF_CACHE_NB_UNITS; i++ )
+    {
+        genCoeffMask( ROSE->wl, fcntup, i, cache->mask[i] );
+    }
+    cache->fcntup = fcntup;
+    cache->wl     = ROSE->wl;
+}
+
+// Write an XOR combination of fragments into buffer pfrag
+// Selection of fragment is controlled by AppCnt
+// Coefficients of the first units come from the cache when they were prepared
+// for this frame, the others are generated in a mask cleared after each unit.
+//
+STATIC void buildRedundancyOctets( rose_t* ROSE, uint32_t fcntup, uint8_t* redbuf, uint8_t n_units )
+{
+    rose_coeff_cache_t* cache  = &ROSE->coeff_cache;
+    int                 cached = 0;
+    uint32_t            mask[ROSE_DEFAULT_WL / 32];
+
+    if( cache->wl == ROSE->wl && cache->fcntup == fcntup )
+    {
+        cached = MIN( n_units, ROSE_COEFF_CACHE_NB_UNITS );
+    }
+    for( int i = 0; i < cached; i++ )
+    {
+        xorCoeffUnits( ROSE, &redbuf[i * ROSE->unitsz], cache->mask[i], false );
+    }
+    memset( mask, 0, sizeof( mask ) );
+    for( int i = cached; i < n_units; i++ )
+    {
+        genCoeffMask( ROSE->wl, fcntup, i, mask );
+        xorCoeffUnits( ROSE, &redbuf[i * ROSE->unitsz], mask, true );
+    }
+}
+#else
 // Write an XOR combination of fragments into buffer pfrag
 // Selection of fragment is controlled by AppCnt
 //
@@ -240,6 +363,7 @@ STATIC void buildRedundancyOctets( rose_t* ROSE, uint32_t fcntup, uint8_t* redbu
         }
     }
 }
+#endif
 
 STATIC void ROSE_payload_encrypt( rose_t* ROSE, const uint8_t* buffer, uint16_t size, uint8_t dir,
                                   uint32_t sequenceCounter, uint8_t* encBuffer )
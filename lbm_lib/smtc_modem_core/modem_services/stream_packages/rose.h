@@ -55,6 +55,22 @@
 #endif
 #endif
 
+#if defined( ROSE_COEFF_CACHE )
+#ifndef ROSE_COEFF_CACHE_NB_UNITS
+#define ROSE_COEFF_CACHE_NB_UNITS 16  // number of redundancy units whose coefficients are generated ahead of a frame
+#endif
+
+/*!
+ *  \brief Coefficient bitmasks of the first redundancy units of a frame
+ */
+typedef struct rose_coeff_cache_s
+{
+    uint32_t fcntup;  // frame counter the masks were generated for
+    uint16_t wl;      // window length the masks were generated for, 0 if none
+    uint32_t mask[ROSE_COEFF_CACHE_NB_UNITS][ROSE_DEFAULT_WL / 32];
+} rose_coeff_cache_t;
+#endif
+
 /*!
  *  \brief ROSE Status codes
  */
@@ -105,6 +121,9 @@ typedef struct rose_s
     uint16_t fill;      // start of free buffer space
     uint8_t  unitsz;
     uint8_t  fifo[ROSE_FIFO_SIZE];
+#if defined( ROSE_COEFF_CACHE )
+    rose_coeff_cache_t coeff_cache;
+#endif
 } rose_t;
 
 // minfree in bytes
@@ -125,4 +144,9 @@ int      ROSE_getStatus( rose_t* ROSE );
 uint32_t ROSE_getSoff( rose_t* ROSE );  // stream offset of 1st byte of next addData
 int      ROSE_rvec_len( rose_t* ROSE );
 
+#if defined( ROSE_COEFF_CACHE )
+// generate ahead the coefficients of the first redundancy units of the frame sent with fcntup
+void ROSE_prepareCoeffs( rose_t* ROSE, uint32_t fcntup );
+#endif
+
 #endif  // __ROSE_H__
@@ -199,6 +199,8 @@ void stream_services_init( uint8_t* service_id, uint8_t task_id,
     ctx->ROSE.stack_id  = CURRENT_STACK;
     ctx->port           = DM_PORT;
     SMTC_MODEM_HAL_TRACE_WARNING( "%s\n", __func__ );
+    modem_downlink_set_filter( stream_service_downlink_handler, CURRENT_STACK, MODEM_DOWNLINK_FILTER_DM_FPORT,
+                               DM_PORT );
 }
 
 void stream_service_on_launch( void* service_id )
@@ -528,6 +530,11 @@ static void stream_add_task( stream_ctx_t* ctx )
     stream_task.priority          = TASK_MEDIUM_HIGH_PRIORITY;
     stream_task.time_to_execute_s = smtc_modem_hal_get_time_in_s( ) + ( MODEM_TASK_DELAY_MS / 1000 );
 
+#if defined( ROSE_COEFF_CACHE )
+    // Generate the redundancy coefficients of the next frame now rather than when the task is launched
+    ROSE_prepareCoeffs( &ctx->ROSE, lorawan_api_fcnt_up_get( ctx->stack_id ) );
+#endif
+
     modem_supervisor_add_task( &stream_task );
 }
 
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rose.h"
+#include "smtc_modem_crypto.h"
+
+// Previous implementation, see rose_ref.c
+int      ref_ROSE_init( rose_t* ROSE, uint16_t windowLen, uint16_t minfree, uint8_t redundancyRate, uint8_t unitsz );
+int      ref_ROSE_enable_encryption( rose_t* ROSE );
+uint16_t ref_ROSE_getFree( rose_t* ROSE );
+int      ref_ROSE_getData( rose_t* ROSE, uint32_t fcntup, uint8_t* frame, uint8_t* pTransferSize );
+int      ref_ROSE_addRecord( rose_t* ROSE, const uint8_t* data, uint16_t nbytes );
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt( const uint8_t* clear_buff, uint16_t len,
+                                                                   uint8_t nonce[14], uint8_t* enc_buff,
+                                                                   uint8_t stack_id )
+{
+    // AES-CTR model: each byte only depends on the nonce and on its position
+    for( uint16_t i = 0; i < len; i++ )
+    {
+        uint32_t x = i;
+        for( uint8_t k = 0; k < 14; k++ )
+        {
+            x = x * 31 + nonce[k];
+        }
+        enc_buff[i] = clear_buff[i] ^ ( uint8_t ) ( x ^ ( x >> 11 ) );
+    }
+    return SMTC_MODEM_CRYPTO_RC_SUCCESS;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+typedef enum cache_state_e
+{
+    CACHE_MISSING,   // the coefficients of the frame are not prepared
+    CACHE_PREPARED,  // the coefficients of the frame are prepared before the records are added
+    CACHE_STALE,     // the coefficients of another frame are prepared
+    CACHE_RANDOM,    // any of the above, drawn for each frame
+} cache_state_t;
+
+static const uint16_t window_lengths[] = { 16, 64, 128, 256, 512 };
+static const uint8_t  redundancy_rates[] = { 50, 110, 200 };
+static const uint8_t  unit_sizes[]       = { 1, 2, 4, 8 };
+
+static rose_t rose;
+static rose_t ref_rose;
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static double now_us( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static void set_cache( cache_state_t state, uint32_t fcnt )
+{
+#if defined( ROSE_COEFF_CACHE )
+    if( state == CACHE_RANDOM )
+    {
+        state = ( cache_state_t )( rnd( ) % CACHE_RANDOM );
+    }
+    if( state == CACHE_PREPARED )
+    {
+        ROSE_prepareCoeffs( &rose, fcnt );
+    }
+    else if( state == CACHE_STALE )
+    {
+        ROSE_prepareCoeffs( &rose, fcnt + 1 + rnd( ) % 3 );
+    }
+#endif
+}
+
+typedef struct replay_stat_s
+{
+    uint32_t streams;
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t errors;
+} replay_stat_t;
+
+/**
+ * Stream records on both implementations and compare the frames byte per byte
+ */
+static void replay_streams( cache_state_t state, uint32_t nb_frames, replay_stat_t* stat )
+{
+    rnd_state = 1;
+    for( uint8_t a = 0; a < sizeof( window_lengths ) / sizeof( window_lengths[0] ); a++ )
+    {
+        for( uint8_t b = 0; b < sizeof( redundancy_rates ); b++ )
+        {
+            for( uint8_t c = 0; c < sizeof( unit_sizes ); c++ )
+            {
+                for( uint8_t encryption = 0; encryption < 2; encryption++ )
+                {
+                    int rc     = ROSE_init( &rose, window_lengths[a], 512, redundancy_rates[b], unit_sizes[c] );
+                    int ref_rc = ref_ROSE_init( &ref_rose, window_lengths[a], 512, redundancy_rates[b], unit_sizes[c] );
+
+                    if( rc != ref_rc )
+                    {
+                        stat->errors++;
+                    }
+                    if( rc != ROSE_OK )
+                    {
+                        continue;
+                    }
+                    if( encryption == 1 )
+                    {
+                        ROSE_enable_encryption( &rose );
+                        ref_ROSE_enable_encryption( &ref_rose );
+                    }
+                    stat->streams++;
+
+                    for( uint32_t fcnt = 1; fcnt < nb_frames; fcnt++ )
+                    {
+                        uint8_t record[40];
+                        uint8_t frame[255];
+                        uint8_t ref_frame[255];
+                        uint8_t size     = 11 + ( rnd( ) % 4 ) * 60;
+                        uint8_t ref_size = size;
+                        int     len      = unit_sizes[c] * ( 1 + rnd( ) % ( 32 / unit_sizes[c] ) );
+
+                        // The coefficients only depend on the frame counter, they are prepared before the records
+                        set_cache( state, fcnt );
+                        for( int i = 0; i < len; i++ )
+                        {
+                            record[i] = ( uint8_t ) rnd( );
+                        }
+                        if( ( ROSE_getFree( &rose ) > len + 2 ) != ( ref_ROSE_getFree( &ref_rose ) > len + 2 ) )
+                        {
+                            stat->errors++;
+                        }
+                        if( ROSE_getFree( &rose ) > len + 2 )
+                        {
+                            ROSE_addRecord( &rose, record, len );
+                            ref_ROSE_addRecord( &ref_rose, record, len );
+                        }
+
+                        rc     = ROSE_getData( &rose, fcnt, frame, &size );
+                        ref_rc = ref_ROSE_getData( &ref_rose, fcnt, ref_frame, &ref_size );
+                        if( ( rc != ref_rc ) || ( size != ref_size ) || ( memcmp( frame, ref_frame, size ) != 0 ) )
+                        {
+                            stat->errors++;
+                        }
+                        stat->frames++;
+                        stat->bytes += size;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Time ROSE_getData() on the full windows
+ */
+static double bench_get_data( cache_state_t state, bool reference, double* prepare_us )
+{
+    double   get_data_us = 0;
+    uint32_t nb_frames   = 0;
+
+    rnd_state   = 1;
+    *prepare_us = 0;
+    for( uint8_t b = 0; b < sizeof( redundancy_rates ); b++ )
+    {
+        rose_t* r = reference ? &ref_rose : &rose;
+
+        if( reference )
+        {
+            ref_ROSE_init( r, ROSE_DEFAULT_WL, 512, redundancy_rates[b], 1 );
+        }
+        else
+        {
+            ROSE_init( r, ROSE_DEFAULT_WL, 512, redundancy_rates[b], 1 );
+        }
+        for( uint32_t fcnt = 1; fcnt < 4000; fcnt++ )
+        {
+            uint8_t record[32];
+            uint8_t frame[255];
+            uint8_t size = 242;
+            double  t0;
+
+            for( uint8_t i = 0; i < sizeof( record ); i++ )
+            {
+                record[i] = ( uint8_t ) rnd( );
+            }
+            t0 = now_us( );
+            if( reference == false )
+            {
+                set_cache( state, fcnt );
+            }
+            *prepare_us += now_us( ) - t0;
+            if( reference )
+            {
+                ref_ROSE_addRecord( r, record, sizeof( record ) );
+            }
+            else
+            {
+                ROSE_addRecord( r, record, sizeof( record ) );
+            }
+            t0 = now_us( );
+            if( reference )
+            {
+                ref_ROSE_getData( r, fcnt, frame, &size );
+            }
+            else
+            {
+                ROSE_getData( r, fcnt, frame, &size );
+            }
+            get_data_us += now_us( ) - t0;
+            nb_frames++;
+        }
+    }
+    *prepare_us /= nb_frames;
+    return get_data_us / nb_frames;
+}
+
+static void bench( void )
+{
+    double prepare_us;
+    double ref_us = bench_get_data( CACHE_MISSING, true, &prepare_us );
+
+    printf( "\nROSE_getData, wl %u, 1-byte units, 242-byte frames\n", ROSE_DEFAULT_WL );
+    printf( "  previous implementation : %6.2f us/frame\n", ref_us );
+    printf( "  missing cache           : %6.2f us/frame\n", bench_get_data( CACHE_MISSING, false, &prepare_us ) );
+#if defined( ROSE_COEFF_CACHE )
+    double get_data_us = bench_get_data( CACHE_PREPARED, false, &prepare_us );
+    printf( "  prepared cache          : %6.2f us/frame (prepared ahead in %.2f us)\n", get_data_us, prepare_us );
+    printf( "  stale cache             : %6.2f us/frame\n", bench_get_data( CACHE_STALE, false, &prepare_us ) );
+#endif
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies that the frames are the ones of the previous implementation when the coefficients are not prepared.
+ */
+void test_missing_cache_identical( )
+{
+    replay_stat_t stat = { 0 };
+
+    replay_streams( CACHE_MISSING, 300, &stat );
+    printf( "     %u streams, %u frames, %u bytes\n", stat.streams, stat.frames, stat.bytes );
+    print_result( "test_missing_cache_identical", ( stat.errors == 0 ) && ( stat.bytes > 0 ) );
+}
+
+#if defined( ROSE_COEFF_CACHE )
+/**
+ * Verifies that the frames are the ones of the previous implementation when the coefficients of the frame are
+ * prepared before the records are added.
+ */
+void test_prepared_cache_identical( )
+{
+    replay_stat_t stat = { 0 };
+
+    replay_streams( CACHE_PREPARED, 300, &stat );
+    print_result( "test_prepared_cache_identical", ( stat.errors == 0 ) && ( stat.bytes > 0 ) );
+}
+
+/**
+ * Verifies that coefficients prepared for another frame are not used.
+ */
+void test_stale_cache_identical( )
+{
+    replay_stat_t stat = { 0 };
+
+    replay_streams( CACHE_STALE, 300, &stat );
+    print_result( "test_stale_cache_identical", ( stat.errors == 0 ) && ( stat.bytes > 0 ) );
+}
+
+/**
+ * Verifies that coefficients prepared for another window length are not used.
+ */
+void test_other_window_cache_identical( )
+{
+    bool     passed     = true;
+    uint32_t nb_frames  = 0;
+    uint16_t wl_list[2] = { 128, 512 };
+
+    rnd_state = 5;
+    for( uint8_t w = 0; w < 2; w++ )
+    {
+        ROSE_init( &rose, wl_list[w], 512, 110, 1 );
+        ref_ROSE_init( &ref_rose, wl_list[w], 512, 110, 1 );
+        for( uint32_t fcnt = 1; fcnt < 300; fcnt++ )
+        {
+            uint8_t record[16];
+            uint8_t frame[255];
+            uint8_t ref_frame[255];
+            uint8_t size     = 242;
+            uint8_t ref_size = 242;
+
+            for( uint8_t i = 0; i < sizeof( record ); i++ )
+            {
+                record[i] = ( uint8_t ) rnd( );
+            }
+            ROSE_addRecord( &rose, record, sizeof( record ) );
+            ref_ROSE_addRecord( &ref_rose, record, sizeof( record ) );
+
+            // Coefficients of the frame left by a stream with another window length, poisoned to show up if used
+            rose.coeff_cache.fcntup = fcnt;
+            rose.coeff_cache.wl     = 256;
+            memset( rose.coeff_cache.mask, 0xFF, sizeof( rose.coeff_cache.mask ) );
+
+            ROSE_getData( &rose, fcnt, frame, &size );
+            ref_ROSE_getData( &ref_rose, fcnt, ref_frame, &ref_size );
+            passed = passed && ( size == ref_size ) && ( memcmp( frame, ref_frame, size ) == 0 );
+            nb_frames++;
+        }
+    }
+    print_result( "test_other_window_cache_identical", passed && ( nb_frames > 0 ) );
+}
+#endif
+
+/**
+ * Verifies that the frames are the ones of the previous implementation when the cache state changes at each frame.
+ */
+void test_random_cache_identical( )
+{
+    replay_stat_t stat = { 0 };
+
+    replay_streams( CACHE_RANDOM, 1000, &stat );
+    print_result( "test_random_cache_identical", ( stat.errors == 0 ) && ( stat.bytes > 0 ) );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( int argc, char** argv )
+{
+    test_missing_cache_identical( );
+#if defined( ROSE_COEFF_CACHE )
+    test_prepared_cache_identical( );
+    test_stale_cache_identical( );
+    test_other_window_cache_identical( );
+#endif
+    test_random_cache_identical( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    if( ( argc > 1 ) && ( strcmp( argv[1], "bench" ) == 0 ) )
+    {
+        bench( );
+    }
+
+    return failed_count == 0 ? 0 : 1;
+}
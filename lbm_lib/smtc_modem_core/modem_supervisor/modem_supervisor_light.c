@@ -62,6 +62,7 @@
 #define LR1MAC_PERIOD_RETRANS_MS 1000
 #define MODEM_MAX_ALARM_S 0x7FFFFFFF
 #define SUPERVISOR_PERIOD_FAILSAFE_S 120
+#define SUPERVISOR_TASK_QUEUE_END 0xFF
 
 /*
  *-----------------------------------------------------------------------------------
@@ -113,6 +114,10 @@ struct
     void ( *supervisor_on_update_func[NUMBER_OF_TASKS] )( void* );
 
     bool is_duty_cycle_constraint_enabled[NUMBER_OF_STACKS];
+
+    // Pending tasks (priority != TASK_FINISH) linked by priority then by time to execute
+    uint8_t task_queue_head;
+    uint8_t task_queue_next[NUMBER_OF_TASKS * NUMBER_OF_STACKS];
 } modem_supervisor_context;
 
 /* clang-format off */
@@ -124,6 +129,9 @@ struct
 
 #define is_duty_cycle_constraint_enabled modem_supervisor_context.is_duty_cycle_constraint_enabled
 
+#define task_queue_head modem_supervisor_context.task_queue_head
+#define task_queue_next modem_supervisor_context.task_queue_next
+
 /* clang-format on */
 
 /*
@@ -131,9 +139,13 @@ struct
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
-static uint32_t supervisor_check_user_alarm( void );
+static uint32_t supervisor_check_user_alarm( uint32_t now_s );
 static uint32_t supervisor_run_lorawan_engine( uint8_t stack_id );
-static uint32_t supervisor_find_next_task( void );
+static uint32_t supervisor_find_next_task( uint32_t now_s );
+
+static bool supervisor_task_queue_is_before( uint8_t index_a, uint8_t index_b );
+static void supervisor_task_queue_insert( uint8_t index );
+static void supervisor_task_queue_remove( uint8_t index );
 
 static void supervisor_idle_task_on_launch( void* context );
 static void supervisor_idle_task_on_update( void* context );
@@ -155,6 +167,7 @@ void modem_supervisor_init( void )
         task_manager.modem_task[i].updated_locked = false;
     }
     task_manager.next_task_id = IDLE_TASK;
+    task_queue_head           = SUPERVISOR_TASK_QUEUE_END;
 
     for( uint8_t i = 0; i < NUMBER_OF_TASKS; i++ )
     {
@@ -219,6 +232,7 @@ task_valid_t modem_supervisor_remove_task( uint16_t id )
 {
     if( id < NUMBER_OF_TASKS * NUMBER_OF_STACKS )
     {
+        supervisor_task_queue_remove( id );
         task_manager.modem_task[id].priority     = TASK_FINISH;
         task_manager.modem_task[id].task_enabled = false;
         return TASK_VALID;
@@ -236,13 +250,22 @@ task_valid_t modem_supervisor_add_task( smodem_task* task )
 
     if( task->id < NUMBER_OF_TASKS * NUMBER_OF_STACKS )
     {
-        uint8_t task_index                                    = task->id;
+        uint8_t task_index = task->id;
+
+        // The task replaces the previous one with the same id, relink it at the place of its new priority and date
+        supervisor_task_queue_remove( task_index );
+
         task_manager.modem_task[task_index].time_to_execute_s = task->time_to_execute_s;
         task_manager.modem_task[task_index].priority          = task->priority;
         task_manager.modem_task[task_index].stack_id          = task->stack_id;
         task_manager.modem_task[task_index].task_context      = task->task_context;
         task_manager.modem_task[task_index].task_enabled      = true;
         task_manager.modem_task[task_index].updated_locked    = task->updated_locked;
+        task_manager.modem_task[task_index].payload_length    = task->payload_length;
+        if( task->priority != TASK_FINISH )
+        {
+            supervisor_task_queue_insert( task_index );
+        }
         return TASK_VALID;
     }
     SMTC_MODEM_HAL_TRACE_ERROR( "modem_supervisor_add_task id = %d unknown\n", task->id );
@@ -261,8 +284,9 @@ uint32_t modem_supervisor_engine( void )
 {
     uint32_t sleep_time       = 0;
     uint32_t sleep_time_alarm = 0;
+    uint32_t now_s            = smtc_modem_hal_get_time_in_s( );
     sleep_time                = tx_protocol_manager_is_busy( );
-    sleep_time_alarm          = supervisor_check_user_alarm( );
+    sleep_time_alarm          = supervisor_check_user_alarm( now_s );
     if( sleep_time > 0 )
     {
         sleep_time = MIN( sleep_time, sleep_time_alarm * 1000 );
@@ -278,8 +302,7 @@ uint32_t modem_supervisor_engine( void )
 
     if( task_manager.modem_task[task_manager.next_task_id].updated_locked == true )
     {
-        if( ( int32_t ) ( smtc_modem_hal_get_time_in_s( ) -
-                          task_manager.modem_task[task_manager.next_task_id].launched_timestamp -
+        if( ( int32_t ) ( now_s - task_manager.modem_task[task_manager.next_task_id].launched_timestamp -
                           SUPERVISOR_PERIOD_FAILSAFE_S ) > 0 )
         {
             SMTC_MODEM_HAL_PANIC( "Supervisor FAILSAFE EVENT OCCUR task:0x%x)\n", task_manager.next_task_id );
@@ -294,19 +317,20 @@ uint32_t modem_supervisor_engine( void )
         supervisor_on_update_func[CURRENT_TASK_ID]( supervisor_context_callback[CURRENT_TASK_ID] );
         task_manager.next_task_id = IDLE_TASK;
     }
-    sleep_time = supervisor_find_next_task( );
+    sleep_time = supervisor_find_next_task( now_s );
 
     if( sleep_time == 0 )  // launch task
     {
-        task_manager.modem_task[task_manager.next_task_id].launched_timestamp = smtc_modem_hal_get_time_in_s( );
+        task_manager.modem_task[task_manager.next_task_id].launched_timestamp = now_s;
         supervisor_on_launch_func[CURRENT_TASK_ID]( supervisor_context_callback[CURRENT_TASK_ID] );
+        supervisor_task_queue_remove( task_manager.next_task_id );
         task_manager.modem_task[task_manager.next_task_id].priority = TASK_FINISH;
     }
     uint32_t alarm                 = modem_get_user_alarm( );
     int32_t  user_alarm_in_seconds = MODEM_MAX_ALARM_S / 1000;
     if( alarm != 0 )
     {
-        user_alarm_in_seconds = ( int32_t ) ( alarm - smtc_modem_hal_get_time_in_s( ) );
+        user_alarm_in_seconds = ( int32_t ) ( alarm - now_s );
         if( user_alarm_in_seconds <= 0 )
         {
             user_alarm_in_seconds = 0;
@@ -344,14 +368,14 @@ void modem_supervisor_set_modem_mute_with_priority_parameter( task_priority_t pr
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
-static uint32_t supervisor_check_user_alarm( void )
+static uint32_t supervisor_check_user_alarm( uint32_t now_s )
 {
     uint32_t alarm                 = modem_get_user_alarm( );
     int32_t  user_alarm_in_seconds = MODEM_MAX_ALARM_S;
     // manage the user alarm
     if( alarm != 0 )
     {
-        user_alarm_in_seconds = ( int32_t ) ( alarm - smtc_modem_hal_get_time_in_s( ) );
+        user_alarm_in_seconds = ( int32_t ) ( alarm - now_s );
 
         if( user_alarm_in_seconds <= 0 )
         {
@@ -383,7 +407,7 @@ static uint32_t supervisor_run_lorawan_engine( uint8_t stack_id )
     return sleep_time;
 }
 
-static uint32_t supervisor_find_next_task( void )
+static uint32_t supervisor_find_next_task( uint32_t now_s )
 {
     // Find stacks that can continue to send uplink frame in regard of duty-cycle regulation
     int32_t dtc_ms                            = MODEM_MAX_TIME;
@@ -391,12 +415,13 @@ static uint32_t supervisor_find_next_task( void )
 
     for( uint8_t i = 0; i < NUMBER_OF_STACKS; i++ )
     {
+        // Same rule as smtc_modem_get_duty_cycle_status(): some budget is left, whatever the size of the next frame
         int32_t dtc_ms_tmp = modem_duty_cycle_get_status( i );
         if( dtc_ms_tmp <= 0 )
         {
             available_stack[i] = 1;
         }
-        if( dtc_ms > dtc_ms_tmp )
+        else if( dtc_ms > dtc_ms_tmp )
         {
             dtc_ms = dtc_ms_tmp;
         }
@@ -421,63 +446,53 @@ static uint32_t supervisor_find_next_task( void )
         }
     }
 
-    task_priority_t next_task_priority = TASK_FINISH;
-    int32_t         next_task_time     = MODEM_MAX_TIME;
+    int32_t next_task_time  = MODEM_MAX_TIME;
+    uint8_t next_task_index = SUPERVISOR_TASK_QUEUE_END;
 
-    // Find the highest priority task in the past
-    for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+    // The queue is sorted by priority then by date: the first eligible task in the past is the highest priority one,
+    // if there is none keep the least in the future for wake up
+    for( uint8_t i = task_queue_head; i != SUPERVISOR_TASK_QUEUE_END; i = task_queue_next[i] )
     {
-        for( task_id_t k = 0; k < NUMBER_OF_TASKS; k++ )
+        uint8_t stack_id = i / NUMBER_OF_TASKS;
+
+        if( ( task_manager.modem_task[i].priority > task_manager.modem_mute_with_priority[stack_id] ) ||
+            ( task_manager.modem_is_suspended[stack_id] == true ) ||
+            ( ( available_stack[stack_id] == 0 ) &&
+              ( task_manager.modem_task[i].priority != TASK_BYPASS_DUTY_CYCLE ) ) )
         {
-            uint8_t i = ( stack_id * NUMBER_OF_TASKS ) + k;
-            if( ( task_manager.modem_task[i].priority != TASK_FINISH ) &&
-                ( task_manager.modem_task[i].priority <= task_manager.modem_mute_with_priority[stack_id] ) &&
-                ( task_manager.modem_is_suspended[stack_id] == false ) )
-            {
-                int32_t next_task_time_tmp =
-                    ( int32_t ) ( task_manager.modem_task[i].time_to_execute_s - smtc_modem_hal_get_time_in_s( ) );
-
-                if( ( next_task_time_tmp <= 0 ) && ( task_manager.modem_task[i].priority <= next_task_priority ) &&
-                    ( next_task_time_tmp <= next_task_time ) &&
-                    ( ( available_stack[stack_id] == 1 ) ||
-                      ( ( available_stack[stack_id] == 0 ) &&
-                        ( task_manager.modem_task[i].priority == TASK_BYPASS_DUTY_CYCLE ) ) ) )
-                {
-                    next_task_priority        = task_manager.modem_task[i].priority;
-                    next_task_time            = next_task_time_tmp;
-                    task_manager.next_task_id = ( task_id_t ) i;
-                }
-            }
+            continue;
         }
-    }
 
-    // No task in the past was found, select the least in the future for wake up
-    if( next_task_priority == TASK_FINISH )
-    {
-        for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+        int32_t next_task_time_tmp = ( int32_t ) ( task_manager.modem_task[i].time_to_execute_s - now_s );
+
+        if( next_task_time_tmp <= 0 )
         {
-            for( task_id_t k = 0; k < NUMBER_OF_TASKS; k++ )
+            // The frame of the task shall also fit in the budget: wait for it rather than for the first free ms
+            if( task_manager.modem_task[i].priority != TASK_BYPASS_DUTY_CYCLE )
             {
-                uint8_t i = ( stack_id * NUMBER_OF_TASKS ) + k;
-                if( ( task_manager.modem_task[i].priority != TASK_FINISH ) &&
-                    ( task_manager.modem_task[i].priority <= task_manager.modem_mute_with_priority[stack_id] ) &&
-                    ( task_manager.modem_is_suspended[stack_id] == false ) )
+                int32_t uplink_dtc_ms =
+                    modem_duty_cycle_get_uplink_status( stack_id, task_manager.modem_task[i].payload_length );
+                if( uplink_dtc_ms > 0 )
                 {
-                    int32_t next_task_time_tmp =
-                        ( int32_t ) ( task_manager.modem_task[i].time_to_execute_s - smtc_modem_hal_get_time_in_s( ) );
-                    if( ( next_task_time_tmp < next_task_time ) &&
-                        ( ( available_stack[stack_id] == 1 ) ||
-                          ( ( available_stack[stack_id] == 0 ) &&
-                            ( task_manager.modem_task[i].priority == TASK_BYPASS_DUTY_CYCLE ) ) ) )
-                    {
-                        next_task_time            = next_task_time_tmp;
-                        task_manager.next_task_id = ( task_id_t ) i;
-                    }
+                    dtc_ms = MIN( dtc_ms, uplink_dtc_ms );
+                    continue;
                 }
             }
+            next_task_time  = next_task_time_tmp;
+            next_task_index = i;
+            break;
+        }
+        if( ( next_task_time_tmp < next_task_time ) ||
+            ( ( next_task_time_tmp == next_task_time ) && ( i < next_task_index ) ) )
+        {
+            next_task_time  = next_task_time_tmp;
+            next_task_index = i;
         }
     }
-    if( ( dtc_ms > 0 ) && ( next_task_time == MODEM_MAX_TIME ) )
+
+    // Wake up when the duty cycle releases a stack or a pending frame, if it is before the next task
+    if( ( dtc_ms != MODEM_MAX_TIME ) && ( ( next_task_time == MODEM_MAX_TIME ) ||
+                                          ( ( next_task_time > 0 ) && ( dtc_ms < ( next_task_time * 1000 ) ) ) ) )
     {
         SMTC_MODEM_HAL_TRACE_WARNING_DEBUG( "Duty Cycle, remaining time: %dms\n", dtc_ms );
         task_manager.next_task_id = IDLE_TASK;
@@ -491,10 +506,82 @@ static uint32_t supervisor_find_next_task( void )
     }
     else
     {
+        task_manager.next_task_id = ( task_id_t ) next_task_index;
         return 0;
     }
 }
 
+/**
+ * @brief Check if a pending task has to be linked before another one in the task queue
+ *
+ * @remark Tasks are sorted by priority, then by time to execute, then by decreasing index to elect the same task as a
+ *         scan of all the tasks keeping the last one found at equal priority and date
+ *
+ * @param [in] index_a Index of the task already in the queue
+ * @param [in] index_b Index of the task to insert
+ * @return true if task index_a shall stay before task index_b
+ */
+static bool supervisor_task_queue_is_before( uint8_t index_a, uint8_t index_b )
+{
+    const smodem_task* task_a = &task_manager.modem_task[index_a];
+    const smodem_task* task_b = &task_manager.modem_task[index_b];
+
+    if( task_a->priority != task_b->priority )
+    {
+        return ( task_a->priority < task_b->priority );
+    }
+
+    int32_t delta_s = ( int32_t ) ( task_a->time_to_execute_s - task_b->time_to_execute_s );
+
+    if( delta_s != 0 )
+    {
+        return ( delta_s < 0 );
+    }
+    return ( index_a > index_b );
+}
+
+/**
+ * @brief Link a pending task in the task queue at the place of its priority and time to execute
+ *
+ * @param [in] index Index of the task
+ */
+static void supervisor_task_queue_insert( uint8_t index )
+{
+    uint8_t* link = &task_queue_head;
+
+    while( ( *link != SUPERVISOR_TASK_QUEUE_END ) && ( supervisor_task_queue_is_before( *link, index ) == true ) )
+    {
+        link = &task_queue_next[*link];
+    }
+    task_queue_next[index] = *link;
+    *link                  = index;
+}
+
+/**
+ * @brief Unlink a task from the task queue, nothing is done if the task is not pending
+ *
+ * @param [in] index Index of the task
+ */
+static void supervisor_task_queue_remove( uint8_t index )
+{
+    if( task_manager.modem_task[index].priority == TASK_FINISH )
+    {
+        return;
+    }
+
+    uint8_t* link = &task_queue_head;
+
+    while( *link != SUPERVISOR_TASK_QUEUE_END )
+    {
+        if( *link == index )
+        {
+            *link = task_queue_next[index];
+            return;
+        }
+        link = &task_queue_next[*link];
+    }
+}
+
 static void supervisor_idle_task_on_launch( void* context )
 {
 }
@@ -123,6 +123,7 @@ typedef struct smodem_task
     bool            task_enabled;       //!< Parameters to store context running or not of the task
     bool            updated_locked;
     uint32_t        launched_timestamp;
+    uint8_t         payload_length;  //!< Application payload length of the uplink sent by the task, 0 if unknown
 } smodem_task;
 
 /*!
@@ -249,6 +249,9 @@ static status_lorawan_t tpm_get_next_channel( void );
 static void             tpm_abort( void );
 static void             update_tpm_target_time( void );
 static uint32_t         update_add_delay_ms( void );
+#if defined( ADD_CHANNEL_OCCUPANCY )
+static void tpm_record_channel_occupancy( bool busy, bool rssi_valid, int16_t rssi_dbm );
+#endif
 static status_lorawan_t ( *launch_tpm_func[TPM_NUMBER_OF_STATE] )( void ) = {
     [TPM_STATE_TX_LORA]     = &manage_tx_lora_state,
     [TPM_STATE_NWK_TX_LORA] = &manage_tx_nwk_lora_state,
@@ -691,6 +694,11 @@ static status_lorawan_t manage_tx_lora_state( void )
 
 static void modem_tpm_radio_busy_lbt( void* context )
 {
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    int16_t lbt_rssi_dbm   = 0;
+    bool    lbt_rssi_valid = smtc_lbt_get_listen_rssi( smtc_lbt_get_obj( current_tpm_stack_id ), &lbt_rssi_dbm );
+    tpm_record_channel_occupancy( true, lbt_rssi_valid, lbt_rssi_dbm );
+#endif
 #if defined( ADD_RELAY_TX )
     // manage WOR LBT
     if( smtc_relay_tx_is_enable( current_tpm_stack_id ) == true )
@@ -748,6 +756,11 @@ static void modem_tpm_radio_busy_lbt( void* context )
 
 static void modem_tpm_radio_free_lbt( void* context )
 {
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    int16_t lbt_rssi_dbm   = 0;
+    bool    lbt_rssi_valid = smtc_lbt_get_listen_rssi( smtc_lbt_get_obj( current_tpm_stack_id ), &lbt_rssi_dbm );
+    tpm_record_channel_occupancy( false, lbt_rssi_valid, lbt_rssi_dbm );
+#endif
     shift_left_tpm_list( );
     current_tpm_cpt_lbt_max_trial = 0;
     update_tpm_target_time( );
@@ -837,6 +850,9 @@ static status_lorawan_t manage_lbt_state( void )
 #if defined( ADD_CSMA )
 static void modem_tpm_radio_busy_csma( void* context )
 {
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    tpm_record_channel_occupancy( true, false, 0 );
+#endif
 #if defined( ADD_RELAY_TX )
     // manage WOR CSMA
     if( smtc_relay_tx_is_enable( current_tpm_stack_id ) == true )
@@ -893,6 +909,9 @@ static void modem_tpm_radio_busy_csma( void* context )
  */
 static void modem_tpm_radio_free_csma( void* context )
 {
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    tpm_record_channel_occupancy( false, false, 0 );
+#endif
     shift_left_tpm_list( );
     update_tpm_target_time( );
     modem_tx_protocol_manager_engine( );
@@ -935,6 +954,9 @@ static void modem_tpm_radio_free_cad_keep_channel( void* context )
     }
     else
     {
+#endif
+#if defined( ADD_CHANNEL_OCCUPANCY )
+        tpm_record_channel_occupancy( false, false, 0 );
 #endif
         // Do not restart LBT between each CSMA check , on this mode we have to keep the same frequency
         // => so do not call compute_tpm_list( );
@@ -1308,6 +1330,35 @@ static void compute_tpm_list( void )
     }
     tpm_list_of_state_to_execute[index] = TPM_STATE_IDLE;
 }
+#if defined( ADD_CHANNEL_OCCUPANCY )
+/**
+ * @brief Record the outcome of the LBT or CSMA sense that just completed in the channel occupancy statistics
+ * @remark Senses of the relay WOR channel and of the test mode are not on the LoRaWAN uplink channels and are ignored
+ * @param [in] busy       true if the channel was found busy
+ * @param [in] rssi_valid true if rssi_dbm holds the average rssi measured by LBT
+ * @param [in] rssi_dbm   average rssi measured by LBT
+ */
+static void tpm_record_channel_occupancy( bool busy, bool rssi_valid, int16_t rssi_dbm )
+{
+    if( current_tpm_request_type == TX_PROTOCOL_TRANSMIT_TEST_MODE )
+    {
+        return;
+    }
+#if defined( ADD_RELAY_TX )
+    if( ( tpm_list_of_state_to_execute[0] == TPM_STATE_LBT_BEFORE_WOR )
+#if defined( ADD_CSMA )
+        || ( tpm_list_of_state_to_execute[0] == TPM_STATE_CSMA_BEFORE_WOR )
+#endif
+    )
+    {
+        return;
+    }
+#endif
+    lr1_stack_mac_t* lr1mac_obj = lorawan_api_stack_mac_get( current_tpm_stack_id );
+    smtc_real_channel_occupancy_update( lr1mac_obj->real, lr1mac_obj->tx_frequency, busy, rssi_valid, rssi_dbm );
+}
+#endif
+
 /**
  * @brief This function update the current list by shifting left the elements , as a consequence the first element is
  * lost and the last one is replaced by TPM_STATE_IDLE
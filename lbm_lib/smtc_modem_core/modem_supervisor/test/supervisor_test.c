@@ -0,0 +1,437 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The task queue is static: the module is built within the test
+#include "modem_supervisor_light.c"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static uint32_t now_s;
+static int32_t  dtc_status_ms[NUMBER_OF_STACKS];
+static uint8_t  launched_id;
+static uint8_t  launched_priority;
+
+uint32_t smtc_modem_hal_get_time_in_s( void )
+{
+    return now_s;
+}
+
+void smtc_modem_hal_on_panic( uint8_t* func, uint32_t line, const char* fmt, ... )
+{
+    printf( "PANIC %s:%u\n", func, line );
+    exit( 2 );
+}
+
+uint32_t tx_protocol_manager_is_busy( void )
+{
+    return 0;
+}
+
+void tx_protocol_manager_lr1mac_stand_alone_tx( void )
+{
+}
+
+lr1mac_states_t lorawan_api_process( uint8_t stack_id )
+{
+    return LWPSTATE_IDLE;
+}
+
+uint32_t modem_get_user_alarm( void )
+{
+    return 0;
+}
+
+void modem_set_user_alarm( uint32_t alarm )
+{
+}
+
+void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id )
+{
+}
+
+int32_t modem_duty_cycle_get_status( uint8_t stack_id )
+{
+    return dtc_status_ms[stack_id];
+}
+
+int32_t modem_duty_cycle_get_uplink_status( uint8_t stack_id, uint8_t payload_length )
+{
+    // The frame always fits once some budget is left, the election only depends on the stack availability
+    return dtc_status_ms[stack_id];
+}
+
+// Referenced by the services configuration table
+void lorawan_certification_services_init( uint8_t* service_id, uint8_t task_id,
+                                          uint8_t ( **downlink_callback )( lr1_stack_mac_down_data_t* ),
+                                          void ( **on_launch_callback )( void* ),
+                                          void ( **on_update_callback )( void* ), void** context_callback )
+{
+}
+
+static void task_on_launch( void* context )
+{
+    launched_id       = task_manager.next_task_id;
+    launched_priority = task_manager.modem_task[launched_id].priority;
+}
+
+static void task_on_update( void* context )
+{
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define NB_TASKS ( NUMBER_OF_TASKS * NUMBER_OF_STACKS )
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static void setup( uint32_t start_s )
+{
+    now_s = start_s;
+    modem_supervisor_init( );
+    for( uint8_t i = SEND_TASK; i < NUMBER_OF_TASKS; i++ )
+    {
+        modem_supervisor_init_callback( ( task_id_t ) i, task_on_launch, task_on_update, &task_manager );
+    }
+    for( uint8_t s = 0; s < NUMBER_OF_STACKS; s++ )
+    {
+        dtc_status_ms[s] = 0;
+    }
+}
+
+static void add_task( uint8_t id, task_priority_t priority, int32_t delay_s )
+{
+    smodem_task task = { 0 };
+
+    task.id                = ( task_id_t ) id;
+    task.stack_id          = id / NUMBER_OF_TASKS;
+    task.priority          = priority;
+    task.time_to_execute_s = now_s + delay_s;
+    modem_supervisor_add_task( &task );
+}
+
+/**
+ * The queue holds each pending task once, in priority, date then decreasing index order
+ */
+static bool queue_is_consistent( void )
+{
+    uint8_t nb_linked  = 0;
+    uint8_t nb_pending = 0;
+    bool    linked[NB_TASKS];
+
+    memset( linked, 0, sizeof( linked ) );
+    for( uint8_t i = task_queue_head; i != SUPERVISOR_TASK_QUEUE_END; i = task_queue_next[i] )
+    {
+        if( ( i >= NB_TASKS ) || ( linked[i] == true ) || ( task_manager.modem_task[i].priority == TASK_FINISH ) )
+        {
+            return false;
+        }
+        if( ( task_queue_next[i] != SUPERVISOR_TASK_QUEUE_END ) &&
+            ( supervisor_task_queue_is_before( i, task_queue_next[i] ) == false ) )
+        {
+            return false;
+        }
+        linked[i] = true;
+        nb_linked++;
+    }
+    for( uint8_t i = 0; i < NB_TASKS; i++ )
+    {
+        nb_pending += ( task_manager.modem_task[i].priority != TASK_FINISH ) ? 1 : 0;
+    }
+    return nb_linked == nb_pending;
+}
+
+/**
+ * Previous election: a scan of all the tasks for the highest priority task in the past, then for the least in the
+ * future, without the queue
+ */
+static uint8_t ref_find_next_task( const uint8_t* available_stack, int32_t* next_task_time )
+{
+    task_priority_t next_task_priority = TASK_FINISH;
+    uint8_t         next_task_id       = IDLE_TASK;
+
+    *next_task_time = MODEM_MAX_TIME;
+
+    // Find the highest priority task in the past
+    for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+    {
+        for( task_id_t k = 0; k < NUMBER_OF_TASKS; k++ )
+        {
+            uint8_t i = ( stack_id * NUMBER_OF_TASKS ) + k;
+            if( ( task_manager.modem_task[i].priority != TASK_FINISH ) &&
+                ( task_manager.modem_task[i].priority <= task_manager.modem_mute_with_priority[stack_id] ) &&
+                ( task_manager.modem_is_suspended[stack_id] == false ) )
+            {
+                int32_t next_task_time_tmp = ( int32_t ) ( task_manager.modem_task[i].time_to_execute_s - now_s );
+
+                if( ( next_task_time_tmp <= 0 ) && ( task_manager.modem_task[i].priority <= next_task_priority ) &&
+                    ( next_task_time_tmp <= *next_task_time ) &&
+                    ( ( available_stack[stack_id] == 1 ) ||
+                      ( ( available_stack[stack_id] == 0 ) &&
+                        ( task_manager.modem_task[i].priority == TASK_BYPASS_DUTY_CYCLE ) ) ) )
+                {
+                    next_task_priority = task_manager.modem_task[i].priority;
+                    *next_task_time    = next_task_time_tmp;
+                    next_task_id       = i;
+                }
+            }
+        }
+    }
+
+    // No task in the past was found, select the least in the future for wake up
+    if( next_task_priority == TASK_FINISH )
+    {
+        for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+        {
+            for( task_id_t k = 0; k < NUMBER_OF_TASKS; k++ )
+            {
+                uint8_t i = ( stack_id * NUMBER_OF_TASKS ) + k;
+                if( ( task_manager.modem_task[i].priority != TASK_FINISH ) &&
+                    ( task_manager.modem_task[i].priority <= task_manager.modem_mute_with_priority[stack_id] ) &&
+                    ( task_manager.modem_is_suspended[stack_id] == false ) )
+                {
+                    int32_t next_task_time_tmp = ( int32_t ) ( task_manager.modem_task[i].time_to_execute_s - now_s );
+                    if( ( next_task_time_tmp < *next_task_time ) &&
+                        ( ( available_stack[stack_id] == 1 ) ||
+                          ( ( available_stack[stack_id] == 0 ) &&
+                            ( task_manager.modem_task[i].priority == TASK_BYPASS_DUTY_CYCLE ) ) ) )
+                    {
+                        *next_task_time = next_task_time_tmp;
+                        next_task_id    = i;
+                    }
+                }
+            }
+        }
+    }
+    return next_task_id;
+}
+
+/**
+ * Expected result of the engine with the previous election: the task to launch, or IDLE_TASK and the sleep time
+ */
+static uint8_t ref_engine( uint32_t* sleep_ms )
+{
+    uint8_t available_stack[NUMBER_OF_STACKS];
+    int32_t dtc_ms = MODEM_MAX_TIME;
+    int32_t next_task_time;
+
+    for( uint8_t s = 0; s < NUMBER_OF_STACKS; s++ )
+    {
+        available_stack[s] = ( dtc_status_ms[s] <= 0 ) ? 1 : 0;
+        if( dtc_status_ms[s] > 0 )
+        {
+            dtc_ms = MIN( dtc_ms, dtc_status_ms[s] );
+        }
+    }
+
+    uint8_t id = ref_find_next_task( available_stack, &next_task_time );
+
+    if( ( dtc_ms != MODEM_MAX_TIME ) &&
+        ( ( next_task_time == MODEM_MAX_TIME ) || ( ( next_task_time > 0 ) && ( dtc_ms < ( next_task_time * 1000 ) ) ) ) )
+    {
+        *sleep_ms = dtc_ms;
+        return IDLE_TASK;
+    }
+    if( next_task_time > 0 )
+    {
+        *sleep_ms = next_task_time * 1000;
+        return IDLE_TASK;
+    }
+    *sleep_ms = 0;
+    return id;
+}
+
+typedef struct election_stat_s
+{
+    uint32_t elections;
+    uint32_t launches;
+    uint32_t same;
+    uint32_t inversions;  // the previous scan launched a lower priority task while a higher priority one was due
+    uint32_t errors;
+} election_stat_t;
+
+/**
+ * Random add, replace, remove, abort, mute and suspend operations, each followed by an engine run compared with the
+ * previous election
+ */
+static void replay( uint32_t seed, uint32_t steps, election_stat_t* stat )
+{
+    rnd_state = seed;
+    setup( rnd( ) );
+
+    for( uint32_t step = 0; step < steps; step++ )
+    {
+        uint8_t op = rnd( ) % 16;
+        uint8_t id = rnd( ) % NB_TASKS;
+
+        if( ( id % NUMBER_OF_TASKS ) == IDLE_TASK )
+        {
+            id++;
+        }
+        if( op < 8 )
+        {
+            // Dates are grouped around now to get many equal dates
+            add_task( id, ( task_priority_t ) ( rnd( ) % TASK_FINISH ), ( int32_t ) ( rnd( ) % 12 ) - 6 );
+        }
+        else if( op < 10 )
+        {
+            modem_supervisor_remove_task( id );
+        }
+        else if( op == 10 )
+        {
+            uint8_t stack_id = rnd( ) % NUMBER_OF_STACKS;
+            modem_supervisor_abort_tasks_in_range( stack_id * NUMBER_OF_TASKS + SEND_TASK,
+                                                   stack_id * NUMBER_OF_TASKS + ( rnd( ) % NUMBER_OF_TASKS ) );
+        }
+        else if( op == 11 )
+        {
+            modem_supervisor_set_modem_mute_with_priority_parameter( ( task_priority_t ) ( rnd( ) % TASK_FINISH ),
+                                                                     rnd( ) % NUMBER_OF_STACKS );
+        }
+        else if( op == 12 )
+        {
+            uint8_t stack_id = rnd( ) % NUMBER_OF_STACKS;
+            modem_supervisor_set_modem_is_suspended( ( rnd( ) % 4 ) == 0, stack_id );
+        }
+        else if( op == 13 )
+        {
+            dtc_status_ms[rnd( ) % NUMBER_OF_STACKS] = ( ( rnd( ) % 3 ) == 0 ) ? 1 + rnd( ) % 20000 : 0;
+        }
+        else
+        {
+            now_s += rnd( ) % 4;
+        }
+
+        if( queue_is_consistent( ) == false )
+        {
+            stat->errors++;
+        }
+
+        uint32_t ref_sleep_ms;
+        uint8_t  ref_id       = ref_engine( &ref_sleep_ms );
+        uint8_t  ref_priority = task_manager.modem_task[ref_id].priority;
+
+        launched_id       = IDLE_TASK;
+        uint32_t sleep_ms = modem_supervisor_engine( );
+        stat->elections++;
+
+        if( ( sleep_ms == ref_sleep_ms ) && ( launched_id == ref_id ) )
+        {
+            stat->same++;
+        }
+        else if( ( sleep_ms == 0 ) && ( ref_sleep_ms == 0 ) && ( launched_priority < ref_priority ) )
+        {
+            stat->inversions++;
+        }
+        else
+        {
+            stat->errors++;
+        }
+        if( sleep_ms == 0 )
+        {
+            stat->launches++;
+            // A launched task leaves the queue
+            if( ( task_manager.modem_task[launched_id].priority != TASK_FINISH ) || ( queue_is_consistent( ) == false ) )
+            {
+                stat->errors++;
+            }
+        }
+    }
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies that the queue holds the pending tasks in order and that the engine launches the same task and sleeps the
+ * same time as the previous scan, except when the previous scan elected a lower priority task.
+ */
+void test_election_matches_previous_scan( )
+{
+    election_stat_t stat = { 0 };
+
+    for( uint32_t seed = 1; seed <= 64; seed++ )
+    {
+        replay( seed, 5000, &stat );
+    }
+    printf( "     %u elections, %u launches: %u same, %u priority inversions fixed\n", stat.elections, stat.launches,
+            stat.same, stat.inversions );
+    print_result( "test_election_matches_previous_scan", ( stat.errors == 0 ) && ( stat.launches > 0 ) );
+}
+
+/**
+ * Verifies the priority inversion of the previous scan: a due low priority task with a lower index and an older date
+ * is not launched before a due higher priority task.
+ */
+void test_priority_inversion( )
+{
+    uint32_t sleep_ms;
+    bool     passed;
+
+    setup( 1000 );
+    add_task( SEND_TASK, TASK_LOW_PRIORITY, -5 );
+    add_task( CID_REQ_TASK, TASK_HIGH_PRIORITY, -1 );
+
+    passed = ( ref_engine( &sleep_ms ) == SEND_TASK ) && ( sleep_ms == 0 );
+    passed = passed && ( modem_supervisor_engine( ) == 0 ) && ( launched_id == CID_REQ_TASK );
+    // The low priority task is next
+    passed = passed && ( modem_supervisor_engine( ) == 0 ) && ( launched_id == SEND_TASK );
+    passed = passed && ( task_queue_head == SUPERVISOR_TASK_QUEUE_END );
+    print_result( "test_priority_inversion", passed );
+}
+
+/**
+ * Verifies that adding a task with the id of a pending task replaces it at the place of its new priority and date.
+ */
+void test_replace_pending_task( )
+{
+    bool passed;
+
+    setup( 1000 );
+    add_task( SEND_TASK, TASK_LOW_PRIORITY, 10 );
+    add_task( JOIN_TASK, TASK_MEDIUM_HIGH_PRIORITY, 20 );
+    add_task( SEND_TASK, TASK_VERY_HIGH_PRIORITY, 30 );
+
+    passed = queue_is_consistent( ) && ( task_queue_head == SEND_TASK ) && ( task_queue_next[SEND_TASK] == JOIN_TASK );
+    // The least in the future wakes up the engine, whatever its priority
+    passed = passed && ( modem_supervisor_engine( ) == 20000 );
+    modem_supervisor_remove_task( JOIN_TASK );
+    passed = passed && queue_is_consistent( ) && ( modem_supervisor_engine( ) == 30000 );
+    modem_supervisor_remove_task( SEND_TASK );
+    passed = passed && ( task_queue_head == SUPERVISOR_TASK_QUEUE_END );
+    print_result( "test_replace_pending_task", passed );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_election_matches_previous_scan( );
+    test_priority_inversion( );
+    test_replace_pending_task( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
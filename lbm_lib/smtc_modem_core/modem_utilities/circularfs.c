@@ -40,14 +40,72 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "smtc_modem_hal_dbg_trace.h"
 #include "circularfs.h"
+#include "modem_crc.h"
 
 #ifndef MIN
 #define MIN( a, b ) ( ( ( a ) < ( b ) ) ? ( a ) : ( b ) )
 #endif
 
+/**
+ * @}
+ * @defgroup RAM index
+ * @{
+ */
+#define INDEX_SLOT_ERASED 0   /**< Slot erased, value of a cleared index. */
+#define INDEX_SLOT_RESERVED 1 /**< Write started but not yet committed. */
+#define INDEX_SLOT_VALID 2    /**< Write committed, slot contains valid data. */
+#define INDEX_SLOT_GARBAGE 3  /**< Slot discarded, or slot header corrupted. */
+
+static uint32_t _index_slot_number( struct circularfs* fs, int32_t sector, int32_t slot )
+{
+    return ( uint32_t ) sector * fs->slots_per_sector + slot;
+}
+
+static uint8_t _index_get( struct circularfs* fs, int32_t sector, int32_t slot )
+{
+    uint32_t n = _index_slot_number( fs, sector, slot );
+
+    return ( fs->index_slot_status[n >> 2] >> ( ( n & 0x03 ) * 2 ) ) & 0x03;
+}
+
+/** A slot holds data when valid, or when reserved in record mode as records are written in reserved slots. */
+static bool _index_is_readable( struct circularfs* fs, uint8_t status )
+{
+    return ( status == INDEX_SLOT_VALID ) || ( ( fs->record_mode == true ) && ( status == INDEX_SLOT_RESERVED ) );
+}
+
+/** Update the status of a slot and the readable slots counter of its sector. */
+static void _index_set( struct circularfs* fs, int32_t sector, int32_t slot, uint8_t status )
+{
+    uint32_t n           = _index_slot_number( fs, sector, slot );
+    uint8_t  shift       = ( n & 0x03 ) * 2;
+    uint8_t  old_status  = ( fs->index_slot_status[n >> 2] >> shift ) & 0x03;
+    bool     was_counted = _index_is_readable( fs, old_status );
+    bool     is_counted  = _index_is_readable( fs, status );
+
+    if( ( was_counted == true ) && ( is_counted == false ) )
+    {
+        fs->index_sector_valid[sector]--;
+    }
+    else if( ( was_counted == false ) && ( is_counted == true ) )
+    {
+        fs->index_sector_valid[sector]++;
+    }
+    fs->index_slot_status[n >> 2] = ( fs->index_slot_status[n >> 2] & ~( 0x03 << shift ) ) | ( status << shift );
+}
+
+static void _index_clear_sector( struct circularfs* fs, int32_t sector )
+{
+    for( int32_t slot = 0; slot < fs->slots_per_sector; slot++ )
+    {
+        _index_set( fs, sector, slot, INDEX_SLOT_ERASED );
+    }
+}
+
 /**
  * @}
  * @defgroup sector status
@@ -172,6 +230,11 @@ static int32_t _sector_free( struct circularfs* fs, int32_t sector, bool guard )
     fs->flash->program( fs->flash, sector_addr + offsetof( struct sector_header, version ), &fs->version,
                         sizeof( fs->version ) );
     _sector_set_status( fs, sector, SECTOR_FREE );
+
+    if( fs->index_ready == true )
+    {
+        _index_clear_sector( fs, sector );
+    }
     return 0;
 }
 
@@ -204,7 +267,8 @@ static int32_t _slot_address( struct circularfs* fs, struct circularfs_loc* loc
            ( sizeof( struct slot_header ) + fs->object_size ) * loc->slot;
 }
 
-static int32_t _slot_get_status( struct circularfs* fs, struct circularfs_loc* loc, uint32_t* status )
+/** Read the status of a slot from flash, bypassing the RAM index. */
+static int32_t _slot_read_status( struct circularfs* fs, struct circularfs_loc* loc, uint32_t* status )
 {
     slot_header_t status_tmp;
 
@@ -239,26 +303,199 @@ static int32_t _slot_get_status( struct circularfs* fs, struct circularfs_loc* l
     return ret;
 }
 
+static int32_t _slot_get_status( struct circularfs* fs, struct circularfs_loc* loc, uint32_t* status )
+{
+    static const uint32_t index_to_slot_status[] = { SLOT_ERASED, SLOT_RESERVED, SLOT_VALID, SLOT_GARBAGE };
+
+    if( fs->index_ready == true )
+    {
+        *status = index_to_slot_status[_index_get( fs, loc->sector, loc->slot )];
+        return 0;
+    }
+    return _slot_read_status( fs, loc, status );
+}
+
 static int32_t _slot_set_status( struct circularfs* fs, struct circularfs_loc* loc, uint32_t status )
 {
     uint64_t status_tmp = 0ULL;
+    int32_t  offset;
+    uint8_t  index_status;
+
     if( status == SLOT_RESERVED )
     {
-        return fs->flash->program( fs->flash,
-                                   _slot_address( fs, loc ) + offsetof( struct slot_header, status_reserved ),
-                                   &status_tmp, sizeof( status_tmp ) );
+        offset       = offsetof( struct slot_header, status_reserved );
+        index_status = INDEX_SLOT_RESERVED;
     }
     else if( status == SLOT_VALID )
     {
-        return fs->flash->program( fs->flash, _slot_address( fs, loc ) + offsetof( struct slot_header, status_valid ),
-                                   &status_tmp, sizeof( status_tmp ) );
+        offset       = offsetof( struct slot_header, status_valid );
+        index_status = INDEX_SLOT_VALID;
     }
     else if( status == SLOT_GARBAGE )
     {
-        return fs->flash->program( fs->flash, _slot_address( fs, loc ) + offsetof( struct slot_header, status_garbage ),
-                                   &status_tmp, sizeof( status_tmp ) );
+        offset       = offsetof( struct slot_header, status_garbage );
+        index_status = INDEX_SLOT_GARBAGE;
     }
-    return -1;
+    else
+    {
+        return -1;
+    }
+
+    int32_t ret = fs->flash->program( fs->flash, _slot_address( fs, loc ) + offset, &status_tmp, sizeof( status_tmp ) );
+
+    /* The index must mirror the flash: leave it alone when the status could not be written. */
+    if( ( ret >= 0 ) && ( fs->index_ready == true ) )
+    {
+        _index_set( fs, loc->sector, loc->slot, index_status );
+    }
+    return ret;
+}
+
+/** Fill the RAM index of a sector from the slot headers found in flash. */
+static void _index_build_sector( struct circularfs* fs, int32_t sector, bool in_use )
+{
+    for( int32_t slot = 0; slot < fs->slots_per_sector; slot++ )
+    {
+        uint8_t index_status = INDEX_SLOT_ERASED;
+
+        /* Slots of a FREE sector are erased, don't read them. */
+        if( in_use == true )
+        {
+            struct circularfs_loc loc    = { sector, slot };
+            uint32_t              status = 0;
+
+            if( _slot_read_status( fs, &loc, &status ) < 0 )
+            {
+                /* Corrupted header, e.g. power cut while programming: never a valid slot. */
+                status = SLOT_GARBAGE;
+            }
+            index_status = ( status == SLOT_ERASED )     ? INDEX_SLOT_ERASED
+                           : ( status == SLOT_RESERVED ) ? INDEX_SLOT_RESERVED
+                           : ( status == SLOT_VALID )    ? INDEX_SLOT_VALID
+                                                         : INDEX_SLOT_GARBAGE;
+        }
+        _index_set( fs, sector, slot, index_status );
+    }
+}
+
+static bool _slot_is_readable( struct circularfs* fs, uint32_t status )
+{
+    return ( status == SLOT_VALID ) || ( ( fs->record_mode == true ) && ( status == SLOT_RESERVED ) );
+}
+
+/**
+ * @}
+ * @defgroup record
+ * @{
+ */
+
+// In record mode the data area of a slot holds a sequence of records, each one starting with a record header and a
+// discard mark. A record is programmed once, header first, and its footprint is a multiple of 8 bytes so no flash
+// double word is programmed twice. A torn record is detected by its checksum and skipped, a torn header ends the slot.
+// The discard mark stays erased until the record is discarded while its slot still holds records to be read, it is
+// then programmed so the record is not fetched again after a new scan.
+
+typedef struct record_header
+{
+    uint16_t size;       /**< Record size in bytes, 0xFFFF when erased. */
+    uint16_t size_check; /**< Bitwise inverse of size. */
+    uint32_t checksum;   /**< CRC-32 of the record data. */
+} record_header_t;
+
+/** Discard mark following the record header, any programmed bit means the record is discarded. */
+typedef uint64_t record_mark_t;
+
+#define RECORD_HEADER_ERASED 0 /**< No record yet at this offset. */
+#define RECORD_HEADER_VALID 1  /**< Record found at this offset. */
+#define RECORD_HEADER_END 2    /**< No room or torn header: no more record in this slot. */
+
+static uint32_t _record_footprint( uint32_t size )
+{
+    return sizeof( record_header_t ) + sizeof( record_mark_t ) + ( ( size + 7 ) & ~7UL );
+}
+
+static int32_t _record_address( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset )
+{
+    return _slot_address( fs, loc ) + sizeof( struct slot_header ) + offset;
+}
+
+static int32_t _record_read_header( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset,
+                                    record_header_t* header )
+{
+    if( offset + ( int32_t ) sizeof( record_header_t ) >= fs->object_size )
+    {
+        return RECORD_HEADER_END;
+    }
+
+    fs->flash->read( fs->flash, _record_address( fs, loc, offset ), header, sizeof( record_header_t ) );
+
+    if( ( header->size == 0xFFFF ) && ( header->size_check == 0xFFFF ) && ( header->checksum == 0xFFFFFFFF ) )
+    {
+        return RECORD_HEADER_ERASED;
+    }
+    if( ( ( uint16_t ) ( header->size ^ header->size_check ) != 0xFFFF ) || ( header->size == 0 ) ||
+        ( offset + ( int32_t ) _record_footprint( header->size ) > fs->object_size ) )
+    {
+        return RECORD_HEADER_END;
+    }
+    return RECORD_HEADER_VALID;
+}
+
+static int32_t _record_data_address( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset )
+{
+    return _record_address( fs, loc, offset ) + sizeof( record_header_t ) + sizeof( record_mark_t );
+}
+
+static bool _record_is_discarded( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset )
+{
+    record_mark_t mark;
+
+    fs->flash->read( fs->flash, _record_address( fs, loc, offset ) + sizeof( record_header_t ), &mark,
+                     sizeof( mark ) );
+    return mark != ~0ULL;
+}
+
+/** Mark the records of a slot from offset up to offset_end as discarded, already discarded records are skipped. */
+static void _record_discard( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset, int32_t offset_end )
+{
+    record_header_t header;
+    record_mark_t   mark = 0ULL;
+
+    while( ( offset < offset_end ) && ( _record_read_header( fs, loc, offset, &header ) == RECORD_HEADER_VALID ) )
+    {
+        if( _record_is_discarded( fs, loc, offset ) == false )
+        {
+            fs->flash->program( fs->flash, _record_address( fs, loc, offset ) + sizeof( record_header_t ), &mark,
+                                sizeof( mark ) );
+        }
+        offset += _record_footprint( header.size );
+    }
+}
+
+/** Get the offset of the first record not discarded in a slot, starting from offset. */
+static int32_t _record_skip_discarded( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset )
+{
+    record_header_t header;
+
+    while( ( _record_read_header( fs, loc, offset, &header ) == RECORD_HEADER_VALID ) &&
+           ( _record_is_discarded( fs, loc, offset ) == true ) )
+    {
+        offset += _record_footprint( header.size );
+    }
+    return offset;
+}
+
+/** Check if a location is the slot still open for new records. */
+static bool _record_is_open_slot( struct circularfs* fs, struct circularfs_loc* loc )
+{
+    return ( fs->record_open == true ) && ( fs->record_slot.sector == loc->sector ) &&
+           ( fs->record_slot.slot == loc->slot );
+}
+
+/** Unread slots between loc and the write head do not include the open slot once all its records are read. */
+static int32_t _record_open_slot_done( struct circularfs* fs, struct circularfs_loc* loc, int32_t offset )
+{
+    return ( ( _record_is_open_slot( fs, loc ) == true ) && ( offset >= fs->record_write_offset ) ) ? 1 : 0;
 }
 
 /**
@@ -293,6 +530,160 @@ static void _loc_advance_slot( struct circularfs* fs, struct circularfs_loc* loc
     }
 }
 
+/**
+ * Advance a location to the next valid slot (readable slot in record mode), or up to end if there is none.
+ * With the RAM index, sectors without valid slot are skipped at once.
+ */
+static void _loc_seek_valid( struct circularfs* fs, struct circularfs_loc* loc, struct circularfs_loc* end )
+{
+    while( !_loc_equal( loc, end ) )
+    {
+        if( ( fs->index_ready == true ) && ( loc->slot == 0 ) && ( loc->sector != end->sector ) &&
+            ( fs->index_sector_valid[loc->sector] == 0 ) )
+        {
+            _loc_advance_sector( fs, loc );
+            continue;
+        }
+
+        uint32_t status = 0;
+        _slot_get_status( fs, loc, &status );
+        if( _slot_is_readable( fs, status ) == true )
+        {
+            break;
+        }
+
+        _loc_advance_slot( fs, loc );
+    }
+}
+
+/**
+ * Count the valid slots (readable slots in record mode) from a location up to end.
+ * With the RAM index, whole sectors are counted with their valid slots counter.
+ */
+static int32_t _loc_count_valid( struct circularfs* fs, struct circularfs_loc* from, struct circularfs_loc* end )
+{
+    int32_t count = 0;
+
+    /* Use a temporary loc for iteration. */
+    struct circularfs_loc loc = *from;
+    while( !_loc_equal( &loc, end ) )
+    {
+        if( ( fs->index_ready == true ) && ( loc.slot == 0 ) && ( loc.sector != end->sector ) )
+        {
+            count += fs->index_sector_valid[loc.sector];
+            _loc_advance_sector( fs, &loc );
+            continue;
+        }
+
+        uint32_t status = 0;
+        _slot_get_status( fs, &loc, &status );
+        if( _slot_is_readable( fs, status ) == true )
+        {
+            count++;
+        }
+
+        _loc_advance_slot( fs, &loc );
+    }
+
+    return count;
+}
+
+/**
+ * Mark the slot at the write head as reserved. The next sector is freed first if needed to keep a FREE sector
+ * at all times.
+ */
+static int32_t _slot_reserve( struct circularfs* fs )
+{
+    uint32_t status;
+
+    /*
+     * There are three sectors involved in appending a value:
+     * - the sector where the append happens: it has to be writable
+     * - the next sector: it must be free (invariant)
+     * - the next-next sector: read & cursor heads are moved there if needed
+     */
+    ///////////////////////////////////////
+    ////////////
+    /* Make sure the next sector is free. */
+    int32_t next_sector = ( fs->write.sector + 1 ) % fs->flash->sector_count;
+    _sector_get_status( fs, next_sector, &status );
+    if( status != SECTOR_FREE )
+    {
+        /* Next sector must be freed. But first... */
+
+        /* Move the read & cursor heads out of the way. */
+        if( fs->read.sector == next_sector )
+        {
+            _loc_advance_sector( fs, &fs->read );
+            fs->record_read_offset = 0;
+        }
+        if( fs->cursor.sector == next_sector )
+        {
+            _loc_advance_sector( fs, &fs->cursor );
+            fs->record_cursor_offset = 0;
+        }
+
+        /* Free the next sector. */
+        _sector_free( fs, next_sector, true );
+    }
+    ////////////
+    ///////////////////////////////////////
+
+    /* Now we can make sure the current write sector is writable. */
+    _sector_get_status( fs, fs->write.sector, &status );
+    if( status == SECTOR_FREE )
+    {
+        /* Free sector. Mark as used. */
+        _sector_set_status( fs, fs->write.sector, SECTOR_IN_USE );
+    }
+    else if( status != SECTOR_IN_USE )
+    {
+        SMTC_MODEM_HAL_TRACE_PRINTF( "circularfs_append: corrupted filesystem\n" );
+        return -1;
+    }
+
+    /* Preallocate slot. */
+    _slot_set_status( fs, &fs->write, SLOT_RESERVED );
+
+    return 0;
+}
+
+/**
+ * Reopen the slot preceding the write head after a scan in record mode, if its records end cleanly.
+ */
+static void _record_reopen( struct circularfs* fs )
+{
+    struct circularfs_loc loc    = { fs->write.sector, fs->write.slot - 1 };
+    uint32_t              status = 0;
+    int32_t               offset = 0;
+    record_header_t       header;
+
+    fs->record_open = false;
+    if( fs->write.slot == 0 )
+    {
+        return;
+    }
+    _slot_get_status( fs, &loc, &status );
+    if( status != SLOT_RESERVED )
+    {
+        return;
+    }
+
+    int32_t header_status = _record_read_header( fs, &loc, offset, &header );
+    while( header_status == RECORD_HEADER_VALID )
+    {
+        offset += _record_footprint( header.size );
+        header_status = _record_read_header( fs, &loc, offset, &header );
+    }
+
+    if( header_status == RECORD_HEADER_ERASED )
+    {
+        fs->record_open         = true;
+        fs->record_slot         = loc;
+        fs->record_write_offset = offset;
+    }
+}
+
 /**
  * @}
  */
@@ -314,11 +705,71 @@ int32_t circularfs_init( struct circularfs* fs, struct circularfs_flash_partitio
     fs->slots_per_sector = ( fs->flash->sector_size - sizeof( struct sector_header ) ) /
                            ( sizeof( struct slot_header ) + fs->object_size );
 
+    /* No RAM index until circularfs_set_index() is called. */
+    fs->index_sector_valid = NULL;
+    fs->index_slot_status  = NULL;
+    fs->index_ready        = false;
+
+    fs->record_mode          = false;
+    fs->record_open          = false;
+    fs->record_write_offset  = 0;
+    fs->record_read_offset   = 0;
+    fs->record_cursor_offset = 0;
+
+    return 0;
+}
+
+int32_t circularfs_init_records( struct circularfs* fs, struct circularfs_flash_partition* flash, uint32_t version,
+                                 int32_t slot_size )
+{
+    /* Records are aligned on 8 bytes, as the data area of each slot. */
+    if( ( slot_size % 8 ) != 0 )
+    {
+        return -1;
+    }
+
+    circularfs_init( fs, flash, version, slot_size );
+    fs->record_mode = true;
+
+    return 0;
+}
+
+int32_t circularfs_get_record_size_max( struct circularfs* fs )
+{
+    return fs->object_size - sizeof( record_header_t ) - sizeof( record_mark_t );
+}
+
+uint32_t circularfs_get_index_size( struct circularfs* fs )
+{
+    uint32_t slot_count = ( uint32_t ) fs->flash->sector_count * fs->slots_per_sector;
+
+    return fs->flash->sector_count * sizeof( uint16_t ) + ( slot_count + 3 ) / 4;
+}
+
+int32_t circularfs_set_index( struct circularfs* fs, void* buffer, uint32_t size )
+{
+    fs->index_ready = false;
+
+    if( ( buffer == NULL ) || ( size < circularfs_get_index_size( fs ) ) )
+    {
+        fs->index_sector_valid = NULL;
+        fs->index_slot_status  = NULL;
+        return -1;
+    }
+
+    /* A cleared index is consistent: all slots erased and no valid slot counted. */
+    memset( buffer, 0, circularfs_get_index_size( fs ) );
+    fs->index_sector_valid = ( uint16_t* ) buffer;
+    fs->index_slot_status  = ( uint8_t* ) buffer + fs->flash->sector_count * sizeof( uint16_t );
+
     return 0;
 }
 
 int32_t circularfs_format( struct circularfs* fs, bool guard )
 {
+    /* Sectors are cleared in the index as they are freed. */
+    fs->index_ready = ( fs->index_sector_valid != NULL );
+
     if( guard == true )
     {
         /* Mark all sectors to prevent half-erased filesystems. */
@@ -342,6 +793,10 @@ int32_t circularfs_format( struct circularfs* fs, bool guard )
     fs->cursor.sector = 0;
     fs->cursor.slot   = 0;
 
+    fs->record_open          = false;
+    fs->record_read_offset   = 0;
+    fs->record_cursor_offset = 0;
+
     return 0;
 }
 
@@ -359,6 +814,9 @@ int32_t circularfs_scan( struct circularfs* fs )
     /* If there's no IN_USE sector, we start at the first one. */
     bool used_seen = false;
 
+    /* The index is rebuilt from flash, it is only trusted once all sectors are scanned. */
+    fs->index_ready = false;
+
     /* Iterate over sectors. */
     for( int32_t sector = 0; sector < fs->flash->sector_count; sector++ )
     {
@@ -426,6 +884,11 @@ int32_t circularfs_scan( struct circularfs* fs )
             write_sector = sector - 1;
         }
 
+        if( fs->index_sector_valid != NULL )
+        {
+            _index_build_sector( fs, sector, header_status == SECTOR_IN_USE );
+        }
+
         previous_sector_status = header_status;
     }
 
@@ -440,6 +903,8 @@ int32_t circularfs_scan( struct circularfs* fs )
     ////////////
     ///////////////////////////////////////
 
+    fs->index_ready = ( fs->index_sector_valid != NULL );
+
     /* Start writing at the first sector if the filesystem is empty. */
     if( !used_seen )
     {
@@ -467,21 +932,24 @@ int32_t circularfs_scan( struct circularfs* fs )
      * the write head which means there's no data. */
     fs->read.sector = read_sector;
     fs->read.slot   = 0;
-    while( !_loc_equal( &fs->read, &fs->write ) )
+    _loc_seek_valid( fs, &fs->read, &fs->write );
+
+    /* Move the read cursor to the read head position. */
+    fs->cursor = fs->read;
+
+    /* Records may still be appended after the last one, read from the first record not yet discarded. */
+    fs->record_read_offset   = 0;
+    fs->record_cursor_offset = 0;
+    if( fs->record_mode == true )
     {
-        uint32_t status;
-        _slot_get_status( fs, &fs->read, &status );
-        if( status == SLOT_VALID )
+        _record_reopen( fs );
+        if( !_loc_equal( &fs->read, &fs->write ) )
         {
-            break;
+            fs->record_read_offset   = _record_skip_discarded( fs, &fs->read, 0 );
+            fs->record_cursor_offset = fs->record_read_offset;
         }
-
-        _loc_advance_slot( fs, &fs->read );
     }
 
-    /* Move the read cursor to the read head position. */
-    fs->cursor = fs->read;
-
     return 0;
 }
 
@@ -508,145 +976,196 @@ int32_t circularfs_count_estimate( struct circularfs* fs )
 {
     int32_t sector_diff = ( fs->write.sector - fs->read.sector + fs->flash->sector_count ) % fs->flash->sector_count;
 
-    return sector_diff * fs->slots_per_sector + fs->write.slot - fs->read.slot;
+    return sector_diff * fs->slots_per_sector + fs->write.slot - fs->read.slot -
+           _record_open_slot_done( fs, &fs->read, fs->record_read_offset );
 }
 
 int32_t circularfs_count_estimate_from_last_fetch( struct circularfs* fs )
 {
     int32_t sector_diff = ( fs->write.sector - fs->cursor.sector + fs->flash->sector_count ) % fs->flash->sector_count;
 
-    return sector_diff * fs->slots_per_sector + fs->write.slot - fs->cursor.slot;
+    return sector_diff * fs->slots_per_sector + fs->write.slot - fs->cursor.slot -
+           _record_open_slot_done( fs, &fs->cursor, fs->record_cursor_offset );
 }
 
 int32_t circularfs_count_exact( struct circularfs* fs )
 {
-    int32_t count = 0;
+    return _loc_count_valid( fs, &fs->read, &fs->write );
+}
 
-    /* Use a temporary loc for iteration. */
-    struct circularfs_loc loc = fs->read;
-    while( !_loc_equal( &loc, &fs->write ) )
-    {
-        uint32_t status = 0;
-        _slot_get_status( fs, &loc, &status );
+int32_t circularfs_count_exact_from_last_fetch( struct circularfs* fs )
+{
+    return _loc_count_valid( fs, &fs->cursor, &fs->write );
+}
 
-        if( status == SLOT_VALID )
-        {
-            count++;
-        }
+int32_t circularfs_append( struct circularfs* fs, const void* object )
+{
+    if( fs->record_mode == true )
+    {
+        return -1;
+    }
 
-        _loc_advance_slot( fs, &loc );
+    /* Preallocate slot. */
+    if( _slot_reserve( fs ) != 0 )
+    {
+        return -1;
     }
 
-    return count;
+    /* Write object. */
+    fs->flash->program( fs->flash, _slot_address( fs, &fs->write ) + sizeof( struct slot_header ), object,
+                        fs->object_size );
+
+    /* Commit write. */
+    _slot_set_status( fs, &fs->write, SLOT_VALID );
+
+    /* Advance the write head. */
+    _loc_advance_slot( fs, &fs->write );
+
+    return 0;
 }
 
-int32_t circularfs_count_exact_from_last_fetch( struct circularfs* fs )
+int32_t circularfs_append_record( struct circularfs* fs, const void* record, int32_t size )
 {
-    int32_t count = 0;
+    record_header_t header;
 
-    /* Use a temporary loc for iteration. */
-    struct circularfs_loc loc = fs->cursor;
-    while( !_loc_equal( &loc, &fs->write ) )
+    if( ( fs->record_mode == false ) || ( size <= 0 ) || ( size > circularfs_get_record_size_max( fs ) ) )
     {
-        uint32_t status = 0;
-        _slot_get_status( fs, &loc, &status );
+        return -1;
+    }
 
-        if( status == SLOT_VALID )
+    /* Close the open slot if the record does not fit, the rest of the slot stays erased. */
+    if( ( fs->record_open == true ) &&
+        ( fs->record_write_offset + ( int32_t ) _record_footprint( size ) > fs->object_size ) )
+    {
+        fs->record_open = false;
+    }
+
+    if( fs->record_open == false )
+    {
+        if( _slot_reserve( fs ) != 0 )
         {
-            count++;
+            return -1;
         }
+        fs->record_open         = true;
+        fs->record_slot         = fs->write;
+        fs->record_write_offset = 0;
 
-        _loc_advance_slot( fs, &loc );
+        /* Advance the write head, records are written behind it in the open slot. */
+        _loc_advance_slot( fs, &fs->write );
     }
 
-    return count;
+    header.size       = size;
+    header.size_check = ~header.size;
+    header.checksum   = modem_crc32( record, size );
+
+    /* Header first: a record torn while writing its data is then skipped thanks to its checksum. The discard mark
+     * is left erased. */
+    fs->flash->program( fs->flash, _record_address( fs, &fs->record_slot, fs->record_write_offset ), &header,
+                        sizeof( header ) );
+    fs->flash->program( fs->flash, _record_data_address( fs, &fs->record_slot, fs->record_write_offset ), record,
+                        size );
+
+    fs->record_write_offset += _record_footprint( size );
+
+    return 0;
 }
 
-int32_t circularfs_append( struct circularfs* fs, const void* object )
+int32_t circularfs_fetch_record( struct circularfs* fs, void* record, int32_t size_max )
 {
-    uint32_t status;
+    record_header_t header;
 
-    /*
-     * There are three sectors involved in appending a value:
-     * - the sector where the append happens: it has to be writable
-     * - the next sector: it must be free (invariant)
-     * - the next-next sector: read & cursor heads are moved there if needed
-     */
-    ///////////////////////////////////////
-    ////////////
-    /* Make sure the next sector is free. */
-    int32_t next_sector = ( fs->write.sector + 1 ) % fs->flash->sector_count;
-    _sector_get_status( fs, next_sector, &status );
-    if( status != SECTOR_FREE )
+    if( fs->record_mode == false )
     {
-        /* Next sector must be freed. But first... */
+        return -1;
+    }
 
-        /* Move the read & cursor heads out of the way. */
-        if( fs->read.sector == next_sector )
+    while( !_loc_equal( &fs->cursor, &fs->write ) )
+    {
+        /* Advance forward in search of a slot holding records. */
+        if( fs->record_cursor_offset == 0 )
         {
-            _loc_advance_sector( fs, &fs->read );
+            _loc_seek_valid( fs, &fs->cursor, &fs->write );
+            if( _loc_equal( &fs->cursor, &fs->write ) )
+            {
+                break;
+            }
         }
-        if( fs->cursor.sector == next_sector )
+
+        if( _record_read_header( fs, &fs->cursor, fs->record_cursor_offset, &header ) != RECORD_HEADER_VALID )
         {
-            _loc_advance_sector( fs, &fs->cursor );
+            /* All records of the open slot are read, wait for the next ones. */
+            if( _record_is_open_slot( fs, &fs->cursor ) == true )
+            {
+                break;
+            }
+            _loc_advance_slot( fs, &fs->cursor );
+            fs->record_cursor_offset = 0;
+            continue;
         }
 
-        /* Free the next sector. */
-        _sector_free( fs, next_sector, true );
-    }
-    ////////////
-    ///////////////////////////////////////
+        int32_t offset = fs->record_cursor_offset;
+        int32_t size   = header.size;
+        fs->record_cursor_offset += _record_footprint( size );
 
-    /* Now we can make sure the current write sector is writable. */
-    _sector_get_status( fs, fs->write.sector, &status );
-    if( status == SECTOR_FREE )
-    {
-        /* Free sector. Mark as used. */
-        _sector_set_status( fs, fs->write.sector, SECTOR_IN_USE );
-    }
-    else if( status != SECTOR_IN_USE )
-    {
-        SMTC_MODEM_HAL_TRACE_PRINTF( "circularfs_append: corrupted filesystem\n" );
-        return -1;
-    }
+        if( _record_is_discarded( fs, &fs->cursor, offset ) == true )
+        {
+            continue;
+        }
+        if( size > size_max )
+        {
+            SMTC_MODEM_HAL_TRACE_PRINTF( "circularfs_fetch_record: record too large (%d)\n", size );
+            continue;
+        }
 
-    /* Preallocate slot. */
-    _slot_set_status( fs, &fs->write, SLOT_RESERVED );
+        fs->flash->read( fs->flash, _record_data_address( fs, &fs->cursor, offset ), record, size );
+        if( modem_crc32( record, size ) != header.checksum )
+        {
+            SMTC_MODEM_HAL_TRACE_PRINTF( "circularfs_fetch_record: corrupted record\n" );
+            continue;
+        }
 
-    /* Write object. */
-    fs->flash->program( fs->flash, _slot_address( fs, &fs->write ) + sizeof( struct slot_header ), object,
-                        fs->object_size );
+        /* Leave a slot as soon as its last record is read so it is discarded with it. */
+        if( ( _record_is_open_slot( fs, &fs->cursor ) == false ) &&
+            ( _record_read_header( fs, &fs->cursor, fs->record_cursor_offset, &header ) != RECORD_HEADER_VALID ) )
+        {
+            _loc_advance_slot( fs, &fs->cursor );
+            fs->record_cursor_offset = 0;
+        }
+        return size;
+    }
 
-    /* Commit write. */
-    _slot_set_status( fs, &fs->write, SLOT_VALID );
+    return -1;
+}
 
-    /* Advance the write head. */
-    _loc_advance_slot( fs, &fs->write );
+int32_t circularfs_peek_record( struct circularfs* fs, void* record, int32_t size_max )
+{
+    struct circularfs_loc cursor        = fs->cursor;
+    int32_t               cursor_offset = fs->record_cursor_offset;
+    int32_t               size          = circularfs_fetch_record( fs, record, size_max );
 
-    return 0;
+    fs->cursor               = cursor;
+    fs->record_cursor_offset = cursor_offset;
+    return size;
 }
 
 int32_t circularfs_fetch( struct circularfs* fs, void* object )
 {
-    /* Advance forward in search of a valid slot. */
-    while( !_loc_equal( &fs->cursor, &fs->write ) )
+    if( fs->record_mode == true )
     {
-        uint32_t status = 0;
-
-        _slot_get_status( fs, &fs->cursor, &status );
-
-        if( status == SLOT_VALID )
-        {
-            fs->flash->read( fs->flash, _slot_address( fs, &fs->cursor ) + sizeof( struct slot_header ), object,
-                             fs->object_size );
-            _loc_advance_slot( fs, &fs->cursor );
-            return 0;
-        }
+        return -1;
+    }
 
-        _loc_advance_slot( fs, &fs->cursor );
+    /* Advance forward in search of a valid slot. */
+    _loc_seek_valid( fs, &fs->cursor, &fs->write );
+    if( _loc_equal( &fs->cursor, &fs->write ) )
+    {
+        return -1;
     }
 
-    return -1;
+    fs->flash->read( fs->flash, _slot_address( fs, &fs->cursor ) + sizeof( struct slot_header ), object,
+                     fs->object_size );
+    _loc_advance_slot( fs, &fs->cursor );
+    return 0;
 }
 
 int32_t circularfs_discard( struct circularfs* fs )
@@ -655,8 +1174,16 @@ int32_t circularfs_discard( struct circularfs* fs )
     {
         _slot_set_status( fs, &fs->read, SLOT_GARBAGE );
         _loc_advance_slot( fs, &fs->read );
+        fs->record_read_offset = 0;
     }
 
+    /* The slot of the cursor still holds records to be read: discard the fetched ones one by one. */
+    if( ( fs->record_mode == true ) && ( fs->record_cursor_offset > fs->record_read_offset ) )
+    {
+        _record_discard( fs, &fs->cursor, fs->record_read_offset, fs->record_cursor_offset );
+    }
+    fs->record_read_offset = fs->record_cursor_offset;
+
     return 0;
 }
 
@@ -666,6 +1193,11 @@ int32_t circularfs_discard_item_x_from_head_position( struct circularfs* fs, uin
     /* Use a temporary loc for iteration. */
     struct circularfs_loc loc = fs->read;
 
+    if( fs->record_mode == true )
+    {
+        return -1;
+    }
+
     while( ( !_loc_equal( &loc, &fs->cursor ) ) && ( count < ( sizeof( item_x_bitfield ) * 8 ) ) )
     {
         /* garbage requested data */
@@ -691,24 +1223,15 @@ int32_t circularfs_discard_item_x_from_head_position( struct circularfs* fs, uin
     }
 
     /* Move the read cursor to the next valid data */
-    while( !_loc_equal( &fs->read, &fs->write ) )
-    {
-        uint32_t status;
-        _slot_get_status( fs, &fs->read, &status );
-        if( status == SLOT_VALID )
-        {
-            break;
-        }
-
-        _loc_advance_slot( fs, &fs->read );
-    }
+    _loc_seek_valid( fs, &fs->read, &fs->write );
 
     return 0;
 }
 
 int32_t circularfs_rewind( struct circularfs* fs )
 {
-    fs->cursor = fs->read;
+    fs->cursor               = fs->read;
+    fs->record_cursor_offset = fs->record_read_offset;
     return 0;
 }
 
@@ -764,7 +1287,7 @@ void circularfs_dump( struct circularfs* fs )
         {
             struct circularfs_loc loc    = { sector, slot };
             uint32_t              status = 0;
-            _slot_get_status( fs, &loc, &status );
+            _slot_read_status( fs, &loc, &status );
             switch( status )
             {
             case SLOT_ERASED:
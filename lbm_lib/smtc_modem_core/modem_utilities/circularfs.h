@@ -45,6 +45,7 @@ extern "C" {
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 /*
@@ -119,6 +120,19 @@ struct circularfs
     struct circularfs_loc read;
     struct circularfs_loc write;
     struct circularfs_loc cursor;
+
+    /* Optional RAM index of the slots status, see circularfs_set_index(). */
+    uint16_t* index_sector_valid; /* Number of valid slots per sector. */
+    uint8_t*  index_slot_status;  /* Status of each slot, 2 bits per slot. */
+    bool      index_ready;        /* Index built by circularfs_scan() or circularfs_format(). */
+
+    /* Record mode, see circularfs_init_records(). */
+    bool                  record_mode;
+    bool                  record_open;          /* record_slot accepts new records. */
+    struct circularfs_loc record_slot;          /* Slot preceding the write head where records are appended. */
+    int32_t               record_write_offset;  /* Offset of the next record in record_slot. */
+    int32_t               record_read_offset;   /* Offset of the first record not discarded in the read slot. */
+    int32_t               record_cursor_offset; /* Offset of the next record to fetch in the cursor slot. */
 };
 
 /*
@@ -140,6 +154,55 @@ struct circularfs
 int32_t circularfs_init( struct circularfs* fs, struct circularfs_flash_partition* flash, uint32_t version,
                          int32_t object_size );
 
+/**
+ * Initialize a RingFS instance in record mode, used with the circularfs_*_record()
+ * functions instead of circularfs_append() and circularfs_fetch().
+ *
+ * In record mode each slot holds several variable-length records, each one
+ * protected by its own header and checksum. A slot is reserved when its first
+ * record is written and discarded once all its records are fetched; counts and
+ * capacity are given in slots.
+ *
+ * @param fs RingFS instance to be initialized.
+ * @param flash Flash memory interface. Must be implemented externally.
+ * @param version Object version, shall differ from the fixed-size objects one.
+ * @param slot_size Size of the data area of a slot, in bytes, multiple of 8.
+ * @returns Zero on success, -1 on failure.
+ */
+int32_t circularfs_init_records( struct circularfs* fs, struct circularfs_flash_partition* flash, uint32_t version,
+                                 int32_t slot_size );
+
+/**
+ * Get the size of the largest record accepted in record mode.
+ *
+ * @param fs Initialized RingFS instance.
+ * @returns Maximum record size in bytes.
+ */
+int32_t circularfs_get_record_size_max( struct circularfs* fs );
+
+/**
+ * Get the size of the buffer needed by the optional RAM index.
+ *
+ * @param fs Initialized RingFS instance.
+ * @returns Index size in bytes.
+ */
+uint32_t circularfs_get_index_size( struct circularfs* fs );
+
+/**
+ * Attach a RAM index to the instance. Must be called after circularfs_init() and
+ * before circularfs_scan() or circularfs_format(), which build the index.
+ *
+ * The index keeps the status of every slot and the number of valid slots of every
+ * sector so slots status are no longer read from flash: seeking a valid object
+ * and counting objects skip sectors without valid slot and only access RAM.
+ *
+ * @param fs Initialized RingFS instance.
+ * @param buffer Index buffer, 16-bit aligned, kept by the instance.
+ * @param size Size of buffer, in bytes.
+ * @returns Zero on success, -1 if buffer is too small (the index stays disabled).
+ */
+int32_t circularfs_set_index( struct circularfs* fs, void* buffer, uint32_t size );
+
 /**
  * Format the flash memory.
  *
@@ -180,7 +243,7 @@ int32_t circularfs_count_estimate_from_last_fetch( struct circularfs* fs );
 
 /**
  * Calculate exact object count.
- * Runs in O(n).
+ * Runs in O(n), or in O(sectors) with a RAM index.
  *
  * @param fs Initialized RingFS instance.
  * @returns Exact object count on success, -1 on failure.
@@ -198,6 +261,17 @@ int32_t circularfs_count_exact_from_last_fetch( struct circularfs* fs );
  */
 int32_t circularfs_append( struct circularfs* fs, const void* object );
 
+/**
+ * Append a record at the end of the ring (record mode). Records are packed in
+ * the current slot, a new slot is used when the record does not fit.
+ *
+ * @param fs Initialized RingFS instance.
+ * @param record Record to be stored.
+ * @param size Size of the record, up to circularfs_get_record_size_max().
+ * @returns Zero on success, -1 on failure.
+ */
+int32_t circularfs_append_record( struct circularfs* fs, const void* record, int32_t size );
+
 /**
  * Fetch next object from the ring, oldest-first. Advances read cursor.
  *
@@ -208,7 +282,31 @@ int32_t circularfs_append( struct circularfs* fs, const void* object );
 int32_t circularfs_fetch( struct circularfs* fs, void* object );
 
 /**
- * Discard all fetched objects up to the read cursor.
+ * Fetch next record from the ring, oldest-first (record mode). Advances read
+ * cursor. Corrupted records are skipped.
+ *
+ * @param fs Initialized RingFS instance.
+ * @param record Buffer to store retrieved record.
+ * @param size_max Size of the buffer, larger records are skipped.
+ * @returns Size of the record on success, -1 if there is no record.
+ */
+int32_t circularfs_fetch_record( struct circularfs* fs, void* record, int32_t size_max );
+
+/**
+ * Read the record circularfs_fetch_record() would return, without advancing
+ * the read cursor (record mode).
+ *
+ * @param fs Initialized RingFS instance.
+ * @param record Buffer to store retrieved record.
+ * @param size_max Size of the buffer, larger records are skipped.
+ * @returns Size of the record on success, -1 if there is no record.
+ */
+int32_t circularfs_peek_record( struct circularfs* fs, void* record, int32_t size_max );
+
+/**
+ * Discard all fetched objects up to the read cursor. In record mode the records
+ * of a partially fetched slot are marked one by one, they are not fetched again
+ * after the next circularfs_scan().
  *
  * @param fs Initialized RingFS instance.
  * @returns Zero on success, -1 on failure.
@@ -72,6 +72,16 @@ static fifo_return_status_t ctrl_set( fifo_ctrl_t* ctrl, const uint8_t* buffer,
 static fifo_return_status_t ctrl_get( fifo_ctrl_t* ctrl, uint8_t* buffer, uint16_t* data_len,
                                       const uint16_t data_buffer_size, void* metadata, uint8_t* metadata_len,
                                       const uint8_t metadata_buffer_size );
+
+static fifo_return_status_t ctrl_peek( const fifo_ctrl_t* ctrl, fifo_ctrl_span_t* data, fifo_ctrl_span_t* metadata );
+
+static void ctrl_consume( fifo_ctrl_t* ctrl, const fifo_ctrl_span_t* data, const fifo_ctrl_span_t* metadata );
+
+static void ctrl_write( fifo_ctrl_t* ctrl, const uint8_t* src, uint16_t len );
+
+static void ctrl_span( const fifo_ctrl_t* ctrl, uint16_t offset, uint16_t len, fifo_ctrl_span_t* span );
+
+static inline uint16_t ctrl_wrap( const fifo_ctrl_t* ctrl, uint32_t offset );
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -81,6 +91,7 @@ void fifo_ctrl_init( fifo_ctrl_t* ctrl, uint8_t* buffer, const uint16_t buffer_s
 {
     ctrl->buffer      = buffer;
     ctrl->buffer_size = buffer_size;
+    ctrl->wrap_mask   = ( ( buffer_size & ( buffer_size - 1 ) ) == 0 ) ? ( buffer_size - 1 ) : 0;
     fifo_ctrl_clear( ctrl );
 }
 
@@ -93,8 +104,8 @@ void fifo_ctrl_clear( fifo_ctrl_t* ctrl )
     ctrl->read_cnt     = 0;
     ctrl->drop_cnt     = 0;
     ctrl->free_space   = ctrl->buffer_size;
+    ctrl->peeked       = false;
 }
-
 void fifo_ctrl_print_stat( const fifo_ctrl_t* ctrl )
 {
     SMTC_MODEM_HAL_TRACE_INFO_DEBUG( "----------------------------------\n" );
@@ -125,6 +136,11 @@ fifo_return_status_t fifo_ctrl_get( fifo_ctrl_t* ctrl, uint8_t* buffer, uint16_t
     smtc_modem_hal_disable_modem_irq( );
     fifo_return_status_t ret =
         ctrl_get( ctrl, buffer, data_len, data_buffer_size, metadata, metadata_len, metadata_buffer_size );
+    if( ret == FIFO_STATUS_OK )
+    {
+        // The peeked element, if any, has been removed
+        ctrl->peeked = false;
+    }
     smtc_modem_hal_enable_modem_irq( );
 
     return ret;
@@ -139,6 +155,50 @@ fifo_return_status_t fifo_ctrl_set( fifo_ctrl_t* ctrl, const uint8_t* buffer, co
     return ret;
 }
 
+fifo_return_status_t fifo_ctrl_peek( fifo_ctrl_t* ctrl, fifo_ctrl_span_t* data, fifo_ctrl_span_t* metadata )
+{
+    if( ( data == NULL ) || ( metadata == NULL ) )
+    {
+        return FIFO_STATUS_PARAM_ERROR;
+    }
+
+    smtc_modem_hal_disable_modem_irq( );
+    fifo_return_status_t ret = ctrl_peek( ctrl, data, metadata );
+    if( ret == FIFO_STATUS_OK )
+    {
+        ctrl->peeked = true;
+    }
+    smtc_modem_hal_enable_modem_irq( );
+    return ret;
+}
+
+fifo_return_status_t fifo_ctrl_consume( fifo_ctrl_t* ctrl )
+{
+    fifo_ctrl_span_t     data;
+    fifo_ctrl_span_t     metadata;
+    fifo_return_status_t ret = FIFO_STATUS_PARAM_ERROR;
+
+    smtc_modem_hal_disable_modem_irq( );
+    if( ( ctrl->peeked == true ) && ( ctrl_peek( ctrl, &data, &metadata ) == FIFO_STATUS_OK ) )
+    {
+        ctrl_consume( ctrl, &data, &metadata );
+        ctrl->peeked = false;
+        ret          = FIFO_STATUS_OK;
+    }
+    smtc_modem_hal_enable_modem_irq( );
+    return ret;
+}
+
+uint16_t fifo_ctrl_span_copy( const fifo_ctrl_span_t* span, void* dest )
+{
+    memcpy( dest, span->part1, span->part1_len );
+    if( span->part2_len != 0 )
+    {
+        memcpy( ( uint8_t* ) dest + span->part1_len, span->part2, span->part2_len );
+    }
+    return span->part1_len + span->part2_len;
+}
+
 static fifo_return_status_t ctrl_set( fifo_ctrl_t* ctrl, const uint8_t* buffer, const uint16_t buffer_len,
                                       const void* metadata, const uint8_t metadata_len )
 {
@@ -151,58 +211,25 @@ static fifo_return_status_t ctrl_set( fifo_ctrl_t* ctrl, const uint8_t* buffer,
 
     while( ctrl->free_space < total_write_len )
     {
+        // The peeked element is read in place, it cannot be overwritten
+        if( ctrl->peeked == true )
+        {
+            return FIFO_STATUS_BUFFER_TOO_SMALL;
+        }
+
         // Not enough free space --> Remove oldest
         ctrl_get( ctrl, NULL, NULL, 0, NULL, NULL, 0 );
         ctrl->drop_cnt += 1;
     }
 
-    // Write data length - 2 bytes MSB first
-    ctrl->buffer[ctrl->write_offset] = ( uint8_t )( buffer_len >> 8 );
-    ctrl->write_offset += 1;
-    ctrl->write_offset %= ctrl->buffer_size;
-    ctrl->buffer[ctrl->write_offset] = ( uint8_t )( buffer_len );
-    ctrl->write_offset += 1;
-    ctrl->write_offset %= ctrl->buffer_size;
-
-    // Write metadata length
-    ctrl->buffer[ctrl->write_offset] = metadata_len;
-    ctrl->write_offset += 1;
-    ctrl->write_offset %= ctrl->buffer_size;
-
-    // Write metadata
-    if( metadata_len != 0 )
-    {
-        if( ( ctrl->write_offset + metadata_len ) > ctrl->buffer_size )
-        {
-            memcpy( ctrl->buffer + ctrl->write_offset, ( uint8_t* ) metadata, ctrl->buffer_size - ctrl->write_offset );
-            memcpy( ctrl->buffer, ( uint8_t* ) metadata + ctrl->buffer_size - ctrl->write_offset,
-                    metadata_len - ( ctrl->buffer_size - ctrl->write_offset ) );
-        }
-        else
-        {
-            memcpy( ctrl->buffer + ctrl->write_offset, ( uint8_t* ) metadata, metadata_len );
-        }
-        ctrl->write_offset += metadata_len;
-        ctrl->write_offset %= ctrl->buffer_size;
-    }
-
-    // Write data
-    if( buffer_len != 0 )
-    {
-        if( ( ctrl->write_offset + buffer_len ) > ctrl->buffer_size )
-        {
-            memcpy( ctrl->buffer + ctrl->write_offset, buffer, ctrl->buffer_size - ctrl->write_offset );
-            memcpy( ctrl->buffer, buffer + ctrl->buffer_size - ctrl->write_offset,
-                    buffer_len - ( ctrl->buffer_size - ctrl->write_offset ) );
-        }
-        else
-        {
-            memcpy( ctrl->buffer + ctrl->write_offset, buffer, buffer_len );
-        }
+    // Write data length - 2 bytes MSB first, then metadata length
+    uint8_t header[LEN_DATA_SIZE + LEN_METADATA_SIZE] = { ( uint8_t ) ( buffer_len >> 8 ), ( uint8_t ) buffer_len,
+                                                          metadata_len };
+    ctrl_write( ctrl, header, sizeof( header ) );
 
-        ctrl->write_offset += buffer_len;
-        ctrl->write_offset %= ctrl->buffer_size;
-    }
+    // Write metadata then data
+    ctrl_write( ctrl, ( const uint8_t* ) metadata, metadata_len );
+    ctrl_write( ctrl, buffer, buffer_len );
 
     ctrl->free_space -= total_write_len;
     ctrl->nb_element += 1;
@@ -215,16 +242,14 @@ static fifo_return_status_t ctrl_get( fifo_ctrl_t* ctrl, uint8_t* buffer, uint16
                                       const uint16_t data_buffer_size, void* metadata, uint8_t* metadata_len,
                                       const uint8_t metadata_buffer_size )
 {
-    if( ctrl->nb_element == 0 )
+    fifo_ctrl_span_t data_span;
+    fifo_ctrl_span_t metadata_span;
+
+    if( ctrl_peek( ctrl, &data_span, &metadata_span ) != FIFO_STATUS_OK )
     {
         return FIFO_STATUS_BUFFER_EMPTY;
     }
 
-    // Read data & metadata size (read_offset update is done later if input param are ok)
-    uint16_t read_data_len = ( ( uint16_t ) ctrl->buffer[ctrl->read_offset] ) << 8;
-    read_data_len += ( ( uint16_t ) ctrl->buffer[( ctrl->read_offset + 1 ) % ctrl->buffer_size] );
-    uint8_t read_metadata_len = ctrl->buffer[( ctrl->read_offset + 2 ) % ctrl->buffer_size];
-
     // Buffer & metadata are NULL --> drop old message --> don't check/update size of buffer
     if( ( buffer != NULL ) && ( metadata != NULL ) )
     {
@@ -234,56 +259,104 @@ static fifo_return_status_t ctrl_get( fifo_ctrl_t* ctrl, uint8_t* buffer, uint16
         }
 
         // Buffer length are ok -> save length infos
-        *data_len     = read_data_len;
-        *metadata_len = read_metadata_len;
+        *data_len     = data_span.part1_len + data_span.part2_len;
+        *metadata_len = metadata_span.part1_len + metadata_span.part2_len;
 
-        if( ( read_data_len > data_buffer_size ) || ( read_metadata_len > metadata_buffer_size ) )
+        if( ( *data_len > data_buffer_size ) || ( *metadata_len > metadata_buffer_size ) )
         {
             return FIFO_STATUS_BUFFER_TOO_SMALL;
         }
     }
 
-    // Update read offset (only if there is no error)
-    ctrl->read_offset += ( LEN_DATA_SIZE + LEN_METADATA_SIZE );
-    ctrl->read_offset %= ctrl->buffer_size;
-
-    // Copy metadata (if required)
-    if( ( metadata != NULL ) && ( read_metadata_len != 0 ) )
+    // Copy metadata & data (if required)
+    if( metadata != NULL )
     {
-        if( ( ctrl->read_offset + read_metadata_len ) > ctrl->buffer_size )
-        {
-            memcpy( ( uint8_t* ) metadata, ctrl->buffer + ctrl->read_offset, ctrl->buffer_size - ctrl->read_offset );
-            memcpy( ( uint8_t* ) metadata + ctrl->buffer_size - ctrl->read_offset, ctrl->buffer,
-                    read_metadata_len - ( ctrl->buffer_size - ctrl->read_offset ) );
-        }
-        else
-        {
-            memcpy( ( uint8_t* ) metadata, ctrl->buffer + ctrl->read_offset, read_metadata_len );
-        }
+        fifo_ctrl_span_copy( &metadata_span, metadata );
     }
-    ctrl->read_offset += read_metadata_len;
-    ctrl->read_offset %= ctrl->buffer_size;
+    if( buffer != NULL )
+    {
+        fifo_ctrl_span_copy( &data_span, buffer );
+    }
+
+    ctrl_consume( ctrl, &data_span, &metadata_span );
+
+    return FIFO_STATUS_OK;
+}
 
-    // Copy data (if required)
-    if( ( buffer != NULL ) && ( read_data_len != 0 ) )
+static fifo_return_status_t ctrl_peek( const fifo_ctrl_t* ctrl, fifo_ctrl_span_t* data, fifo_ctrl_span_t* metadata )
+{
+    if( ctrl->nb_element == 0 )
     {
-        if( ( ctrl->read_offset + read_data_len ) > ctrl->buffer_size )
-        {
-            memcpy( buffer, ctrl->buffer + ctrl->read_offset, ctrl->buffer_size - ctrl->read_offset );
-            memcpy( buffer + ctrl->buffer_size - ctrl->read_offset, ctrl->buffer,
-                    read_data_len - ( ctrl->buffer_size - ctrl->read_offset ) );
-        }
-        else
-        {
-            memcpy( buffer, ctrl->buffer + ctrl->read_offset, read_data_len );
-        }
+        return FIFO_STATUS_BUFFER_EMPTY;
     }
-    ctrl->read_offset += read_data_len;
-    ctrl->read_offset %= ctrl->buffer_size;
 
-    ctrl->free_space += ( LEN_DATA_SIZE + LEN_METADATA_SIZE + read_metadata_len + read_data_len );
+    // Read data & metadata size
+    uint16_t read_data_len = ( ( uint16_t ) ctrl->buffer[ctrl->read_offset] ) << 8;
+    read_data_len += ( ( uint16_t ) ctrl->buffer[ctrl_wrap( ctrl, ctrl->read_offset + 1 )] );
+    uint8_t read_metadata_len = ctrl->buffer[ctrl_wrap( ctrl, ctrl->read_offset + 2 )];
+
+    uint16_t offset = ctrl_wrap( ctrl, ctrl->read_offset + LEN_DATA_SIZE + LEN_METADATA_SIZE );
+    ctrl_span( ctrl, offset, read_metadata_len, metadata );
+    ctrl_span( ctrl, ctrl_wrap( ctrl, offset + read_metadata_len ), read_data_len, data );
+
+    return FIFO_STATUS_OK;
+}
+
+static void ctrl_consume( fifo_ctrl_t* ctrl, const fifo_ctrl_span_t* data, const fifo_ctrl_span_t* metadata )
+{
+    uint16_t read_len = LEN_DATA_SIZE + LEN_METADATA_SIZE + metadata->part1_len + metadata->part2_len +
+                        data->part1_len + data->part2_len;
+
+    ctrl->read_offset = ctrl_wrap( ctrl, ctrl->read_offset + read_len );
+    ctrl->free_space += read_len;
     ctrl->nb_element -= 1;
     ctrl->read_cnt += 1;
+}
 
-    return FIFO_STATUS_OK;
+static void ctrl_write( fifo_ctrl_t* ctrl, const uint8_t* src, uint16_t len )
+{
+    if( len == 0 )
+    {
+        return;
+    }
+
+    uint16_t contiguous_len = ctrl->buffer_size - ctrl->write_offset;
+    if( len > contiguous_len )
+    {
+        memcpy( ctrl->buffer + ctrl->write_offset, src, contiguous_len );
+        memcpy( ctrl->buffer, src + contiguous_len, len - contiguous_len );
+    }
+    else
+    {
+        memcpy( ctrl->buffer + ctrl->write_offset, src, len );
+    }
+    ctrl->write_offset = ctrl_wrap( ctrl, ctrl->write_offset + len );
+}
+
+static void ctrl_span( const fifo_ctrl_t* ctrl, uint16_t offset, uint16_t len, fifo_ctrl_span_t* span )
+{
+    uint16_t contiguous_len = ctrl->buffer_size - offset;
+
+    span->part1 = ctrl->buffer + offset;
+    if( len > contiguous_len )
+    {
+        span->part1_len = contiguous_len;
+        span->part2     = ctrl->buffer;
+        span->part2_len = len - contiguous_len;
+    }
+    else
+    {
+        span->part1_len = len;
+        span->part2     = NULL;
+        span->part2_len = 0;
+    }
+}
+
+static inline uint16_t ctrl_wrap( const fifo_ctrl_t* ctrl, uint32_t offset )
+{
+    if( ctrl->wrap_mask != 0 )
+    {
+        return ( uint16_t ) ( offset & ctrl->wrap_mask );
+    }
+    return ( uint16_t ) ( offset % ctrl->buffer_size );
 }
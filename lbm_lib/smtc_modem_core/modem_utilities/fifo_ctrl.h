@@ -43,7 +43,8 @@ extern "C" {
  * -----------------------------------------------------------------------------
  * --- DEPENDENCIES ------------------------------------------------------------
  */
-#include <stdint.h>  // C99 types
+#include <stdint.h>   // C99 types
+#include <stdbool.h>  // bool type
 
 /*
  * -----------------------------------------------------------------------------
@@ -67,9 +68,19 @@ typedef enum fifo_return_status_e
     FIFO_STATUS_PARAM_ERROR,       // Only for get function
     FIFO_STATUS_BUFFER_EMPTY,      // Only for get function
     FIFO_STATUS_BUFFER_TOO_SMALL,  // For get: not enough space in buffer to read data from fifo
-                                   // For set: fifo is not big enough to save data + metadata
+                                   // For set: fifo is not big enough to save data + metadata, or the oldest
+                                   // element is peeked and cannot be removed
 } fifo_return_status_t;
 
+// Content of an element in the fifo buffer, split in two parts when it wraps at the end of the buffer
+typedef struct fifo_ctrl_span_s
+{
+    const uint8_t* part1;
+    uint16_t       part1_len;
+    const uint8_t* part2;  // beginning of the buffer, NULL if the content does not wrap
+    uint16_t       part2_len;
+} fifo_ctrl_span_t;
+
 // Internal structure to manage fifo - don't modify it
 typedef struct fifo_ctrl_s
 {
@@ -79,6 +90,8 @@ typedef struct fifo_ctrl_s
     uint16_t write_offset;
     uint16_t free_space;
     uint16_t nb_element;
+    uint16_t wrap_mask;  // buffer_size - 1 if buffer_size is a power of 2, 0 otherwise
+    bool     peeked;     // oldest element returned by fifo_ctrl_peek and not consumed yet
 
     // Stat
     uint32_t write_cnt;
@@ -161,6 +174,35 @@ fifo_return_status_t fifo_ctrl_get( fifo_ctrl_t* ctrl, uint8_t* buffer, uint16_t
 fifo_return_status_t fifo_ctrl_set( fifo_ctrl_t* ctrl, const uint8_t* buffer, const uint16_t buffer_len,
                                     const void* metadata, const uint8_t metadata_len );
 
+/**
+ * @brief Get the oldest element in fifo without copying it
+ *      The spans point in the fifo buffer and stay valid until fifo_ctrl_consume is called, the element is not
+ *      removed to store a new one meanwhile
+ *
+ * @param ctrl          fifo manager
+ * @param data          span of the data
+ * @param metadata      span of the metadata
+ * @return fifo_return_status_t return status
+ */
+fifo_return_status_t fifo_ctrl_peek( fifo_ctrl_t* ctrl, fifo_ctrl_span_t* data, fifo_ctrl_span_t* metadata );
+
+/**
+ * @brief Remove the element returned by fifo_ctrl_peek
+ *
+ * @param ctrl          fifo manager
+ * @return fifo_return_status_t return status, FIFO_STATUS_PARAM_ERROR if no element is peeked
+ */
+fifo_return_status_t fifo_ctrl_consume( fifo_ctrl_t* ctrl );
+
+/**
+ * @brief Copy the content of a span
+ *
+ * @param span          span to copy
+ * @param dest          destination buffer, at least part1_len + part2_len bytes
+ * @return uint16_t     number of bytes copied
+ */
+uint16_t fifo_ctrl_span_copy( const fifo_ctrl_span_t* span, void* dest );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,237 @@
+/*!
+ * \file      modem_context_cache.c
+ *
+ * \brief     Write-coalescing cache of the modem contexts stored in non volatile memory
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2025. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+#include <stdint.h>   // C99 types
+#include <stdbool.h>  // bool type
+#include <string.h>   // memcmp, memcpy
+
+#include "modem_context_cache.h"
+#include "smtc_modem_hal.h"
+#include "smtc_modem_hal_dbg_trace.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE MACROS-----------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE CONSTANTS -------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE TYPES -----------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE VARIABLES -------------------------------------------------------
+ */
+
+/**
+ * @brief Caches holding unwritten modifications
+ */
+static modem_context_cache_t* modem_context_cache_pending = NULL;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
+ */
+
+/**
+ * @brief Read the whole context area in the shadow on first access
+ *
+ * @param [in] cache  Context cache
+ * @param [in] offset Offset of the access
+ * @param [in] size   Size of the access
+ */
+static void modem_context_cache_load( modem_context_cache_t* cache, uint32_t offset, uint32_t size );
+
+/**
+ * @brief Remove a cache from the pending list
+ *
+ * @param [in] cache Context cache
+ */
+static void modem_context_cache_unlink( modem_context_cache_t* cache );
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
+ */
+
+void modem_context_cache_restore( modem_context_cache_t* cache, uint32_t offset, uint8_t* buffer, uint32_t size )
+{
+    modem_context_cache_load( cache, offset, size );
+    memcpy( buffer, &cache->shadow[offset], size );
+}
+
+bool modem_context_cache_store( modem_context_cache_t* cache, uint32_t offset, const uint8_t* buffer, uint32_t size )
+{
+    modem_context_cache_load( cache, offset, size );
+
+    if( memcmp( &cache->shadow[offset], buffer, size ) == 0 )
+    {
+        return false;
+    }
+    memcpy( &cache->shadow[offset], buffer, size );
+
+    // Merge with the pending modifications: the written range stays made of whole stores
+    if( cache->dirty_start == cache->dirty_end )
+    {
+        cache->dirty_start   = offset;
+        cache->dirty_end     = offset + size;
+        cache->dirty_time_ms = smtc_modem_hal_get_time_in_ms( );
+    }
+    else
+    {
+        if( offset < cache->dirty_start )
+        {
+            cache->dirty_start = offset;
+        }
+        if( ( offset + size ) > cache->dirty_end )
+        {
+            cache->dirty_end = offset + size;
+        }
+    }
+
+    if( cache->window_ms == 0 )
+    {
+        modem_context_cache_flush( cache );
+    }
+    else
+    {
+        // Append at the end of the pending list, if not already in it
+        modem_context_cache_t** last = &modem_context_cache_pending;
+        while( ( *last != NULL ) && ( *last != cache ) )
+        {
+            last = &( *last )->next;
+        }
+        *last = cache;
+    }
+    return true;
+}
+
+void modem_context_cache_flush( modem_context_cache_t* cache )
+{
+    if( cache->dirty_start == cache->dirty_end )
+    {
+        return;
+    }
+
+    uint32_t offset = cache->dirty_start;
+    uint32_t size   = cache->dirty_end - cache->dirty_start;
+
+    cache->dirty_start = 0;
+    cache->dirty_end   = 0;
+    modem_context_cache_unlink( cache );
+
+    smtc_modem_hal_context_store( cache->ctx_type, offset, &cache->shadow[offset], size );
+    // Read back the written range to ensure the store is done before exiting the function
+    smtc_modem_hal_context_restore( cache->ctx_type, offset, &cache->shadow[offset], size );
+}
+
+void modem_context_cache_flush_all( void )
+{
+    while( modem_context_cache_pending != NULL )
+    {
+        modem_context_cache_flush( modem_context_cache_pending );
+    }
+}
+
+uint32_t modem_context_cache_process( void )
+{
+    uint32_t               now_ms  = smtc_modem_hal_get_time_in_ms( );
+    uint32_t               next_ms = UINT32_MAX;
+    modem_context_cache_t* cache   = modem_context_cache_pending;
+
+    while( cache != NULL )
+    {
+        modem_context_cache_t* next      = cache->next;
+        int32_t                remain_ms = ( int32_t ) ( cache->dirty_time_ms + cache->window_ms - now_ms );
+
+        if( remain_ms <= 0 )
+        {
+            modem_context_cache_flush( cache );
+        }
+        else if( ( uint32_t ) remain_ms < next_ms )
+        {
+            next_ms = ( uint32_t ) remain_ms;
+        }
+        cache = next;
+    }
+    return next_ms;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
+ */
+
+static void modem_context_cache_load( modem_context_cache_t* cache, uint32_t offset, uint32_t size )
+{
+    if( ( offset > cache->size ) || ( size > ( cache->size - offset ) ) )
+    {
+        SMTC_MODEM_HAL_PANIC( "Context %d access out of cache (%lu + %lu > %lu)\n", cache->ctx_type, offset, size,
+                              cache->size );
+    }
+    if( cache->loaded == false )
+    {
+        smtc_modem_hal_context_restore( cache->ctx_type, 0, cache->shadow, cache->size );
+        cache->loaded = true;
+    }
+}
+
+static void modem_context_cache_unlink( modem_context_cache_t* cache )
+{
+    modem_context_cache_t** link = &modem_context_cache_pending;
+
+    while( *link != NULL )
+    {
+        if( *link == cache )
+        {
+            *link       = cache->next;
+            cache->next = NULL;
+            return;
+        }
+        link = &( *link )->next;
+    }
+}
+
+/* --- EOF ------------------------------------------------------------------ */
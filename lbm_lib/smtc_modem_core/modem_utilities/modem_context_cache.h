@@ -0,0 +1,165 @@
+/*!
+ * \file      modem_context_cache.h
+ *
+ * \brief     Write-coalescing cache of the modem contexts stored in non volatile memory
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2025. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MODEM_CONTEXT_CACHE_H__
+#define __MODEM_CONTEXT_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+#include <stdint.h>   // C99 types
+#include <stdbool.h>  // bool type
+
+#include "smtc_modem_hal.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC MACROS -----------------------------------------------------------
+ */
+
+/**
+ * @brief Static initializer of a context cache
+ *
+ * @param [in] type         Context type as defined in @ref modem_context_type_t
+ * @param [in] shadow_array RAM array holding the copy of the whole context area (all the stacks)
+ * @param [in] window       Time in ms a modified context may wait in RAM to be merged with the following writes
+ */
+#define MODEM_CONTEXT_CACHE_INIT( type, shadow_array, window ) \
+    {                                                          \
+        .ctx_type  = ( type ),                                 \
+        .shadow    = ( shadow_array ),                         \
+        .size      = sizeof( shadow_array ),                   \
+        .window_ms = ( window ),                               \
+    }
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+/**
+ * @brief Write window of the contexts whose loss on a power failure is harmless
+ *
+ * @remark 0 writes them through, as the contexts holding nonces (LoRaWAN stack, secure element) always are
+ */
+#ifndef MODEM_CONTEXT_CACHE_WINDOW_MS
+#define MODEM_CONTEXT_CACHE_WINDOW_MS 0
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC TYPES ------------------------------------------------------------
+ */
+
+/**
+ * @brief Cache of one context area
+ *
+ * The shadow is read from the non volatile memory on first access, then restores are served from RAM and a store
+ * that does not change the shadow does not touch the memory. The ranges modified by the stores are merged in one
+ * dirty range which is written at once, either immediately (window_ms = 0), when the window of the oldest modification
+ * elapses, or when a flush is requested.
+ */
+typedef struct modem_context_cache_s
+{
+    modem_context_type_t          ctx_type;       //!< Context backing the cache
+    uint8_t*                      shadow;         //!< RAM copy of the context area
+    uint32_t                      size;           //!< Size of the context area
+    uint32_t                      window_ms;      //!< Time a modification may wait to be merged, 0 to write through
+    bool                          loaded;         //!< Shadow has been read from the non volatile memory
+    uint32_t                      dirty_start;    //!< First modified byte
+    uint32_t                      dirty_end;      //!< End of the modified bytes, equal to dirty_start when clean
+    uint32_t                      dirty_time_ms;  //!< Time of the oldest unwritten modification
+    struct modem_context_cache_s* next;           //!< Next cache holding unwritten modifications
+} modem_context_cache_t;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
+ */
+
+/**
+ * @brief Read a part of a context
+ *
+ * @param [in]  cache  Context cache
+ * @param [in]  offset Offset in the context area
+ * @param [out] buffer Buffer to fill
+ * @param [in]  size   Number of bytes to read
+ */
+void modem_context_cache_restore( modem_context_cache_t* cache, uint32_t offset, uint8_t* buffer, uint32_t size );
+
+/**
+ * @brief Write a part of a context
+ *
+ * @remark Nothing is written when the data is already the content of the context
+ *
+ * @param [in] cache  Context cache
+ * @param [in] offset Offset in the context area
+ * @param [in] buffer Data to write
+ * @param [in] size   Number of bytes to write
+ * @return true if the context has been modified
+ */
+bool modem_context_cache_store( modem_context_cache_t* cache, uint32_t offset, const uint8_t* buffer, uint32_t size );
+
+/**
+ * @brief Write the unwritten modifications of a context
+ *
+ * @param [in] cache Context cache
+ */
+void modem_context_cache_flush( modem_context_cache_t* cache );
+
+/**
+ * @brief Write the unwritten modifications of all the contexts, to be called before a reset
+ */
+void modem_context_cache_flush_all( void );
+
+/**
+ * @brief Write the contexts whose window has elapsed
+ *
+ * @return uint32_t Time in ms until the next window elapses, UINT32_MAX if nothing is waiting
+ */
+uint32_t modem_context_cache_process( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __MODEM_CONTEXT_CACHE_H__
+
+/* --- EOF ------------------------------------------------------------------ */
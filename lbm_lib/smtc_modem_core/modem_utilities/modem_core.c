@@ -41,6 +41,8 @@
 #include <stdbool.h>  // bool type
 
 #include "modem_core.h"
+#include "modem_context_cache.h"
+#include "modem_crc.h"
 #include "modem_event_utilities.h"
 
 #include "smtc_modem_hal_dbg_trace.h"
@@ -90,6 +92,8 @@
 #else
 #define NUMBER_OF_LORAWAN_MANAGEMENT_TASKS 4
 #endif
+#define NUMBER_OF_DOWNLINK_HANDLERS ( NUMBER_OF_SERVICES + NUMBER_OF_LORAWAN_MANAGEMENT_TASKS )
+#define DOWNLINK_FPORT_TABLE_SIZE ( 8 * NUMBER_OF_STACKS )
 
 /*
  * -----------------------------------------------------------------------------
@@ -104,6 +108,16 @@ typedef struct modem_ctx_s
     uint32_t crc;  // !! crc MUST be the last field of the structure !!
 } modem_ctx_t;
 
+/**
+ * @brief Downlink handlers consuming an fport of a stack
+ */
+typedef struct modem_downlink_fport_entry_s
+{
+    uint32_t handlers;  // bitmask of the downlink_services_callback indexes
+    uint8_t  fport;
+    uint8_t  stack_id;
+} modem_downlink_fport_entry_t;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE VARIABLES -------------------------------------------------------
@@ -117,10 +131,15 @@ struct
     uint32_t             user_alarm;
     fifo_ctrl_t          fifo_ctrl_obj;
     uint8_t              fifo_buffer[FIFO_LORAWAN_SIZE];
-    uint8_t ( *downlink_services_callback[NUMBER_OF_SERVICES + NUMBER_OF_LORAWAN_MANAGEMENT_TASKS] )(
-        lr1_stack_mac_down_data_t* rx_down_data );
-    uint32_t modem_reset_counter;
-    bool     report_all_downlinks_to_user;
+    uint8_t ( *downlink_services_callback[NUMBER_OF_DOWNLINK_HANDLERS] )( lr1_stack_mac_down_data_t* rx_down_data );
+    uint8_t                      downlink_services_filter[NUMBER_OF_DOWNLINK_HANDLERS][NUMBER_OF_STACKS];
+    uint8_t                      downlink_services_fport[NUMBER_OF_DOWNLINK_HANDLERS][NUMBER_OF_STACKS];
+    uint16_t                     downlink_services_windows[NUMBER_OF_DOWNLINK_HANDLERS];
+    uint32_t                     downlink_all_fports_handlers[NUMBER_OF_STACKS];
+    modem_downlink_fport_entry_t downlink_fport_table[DOWNLINK_FPORT_TABLE_SIZE];
+    uint8_t                      downlink_fport_table_size;
+    uint32_t                     modem_reset_counter;
+    bool                         report_all_downlinks_to_user;
 } modem_ctx_light;
 
 #define modem_dwn_pkt modem_ctx_light.modem_dwn_pkt
@@ -131,14 +150,37 @@ struct
 #define fifo_ctrl_obj modem_ctx_light.fifo_ctrl_obj
 #define fifo_buffer modem_ctx_light.fifo_buffer
 #define downlink_services_callback modem_ctx_light.downlink_services_callback
+#define downlink_services_filter modem_ctx_light.downlink_services_filter
+#define downlink_services_fport modem_ctx_light.downlink_services_fport
+#define downlink_services_windows modem_ctx_light.downlink_services_windows
+#define downlink_all_fports_handlers modem_ctx_light.downlink_all_fports_handlers
+#define downlink_fport_table modem_ctx_light.downlink_fport_table
+#define downlink_fport_table_size modem_ctx_light.downlink_fport_table_size
 #define modem_reset_counter modem_ctx_light.modem_reset_counter
 #define report_all_downlinks_to_user modem_ctx_light.report_all_downlinks_to_user
 
+/**
+ * @brief Cache of the modem context stored in non volatile memory
+ */
+static uint8_t               modem_nvm_ctx_shadow[sizeof( modem_ctx_t )];
+static modem_context_cache_t modem_nvm_ctx_cache =
+    MODEM_CONTEXT_CACHE_INIT( CONTEXT_MODEM, modem_nvm_ctx_shadow, MODEM_CONTEXT_CACHE_WINDOW_MS );
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 static void modem_downlink_callback( lr1_stack_mac_down_data_t* rx_down_data );
+static void modem_downlink_build_dispatch_table( void );
+
+/**
+ * @brief Compute the duty-cycle status of a stack
+ *
+ * @param [in] stack_id   Stack identifier
+ * @param [in] toa_aware  Wait until the Time On Air of the current uplink frame fits instead of 1 ms
+ * @return int32_t milliseconds, if > 0: time to wait, else the available time
+ */
+static int32_t modem_duty_cycle_compute_status( uint8_t stack_id, bool toa_aware, uint8_t payload_length );
 // static void check_class_b_to_generate_event( void );
 
 /*
@@ -170,6 +212,22 @@ void modem_context_init_light( void ( *callback )( void ), radio_planner_t* rp )
         lorawan_api_set_region( region, stack_id );
     }
 
+    // Until a service sets its filter, its downlink handler receives all the downlinks
+    if( NUMBER_OF_DOWNLINK_HANDLERS > 32 )
+    {
+        SMTC_MODEM_HAL_PANIC( "too many downlink handlers\n" );
+    }
+    for( uint8_t i = 0; i < NUMBER_OF_DOWNLINK_HANDLERS; i++ )
+    {
+        downlink_services_callback[i] = NULL;
+        downlink_services_windows[i]  = MODEM_DOWNLINK_WINDOWS_ALL;
+        for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+        {
+            downlink_services_filter[i][stack_id] = MODEM_DOWNLINK_FILTER_ALL;
+            downlink_services_fport[i][stack_id]  = 0;
+        }
+    }
+
     uint8_t index_tmp = 0;
     lorawan_send_management_services_init( ( uint8_t* ) UNUSED_VALUE, UNUSED_VALUE,
                                            &downlink_services_callback[index_tmp++], &callback_on_launch_temp,
@@ -212,6 +270,7 @@ void modem_context_init_light( void ( *callback )( void ), radio_planner_t* rp )
                                         context_callback_tmp );
         cpt_of_services_init++;
     }
+    modem_downlink_build_dispatch_table( );
 
     // save radio planner pointer for suspend/resume features
 
@@ -311,60 +370,14 @@ bool modem_resume_radio_access( void )
     return status;
 }
 
-uint32_t crc( const uint8_t* buf, int len )
+int32_t modem_duty_cycle_get_status( uint8_t stack_id )
 {
-    uint32_t crc = 0xFFFFFFFF;
-    while( len-- > 0 )
-    {
-        crc = crc ^ *buf++;
-        for( int i = 0; i < 8; i++ )
-        {
-            uint32_t mask = -( crc & 1 );
-            crc           = ( crc >> 1 ) ^ ( 0xEDB88320 & mask );
-        }
-    }
-    return ~crc;
+    return modem_duty_cycle_compute_status( stack_id, false, 0 );
 }
 
-int32_t modem_duty_cycle_get_status( uint8_t stack_id )
+int32_t modem_duty_cycle_get_uplink_status( uint8_t stack_id, uint8_t payload_length )
 {
-    int32_t dtc_ms     = 0;
-    int32_t region_dtc = 0;
-    int32_t nwk_dtc    = lorawan_api_next_network_free_duty_cycle_ms_get( stack_id );
-
-    if( smtc_duty_cycle_enable_get( ) == SMTC_DTC_ENABLED )
-    {
-        uint8_t  number_of_freq = 0;
-        uint32_t freq_list[16]  = { 0 };  // Generally region with duty cycle support 16 channels only
-
-        if( lorawan_api_get_current_enabled_frequencies_list(
-                &number_of_freq, freq_list, sizeof( freq_list ) / sizeof( freq_list[0] ), stack_id ) == true )
-        {
-            region_dtc = smtc_duty_cycle_get_next_free_time_ms( number_of_freq, freq_list );
-#if defined( ADD_RELAY_TX )
-            int32_t relay_region_dtc = smtc_relay_tx_free_duty_cycle_ms_get( stack_id );
-
-            if( relay_region_dtc != 0 )
-            {
-                region_dtc = MAX( region_dtc, relay_region_dtc );
-            }
-#endif
-        }
-
-        if( nwk_dtc == 0 )
-        {
-            dtc_ms = region_dtc;
-        }
-        else
-        {
-            dtc_ms = MAX( nwk_dtc, region_dtc );
-        }
-    }
-    else
-    {
-        dtc_ms = nwk_dtc;
-    }
-    return dtc_ms;
+    return modem_duty_cycle_compute_status( stack_id, true, payload_length );
 }
 
 uint8_t modem_get_status( uint8_t stack_id )
@@ -409,33 +422,29 @@ void modem_store_modem_context( void )
     modem_ctx_t ctx = { 0 };
 
     // Restore current saved context
-    smtc_modem_hal_context_restore( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_restore( &modem_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
 
     // Check if some values have changed
     if( ctx.reset_counter != modem_reset_counter )
     {
         ctx.reset_counter = modem_reset_counter;
-        ctx.crc           = crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+        ctx.crc           = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-        smtc_modem_hal_context_store( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
-        // dummy context reading to ensure context store is done before exiting the function
-        smtc_modem_hal_context_restore( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+        modem_context_cache_store( &modem_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
     }
 }
 
 void modem_load_modem_context( void )
 {
     modem_ctx_t ctx = { 0 };
-    smtc_modem_hal_context_restore( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_restore( &modem_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
 
-    if( crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) != ctx.crc )
+    if( modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) != ctx.crc )
     {
         memset( &ctx, 0, sizeof( ctx ) );
-        ctx.crc = crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+        ctx.crc = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-        smtc_modem_hal_context_store( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
-        // dummy context reading to ensure context store is done before exiting the function
-        smtc_modem_hal_context_restore( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+        modem_context_cache_store( &modem_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
     }
 
     modem_reset_counter = ctx.reset_counter;
@@ -444,7 +453,8 @@ void modem_load_modem_context( void )
 void modem_reset_modem_context( void )
 {
     modem_ctx_t ctx = { 0 };
-    smtc_modem_hal_context_store( CONTEXT_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_store( &modem_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_flush( &modem_nvm_ctx_cache );
 }
 
 uint32_t modem_get_reset_counter( void )
@@ -462,11 +472,120 @@ bool modem_get_report_all_downlinks_to_user( void )
     return report_all_downlinks_to_user;
 }
 
+void modem_downlink_set_filter( modem_downlink_handler_t handler, uint8_t stack_id, modem_downlink_filter_t filter,
+                                uint8_t fport )
+{
+    if( stack_id >= NUMBER_OF_STACKS )
+    {
+        SMTC_MODEM_HAL_PANIC( "stack id not valid %u\n", stack_id );
+    }
+    for( uint8_t i = 0; i < NUMBER_OF_DOWNLINK_HANDLERS; i++ )
+    {
+        if( downlink_services_callback[i] == handler )
+        {
+            downlink_services_filter[i][stack_id] = filter;
+            downlink_services_fport[i][stack_id]  = fport;
+        }
+    }
+    modem_downlink_build_dispatch_table( );
+}
+
+void modem_downlink_set_windows( modem_downlink_handler_t handler, uint16_t windows_mask )
+{
+    for( uint8_t i = 0; i < NUMBER_OF_DOWNLINK_HANDLERS; i++ )
+    {
+        if( downlink_services_callback[i] == handler )
+        {
+            downlink_services_windows[i] = windows_mask;
+        }
+    }
+    modem_downlink_build_dispatch_table( );
+}
+
+void modem_downlink_set_dm_fport( uint8_t stack_id, uint8_t fport )
+{
+    if( stack_id >= NUMBER_OF_STACKS )
+    {
+        SMTC_MODEM_HAL_PANIC( "stack id not valid %u\n", stack_id );
+    }
+    for( uint8_t i = 0; i < NUMBER_OF_DOWNLINK_HANDLERS; i++ )
+    {
+        if( downlink_services_filter[i][stack_id] == MODEM_DOWNLINK_FILTER_DM_FPORT )
+        {
+            downlink_services_fport[i][stack_id] = fport;
+        }
+    }
+    modem_downlink_build_dispatch_table( );
+}
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+static int32_t modem_duty_cycle_compute_status( uint8_t stack_id, bool toa_aware, uint8_t payload_length )
+{
+    int32_t dtc_ms     = 0;
+    int32_t region_dtc = 0;
+    int32_t nwk_dtc    = lorawan_api_next_network_free_duty_cycle_ms_get( stack_id );
+
+    if( smtc_duty_cycle_enable_get( ) == SMTC_DTC_ENABLED )
+    {
+        uint8_t  number_of_freq = 0;
+        uint32_t freq_list[16]  = { 0 };  // Generally region with duty cycle support 16 channels only
+
+        if( lorawan_api_get_current_enabled_frequencies_list(
+                &number_of_freq, freq_list, sizeof( freq_list ) / sizeof( freq_list[0] ), stack_id ) == true )
+        {
+            region_dtc = smtc_duty_cycle_get_next_free_time_ms( number_of_freq, freq_list );
+
+            if( toa_aware == true )
+            {
+                // Wait until the frame fits in the budget of a band rather than until a band has 1 ms left
+                uint32_t toa_ms     = lorawan_api_next_toa_ms_get( stack_id, payload_length );
+                int32_t  toa_dtc_ms = INT32_MAX;
+
+                for( uint8_t i = 0; i < number_of_freq; i++ )
+                {
+                    int32_t free_time_ms = smtc_duty_cycle_get_toa_free_time_ms( freq_list[i], toa_ms );
+
+                    // Negative: the frame never fits in this band, its free time is left to the 1 ms rule
+                    if( ( free_time_ms >= 0 ) && ( free_time_ms < toa_dtc_ms ) )
+                    {
+                        toa_dtc_ms = free_time_ms;
+                    }
+                }
+                if( ( toa_dtc_ms != INT32_MAX ) && ( toa_dtc_ms > region_dtc ) )
+                {
+                    region_dtc = toa_dtc_ms;
+                }
+            }
+#if defined( ADD_RELAY_TX )
+            int32_t relay_region_dtc = smtc_relay_tx_free_duty_cycle_ms_get( stack_id );
+
+            if( relay_region_dtc != 0 )
+            {
+                region_dtc = MAX( region_dtc, relay_region_dtc );
+            }
+#endif
+        }
+
+        if( nwk_dtc == 0 )
+        {
+            dtc_ms = region_dtc;
+        }
+        else
+        {
+            dtc_ms = MAX( nwk_dtc, region_dtc );
+        }
+    }
+    else
+    {
+        dtc_ms = nwk_dtc;
+    }
+    return dtc_ms;
+}
+
 void modem_downlink_callback( lr1_stack_mac_down_data_t* rx_down_data )
 {
     uint8_t                  downlink_used_by_services = 0;
@@ -493,9 +612,30 @@ void modem_downlink_callback( lr1_stack_mac_down_data_t* rx_down_data )
         metadata.rssi = ( int8_t ) ( rx_down_data->rx_metadata.rx_rssi + 64 );
     }
 
-    for( uint8_t i = 0; i < NUMBER_OF_SERVICES + NUMBER_OF_LORAWAN_MANAGEMENT_TASKS; i++ )
+    // Only call the handlers registered for all downlinks or for the received fport, in their init order
+    uint32_t handlers = downlink_all_fports_handlers[rx_down_data->stack_id];
+
+    if( rx_down_data->rx_metadata.rx_fport_present == true )
+    {
+        for( uint8_t i = 0; i < downlink_fport_table_size; i++ )
+        {
+            if( ( downlink_fport_table[i].fport == rx_down_data->rx_metadata.rx_fport ) &&
+                ( downlink_fport_table[i].stack_id == rx_down_data->stack_id ) )
+            {
+                handlers |= downlink_fport_table[i].handlers;
+                break;
+            }
+        }
+    }
+
+    uint16_t window = MODEM_DOWNLINK_WINDOW( rx_down_data->rx_metadata.rx_window );
+
+    for( uint8_t i = 0; handlers != 0; i++, handlers >>= 1 )
     {
-        downlink_used_by_services += downlink_services_callback[i]( rx_down_data );
+        if( ( ( handlers & 1 ) != 0 ) && ( ( downlink_services_windows[i] & window ) != 0 ) )
+        {
+            downlink_used_by_services += downlink_services_callback[i]( rx_down_data );
+        }
     }
 
     if( rx_down_data->rx_metadata.rx_window == RECEIVE_NONE )
@@ -515,10 +655,60 @@ void modem_downlink_callback( lr1_stack_mac_down_data_t* rx_down_data )
         }
         else
         {
-            increment_asynchronous_msgnumber( SMTC_MODEM_EVENT_DOWNDATA, 0, rx_down_data->stack_id );
+            modem_event_payload_t payload;
+
+            payload.downdata.fport  = rx_down_data->rx_metadata.rx_fport;
+            payload.downdata.length = rx_down_data->rx_payload_size;
+            modem_event_push( SMTC_MODEM_EVENT_DOWNDATA, 0, rx_down_data->stack_id, &payload );
             fifo_ctrl_print_stat( &fifo_ctrl_obj );
         }
     }
 }
 
+static void modem_downlink_build_dispatch_table( void )
+{
+    downlink_fport_table_size = 0;
+
+    for( uint8_t stack_id = 0; stack_id < NUMBER_OF_STACKS; stack_id++ )
+    {
+        downlink_all_fports_handlers[stack_id] = 0;
+
+        for( uint8_t i = 0; i < NUMBER_OF_DOWNLINK_HANDLERS; i++ )
+        {
+            // handlers not yet returned by the services are filled at the end of the services init
+            if( ( downlink_services_callback[i] == NULL ) ||
+                ( downlink_services_windows[i] == MODEM_DOWNLINK_WINDOWS_NONE ) )
+            {
+                continue;
+            }
+            if( downlink_services_filter[i][stack_id] == MODEM_DOWNLINK_FILTER_ALL )
+            {
+                downlink_all_fports_handlers[stack_id] |= ( 1UL << i );
+                continue;
+            }
+
+            uint8_t fport = downlink_services_fport[i][stack_id];
+            uint8_t entry = 0;
+
+            while( ( entry < downlink_fport_table_size ) && ( ( downlink_fport_table[entry].fport != fport ) ||
+                                                             ( downlink_fport_table[entry].stack_id != stack_id ) ) )
+            {
+                entry++;
+            }
+            if( entry == downlink_fport_table_size )
+            {
+                if( downlink_fport_table_size >= DOWNLINK_FPORT_TABLE_SIZE )
+                {
+                    SMTC_MODEM_HAL_PANIC( "downlink fport table full\n" );
+                }
+                downlink_fport_table[entry].handlers = 0;
+                downlink_fport_table[entry].fport    = fport;
+                downlink_fport_table[entry].stack_id = stack_id;
+                downlink_fport_table_size++;
+            }
+            downlink_fport_table[entry].handlers |= ( 1UL << i );
+        }
+    }
+}
+
 /* --- EOF ------------------------------------------------------------------ */
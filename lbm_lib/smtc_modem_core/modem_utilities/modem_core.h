@@ -64,6 +64,27 @@ extern "C" {
 
 #define MODEM_MAX_TIME 0x1FFFFF
 
+/**
+ * @brief Bitmask of a reception window (@ref receive_win_t) used to filter the downlinks given to a service
+ */
+#define MODEM_DOWNLINK_WINDOW( rx_window ) ( ( uint16_t ) ( 1 << ( rx_window ) ) )
+
+#define MODEM_DOWNLINK_WINDOWS_NONE 0x0000
+#define MODEM_DOWNLINK_WINDOWS_ALL 0xFFFF
+
+#if defined( SMTC_MULTICAST )
+#define MODEM_DOWNLINK_WINDOWS_MULTICAST                                                                  \
+    ( MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXC_MC_GRP0 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXC_MC_GRP1 ) | \
+      MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXC_MC_GRP2 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXC_MC_GRP3 ) | \
+      MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXB_MC_GRP0 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXB_MC_GRP1 ) | \
+      MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXB_MC_GRP2 ) | MODEM_DOWNLINK_WINDOW( RECEIVE_ON_RXB_MC_GRP3 ) )
+#else
+#define MODEM_DOWNLINK_WINDOWS_MULTICAST 0
+#endif
+
+#define MODEM_DOWNLINK_WINDOWS_UNICAST \
+    ( ( uint16_t ) ( MODEM_DOWNLINK_WINDOWS_ALL & ~MODEM_DOWNLINK_WINDOWS_MULTICAST ) )
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC TYPES ------------------------------------------------------------
@@ -95,6 +116,25 @@ enum
     MODEM_DOWNLINK_UNCONSUMED = 0,
     MODEM_DOWNLINK_CONSUMED   = 1,
 };
+
+struct lr1_stack_mac_down_data_s;
+
+/**
+ * @brief Service downlink handler, returns MODEM_DOWNLINK_CONSUMED if the downlink must not be reported to the user
+ */
+typedef uint8_t ( *modem_downlink_handler_t )( struct lr1_stack_mac_down_data_s* rx_down_data );
+
+/**
+ * @brief Downlinks given to a service downlink handler for a stack
+ *
+ * @enum modem_downlink_filter_t
+ */
+typedef enum modem_downlink_filter_e
+{
+    MODEM_DOWNLINK_FILTER_ALL,       //!< All downlinks and rx events, default behavior
+    MODEM_DOWNLINK_FILTER_FPORT,     //!< Only the frames received on a given fport
+    MODEM_DOWNLINK_FILTER_DM_FPORT,  //!< Only the frames received on the device management fport
+} modem_downlink_filter_t;
 /**
  * @brief Downlink message structure
  *
@@ -193,19 +233,23 @@ bool modem_suspend_radio_access( void );
  */
 bool modem_resume_radio_access( void );
 
-/*!
- * \brief   Compute crc
- * \remark
- *
- * \param  [in]     buf*            - input buffer
- * \param  [in]     len*            - input buffer length
- * \retval [out]    crc             - computed crc
- */
-uint32_t crc( const uint8_t* buf, int len );
-uint8_t  crc8( const uint8_t* data, int length );
+uint8_t crc8( const uint8_t* data, int length );
 
 int32_t modem_duty_cycle_get_status( uint8_t stack_id );
 
+/**
+ * @brief Get the duty-cycle status for the next uplink of a stack
+ *
+ * @remark Same as modem_duty_cycle_get_status() except that when > 0, the returned time is the time to wait until the
+ *         Time On Air of an uplink of \p payload_length bytes at the next datarate fits in the regional budget, not
+ *         until some budget is free
+ *
+ * @param [in] stack_id       Stack identifier
+ * @param [in] payload_length Application payload length of the uplink
+ * @return int32_t milliseconds, if > 0: time to wait before the uplink, else the available time
+ */
+int32_t modem_duty_cycle_get_uplink_status( uint8_t stack_id, uint8_t payload_length );
+
 /*!
  * @brief   return the modem status
  *
@@ -256,6 +300,39 @@ void modem_set_report_all_downlinks_to_user( bool report_all_downlinks );
  */
 bool modem_get_report_all_downlinks_to_user( void );
 
+/**
+ * @brief Set the downlinks dispatched to a service downlink handler on a stack
+ *
+ * @remark To be called by the service once its handler has been returned to the modem (services init), a handler
+ *         without filter receives all the downlinks
+ *
+ * @param [in] handler  Downlink handler of the service
+ * @param [in] stack_id Stack identifier
+ * @param [in] filter   Downlinks given to the handler
+ * @param [in] fport    Fport consumed by the handler, current device management fport for
+ *                      MODEM_DOWNLINK_FILTER_DM_FPORT, unused otherwise
+ */
+void modem_downlink_set_filter( modem_downlink_handler_t handler, uint8_t stack_id, modem_downlink_filter_t filter,
+                                uint8_t fport );
+
+/**
+ * @brief Restrict the reception windows dispatched to a service downlink handler
+ *
+ * @remark MODEM_DOWNLINK_WINDOWS_NONE is used by the services that never consume downlinks
+ *
+ * @param [in] handler      Downlink handler of the service
+ * @param [in] windows_mask Bitmask of accepted windows built with MODEM_DOWNLINK_WINDOW( )
+ */
+void modem_downlink_set_windows( modem_downlink_handler_t handler, uint16_t windows_mask );
+
+/**
+ * @brief Move the handlers filtered on the device management fport of a stack to a new fport
+ *
+ * @param [in] stack_id Stack identifier
+ * @param [in] fport    New device management fport
+ */
+void modem_downlink_set_dm_fport( uint8_t stack_id, uint8_t fport );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+/*!
+ * \file      modem_crc.h
+ *
+ * \brief     CRC-32 engine shared by the modem services
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2025. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MODEM_CRC_H__
+#define __MODEM_CRC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+#include <stdint.h>  // C99 types
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC MACROS -----------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+/**
+ * @brief Implementations of the CRC-32, from the smallest to the fastest
+ */
+#define MODEM_CRC32_BITWISE 0     // No table, 8 iterations per byte
+#define MODEM_CRC32_NIBBLE 1      // 64 bytes table, 2 lookups per byte
+#define MODEM_CRC32_BYTE 2        // 1 KB table, 1 lookup per byte
+#define MODEM_CRC32_SLICE_BY_4 3  // 4 KB tables, 4 bytes per iteration
+
+#ifndef MODEM_CRC32_IMPLEMENTATION
+#define MODEM_CRC32_IMPLEMENTATION MODEM_CRC32_NIBBLE
+#endif
+
+/**
+ * @brief Initial value of a CRC-32 computation
+ */
+#define MODEM_CRC32_INIT ( 0xFFFFFFFF )
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC TYPES ------------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
+ */
+
+/**
+ * @brief Feed bytes to a CRC-32 (reflected, polynomial 0x04C11DB7) computation
+ *
+ * @param [in] crc      Current CRC register, MODEM_CRC32_INIT for the first call
+ * @param [in] buf      Bytes to add
+ * @param [in] len      Number of bytes
+ * @return uint32_t     Updated CRC register
+ */
+uint32_t modem_crc32_update( uint32_t crc, const uint8_t* buf, uint32_t len );
+
+/**
+ * @brief Get the CRC-32 value of a CRC register
+ *
+ * @param [in] crc      CRC register returned by modem_crc32_update
+ * @return uint32_t     CRC-32 value
+ */
+static inline uint32_t modem_crc32_final( uint32_t crc )
+{
+    return ~crc;
+}
+
+/**
+ * @brief Compute the CRC-32 of a buffer
+ *
+ * @param [in] buf      Input buffer
+ * @param [in] len      Input buffer length
+ * @return uint32_t     CRC-32 value
+ */
+static inline uint32_t modem_crc32( const uint8_t* buf, uint32_t len )
+{
+    return modem_crc32_final( modem_crc32_update( MODEM_CRC32_INIT, buf, len ) );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __MODEM_CRC_H__
+
+/* --- EOF ------------------------------------------------------------------ */
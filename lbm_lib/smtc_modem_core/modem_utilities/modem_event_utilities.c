@@ -38,6 +38,7 @@
  */
 #include <stdint.h>   // C99 types
 #include <stdbool.h>  // bool type
+#include <string.h>   // for memset
 
 #include "modem_event_utilities.h"
 #include "smtc_modem_hal_dbg_trace.h"
@@ -45,21 +46,26 @@
  * -----------------------------------------------------------------------------
  * --- PRIVATE CONSTANTS -------------------------------------------------------
  */
+#define MODEM_EVENT_QUEUE_MASK ( MODEM_EVENT_QUEUE_SIZE - 1 )
+
+// Events are pushed by the modem engine and popped by the host, each counter has a single writer
 struct
 {
-    uint8_t asynchronous_msgnumber;
-    uint8_t modem_event_stack_id[MODEM_NUMBER_OF_EVENTS];
-    uint8_t modem_event_count[MODEM_NUMBER_OF_EVENTS];
-    uint8_t modem_event_status[MODEM_NUMBER_OF_EVENTS];
-    uint8_t asynch_msg[MODEM_NUMBER_OF_EVENTS];
+    modem_event_t    events[MODEM_EVENT_QUEUE_SIZE];
+    volatile uint8_t write_cnt;
+    volatile uint8_t read_cnt;
+    uint8_t          high_water_mark;
+    uint16_t         folded_events;
+    uint16_t         dropped_events;
     void ( *app_callback )( void );
 } modem_event_ctx;
 
-#define asynchronous_msgnumber modem_event_ctx.asynchronous_msgnumber
-#define modem_event_count modem_event_ctx.modem_event_count
-#define modem_event_stack_id modem_event_ctx.modem_event_stack_id
-#define modem_event_status modem_event_ctx.modem_event_status
-#define asynch_msg modem_event_ctx.asynch_msg
+#define modem_events modem_event_ctx.events
+#define write_cnt modem_event_ctx.write_cnt
+#define read_cnt modem_event_ctx.read_cnt
+#define high_water_mark modem_event_ctx.high_water_mark
+#define folded_events modem_event_ctx.folded_events
+#define dropped_events modem_event_ctx.dropped_events
 #define app_callback modem_event_ctx.app_callback
 
 /*
@@ -76,109 +82,158 @@ struct
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
+
+/*!
+ * \brief Find the newest queued event of a type
+ *
+ * \param [in] event_type type of event
+ * \param [in] stack_id   stack identifier
+ *
+ * \return The queued event, NULL if there is none
+ */
+static modem_event_t* modem_event_find_newest( uint8_t event_type, uint8_t stack_id );
+
+/*!
+ * \brief Copy the event specific data in a queued event
+ *
+ * \param [in] event   queued event
+ * \param [in] payload event specific data, NULL to zero it
+ */
+static void modem_event_set_payload( modem_event_t* event, const modem_event_payload_t* payload );
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
  */
 void modem_event_init( void ( *callback )( void ) )
 {
-    for( int i = 0; i < MODEM_NUMBER_OF_EVENTS; i++ )
-    {
-        set_modem_event_count_and_status( i, 0, 0 );
-    }
-    asynchronous_msgnumber = 0;
-    app_callback           = callback;
+    memset( &modem_event_ctx, 0, sizeof( modem_event_ctx ) );
+    app_callback = callback;
 }
-uint8_t get_modem_event_count( smtc_modem_event_type_t event_type )
-{
-    if( event_type >= MODEM_NUMBER_OF_EVENTS )
-    {
-        SMTC_MODEM_HAL_PANIC( );
-    }
 
-    return ( modem_event_count[event_type] );
+uint8_t get_asynchronous_msgnumber( void )
+{
+    return ( uint8_t ) ( write_cnt - read_cnt );
 }
 
-uint8_t get_modem_event_status( uint8_t event_type )
+void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id )
 {
-    if( event_type >= MODEM_NUMBER_OF_EVENTS )
-    {
-        SMTC_MODEM_HAL_PANIC( );
-    }
-    return ( modem_event_status[event_type] );
+    modem_event_push( event_type, status, stack_id, NULL );
 }
 
-void set_modem_event_count_and_status( uint8_t event_type, uint8_t value, uint8_t status )
+void modem_event_push( uint8_t event_type, uint8_t status, uint8_t stack_id, const modem_event_payload_t* payload )
 {
-    if( event_type < MODEM_NUMBER_OF_EVENTS )
+    if( event_type >= MODEM_NUMBER_OF_EVENTS )
     {
-        modem_event_count[event_type]  = value;
-        modem_event_status[event_type] = status;
+        return;
     }
-}
 
-void increment_modem_event_count_and_status( uint8_t event_type, uint8_t status )
-{
-    if( event_type < MODEM_NUMBER_OF_EVENTS )
+    uint32_t       timestamp_ms = smtc_modem_hal_get_time_in_ms( );
+    uint8_t        nb_events    = get_asynchronous_msgnumber( );
+    modem_event_t* event;
+
+    if( nb_events < MODEM_EVENT_QUEUE_SIZE )
     {
-        if( modem_event_count[event_type] < 255 )
+        event                = &modem_events[write_cnt & MODEM_EVENT_QUEUE_MASK];
+        event->timestamp_ms  = timestamp_ms;
+        event->event_type    = event_type;
+        event->stack_id      = stack_id;
+        event->status        = status;
+        event->missed_events = 0;
+        modem_event_set_payload( event, payload );
+        write_cnt = write_cnt + 1;
+
+        if( ( nb_events + 1 ) > high_water_mark )
         {
-            modem_event_count[event_type]++;
+            high_water_mark = nb_events + 1;
         }
-        // Set last status even if the number of event max is reached
-        modem_event_status[event_type] = status;
     }
-}
-
-void decrement_asynchronous_msgnumber( void )
-{
-    if( asynchronous_msgnumber > 0 )
+    else
     {
-        asynchronous_msgnumber--;
+        // Queue full: keep the last status like a single event per type would
+        event = modem_event_find_newest( event_type, stack_id );
+        if( event != NULL )
+        {
+            if( event->missed_events < 255 )
+            {
+                event->missed_events++;
+            }
+            event->timestamp_ms = timestamp_ms;
+            event->status       = status;
+            modem_event_set_payload( event, payload );
+            if( folded_events < 0xFFFF )
+            {
+                folded_events++;
+            }
+        }
+        else
+        {
+            if( dropped_events < 0xFFFF )
+            {
+                dropped_events++;
+            }
+            SMTC_MODEM_HAL_TRACE_WARNING( "Event queue full, event %d dropped\n", event_type );
+        }
     }
-    else
+
+    if( *app_callback != NULL )
     {
-        asynchronous_msgnumber = 0;
+        app_callback( );
     }
 }
 
-uint8_t get_asynchronous_msgnumber( void )
+bool modem_event_pop( modem_event_t* event )
 {
-    return ( asynchronous_msgnumber );
-}
+    uint8_t read = read_cnt;
 
-void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id )
-{
-    // Next condition should never append because only one asynch msg by type of message
-    if( asynchronous_msgnumber >= MODEM_NUMBER_OF_EVENTS )
+    if( read == write_cnt )
     {
-        return;
+        return false;
     }
-    uint8_t tmp;
-    tmp = get_modem_event_count( event_type );
+    *event   = modem_events[read & MODEM_EVENT_QUEUE_MASK];
+    read_cnt = read + 1;
+    return true;
+}
 
-    if( tmp == 0 )
-    {
-        asynch_msg[asynchronous_msgnumber] = event_type;
-        asynchronous_msgnumber++;
-    }
+void modem_event_get_and_clear_queue_stats( uint8_t* high_water, uint16_t* folded, uint16_t* dropped )
+{
+    *high_water = high_water_mark;
+    *folded     = folded_events;
+    *dropped    = dropped_events;
 
-    increment_modem_event_count_and_status( event_type, status );
-    modem_event_stack_id[event_type] = stack_id;
+    high_water_mark = get_asynchronous_msgnumber( );
+    folded_events   = 0;
+    dropped_events  = 0;
+}
 
-    if( *app_callback != NULL )
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
+ */
+
+static modem_event_t* modem_event_find_newest( uint8_t event_type, uint8_t stack_id )
+{
+    uint8_t nb_events = get_asynchronous_msgnumber( );
+
+    for( uint8_t i = 1; i <= nb_events; i++ )
     {
-        app_callback( );
+        modem_event_t* event = &modem_events[( uint8_t ) ( write_cnt - i ) & MODEM_EVENT_QUEUE_MASK];
+        if( ( event->event_type == event_type ) && ( event->stack_id == stack_id ) )
+        {
+            return event;
+        }
     }
+    return NULL;
 }
 
-uint8_t get_last_msg_event( uint8_t* stack_id )
+static void modem_event_set_payload( modem_event_t* event, const modem_event_payload_t* payload )
 {
-    if( asynchronous_msgnumber > 0 )
+    if( payload != NULL )
+    {
+        event->payload = *payload;
+    }
+    else
     {
-        *stack_id = modem_event_stack_id[asynch_msg[asynchronous_msgnumber - 1]];
-        return asynch_msg[asynchronous_msgnumber - 1];
+        memset( &event->payload, 0, sizeof( modem_event_payload_t ) );
     }
-    *stack_id = 0xFF;
-    return 0xFF;
 }
@@ -46,60 +46,73 @@ extern "C" {
 #define MODEM_NUMBER_OF_EVENTS SMTC_MODEM_EVENT_MAX  // number of possible events in modem
 
 /*!
- * \brief init context of event
- *
- * \param [in]  ( *callback ) user callback when event occurs
- *
- * \return clear the context
+ * \brief Number of events kept until the host gets them, shall be a power of 2
  */
-void modem_event_init( void ( *callback )( void ) );
+#ifndef MODEM_EVENT_QUEUE_SIZE
+#define MODEM_EVENT_QUEUE_SIZE 32
+#endif
+
+#if( ( MODEM_EVENT_QUEUE_SIZE & ( MODEM_EVENT_QUEUE_SIZE - 1 ) ) != 0 ) || ( MODEM_EVENT_QUEUE_SIZE > 128 )
+#error "MODEM_EVENT_QUEUE_SIZE shall be a power of 2 lower than or equal to 128"
+#endif
+
 /*!
- * \brief For each type of event have to manage a counter in case of overrun
- *
- * \param [in] event_type Type of event
- *
- * \return The number of asynchronous events for this type of event since the last get event cmd
+ * \brief Event specific data, kept inline in the queued event
  */
-uint8_t get_modem_event_count( smtc_modem_event_type_t event_type );
+typedef union modem_event_payload_u
+{
+    struct
+    {
+        uint8_t fport;   //!< LoRaWAN port of the downlink
+        uint8_t length;  //!< Length of the downlink payload pushed in the user fifo
+    } downdata;          //!< SMTC_MODEM_EVENT_DOWNDATA
+} modem_event_payload_t;
+
 /*!
- * \brief For each type of event have to manage a status
- *
- * \param [in] event_type  type of event
- *
- * \return The last status of asynchronous event for this type of event since the last get event cmd
+ * \brief Asynchronous event waiting for the host
  */
-uint8_t get_modem_event_status( uint8_t event_type );
+typedef struct modem_event_s
+{
+    uint32_t              timestamp_ms;   //!< Time of the event (of the last folded one)
+    uint8_t               event_type;     //!< Type of event as defined in @ref smtc_modem_event_type_t
+    uint8_t               stack_id;       //!< Stack that raised the event
+    uint8_t               status;         //!< Event specific status
+    uint8_t               missed_events;  //!< Events of the same type folded in this one while the queue was full
+    modem_event_payload_t payload;        //!< Event specific data (of the last folded one), zeroed if none is given
+} modem_event_t;
 
 /*!
- * \brief set a value in the counter of a type of asynchronous event
+ * \brief init context of event
  *
- * \param [in] event_type type of event
- * \param [in] value      value's type of event
- * \param [in] status     status of event
+ * \param [in]  ( *callback ) user callback when event occurs
+ *
+ * \return clear the context
  */
-void set_modem_event_count_and_status( uint8_t event_type, uint8_t value, uint8_t status );
+void modem_event_init( void ( *callback )( void ) );
 
 /*!
- * \brief increment the counter of a type of asynchronous event
+ * \brief Queue an asynchronous event and notify the user
+ *
+ * When the queue is full the event is folded in the newest queued event of the same type and stack, or dropped if
+ * there is none.
  *
  * \param [in] event_type type of asynchronous message
  * \param [in] status     status of asynchronous message
+ * \param [in] stack_id   stack identifier
  */
-void increment_modem_event_count_and_status( uint8_t event_type, uint8_t status );
-
-/*!
- * \brief decrement the asynchronous message number
- * \retval void
- */
-void decrement_asynchronous_msgnumber( void );
+void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id );
 
 /*!
- * \brief increment the asynchronous message number
+ * \brief Queue an asynchronous event carrying event specific data and notify the user
+ *
+ * Same queueing as increment_asynchronous_msgnumber, a folded event takes the status and payload of the new one.
  *
  * \param [in] event_type type of asynchronous message
  * \param [in] status     status of asynchronous message
+ * \param [in] stack_id   stack identifier
+ * \param [in] payload    event specific data, NULL for none
  */
-void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8_t stack_id );
+void modem_event_push( uint8_t event_type, uint8_t status, uint8_t stack_id, const modem_event_payload_t* payload );
 
 /*!
  * \brief get asynchronous message number
@@ -108,13 +121,23 @@ void increment_asynchronous_msgnumber( uint8_t event_type, uint8_t status, uint8
  */
 uint8_t get_asynchronous_msgnumber( void );
 
-/**
- * @brief Get the last message event if asynchronous msgnumber is positive
+/*!
+ * \brief Remove the oldest event from the queue
+ *
+ * \param [out] event Oldest event
+ *
+ * \return true if an event has been returned, false if the queue is empty
+ */
+bool modem_event_pop( modem_event_t* event );
+
+/*!
+ * \brief Get the queue statistics since the last call
  *
- * @param stack_id The Stack Identifier
- * @return uint8_t the last available modem event
+ * \param [out] high_water Largest number of queued events
+ * \param [out] folded     Number of events folded in a queued one because the queue was full
+ * \param [out] dropped    Number of events lost because the queue was full
  */
-uint8_t get_last_msg_event( uint8_t* stack_id );
+void modem_event_get_and_clear_queue_stats( uint8_t* high_water, uint16_t* folded, uint16_t* dropped );
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,574 @@
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "circularfs.h"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+#define SECTOR_SIZE 512
+#define SECTOR_COUNT 6
+#define SECTOR_HEADER_SIZE 40  // sector status and version, the slots follow
+
+/**
+ * NOR flash simulator: erase sets a sector to 0xFF, program only clears bits, by double words programmed once
+ */
+typedef struct flash_sim_s
+{
+    struct circularfs_flash_partition partition;  // first member, the callbacks cast it back
+    uint8_t                           mem[SECTOR_SIZE * SECTOR_COUNT];
+    bool                              cut_headers;  // power cuts also hit the sector headers
+    uint32_t                          errors;       // programming not aligned on a double word, or programmed twice
+} flash_sim_t;
+
+static jmp_buf power_cut;
+static int32_t power_cut_countdown = -1;  // double words programmed before the power cut, -1 for none
+
+static int32_t flash_erase( struct circularfs_flash_partition* flash, uint32_t address )
+{
+    flash_sim_t* sim = ( flash_sim_t* ) flash;
+
+    memset( sim->mem + ( address / SECTOR_SIZE ) * SECTOR_SIZE, 0xFF, SECTOR_SIZE );
+    return 0;
+}
+
+static int32_t flash_program( struct circularfs_flash_partition* flash, uint32_t address, const void* data,
+                              uint32_t size )
+{
+    flash_sim_t*   sim   = ( flash_sim_t* ) flash;
+    const uint8_t* bytes = data;
+
+    if( ( address % 8 ) != 0 )
+    {
+        sim->errors++;
+    }
+    for( uint32_t i = 0; i < size; i++ )
+    {
+        if( ( i % 8 ) == 0 )
+        {
+            // The power is cut before this double word is programmed
+            if( ( ( sim->cut_headers == true ) || ( ( address % SECTOR_SIZE ) >= SECTOR_HEADER_SIZE ) ) &&
+                ( power_cut_countdown > 0 ) && ( --power_cut_countdown == 0 ) )
+            {
+                longjmp( power_cut, 1 );
+            }
+            // A double word already programmed cannot be programmed again
+            for( uint8_t k = 0; ( k < 8 ) && ( ( address + i + k ) < sizeof( sim->mem ) ); k++ )
+            {
+                if( sim->mem[address + i + k] != 0xFF )
+                {
+                    sim->errors++;
+                    break;
+                }
+            }
+        }
+        sim->mem[address + i] &= bytes[i];
+    }
+    return size;
+}
+
+static int32_t flash_read( struct circularfs_flash_partition* flash, uint32_t address, void* data, uint32_t size )
+{
+    flash_sim_t* sim = ( flash_sim_t* ) flash;
+
+    memcpy( data, sim->mem + address, size );
+    return size;
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+#define MAX( a, b ) ( ( ( a ) > ( b ) ) ? ( a ) : ( b ) )
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static void flash_sim_init( flash_sim_t* sim, bool cut_headers )
+{
+    sim->partition.sector_size   = SECTOR_SIZE;
+    sim->partition.sector_offset = 0;
+    sim->partition.sector_count  = SECTOR_COUNT;
+    sim->partition.sector_erase  = flash_erase;
+    sim->partition.program       = flash_program;
+    sim->partition.read          = flash_read;
+    sim->cut_headers             = cut_headers;
+    sim->errors                  = 0;
+    memset( sim->mem, 0xFF, sizeof( sim->mem ) );
+}
+
+/**
+ * Mount after a reboot: scan the flash, format it if there is no valid file system
+ */
+static void mount( struct circularfs* fs, flash_sim_t* sim, bool records, uint32_t* index, uint32_t index_size )
+{
+    if( records == true )
+    {
+        circularfs_init_records( fs, &sim->partition, 2, 128 );
+    }
+    else
+    {
+        circularfs_init( fs, &sim->partition, 1, 20 );
+    }
+    if( index != NULL )
+    {
+        circularfs_set_index( fs, index, index_size );
+    }
+    if( circularfs_scan( fs ) != 0 )
+    {
+        circularfs_format( fs, false );
+    }
+}
+
+static bool loc_is_equal( struct circularfs_loc a, struct circularfs_loc b )
+{
+    return ( a.sector == b.sector ) && ( a.slot == b.slot );
+}
+
+/**
+ * Run an operation on fixed-size objects, the power is cut after `cut` double words, return true if it was
+ */
+static bool object_step( struct circularfs* fs, uint8_t op, uint32_t item, const uint8_t* object, uint8_t* out,
+                         int32_t cut, int32_t* rc )
+{
+    power_cut_countdown = cut;
+    if( setjmp( power_cut ) != 0 )
+    {
+        power_cut_countdown = -1;
+        return true;
+    }
+    if( op < 4 )
+    {
+        *rc = circularfs_append( fs, object );
+    }
+    else if( op < 7 )
+    {
+        *rc = circularfs_fetch( fs, out );
+    }
+    else if( op == 7 )
+    {
+        *rc = circularfs_discard( fs );
+    }
+    else if( op == 8 )
+    {
+        *rc = circularfs_discard_item_x_from_head_position( fs, item );
+        circularfs_rewind( fs );
+    }
+    else
+    {
+        *rc = circularfs_rewind( fs );
+    }
+    power_cut_countdown = -1;
+    return false;
+}
+
+/**
+ * Records carry their sequence number and a length and content derived from it
+ */
+static int32_t record_build( uint32_t seq, uint8_t* record )
+{
+    int32_t size = 5 + ( seq * 7919 ) % 36;
+
+    memcpy( record, &seq, sizeof( seq ) );
+    for( int32_t i = sizeof( seq ); i < size; i++ )
+    {
+        record[i] = ( uint8_t ) ( seq * 31 + i );
+    }
+    return size;
+}
+
+static bool record_check( const uint8_t* record, int32_t size, uint32_t* seq )
+{
+    uint8_t expected[64];
+
+    memcpy( seq, record, sizeof( *seq ) );
+    return ( record_build( *seq, expected ) == size ) && ( memcmp( record, expected, size ) == 0 );
+}
+
+/**
+ * State of the record replay, in sequence numbers
+ */
+typedef struct record_replay_s
+{
+    uint32_t next_seq;     // sequence of the next appended record
+    uint32_t last_acked;   // last record whose append returned
+    uint32_t discarded;    // all records up to this one were discarded, or overwritten
+    uint32_t discarding;   // records up to this one may have been discarded by a discard cut by a power cut
+    uint32_t fetched;      // last record fetched since the last rewind
+    bool     overwritten;  // the oldest records may have been overwritten by the ring since the last check
+    uint8_t  torn[200000]; // records whose append was cut, they may be missing
+    uint32_t errors;
+} record_replay_t;
+
+static record_replay_t replay;
+
+/**
+ * After a reboot, read back all records: they are intact, in order, without gap except torn ones, none of them was
+ * discarded before, and the last acked record is there.
+ */
+static void records_check_after_reboot( struct circularfs* fs )
+{
+    uint8_t  record[64];
+    int32_t  size;
+    uint32_t first = 0;
+    uint32_t prev  = 0;
+
+    circularfs_rewind( fs );
+    while( ( size = circularfs_fetch_record( fs, record, sizeof( record ) ) ) > 0 )
+    {
+        uint32_t seq;
+        if( record_check( record, size, &seq ) == false )
+        {
+            replay.errors++;
+            break;
+        }
+        if( first == 0 )
+        {
+            first = seq;
+            // A discarded record shall not come back, an undiscarded one shall not be lost unless overwritten
+            uint32_t expected = MAX( replay.discarded, replay.discarding ) + 1;
+            while( ( expected < seq ) && ( replay.torn[expected] != 0 ) )
+            {
+                expected++;
+            }
+            if( ( seq <= replay.discarded ) || ( ( replay.overwritten == false ) && ( seq > expected ) ) )
+            {
+                replay.errors++;
+            }
+        }
+        else
+        {
+            uint32_t expected = prev + 1;
+            while( ( expected < seq ) && ( replay.torn[expected] != 0 ) )
+            {
+                expected++;
+            }
+            if( seq != expected )
+            {
+                replay.errors++;
+            }
+        }
+        prev = seq;
+    }
+    if( ( replay.last_acked != 0 ) && ( prev < replay.last_acked ) && ( replay.overwritten == false ) )
+    {
+        replay.errors++;
+    }
+    if( circularfs_count_estimate_from_last_fetch( fs ) != 0 )
+    {
+        replay.errors++;
+    }
+    if( first > ( replay.discarded + 1 ) )
+    {
+        replay.discarded = first - 1;
+    }
+    replay.discarding  = replay.discarded;
+    replay.overwritten = false;
+    replay.fetched     = 0;
+    circularfs_rewind( fs );
+}
+
+/**
+ * Random appends, fetches, discards and rewinds in record mode with power cuts and reboots
+ */
+static void records_replay( uint32_t seed, uint32_t steps, bool use_index, uint32_t* nb_cuts )
+{
+    static flash_sim_t       sim;
+    static struct circularfs fs;
+    static uint32_t          index[64];
+
+    rnd_state = seed;
+    memset( &replay, 0, sizeof( replay ) );
+    replay.next_seq = 1;
+    flash_sim_init( &sim, false );
+    mount( &fs, &sim, true, ( use_index == true ) ? index : NULL, sizeof( index ) );
+
+    for( uint32_t step = 0; ( step < steps ) && ( replay.next_seq < sizeof( replay.torn ) ); step++ )
+    {
+        volatile uint8_t op     = rnd( ) % 20;
+        volatile bool    append = false;
+
+        power_cut_countdown = ( ( rnd( ) % 40 ) == 0 ) ? ( int32_t ) ( 1 + rnd( ) % 20 ) : -1;
+
+        if( setjmp( power_cut ) == 0 )
+        {
+            if( op < 11 )
+            {
+                uint8_t               record[64];
+                int32_t               size      = record_build( replay.next_seq, record );
+                struct circularfs_loc read_prev = fs.read;
+
+                append = true;
+                if( circularfs_append_record( &fs, record, size ) != 0 )
+                {
+                    replay.errors++;
+                }
+                replay.last_acked = replay.next_seq++;
+                append            = false;
+                if( loc_is_equal( read_prev, fs.read ) == false )
+                {
+                    replay.overwritten = true;
+                }
+            }
+            else if( op < 17 )
+            {
+                uint8_t  record[64];
+                int32_t  size = circularfs_fetch_record( &fs, record, sizeof( record ) );
+                uint32_t seq;
+
+                if( size > 0 )
+                {
+                    if( record_check( record, size, &seq ) == false )
+                    {
+                        replay.errors++;
+                    }
+                    replay.fetched = seq;
+                }
+            }
+            else if( op < 19 )
+            {
+                replay.discarding = ( replay.fetched != 0 ) ? replay.fetched : replay.discarded;
+                circularfs_discard( &fs );
+                replay.discarded = replay.discarding;
+            }
+            else
+            {
+                circularfs_rewind( &fs );
+                replay.fetched = 0;
+            }
+            power_cut_countdown = -1;
+        }
+        else
+        {
+            // Power cut: the record being appended may be lost, reboot
+            power_cut_countdown = -1;
+            ( *nb_cuts )++;
+            if( append == true )
+            {
+                replay.torn[replay.next_seq++] = 1;
+                replay.overwritten             = true;
+            }
+            mount( &fs, &sim, true, ( use_index == true ) ? index : NULL, sizeof( index ) );
+            records_check_after_reboot( &fs );
+            continue;
+        }
+        if( ( rnd( ) % 2000 ) == 0 )
+        {
+            mount( &fs, &sim, true, ( use_index == true ) ? index : NULL, sizeof( index ) );
+            records_check_after_reboot( &fs );
+        }
+    }
+    mount( &fs, &sim, true, ( use_index == true ) ? index : NULL, sizeof( index ) );
+    records_check_after_reboot( &fs );
+    replay.errors += sim.errors;
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies with fixed-size objects and power cuts that an instance with the RAM index writes the same flash, moves the
+ * same pointers and counts the same objects as one without, and that the index always equals a rebuild by a scan.
+ */
+void test_index_matches_flash( )
+{
+    static flash_sim_t       sim_a;
+    static flash_sim_t       sim_b;
+    static struct circularfs fs_a;
+    static struct circularfs fs_b;
+    static struct circularfs fs_check;
+    static uint32_t          index[64];
+    static uint32_t          index_check[64];
+    uint32_t                 errors = 0;
+    uint32_t                 cuts   = 0;
+
+    rnd_state = 1;
+    flash_sim_init( &sim_a, true );
+    flash_sim_init( &sim_b, true );
+    mount( &fs_a, &sim_a, false, NULL, 0 );
+    mount( &fs_b, &sim_b, false, index, sizeof( index ) );
+
+    for( uint32_t step = 0; step < 300000; step++ )
+    {
+        uint8_t  object[20];
+        uint8_t  object_a[20];
+        uint8_t  object_b[20];
+        uint8_t  op   = rnd( ) % 10;
+        uint32_t item = rnd( ) % 8;
+        int32_t  cut  = ( ( rnd( ) % 50 ) == 0 ) ? ( int32_t ) ( 1 + rnd( ) % 200 ) : -1;
+        int32_t  rc[2];
+        bool     is_cut[2];
+
+        memset( object, rnd( ), sizeof( object ) );
+        memset( object_a, 0, sizeof( object_a ) );
+        memset( object_b, 0, sizeof( object_b ) );
+
+        // Same operation and same power cut on both instances
+        is_cut[0] = object_step( &fs_a, op, item, object, object_a, cut, &rc[0] );
+        is_cut[1] = object_step( &fs_b, op, item, object, object_b, cut, &rc[1] );
+
+        if( ( is_cut[0] != is_cut[1] ) || ( memcmp( sim_a.mem, sim_b.mem, sizeof( sim_a.mem ) ) != 0 ) )
+        {
+            errors++;
+            break;
+        }
+        if( ( is_cut[0] == true ) || ( ( rnd( ) % 500 ) == 0 ) )
+        {
+            cuts += ( is_cut[0] == true ) ? 1 : 0;
+            mount( &fs_a, &sim_a, false, NULL, 0 );
+            mount( &fs_b, &sim_b, false, index, sizeof( index ) );
+        }
+        else if( ( rc[0] != rc[1] ) || ( memcmp( object_a, object_b, sizeof( object_a ) ) != 0 ) )
+        {
+            errors++;
+        }
+        if( ( loc_is_equal( fs_a.read, fs_b.read ) == false ) || ( loc_is_equal( fs_a.write, fs_b.write ) == false ) ||
+            ( loc_is_equal( fs_a.cursor, fs_b.cursor ) == false ) ||
+            ( circularfs_count_exact( &fs_a ) != circularfs_count_exact( &fs_b ) ) ||
+            ( circularfs_count_exact_from_last_fetch( &fs_a ) != circularfs_count_exact_from_last_fetch( &fs_b ) ) )
+        {
+            errors++;
+        }
+
+        // The index kept up to date equals the index rebuilt from flash
+        circularfs_init( &fs_check, &sim_b.partition, 1, 20 );
+        circularfs_set_index( &fs_check, index_check, sizeof( index_check ) );
+        if( ( circularfs_scan( &fs_check ) == 0 ) &&
+            ( memcmp( index, index_check, circularfs_get_index_size( &fs_check ) ) != 0 ) )
+        {
+            errors++;
+        }
+    }
+    printf( "     %u power cuts\n", cuts );
+    print_result( "test_index_matches_flash", ( errors == 0 ) && ( cuts > 0 ) );
+}
+
+/**
+ * Verifies that variable-length records are packed in the slots, read back in order and intact, and that peek
+ * returns the record the next fetch returns.
+ */
+void test_records_packing( )
+{
+    static flash_sim_t       sim;
+    static struct circularfs fs;
+    uint8_t                  record[64];
+    uint8_t                  peeked[64];
+    bool                     passed = true;
+    uint32_t                 seq;
+
+    flash_sim_init( &sim, false );
+    mount( &fs, &sim, true, NULL, 0 );
+
+    for( uint32_t i = 1; i <= 24; i++ )
+    {
+        int32_t size = record_build( i, record );
+        passed       = passed && ( circularfs_append_record( &fs, record, size ) == 0 );
+    }
+    // Counts are in slots: records of 5 to 40 bytes share the slots of 128 bytes
+    int32_t slots = circularfs_count_exact( &fs );
+    printf( "     24 records in %d slots\n", slots );
+    passed = passed && ( slots > 1 ) && ( slots < 12 ) && ( slots < circularfs_capacity( &fs ) );
+
+    for( uint32_t i = 1; i <= 24; i++ )
+    {
+        int32_t peek_size = circularfs_peek_record( &fs, peeked, sizeof( peeked ) );
+        int32_t size      = circularfs_fetch_record( &fs, record, sizeof( record ) );
+        passed            = passed && ( peek_size == size ) && ( memcmp( peeked, record, size ) == 0 );
+        passed            = passed && record_check( record, size, &seq ) && ( seq == i );
+    }
+    passed = passed && ( circularfs_fetch_record( &fs, record, sizeof( record ) ) < 0 );
+    passed = passed && ( circularfs_get_record_size_max( &fs ) < 128 ) && ( sim.errors == 0 );
+    print_result( "test_records_packing", passed );
+}
+
+/**
+ * Verifies that records fetched and discarded from a partly read slot, or from the slot still open for new records,
+ * are not fetched again after a reboot, and that the records appended after them are.
+ */
+void test_records_discard_persists( )
+{
+    static flash_sim_t       sim;
+    static struct circularfs fs;
+    static const uint8_t     cases[][2] = { { 3, 2 }, { 10, 5 }, { 10, 7 } };  // records appended, then fetched
+    uint8_t                  record[64];
+    bool                     passed = true;
+    uint32_t                 seq;
+
+    for( uint8_t c = 0; c < sizeof( cases ) / sizeof( cases[0] ); c++ )
+    {
+        flash_sim_init( &sim, false );
+        mount( &fs, &sim, true, NULL, 0 );
+
+        for( uint32_t i = 1; i <= cases[c][0]; i++ )
+        {
+            circularfs_append_record( &fs, record, record_build( i, record ) );
+        }
+        for( uint32_t i = 1; i <= cases[c][1]; i++ )
+        {
+            circularfs_fetch_record( &fs, record, sizeof( record ) );
+        }
+        circularfs_discard( &fs );
+        circularfs_append_record( &fs, record, record_build( cases[c][0] + 1, record ) );
+
+        mount( &fs, &sim, true, NULL, 0 );
+        for( uint32_t i = cases[c][1] + 1; i <= cases[c][0] + 1u; i++ )
+        {
+            passed = passed && record_check( record, circularfs_fetch_record( &fs, record, sizeof( record ) ), &seq ) &&
+                     ( seq == i );
+        }
+        passed = passed && ( circularfs_fetch_record( &fs, record, sizeof( record ) ) < 0 ) && ( sim.errors == 0 );
+    }
+    print_result( "test_records_discard_persists", passed );
+}
+
+/**
+ * Verifies with random appends, fetches, discards, power cuts and reboots, with and without the RAM index, that
+ * records are never corrupted, reordered or lost except the one being appended, and that discarded records are never
+ * fetched again after a reboot.
+ */
+void test_records_power_cuts( )
+{
+    uint32_t errors = 0;
+    uint32_t cuts   = 0;
+
+    for( uint8_t use_index = 0; use_index < 2; use_index++ )
+    {
+        records_replay( 7 + use_index, 400000, use_index == 1, &cuts );
+        errors += replay.errors;
+    }
+    printf( "     %u power cuts\n", cuts );
+    print_result( "test_records_power_cuts", ( errors == 0 ) && ( cuts > 0 ) );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_index_matches_flash( );
+    test_records_packing( );
+    test_records_discard_persists( );
+    test_records_power_cuts( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modem_event_utilities.h"
+
+static int test_counter = 1;
+static int passed_count = 0;
+static int failed_count = 0;
+
+void print_result( const char* test_name, int passed )
+{
+    printf( "[%02d] %s : %s\n", test_counter++, test_name, passed ? "PASSED" : "** FAILED **" );
+    if( passed )
+        passed_count++;
+    else
+        failed_count++;
+}
+
+// --- STUBS -------------------------------------------------------------------
+
+static uint32_t now_ms;
+static uint32_t nb_callbacks;
+
+uint32_t smtc_modem_hal_get_time_in_ms( void )
+{
+    return now_ms;
+}
+
+static void app_callback( void )
+{
+    nb_callbacks++;
+}
+
+// --- HELPERS -----------------------------------------------------------------
+
+static uint32_t rnd_state;
+
+static uint32_t rnd( void )
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+/**
+ * Reference queue: the pending events in order, a full queue folds an event in the newest one of the same type and
+ * stack or drops it
+ */
+static modem_event_t model[MODEM_EVENT_QUEUE_SIZE];
+static uint32_t      model_size;
+static uint32_t      model_high_water;
+static uint32_t      model_folded;
+static uint32_t      model_dropped;
+
+static void setup( uint32_t seed )
+{
+    rnd_state        = seed;
+    now_ms           = 0;
+    nb_callbacks     = 0;
+    model_size       = 0;
+    model_high_water = 0;
+    model_folded     = 0;
+    model_dropped    = 0;
+    modem_event_init( app_callback );
+}
+
+static void push( uint8_t event_type, uint8_t status, uint8_t stack_id, const modem_event_payload_t* payload )
+{
+    modem_event_t event = { 0 };
+
+    now_ms += 1 + rnd( ) % 1000;
+    event.timestamp_ms = now_ms;
+    event.event_type   = event_type;
+    event.stack_id     = stack_id;
+    event.status       = status;
+    if( payload != NULL )
+    {
+        event.payload = *payload;
+    }
+
+    if( model_size < MODEM_EVENT_QUEUE_SIZE )
+    {
+        model[model_size++] = event;
+        model_high_water    = ( model_size > model_high_water ) ? model_size : model_high_water;
+    }
+    else
+    {
+        int32_t i = MODEM_EVENT_QUEUE_SIZE - 1;
+
+        while( ( i >= 0 ) && ( ( model[i].event_type != event_type ) || ( model[i].stack_id != stack_id ) ) )
+        {
+            i--;
+        }
+        if( i >= 0 )
+        {
+            event.missed_events = ( model[i].missed_events < 255 ) ? model[i].missed_events + 1 : 255;
+            model[i]            = event;
+            model_folded++;
+        }
+        else
+        {
+            model_dropped++;
+        }
+    }
+
+    if( payload != NULL )
+    {
+        modem_event_push( event_type, status, stack_id, payload );
+    }
+    else
+    {
+        increment_asynchronous_msgnumber( event_type, status, stack_id );
+    }
+}
+
+static void push_random( void )
+{
+    modem_event_payload_t payload;
+    uint8_t               event_type = SMTC_MODEM_EVENT_JOINED + rnd( ) % 3;  // joined, txdone or downdata
+
+    if( event_type == SMTC_MODEM_EVENT_DOWNDATA )
+    {
+        payload.downdata.fport  = 1 + rnd( ) % 223;
+        payload.downdata.length = rnd( ) % 243;
+        push( event_type, 0, rnd( ) % 2, &payload );
+    }
+    else
+    {
+        push( event_type, rnd( ), rnd( ) % 2, NULL );
+    }
+}
+
+static bool same_event( const modem_event_t* a, const modem_event_t* b )
+{
+    return ( a->timestamp_ms == b->timestamp_ms ) && ( a->event_type == b->event_type ) &&
+           ( a->stack_id == b->stack_id ) && ( a->status == b->status ) && ( a->missed_events == b->missed_events ) &&
+           ( a->payload.downdata.fport == b->payload.downdata.fport ) &&
+           ( a->payload.downdata.length == b->payload.downdata.length );
+}
+
+/**
+ * Pop one event from the queue and the model, true if they match
+ */
+static bool pop_and_check( void )
+{
+    modem_event_t event;
+
+    if( model_size == 0 )
+    {
+        return ( modem_event_pop( &event ) == false ) && ( get_asynchronous_msgnumber( ) == 0 );
+    }
+    if( ( modem_event_pop( &event ) == false ) || ( same_event( &event, &model[0] ) == false ) )
+    {
+        return false;
+    }
+    model_size--;
+    memmove( &model[0], &model[1], model_size * sizeof( modem_event_t ) );
+    return get_asynchronous_msgnumber( ) == model_size;
+}
+
+static bool stats_match( void )
+{
+    uint8_t  high_water;
+    uint16_t folded;
+    uint16_t dropped;
+    bool     match;
+
+    modem_event_get_and_clear_queue_stats( &high_water, &folded, &dropped );
+    match            = ( high_water == model_high_water ) && ( folded == model_folded ) && ( dropped == model_dropped );
+    model_high_water = model_size;
+    model_folded     = 0;
+    model_dropped    = 0;
+    return match;
+}
+
+// --- TEST FUNCTIONS ----------------------------------------------------------
+
+/**
+ * Verifies that the events are popped in the order they were pushed, with their own status, stack, timestamp and
+ * payload, and that the user is notified for each one.
+ */
+void test_event_order( )
+{
+    bool passed = true;
+
+    setup( 1 );
+    for( uint32_t i = 0; i < MODEM_EVENT_QUEUE_SIZE; i++ )
+    {
+        push_random( );
+    }
+    passed = passed && ( nb_callbacks == MODEM_EVENT_QUEUE_SIZE ) &&
+             ( get_asynchronous_msgnumber( ) == MODEM_EVENT_QUEUE_SIZE );
+    for( uint32_t i = 0; i < MODEM_EVENT_QUEUE_SIZE + 1; i++ )
+    {
+        passed = passed && pop_and_check( );
+    }
+
+    // Unknown events are ignored
+    increment_asynchronous_msgnumber( SMTC_MODEM_EVENT_MAX, 0, 0 );
+    passed = passed && ( get_asynchronous_msgnumber( ) == 0 ) && ( nb_callbacks == MODEM_EVENT_QUEUE_SIZE );
+    passed = passed && stats_match( );
+    print_result( "test_event_order", passed );
+}
+
+/**
+ * Verifies that on a full queue an event is folded in the newest queued event of the same type and stack, which
+ * takes its status, timestamp and payload, and is dropped when there is none, with matching queue statistics.
+ */
+void test_fold_and_drop( )
+{
+    modem_event_payload_t payload = { 0 };
+    bool                  passed  = true;
+
+    setup( 2 );
+    for( uint32_t i = 0; i < MODEM_EVENT_QUEUE_SIZE; i++ )
+    {
+        payload.downdata.fport  = i + 1;
+        payload.downdata.length = i;
+        if( ( i % 2 ) == 0 )
+        {
+            push( SMTC_MODEM_EVENT_DOWNDATA, 0, 0, &payload );
+        }
+        else
+        {
+            push( SMTC_MODEM_EVENT_TXDONE, i, 0, NULL );
+        }
+    }
+
+    // Folded in the newest pending downlink and txdone of stack 0
+    for( uint32_t i = 0; i < 300; i++ )
+    {
+        payload.downdata.fport  = 100 + i % 100;
+        payload.downdata.length = i;
+        push( SMTC_MODEM_EVENT_DOWNDATA, 0, 0, &payload );
+        push( SMTC_MODEM_EVENT_TXDONE, i, 0, NULL );
+    }
+    // Dropped, no pending event of this type or stack
+    push( SMTC_MODEM_EVENT_JOINED, 0, 0, NULL );
+    push( SMTC_MODEM_EVENT_DOWNDATA, 0, 1, &payload );
+
+    passed = passed && ( get_asynchronous_msgnumber( ) == MODEM_EVENT_QUEUE_SIZE ) && ( model_folded == 600 ) &&
+             ( model_dropped == 2 ) && ( model[MODEM_EVENT_QUEUE_SIZE - 1].missed_events == 255 );
+    passed = passed && stats_match( );
+    for( uint32_t i = 0; i < MODEM_EVENT_QUEUE_SIZE + 1; i++ )
+    {
+        passed = passed && pop_and_check( );
+    }
+    passed = passed && stats_match( );
+    print_result( "test_fold_and_drop", passed );
+}
+
+/**
+ * Verifies against the reference queue that random bursts of pushes and pops keep the order, the folds and the drops
+ * right while the read and write counters wrap around many times.
+ */
+void test_wrap_around( )
+{
+    bool passed = true;
+
+    setup( 3 );
+    for( uint32_t round = 0; round < 20000; round++ )
+    {
+        uint32_t nb_push = rnd( ) % ( MODEM_EVENT_QUEUE_SIZE + 4 );
+        uint32_t nb_pop  = rnd( ) % ( MODEM_EVENT_QUEUE_SIZE + 4 );
+
+        for( uint32_t i = 0; i < nb_push; i++ )
+        {
+            push_random( );
+        }
+        for( uint32_t i = 0; i < nb_pop; i++ )
+        {
+            passed = passed && pop_and_check( );
+        }
+        if( ( round % 100 ) == 0 )
+        {
+            passed = passed && stats_match( );
+        }
+    }
+    print_result( "test_wrap_around", passed );
+}
+
+// --- MAIN ---------------------------------------------------------------------
+
+int main( )
+{
+    test_event_order( );
+    test_fold_and_drop( );
+    test_wrap_around( );
+
+    printf( "\n---- TEST SUMMARY ----\n" );
+    printf( "Tests passed : %d\n", passed_count );
+    printf( "Tests failed : %d\n", failed_count );
+    printf( "-----------------------\n" );
+
+    return failed_count == 0 ? 0 : 1;
+}
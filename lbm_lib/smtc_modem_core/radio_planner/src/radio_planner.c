@@ -59,6 +59,12 @@
 #define TARGET_RADIO rp->radio_target_attached_to_this_hook[rp->radio_task_id]
 #define TARGET_RAL_FOR_HOOK_ID &( rp->radio_target_attached_to_this_hook[hook_id]->ral )
 
+#if defined( ADD_RP_TIMELINE )
+#define RP_TIMELINE_RECORD( rp, event, task, info, time_ms ) rp_timeline_record( rp, event, task, info, time_ms )
+#else
+#define RP_TIMELINE_RECORD( rp, event, task, info, time_ms )
+#endif  // ADD_RP_TIMELINE
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
@@ -97,11 +103,24 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
 static void rp_irq_get_status( radio_planner_t* rp, const uint8_t hook_id );
 
 /**
- * @brief rp_task_compute_ranking compute the ranking of the different tasks inside the radio planner
+ * @brief rp_task_update_ranking move a task to its place in the ranking after its priority has changed
+ *
+ * The ranking is kept sorted by increasing priority value, the highest hook id first for a same priority value
+ *
+ * @param rp pointer to the radioplanner object itself
+ * @param hook_id id of the task which priority has changed
+ */
+static void rp_task_update_ranking( radio_planner_t* rp, const uint8_t hook_id );
+
+/**
+ * @brief rp_task_has_precedence compare the rank of two tasks
  *
  * @param rp pointer to the radioplanner object itself
+ * @param hook_id_a id of the first task
+ * @param hook_id_b id of the second task
+ * @return true if the first task is ranked before the second one
  */
-static void rp_task_compute_ranking( radio_planner_t* rp );
+static bool rp_task_has_precedence( const radio_planner_t* rp, const uint8_t hook_id_a, const uint8_t hook_id_b );
 
 /**
  * @brief rp_task_launch_current call  the launch callback of the new running task
@@ -130,14 +149,6 @@ static uint8_t rp_task_select_next( radio_planner_t* rp, const uint32_t now );
  */
 static rp_next_state_status_t rp_task_get_next( radio_planner_t* rp, uint32_t* duration, uint8_t* task_id,
                                                 const uint32_t now );
-/**
- * @brief rp_task_find_highest_priority utilities to classify priority task (value 0 is the highest priority)
- *
- * @param vector a vector of value to classify from the lowest to the highest
- * @param length size of the vector
- * @return uint8_t index of the vector to indicate the position inside the vector of the minimum value
- */
-static uint8_t rp_task_find_highest_priority( uint8_t* vector, uint8_t length );
 
 /**
  * @brief rp_get_pkt_payload get the receive payload
@@ -185,6 +196,22 @@ static void rp_consumption_statistics_updated( radio_planner_t* rp, const uint8_
  */
 static void rp_timer_irq_callback( void* obj );
 
+#if defined( ADD_LBT_TIMER_SAMPLING )
+/**
+ * @brief rp_arm_timer start the modem timer on the earliest of the planner alarm and the task alarm
+ *
+ * @param rp pointer to the radioplanner object itself
+ */
+static void rp_arm_timer( radio_planner_t* rp );
+
+/**
+ * @brief rp_timer_expired sort out which of the planner alarm and the task alarm have expired
+ *
+ * @param rp pointer to the radioplanner object itself
+ */
+static void rp_timer_expired( radio_planner_t* rp );
+#endif  // ADD_LBT_TIMER_SAMPLING
+
 /**
  * @brief rp_hook_callback call the callback associated to the id
  *
@@ -201,6 +228,20 @@ static void rp_hook_callback( radio_planner_t* rp, uint8_t id );
  */
 static void rp_task_print( const radio_planner_t* rp, const rp_task_t* task );
 
+#if defined( ADD_RP_TIMELINE )
+/**
+ * @brief rp_timeline_record append an event about a task to the timeline recorder
+ *
+ * @param rp pointer to the radioplanner object itself
+ * @param event event type
+ * @param task task concerned by the event
+ * @param info event specific information
+ * @param time_ms time of the event
+ */
+static void rp_timeline_record( radio_planner_t* rp, rp_timeline_event_type_t event, const rp_task_t* task,
+                                uint8_t info, uint32_t time_ms );
+#endif  // ADD_RP_TIMELINE
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -223,6 +264,8 @@ void rp_init( radio_planner_t* rp, const ralf_t* radio )
         rp->tasks[i].launch_task_callbacks        = NULL;
         rp->hook_callbacks[i]                     = NULL;
         rp->status[i]                             = RP_STATUS_TASK_INIT;
+        // All priorities are equal after reset: the highest hook id is ranked first
+        rp->rankings[i] = RP_NB_HOOKS - 1 - i;
     }
     rp->priority_task.type  = RP_TASK_TYPE_NONE;
     rp->priority_task.state = RP_TASK_STATE_FINISHED;
@@ -231,6 +274,9 @@ void rp_init( radio_planner_t* rp, const ralf_t* radio )
     rp->next_state_status = RP_STATUS_NO_MORE_TASK_SCHEDULE;
     rp->margin_delay      = RP_MARGIN_DELAY;
     rp->disable_failsafe  = 0;
+#if defined( ADD_RP_TIMELINE )
+    rp_timeline_init( &rp->timeline );
+#endif  // ADD_RP_TIMELINE
 }
 rp_hook_status_t rp_attach_new_radio( radio_planner_t* rp, const ralf_t* radio, const uint8_t hook_id )
 {
@@ -319,6 +365,7 @@ rp_hook_status_t rp_task_enqueue( radio_planner_t* rp, const rp_task_t* task, ui
         SMTC_MODEM_HAL_TRACE_PRINTF(
             " RP: Task #%u enqueue impossible. Task is in past start_time_ms:%d - now:%d = %d\n", hook_id,
             task->start_time_ms, now, task->start_time_ms - now );
+        RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ENQUEUE_REJECTED, task, RP_TASK_STATUS_SCHEDULE_TASK_IN_PAST, now );
         return RP_TASK_STATUS_SCHEDULE_TASK_IN_PAST;
     }
 
@@ -328,12 +375,14 @@ rp_hook_status_t rp_task_enqueue( radio_planner_t* rp, const rp_task_t* task, ui
         SMTC_MODEM_HAL_TRACE_PRINTF(
             " RP: Task enqueue impossible. Task is too far in future start_time_ms:%d - now:%d = %d\n",
             task->start_time_ms, now, task->start_time_ms - now );
+        RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ENQUEUE_REJECTED, task, RP_TASK_STATUS_TASK_TOO_FAR_IN_FUTURE, now );
         return RP_TASK_STATUS_TASK_TOO_FAR_IN_FUTURE;
     }
 
     if( rp->tasks[hook_id].state == RP_TASK_STATE_RUNNING )
     {
         SMTC_MODEM_HAL_TRACE_PRINTF( " RP: Task enqueue impossible. Task is already running\n" );
+        RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ENQUEUE_REJECTED, task, RP_TASK_STATUS_ALREADY_RUNNING, now );
         return RP_TASK_STATUS_ALREADY_RUNNING;
     }
     if( rp->tasks[hook_id].state != RP_TASK_STATE_FINISHED )
@@ -355,7 +404,8 @@ rp_hook_status_t rp_task_enqueue( radio_planner_t* rp, const rp_task_t* task, ui
     }
     rp->tasks[hook_id].start_time_init_ms = rp->tasks[hook_id].start_time_ms;
     SMTC_MODEM_HAL_RP_TRACE_PRINTF( "RP: Task #%u enqueue with #%u priority\n", hook_id, rp->tasks[hook_id].priority );
-    rp_task_compute_ranking( rp );
+    rp_task_update_ranking( rp, hook_id );
+    RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ENQUEUE, &rp->tasks[hook_id], rp->tasks[hook_id].state, now );
     if( rp->radio_irq_flag == false )
     {
         rp_task_arbiter( rp, __func__ );
@@ -376,6 +426,8 @@ rp_hook_status_t rp_task_abort( radio_planner_t* rp, const uint8_t hook_id )
     {
         return RP_HOOK_STATUS_OK;
     }
+    RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[hook_id], RP_TIMELINE_ABORT_USER,
+                        smtc_modem_hal_get_time_in_ms( ) );
 
     if( rp->tasks[hook_id].state == RP_TASK_STATE_RUNNING )
     {
@@ -440,6 +492,13 @@ void rp_callback( radio_planner_t* rp )
     {
         SMTC_MODEM_HAL_PANIC( "RP_FAILSAFE - #%d\n", rp->radio_task_id );
     }
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    if( rp->timer_expired_flag == true )
+    {
+        rp->timer_expired_flag = false;
+        rp_timer_expired( rp );
+    }
+#endif  // ADD_LBT_TIMER_SAMPLING
     if( ( rp->radio_irq_flag == false ) && ( rp->timer_irq_flag == false ) )
     {
         return;
@@ -463,6 +522,8 @@ void rp_callback( radio_planner_t* rp )
             {
                 return;
             }
+            RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_IRQ, &rp->tasks[rp->radio_task_id], rp->status[rp->radio_task_id],
+                                rp->irq_timestamp_ms[rp->radio_task_id] );
 
             // Compute statistics after LR-FHSS hopping interrupts to have the correct TOA and not only by hop
             rp_consumption_statistics_updated( rp, rp->radio_task_id, rp->irq_timestamp_ms[rp->radio_task_id] );
@@ -533,6 +594,12 @@ bool rp_get_irq_flag( void* obj )
     {
         return true;
     }
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    else if( rp->timer_expired_flag == true )
+    {
+        return true;
+    }
+#endif  // ADD_LBT_TIMER_SAMPLING
     else
     {
         return false;
@@ -565,6 +632,18 @@ bool rp_radio_is_free( radio_planner_t* rp )
         return true;
     }
 }
+
+#if defined( ADD_LBT_TIMER_SAMPLING )
+void rp_task_set_alarm( radio_planner_t* rp, const uint32_t alarm_in_ms, void ( *callback )( void* rp_void ) )
+{
+    rp->task_alarm_callback = callback;
+    rp->task_alarm_hook_id  = rp->radio_task_id;
+    rp->task_alarm_time_ms  = smtc_modem_hal_get_time_in_ms( ) + alarm_in_ms;
+    rp->task_alarm_is_set   = true;
+    rp_arm_timer( rp );
+}
+#endif  // ADD_LBT_TIMER_SAMPLING
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
@@ -602,7 +681,7 @@ static void rp_task_update_time( radio_planner_t* rp, uint32_t now )
                 SMTC_MODEM_HAL_TRACE_WARNING(
                     "RP: SWITCH TASK #%d FROM ASAP TO SCHEDULED (start_time_init_ms:%u, now:%u, diff:%d)\n", i,
                     rp->tasks[i].start_time_init_ms, now, ( int32_t ) ( now - rp->tasks[i].start_time_init_ms ) );
-                rp_task_compute_ranking( rp );
+                rp_task_update_ranking( rp, i );
             }
         }
     }
@@ -619,7 +698,7 @@ static void rp_task_update_time( radio_planner_t* rp, uint32_t now )
         {
             rp->tasks[rp->radio_task_id].schedule_task_low_priority = false;
             rp->tasks[rp->radio_task_id].priority = ( RP_TASK_STATE_SCHEDULE * RP_NB_HOOKS ) + rp->radio_task_id;
-            rp_task_compute_ranking( rp );
+            rp_task_update_ranking( rp, rp->radio_task_id );
         }
         SMTC_MODEM_HAL_RP_TRACE_PRINTF( " RP: Extended duration of radio task #%u time to %u ms\n", rp->radio_task_id,
                                         now );
@@ -649,6 +728,7 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
             {
                 rp->stats.rp_error++;
                 SMTC_MODEM_HAL_TRACE_ERROR( " RP: ERROR - delay #%d - hook #%d\n", delay, rp->priority_task.hook_id );
+                RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->priority_task, RP_TIMELINE_ABORT_LATE, now );
 
                 rp->tasks[rp->priority_task.hook_id].state = RP_TASK_STATE_ABORTED;
             }
@@ -668,6 +748,8 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
                     rp->tasks[rp->radio_task_id].state = RP_TASK_STATE_ABORTED;
                     SMTC_MODEM_HAL_TRACE_PRINTF( "RP: Abort running #%u for priority #%u\n", rp->radio_task_id,
                                                  rp->priority_task.hook_id );
+                    RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[rp->radio_task_id],
+                                        RP_TIMELINE_ABORT_PREEMPTED, now );
 #if defined( ADD_LBM_GEOLOCATION )
                     if( ( rp->radio_task_id == RP_HOOK_ID_DIRECT_RP_ACCESS_GNSS ) ||
                         ( rp->radio_task_id == RP_HOOK_ID_DIRECT_RP_ACCESS_GNSS_ALMANAC ) ||
@@ -695,6 +777,8 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
                     rp->radio_task_id = rp->priority_task.hook_id;
                     if( smtc_modem_external_stack_currently_use_radio( ) == true )
                     {
+                        RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[rp->radio_task_id],
+                                            RP_TIMELINE_ABORT_RADIO_BUSY, now );
                         rp->tasks[rp->radio_task_id].state = RP_TASK_STATE_ABORTED;
                     }
                     else
@@ -709,6 +793,8 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
                 rp->radio_task_id = rp->priority_task.hook_id;
                 if( smtc_modem_external_stack_currently_use_radio( ) == true )
                 {
+                    RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[rp->radio_task_id],
+                                        RP_TIMELINE_ABORT_RADIO_BUSY, now );
                     rp->tasks[rp->radio_task_id].state = RP_TASK_STATE_ABORTED;
                 }
                 else
@@ -729,6 +815,8 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
             {
                 SMTC_MODEM_HAL_TRACE_WARNING( " RP: Aborted task with hook #%u - not a priority task\n",
                                               rp->timer_hook_id );
+                RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[rp->timer_hook_id],
+                                    RP_TIMELINE_ABORT_NOT_PRIORITY, now );
                 rp->tasks[rp->timer_hook_id].state = RP_TASK_STATE_ABORTED;
             }
         }
@@ -744,6 +832,8 @@ static void rp_task_arbiter( radio_planner_t* rp, const char* caller_func_name )
 
         if( rp->next_state_status == RP_STATUS_HAVE_TO_SET_TIMER )
         {
+            RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_TIMER_SET, &rp->tasks[rp->timer_hook_id], 0,
+                                smtc_modem_hal_get_time_in_ms( ) );
             if( rp->timer_value > rp->margin_delay )
             {
                 rp_set_alarm( rp, rp->timer_value - rp->margin_delay );
@@ -876,21 +966,36 @@ static void rp_irq_get_status( radio_planner_t* rp, const uint8_t hook_id )
     }
 }
 
-static void rp_task_compute_ranking( radio_planner_t* rp )
+static void rp_task_update_ranking( radio_planner_t* rp, const uint8_t hook_id )
 {
-    uint8_t rank;
-    uint8_t ranks_temp[RP_NB_HOOKS];
+    uint8_t pos = 0;
 
-    for( int32_t i = 0; i < RP_NB_HOOKS; i++ )
+    while( rp->rankings[pos] != hook_id )
     {
-        ranks_temp[i] = rp->tasks[i].priority;
+        pos++;
     }
-    for( int32_t i = 0; i < RP_NB_HOOKS; i++ )
+
+    // Only the priority of hook_id has changed: the other tasks are still sorted, shift them to make room
+    while( ( pos > 0 ) && ( rp_task_has_precedence( rp, hook_id, rp->rankings[pos - 1] ) == true ) )
     {
-        rank             = rp_task_find_highest_priority( &( ranks_temp[0] ), RP_NB_HOOKS );
-        ranks_temp[rank] = 0xFF;
-        rp->rankings[i]  = rank;
+        rp->rankings[pos] = rp->rankings[pos - 1];
+        pos--;
     }
+    while( ( pos < ( RP_NB_HOOKS - 1 ) ) && ( rp_task_has_precedence( rp, rp->rankings[pos + 1], hook_id ) == true ) )
+    {
+        rp->rankings[pos] = rp->rankings[pos + 1];
+        pos++;
+    }
+    rp->rankings[pos] = hook_id;
+}
+
+static bool rp_task_has_precedence( const radio_planner_t* rp, const uint8_t hook_id_a, const uint8_t hook_id_b )
+{
+    if( rp->tasks[hook_id_a].priority != rp->tasks[hook_id_b].priority )
+    {
+        return ( rp->tasks[hook_id_a].priority < rp->tasks[hook_id_b].priority );
+    }
+    return ( hook_id_a > hook_id_b );
 }
 
 static void rp_task_launch_current( radio_planner_t* rp )
@@ -905,6 +1010,8 @@ static void rp_task_launch_current( radio_planner_t* rp )
     else
     {
         rp_task_print( rp, &rp->tasks[id] );
+        RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_LAUNCH, &rp->tasks[id], rp->tasks[id].state,
+                            smtc_modem_hal_get_time_in_ms( ) );
         rp->radio = TARGET_RADIO;
         rp->tasks[id].launch_task_callbacks( ( void* ) rp );
     }
@@ -915,51 +1022,44 @@ static uint8_t rp_task_select_next( radio_planner_t* rp, const uint32_t now )
     uint8_t  hook_to_exe_tmp      = 0xFF;
     uint32_t hook_time_to_exe_tmp = 0;
     uint32_t time_tmp             = 0;
-    uint8_t  rank                 = 0;
-    uint8_t  hook_id              = 0;
 
-    for( hook_id = 0; hook_id < RP_NB_HOOKS; hook_id++ )
-    {  // Garbage collector
-        if( ( rp->tasks[hook_id].state == RP_TASK_STATE_SCHEDULE ) &&
-            ( ( ( int32_t ) ( rp->tasks[hook_id].start_time_ms - now ) < 0 ) ) )
-        {
-            rp->tasks[hook_id].state = RP_TASK_STATE_ABORTED;
-        }
-    }
-    for( hook_id = 0; hook_id < RP_NB_HOOKS; hook_id++ )
+    // Single pass in ranking order: the garbage collection of a task does not depend on the other tasks
+    for( uint8_t i = 0; i < RP_NB_HOOKS; i++ )
     {
-        rank = rp->rankings[hook_id];
-        if( ( ( rp->tasks[rank].state < RP_TASK_STATE_RUNNING ) &&
-              ( ( int32_t ) ( rp->tasks[rank].start_time_ms - now ) >= 0 ) ) ||
-            ( rp->tasks[rank].state == RP_TASK_STATE_RUNNING ) )
+        rp_task_t* task = &rp->tasks[rp->rankings[i]];
+
+        if( ( task->state == RP_TASK_STATE_SCHEDULE ) && ( ( ( int32_t ) ( task->start_time_ms - now ) < 0 ) ) )
+        {  // Garbage collector
+            RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, task, RP_TIMELINE_ABORT_MISSED, now );
+            task->state = RP_TASK_STATE_ABORTED;
+            continue;
+        }
+        if( ( ( task->state < RP_TASK_STATE_RUNNING ) && ( ( int32_t ) ( task->start_time_ms - now ) >= 0 ) ) ||
+            ( task->state == RP_TASK_STATE_RUNNING ) )
         {
-            hook_to_exe_tmp      = rp->tasks[rank].hook_id;
-            hook_time_to_exe_tmp = rp->tasks[rank].start_time_ms;
-            break;
+            if( hook_to_exe_tmp == 0xFF )
+            {  // Highest ranked task
+                hook_to_exe_tmp      = task->hook_id;
+                hook_time_to_exe_tmp = task->start_time_ms;
+            }
+            else
+            {  // Lower ranked task that ends before the start of the selected one
+                time_tmp = task->start_time_ms + task->duration_time_ms;
+
+                int32_t tmp = ( int32_t ) ( time_tmp - hook_time_to_exe_tmp );
+                if( ( tmp < 0 ) && ( ( int32_t ) ( time_tmp - now ) >= 0 ) )
+                {
+                    hook_to_exe_tmp      = task->hook_id;
+                    hook_time_to_exe_tmp = task->start_time_ms;
+                }
+            }
         }
     }
-    if( hook_id == RP_NB_HOOKS )
+    if( hook_to_exe_tmp == 0xFF )
     {
         return RP_NO_MORE_TASK;
     }
 
-    for( int32_t i = hook_id + 1; i < RP_NB_HOOKS; i++ )
-    {
-        rank = rp->rankings[i];
-        if( ( ( rp->tasks[rank].state < RP_TASK_STATE_RUNNING ) &&
-              ( ( int32_t ) ( rp->tasks[rank].start_time_ms - now ) >= 0 ) ) ||
-            ( rp->tasks[rank].state == RP_TASK_STATE_RUNNING ) )
-        {
-            time_tmp = rp->tasks[rank].start_time_ms + rp->tasks[rank].duration_time_ms;
-
-            int32_t tmp = ( int32_t ) ( time_tmp - hook_time_to_exe_tmp );
-            if( ( tmp < 0 ) && ( ( int32_t ) ( time_tmp - now ) >= 0 ) )
-            {
-                hook_to_exe_tmp      = rp->tasks[rank].hook_id;
-                hook_time_to_exe_tmp = rp->tasks[rank].start_time_ms;
-            }
-        }
-    }
     rp->priority_task = rp->tasks[hook_to_exe_tmp];
     return RP_SOMETHING_TO_DO;
 }
@@ -967,19 +1067,9 @@ static uint8_t rp_task_select_next( radio_planner_t* rp, const uint32_t now )
 static rp_next_state_status_t rp_task_get_next( radio_planner_t* rp, uint32_t* duration, uint8_t* task_id,
                                                 const uint32_t now )
 {
-    uint8_t  hook_id  = 0;
     uint8_t  index    = 0xFF;
     uint32_t time_tmp = now;
 
-    for( hook_id = 0; hook_id < RP_NB_HOOKS; hook_id++ )
-    {  // Garbage collector
-        if( ( rp->tasks[hook_id].state == RP_TASK_STATE_SCHEDULE ) &&
-            ( ( ( int32_t ) ( rp->tasks[hook_id].start_time_ms - time_tmp ) < 0 ) ) )
-        {
-            rp->tasks[hook_id].state = RP_TASK_STATE_ABORTED;
-        }
-    }
-
     // find the max time in the future
     for( uint8_t i = 0; i < RP_NB_HOOKS; i++ )
     {
@@ -993,6 +1083,13 @@ static rp_next_state_status_t rp_task_get_next( radio_planner_t* rp, uint32_t* d
     {  // set a timer only if a schedule task is pending and the radio activity is  running or for every task if the
        // radio activity is not running
 
+        if( ( rp->tasks[i].state == RP_TASK_STATE_SCHEDULE ) &&
+            ( ( ( int32_t ) ( rp->tasks[i].start_time_ms - now ) < 0 ) ) )
+        {  // Garbage collector
+            RP_TIMELINE_RECORD( rp, RP_TIMELINE_EVENT_ABORT, &rp->tasks[i], RP_TIMELINE_ABORT_MISSED, now );
+            rp->tasks[i].state = RP_TASK_STATE_ABORTED;
+            continue;
+        }
         if(
             // ( ( ( rp->tasks[rp->radio_task_id].state == RP_TASK_STATE_RUNNING ) &&
             //     ( rp->tasks[i].state == RP_TASK_STATE_SCHEDULE ) ) ||
@@ -1016,21 +1113,6 @@ static rp_next_state_status_t rp_task_get_next( radio_planner_t* rp, uint32_t* d
         return RP_STATUS_HAVE_TO_SET_TIMER;
     }
 }
-static uint8_t rp_task_find_highest_priority( uint8_t* vector, uint8_t length )
-{
-    uint8_t priority_high = 0xFF;
-    uint8_t index         = 0;
-
-    for( int32_t i = 0; i < length; i++ )
-    {
-        if( vector[i] <= priority_high )
-        {
-            priority_high = vector[i];
-            index         = i;
-        }
-    }
-    return index;
-}
 
 rp_hook_status_t rp_get_pkt_payload( radio_planner_t* rp, const rp_task_t* task )
 {
@@ -1084,10 +1166,66 @@ rp_hook_status_t rp_get_pkt_payload( radio_planner_t* rp, const rp_task_t* task
 
 static void rp_set_alarm( radio_planner_t* rp, const uint32_t alarm_in_ms )
 {
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    rp->alarm_time_ms = smtc_modem_hal_get_time_in_ms( ) + alarm_in_ms;
+    rp->alarm_is_set  = true;
+    rp_arm_timer( rp );
+#else
     smtc_modem_hal_stop_timer( );
     smtc_modem_hal_start_timer( alarm_in_ms, rp_timer_irq_callback, rp );
+#endif  // ADD_LBT_TIMER_SAMPLING
 }
 
+#if defined( ADD_LBT_TIMER_SAMPLING )
+static void rp_arm_timer( radio_planner_t* rp )
+{
+    smtc_modem_hal_stop_timer( );
+    if( ( rp->alarm_is_set == false ) && ( rp->task_alarm_is_set == false ) )
+    {
+        return;
+    }
+
+    uint32_t alarm_time_ms = rp->alarm_time_ms;
+    if( ( rp->alarm_is_set == false ) ||
+        ( ( rp->task_alarm_is_set == true ) && ( ( int32_t ) ( rp->task_alarm_time_ms - alarm_time_ms ) < 0 ) ) )
+    {
+        alarm_time_ms = rp->task_alarm_time_ms;
+    }
+
+    int32_t delay = ( int32_t ) ( alarm_time_ms - smtc_modem_hal_get_time_in_ms( ) );
+    if( delay > 0 )
+    {
+        smtc_modem_hal_start_timer( delay, rp_timer_irq_callback, rp );
+    }
+    else
+    {
+        rp->timer_expired_flag = true;
+    }
+}
+
+static void rp_timer_expired( radio_planner_t* rp )
+{
+    uint32_t now = smtc_modem_hal_get_time_in_ms( );
+
+    if( ( rp->alarm_is_set == true ) && ( ( int32_t ) ( rp->alarm_time_ms - now ) <= 0 ) )
+    {
+        rp->alarm_is_set   = false;
+        rp->timer_irq_flag = true;
+    }
+    if( ( rp->task_alarm_is_set == true ) && ( ( int32_t ) ( rp->task_alarm_time_ms - now ) <= 0 ) )
+    {
+        rp->task_alarm_is_set = false;
+        // Drop the alarm of a task that has been aborted or has completed meanwhile
+        if( ( rp->task_alarm_hook_id == rp->radio_task_id ) &&
+            ( rp->tasks[rp->radio_task_id].state == RP_TASK_STATE_RUNNING ) )
+        {
+            rp->task_alarm_callback( ( void* ) rp );
+        }
+    }
+    rp_arm_timer( rp );
+}
+#endif  // ADD_LBT_TIMER_SAMPLING
+
 static void rp_timer_irq( radio_planner_t* rp )
 {
     rp_task_arbiter( rp, __func__ );
@@ -1249,7 +1387,11 @@ void rp_radio_irq_callback( void* obj )
 static void rp_timer_irq_callback( void* obj )
 {
     radio_planner_t* rp = ( ( radio_planner_t* ) obj );
-    rp->timer_irq_flag  = true;
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    rp->timer_expired_flag = true;
+#else
+    rp->timer_irq_flag = true;
+#endif  // ADD_LBT_TIMER_SAMPLING
     smtc_modem_hal_user_lbm_irq( );
 }
 
@@ -1270,4 +1412,22 @@ static void rp_hook_callback( radio_planner_t* rp, uint8_t id )
     rp->radio_is_free = true;
 }
 
+#if defined( ADD_RP_TIMELINE )
+static void rp_timeline_record( radio_planner_t* rp, rp_timeline_event_type_t event, const rp_task_t* task,
+                                uint8_t info, uint32_t time_ms )
+{
+    rp_timeline_event_t timeline_event = {
+        .time_ms     = time_ms,
+        .delay_ms    = ( int32_t ) ( task->start_time_ms - time_ms ),
+        .duration_ms = task->duration_time_ms,
+        .event       = ( uint8_t ) event,
+        .hook_id     = task->hook_id,
+        .task_type   = ( uint8_t ) task->type,
+        .info        = info,
+    };
+
+    rp_timeline_push( &rp->timeline, &timeline_event );
+}
+#endif  // ADD_RP_TIMELINE
+
 /* --- EOF ------------------------------------------------------------------ */
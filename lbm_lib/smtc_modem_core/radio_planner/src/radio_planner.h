@@ -49,6 +49,9 @@ extern "C" {
 #include "radio_planner_types.h"
 #include "radio_planner_stats.h"
 #include "radio_planner_hook_id_defs.h"
+#if defined( ADD_RP_TIMELINE )
+#include "radio_planner_timeline.h"
+#endif  // ADD_RP_TIMELINE
 
 #include "ralf.h"
 
@@ -98,6 +101,19 @@ typedef struct radio_planner_s
     const ralf_t*          radio;
     const ralf_t*          radio_target_attached_to_this_hook[RP_NB_HOOKS];
     uint32_t               margin_delay;
+#if defined( ADD_RP_TIMELINE )
+    rp_timeline_t          timeline;
+#endif  // ADD_RP_TIMELINE
+#if defined( ADD_LBT_TIMER_SAMPLING )
+    // The modem timer is shared by the planner alarm and the alarm of the running task
+    void ( *task_alarm_callback )( void* );
+    uint32_t task_alarm_time_ms;
+    uint32_t alarm_time_ms;
+    uint8_t  task_alarm_hook_id;
+    bool     task_alarm_is_set;
+    bool     alarm_is_set;
+    bool     timer_expired_flag;
+#endif  // ADD_LBT_TIMER_SAMPLING
 } radio_planner_t;
 
 /*
@@ -184,6 +200,20 @@ rp_hook_status_t rp_attach_new_radio( radio_planner_t* rp, const ralf_t* radio,
  * @param [in] disable true to disable failsafe check, flase otherwize
  */
 void rp_disable_failsafe( radio_planner_t* rp, bool disable );
+#if defined( ADD_LBT_TIMER_SAMPLING )
+/**
+ * @brief Wake the running task up after a delay, leaving the MCU free to sleep meanwhile
+ *
+ * @remark The callback is called from rp_callback with the radio planner as context, only if the task that set the
+ * alarm is still running. A new alarm replaces the previous one.
+ *
+ * @param rp pointer to the radioplanner object itself
+ * @param alarm_in_ms delay in ms (relative value)
+ * @param callback function to call when the alarm expires
+ */
+void rp_task_set_alarm( radio_planner_t* rp, const uint32_t alarm_in_ms, void ( *callback )( void* rp_void ) );
+#endif  // ADD_LBT_TIMER_SAMPLING
+
 /**
  * @brief Get the status of the radio
  * @param [in] rp pointer to the radioplanner object itself
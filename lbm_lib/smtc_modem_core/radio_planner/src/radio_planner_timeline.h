@@ -0,0 +1,248 @@
+/*!
+ * \file      radio_planner_timeline.h
+ *
+ * \brief     Radio planner timeline recorder
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2024. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Semtech corporation nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef RADIO_PLANNER_TIMELINE_H
+#define RADIO_PLANNER_TIMELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+
+#include <stdint.h>   // C99 types
+#include <stdbool.h>  // bool type
+#include <string.h>   // for memset
+
+#include "radio_planner_types.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC MACROS -----------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+/* clang-format off */
+
+/*!
+ * Number of events kept by the timeline recorder, shall be a power of 2
+ */
+#ifndef RP_TIMELINE_NB_EVENTS
+#define RP_TIMELINE_NB_EVENTS                       64
+#endif
+
+/*!
+ * Size in bytes of a serialized timeline event
+ */
+#define RP_TIMELINE_EVENT_SERIALIZED_SIZE           16
+
+/* clang-format on */
+
+#if( ( RP_TIMELINE_NB_EVENTS & ( RP_TIMELINE_NB_EVENTS - 1 ) ) != 0 ) || ( RP_TIMELINE_NB_EVENTS > 32768 )
+#error "RP_TIMELINE_NB_EVENTS shall be a power of 2 lower than or equal to 32768"
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC TYPES ------------------------------------------------------------
+ */
+
+/*!
+ * Timeline event types
+ */
+typedef enum rp_timeline_event_type_e
+{
+    RP_TIMELINE_EVENT_ENQUEUE,           //!< Task accepted, info is the task state (schedule or asap)
+    RP_TIMELINE_EVENT_ENQUEUE_REJECTED,  //!< Task refused, info is the rp_hook_status_t returned to the caller
+    RP_TIMELINE_EVENT_LAUNCH,            //!< Task started on the radio
+    RP_TIMELINE_EVENT_IRQ,               //!< Radio irq of the running task, info is the rp_status_t
+    RP_TIMELINE_EVENT_ABORT,             //!< Task aborted, info is the rp_timeline_abort_reason_t
+    RP_TIMELINE_EVENT_TIMER_SET,         //!< Radio planner timer armed for the task
+} rp_timeline_event_type_t;
+
+/*!
+ * Reasons of a task abort
+ */
+typedef enum rp_timeline_abort_reason_e
+{
+    RP_TIMELINE_ABORT_USER,          //!< rp_task_abort called by the hook owner
+    RP_TIMELINE_ABORT_LATE,          //!< Priority task found in the past by the arbiter (counted in rp_error)
+    RP_TIMELINE_ABORT_PREEMPTED,     //!< Running task stopped for a higher priority task
+    RP_TIMELINE_ABORT_NOT_PRIORITY,  //!< Timer expired on a scheduled task that is not the priority task
+    RP_TIMELINE_ABORT_MISSED,        //!< Scheduled task start time elapsed before it could be launched
+    RP_TIMELINE_ABORT_RADIO_BUSY,    //!< Radio is used by an external stack
+} rp_timeline_abort_reason_t;
+
+/*!
+ * Timeline event, serialized on RP_TIMELINE_EVENT_SERIALIZED_SIZE bytes (big endian, fields in declaration order)
+ */
+typedef struct rp_timeline_event_s
+{
+    uint32_t time_ms;      //!< Event time
+    int32_t  delay_ms;     //!< Task start time relative to the event time (negative when the task is late)
+    uint32_t duration_ms;  //!< Task duration
+    uint8_t  event;        //!< Event type as defined in @ref rp_timeline_event_type_t
+    uint8_t  hook_id;      //!< Hook id of the task
+    uint8_t  task_type;    //!< Task type as defined in @ref rp_task_types_t
+    uint8_t  info;         //!< Event specific information, see @ref rp_timeline_event_type_t
+} rp_timeline_event_t;
+
+/*!
+ * Single producer / single consumer ring buffer of timeline events
+ *
+ * Each counter has a single writer: the producer (radio planner) only moves write_cnt and lost_cnt, the consumer only
+ * moves read_cnt and lost_read_cnt. An event slot is filled before write_cnt publishes it (all accesses are volatile
+ * so they are not reordered), thus the consumer never sees a partially written event and no lock is needed. When the
+ * buffer is full new events are dropped and counted.
+ */
+typedef struct rp_timeline_s
+{
+    volatile rp_timeline_event_t events[RP_TIMELINE_NB_EVENTS];
+    volatile uint16_t            write_cnt;
+    volatile uint16_t            read_cnt;
+    volatile uint16_t            lost_cnt;
+    volatile uint16_t            lost_read_cnt;
+} rp_timeline_t;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
+ */
+
+/*!
+ * @brief Reset the timeline
+ *
+ * @param [in] timeline Timeline to reset
+ */
+static inline void rp_timeline_init( rp_timeline_t* timeline )
+{
+    memset( timeline, 0, sizeof( rp_timeline_t ) );
+}
+
+/*!
+ * @brief Append an event to the timeline (producer side)
+ *
+ * @param [in] timeline Timeline
+ * @param [in] event    Event to append
+ * @return true if the event has been recorded, false if the timeline is full
+ */
+static inline bool rp_timeline_push( rp_timeline_t* timeline, const rp_timeline_event_t* event )
+{
+    uint16_t write_cnt = timeline->write_cnt;
+
+    if( ( uint16_t ) ( write_cnt - timeline->read_cnt ) >= RP_TIMELINE_NB_EVENTS )
+    {
+        timeline->lost_cnt++;
+        return false;
+    }
+    timeline->events[write_cnt & ( RP_TIMELINE_NB_EVENTS - 1 )] = *event;
+    timeline->write_cnt                                          = write_cnt + 1;
+    return true;
+}
+
+/*!
+ * @brief Remove the oldest event from the timeline (consumer side)
+ *
+ * @param [in]  timeline Timeline
+ * @param [out] event    Oldest event
+ * @return true if an event has been returned, false if the timeline is empty
+ */
+static inline bool rp_timeline_pop( rp_timeline_t* timeline, rp_timeline_event_t* event )
+{
+    uint16_t read_cnt = timeline->read_cnt;
+
+    if( read_cnt == timeline->write_cnt )
+    {
+        return false;
+    }
+    *event             = timeline->events[read_cnt & ( RP_TIMELINE_NB_EVENTS - 1 )];
+    timeline->read_cnt = read_cnt + 1;
+    return true;
+}
+
+/*!
+ * @brief Get the number of events dropped since the last call (consumer side)
+ *
+ * @param [in] timeline Timeline
+ * @return uint16_t Number of dropped events
+ */
+static inline uint16_t rp_timeline_get_and_clear_lost( rp_timeline_t* timeline )
+{
+    uint16_t lost_cnt = timeline->lost_cnt;
+    uint16_t lost     = lost_cnt - timeline->lost_read_cnt;
+
+    timeline->lost_read_cnt = lost_cnt;
+    return lost;
+}
+
+/*!
+ * @brief Serialize an event on RP_TIMELINE_EVENT_SERIALIZED_SIZE bytes
+ *
+ * @param [in]  event  Event to serialize
+ * @param [out] buffer Output buffer
+ */
+static inline void rp_timeline_event_serialize( const rp_timeline_event_t* event,
+                                                uint8_t buffer[RP_TIMELINE_EVENT_SERIALIZED_SIZE] )
+{
+    buffer[0]  = ( event->time_ms >> 24 ) & 0xFF;
+    buffer[1]  = ( event->time_ms >> 16 ) & 0xFF;
+    buffer[2]  = ( event->time_ms >> 8 ) & 0xFF;
+    buffer[3]  = ( event->time_ms & 0xFF );
+    buffer[4]  = ( ( uint32_t ) event->delay_ms >> 24 ) & 0xFF;
+    buffer[5]  = ( ( uint32_t ) event->delay_ms >> 16 ) & 0xFF;
+    buffer[6]  = ( ( uint32_t ) event->delay_ms >> 8 ) & 0xFF;
+    buffer[7]  = ( ( uint32_t ) event->delay_ms & 0xFF );
+    buffer[8]  = ( event->duration_ms >> 24 ) & 0xFF;
+    buffer[9]  = ( event->duration_ms >> 16 ) & 0xFF;
+    buffer[10] = ( event->duration_ms >> 8 ) & 0xFF;
+    buffer[11] = ( event->duration_ms & 0xFF );
+    buffer[12] = event->event;
+    buffer[13] = event->hook_id;
+    buffer[14] = event->task_type;
+    buffer[15] = event->info;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RADIO_PLANNER_TIMELINE_H
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -0,0 +1,246 @@
+"""
+The Clear BSD License
+Copyright Semtech Corporation 2024. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the disclaimer
+below) provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Semtech corporation nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SEMTECH CORPORATION BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+"""
+
+import struct
+import sys
+from argparse import ArgumentParser
+from collections import Counter, defaultdict
+
+# Must match rp_timeline_event_type_t, rp_timeline_abort_reason_t and rp_task_types_t
+EVENT_NAMES = ["ENQUEUE", "REJECTED", "LAUNCH", "IRQ", "ABORT", "TIMER_SET"]
+ABORT_REASON_NAMES = ["USER", "LATE", "PREEMPTED", "NOT_PRIORITY", "MISSED", "RADIO_BUSY"]
+TASK_TYPE_NAMES = [
+    "RX_LORA",
+    "RX_FSK",
+    "TX_LORA",
+    "TX_FSK",
+    "TX_LR_FHSS",
+    "CAD",
+    "CAD_TO_TX",
+    "CAD_TO_RX",
+    "GNSS_SNIFF",
+    "WIFI_SNIFF",
+    "GNSS_RSSI",
+    "WIFI_RSSI",
+    "LBT",
+    "USER",
+    "TX_BLE",
+    "RX_BLE",
+    "RX_BLE_SCAN",
+    "NONE",
+]
+RP_STATUS_NAMES = [
+    "RX_CRC_ERROR",
+    "CAD_POSITIVE",
+    "CAD_NEGATIVE",
+    "TX_DONE",
+    "RX_PACKET",
+    "RX_TIMEOUT",
+    "LBT_FREE_CHANNEL",
+    "LBT_BUSY_CHANNEL",
+    "WIFI_SCAN_DONE",
+    "GNSS_SCAN_DONE",
+    "TASK_ABORTED",
+    "TASK_INIT",
+    "LR_FHSS_HOP",
+]
+TASK_STATE_NAMES = ["SCHEDULE", "ASAP", "RUNNING", "ABORTED", "FINISHED"]
+HOOK_STATUS_NAMES = ["OK", "ID_ERROR", "ALREADY_RUNNING", "IN_PAST", "TOO_FAR_IN_FUTURE"]
+
+EVENT_FORMAT = ">IiIBBBB"
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+
+
+def name(table, index):
+    return table[index] if index < len(table) else str(index)
+
+
+def decode_events(data):
+    events = []
+    for offset in range(0, len(data) - EVENT_SIZE + 1, EVENT_SIZE):
+        time_ms, delay_ms, duration_ms, event, hook_id, task_type, info = struct.unpack_from(
+            EVENT_FORMAT, data, offset
+        )
+        events.append(
+            {
+                "time": time_ms,
+                "delay": delay_ms,
+                "duration": duration_ms,
+                "event": event,
+                "hook": hook_id,
+                "type": task_type,
+                "info": info,
+            }
+        )
+    return events
+
+
+def info_to_str(event):
+    if event["event"] == 0:
+        return name(TASK_STATE_NAMES, event["info"])
+    if event["event"] == 1:
+        return name(HOOK_STATUS_NAMES, event["info"])
+    if event["event"] == 3:
+        return name(RP_STATUS_NAMES, event["info"])
+    if event["event"] == 4:
+        return name(ABORT_REASON_NAMES, event["info"])
+    return ""
+
+
+def print_events(events):
+    print("%10s %-9s %4s %-12s %8s %8s  %s" % ("time_ms", "event", "hook", "task", "delay", "duration", "info"))
+    for event in events:
+        print(
+            "%10u %-9s %4u %-12s %8d %8u  %s"
+            % (
+                event["time"],
+                name(EVENT_NAMES, event["event"]),
+                event["hook"],
+                name(TASK_TYPE_NAMES, event["type"]),
+                event["delay"],
+                event["duration"],
+                info_to_str(event),
+            )
+        )
+
+
+def print_gantt(events, width):
+    # A task occupies the radio from its launch up to its irq or its abort, times are taken relative to the first
+    # event so that the 32 bits wrap of the modem time is handled
+    start = events[0]["time"]
+    busy = defaultdict(list)
+    running = {}
+    for event in events:
+        time = (event["time"] - start) & 0xFFFFFFFF
+        if event["event"] == 2:
+            running[event["hook"]] = time
+        elif event["event"] in (3, 4) and event["hook"] in running:
+            busy[event["hook"]].append((running.pop(event["hook"]), time))
+    span = max((events[-1]["time"] - start) & 0xFFFFFFFF, 1)
+    for hook, begin in running.items():
+        busy[hook].append((begin, span))
+
+    print("\nRadio occupancy from %u ms to %u ms (%.1f ms per column)" % (start, events[-1]["time"], span / width))
+    for hook in sorted(busy):
+        line = [" "] * width
+        for begin, finish in busy[hook]:
+            first = min(begin * width // span, width - 1)
+            last = min(finish * width // span, width - 1)
+            for column in range(first, last + 1):
+                line[column] = "#"
+        print("hook %2u |%s|" % (hook, "".join(line)))
+
+
+def print_statistics(events):
+    # Launch delay is the start time of the task minus the launch time, negative when the task started late
+    slack = defaultdict(list)
+    enqueues = Counter()
+    aborts = defaultdict(Counter)
+    for event in events:
+        if event["event"] == 0:
+            enqueues[event["hook"]] += 1
+        elif event["event"] == 2:
+            slack[event["hook"]].append(event["delay"])
+        elif event["event"] == 4:
+            aborts[event["hook"]][event["info"]] += 1
+
+    print("\n%4s %8s %8s %10s %10s %10s  %s" % ("hook", "enqueue", "launch", "min slack", "avg slack", "max slack", "aborts"))
+    for hook in sorted(set(enqueues) | set(slack) | set(aborts)):
+        delays = slack[hook]
+        if delays:
+            delay_str = "%10d %10.1f %10d" % (min(delays), sum(delays) / len(delays), max(delays))
+        else:
+            delay_str = "%10s %10s %10s" % ("-", "-", "-")
+        abort_str = ", ".join(
+            "%s=%u" % (name(ABORT_REASON_NAMES, reason), count) for reason, count in sorted(aborts[hook].items())
+        )
+        print("%4u %8u %8u %s  %s" % (hook, enqueues[hook], len(delays), delay_str, abort_str))
+
+    total_enqueues = sum(enqueues.values())
+    conflicts = sum(
+        count for hook_aborts in aborts.values() for reason, count in hook_aborts.items() if reason != 0
+    )
+    if total_enqueues > 0:
+        print("\nConflict rate: %u aborts (user aborts excluded) for %u enqueues (%.1f %%)" % (
+            conflicts,
+            total_enqueues,
+            100.0 * conflicts / total_enqueues,
+        ))
+
+
+def main():
+    parser = ArgumentParser(
+        description="Decode the radio planner timeline read with smtc_modem_debug_get_rp_timeline() or the "
+        "CMD_MODEM_GET_RP_TIMELINE hw_modem command."
+    )
+    parser.add_argument("input_file", help="file containing the timeline, as an hexadecimal string or raw bytes")
+    parser.add_argument(
+        "-b", "--binary", action="store_true", help="input file contains raw bytes instead of an hexadecimal string"
+    )
+    parser.add_argument(
+        "-m",
+        "--hw-modem",
+        action="store_true",
+        help="input file is a concatenation of CMD_MODEM_GET_RP_TIMELINE responses (one per line when hexadecimal), "
+        "each starting with the 2 bytes lost events count",
+    )
+    parser.add_argument("-w", "--width", type=int, default=100, help="width of the occupancy chart (default: 100)")
+    args = parser.parse_args()
+
+    if args.binary:
+        with open(args.input_file, "rb") as f:
+            chunks = [f.read()]
+    else:
+        with open(args.input_file, "r") as f:
+            lines = [line.strip().replace(" ", "") for line in f if line.strip()]
+        chunks = [bytes.fromhex(line) for line in lines] if args.hw_modem else [bytes.fromhex("".join(lines))]
+
+    data = b""
+    lost = 0
+    for chunk in chunks:
+        if args.hw_modem:
+            lost += struct.unpack_from(">H", chunk)[0]
+            chunk = chunk[2:]
+        data += chunk
+
+    events = decode_events(data)
+    if not events:
+        print("No event in timeline")
+        sys.exit(1)
+
+    print_events(events)
+    print_gantt(events, args.width)
+    print_statistics(events)
+    if lost > 0:
+        print("\nWarning: %u events were dropped because the timeline was full" % lost)
+
+
+if __name__ == "__main__":
+    main()
@@ -49,7 +49,10 @@
 #include "smtc_modem_hal_dbg_trace.h"
 #include "modem_supervisor_light.h"
 #include "modem_core.h"
+#include "modem_context_cache.h"
+#include "modem_crc.h"
 #include "smtc_real_defs.h"
+#include "smtc_real.h"
 #include "lorawan_api.h"
 #include "smtc_duty_cycle.h"
 
@@ -220,6 +223,12 @@ struct
 #define modem_gen_appkey_crc smtc_modem_key_ctx.modem_gen_appkey_crc
 #define modem_data_block_int_key smtc_modem_key_ctx.modem_data_block_int_key
 
+#if defined( USE_LR11XX_CE )
+static uint8_t               modem_key_ctx_shadow[sizeof( modem_key_ctx_t )];
+static modem_context_cache_t modem_key_ctx_cache =
+    MODEM_CONTEXT_CACHE_INIT( CONTEXT_KEY_MODEM, modem_key_ctx_shadow, MODEM_CONTEXT_CACHE_WINDOW_MS );
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
@@ -280,7 +289,14 @@ void smtc_modem_init( void ( *callback_event )( void ) )
 uint32_t smtc_modem_run_engine( void )
 {
     rp_callback( &modem_radio_planner );
-    return modem_supervisor_engine( );
+    uint32_t sleep_time     = modem_supervisor_engine( );
+    uint32_t ctx_flush_time = modem_context_cache_process( );
+    return ( ctx_flush_time < sleep_time ) ? ctx_flush_time : sleep_time;
+}
+
+void smtc_modem_flush_context( void )
+{
+    modem_context_cache_flush_all( );
 }
 
 void smtc_modem_set_radio_context( const void* radio_ctx )
@@ -441,7 +457,7 @@ smtc_modem_return_code_t smtc_modem_set_appkey( uint8_t stack_id, const uint8_t
 
 // To prevent too much flash access first check crc on key in case of Hardware Secure element
 #if defined( USE_LR11XX_CE )
-    uint32_t new_crc = crc( appkey, SMTC_MODEM_KEY_LENGTH );
+    uint32_t new_crc = modem_crc32( appkey, SMTC_MODEM_KEY_LENGTH );
 
     if( ( modem_gen_appkey_status == MODEM_KEY_CRC_STATUS_INVALID ) || ( modem_gen_appkey_crc != new_crc ) )
     {
@@ -488,7 +504,7 @@ smtc_modem_return_code_t smtc_modem_set_nwkkey( uint8_t stack_id, const uint8_t
 
 // To prevent too much flash access first check crc on key in case of Hardware Secure element
 #if defined( USE_LR11XX_CE )
-    uint32_t new_crc = crc( nwkkey, SMTC_MODEM_KEY_LENGTH );
+    uint32_t new_crc = modem_crc32( nwkkey, SMTC_MODEM_KEY_LENGTH );
 
     if( ( modem_appkey_status == MODEM_KEY_CRC_STATUS_INVALID ) || ( modem_appkey_crc != new_crc ) )
     {
@@ -762,6 +778,14 @@ smtc_modem_return_code_t smtc_modem_join_network( uint8_t stack_id )
         increment_asynchronous_msgnumber( SMTC_MODEM_EVENT_JOINED, 0, stack_id );
         return_code = SMTC_MODEM_RC_OK;
     }
+#if defined( ADD_SMTC_SESSION_JOURNAL )
+    else if( lorawan_api_session_restore( stack_id ) == OKLORAWAN )
+    {
+        // The session opened before the last reset is still valid, no need to join again
+        increment_asynchronous_msgnumber( SMTC_MODEM_EVENT_JOINED, 0, stack_id );
+        return_code = SMTC_MODEM_RC_OK;
+    }
+#endif
     else
     {
         // Launch OTAA task
@@ -787,20 +811,16 @@ smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_
     RETURN_INVALID_IF_NULL( event_pending_count );
 
     smtc_modem_return_code_t return_code = SMTC_MODEM_RC_OK;
-    const uint8_t            event_count = get_asynchronous_msgnumber( );
+    modem_event_t            modem_event;
 
-    if( event_count > MODEM_NUMBER_OF_EVENTS )
-    {
-        SMTC_MODEM_HAL_PANIC( "asynchronous_msgnumber overlap" );
-    }
-    else if( event_count > 0 )
+    if( modem_event_pop( &modem_event ) == true )
     {
-        uint8_t stack_id;
-        event->event_type    = ( smtc_modem_event_type_t ) get_last_msg_event( &stack_id );
-        event->stack_id      = stack_id;
-        event->missed_events = get_modem_event_count( event->event_type ) - 1;
+        event->event_type    = ( smtc_modem_event_type_t ) modem_event.event_type;
+        event->stack_id      = modem_event.stack_id;
+        event->missed_events = modem_event.missed_events;
+        event->timestamp_ms  = modem_event.timestamp_ms;
 
-        *event_pending_count = event_count - 1;
+        *event_pending_count = get_asynchronous_msgnumber( );
 
         switch( event->event_type )
         {
@@ -809,60 +829,60 @@ smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_
             break;
         case SMTC_MODEM_EVENT_TXDONE:
             event->event_data.txdone.status =
-                ( smtc_modem_event_txdone_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_txdone_status_t ) modem_event.status;
             break;
 
         case SMTC_MODEM_EVENT_LINK_CHECK:
             event->event_data.link_check.status =
-                ( smtc_modem_event_mac_request_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_mac_request_status_t ) modem_event.status;
             break;
 
         case SMTC_MODEM_EVENT_CLASS_B_PING_SLOT_INFO:
             event->event_data.class_b_ping_slot_info.status =
-                ( smtc_modem_event_mac_request_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_mac_request_status_t ) modem_event.status;
             break;
 
         case SMTC_MODEM_EVENT_CLASS_B_STATUS:
             event->event_data.class_b_status.status =
-                ( smtc_modem_event_class_b_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_class_b_status_t ) modem_event.status;
             break;
 
         case SMTC_MODEM_EVENT_LORAWAN_MAC_TIME:
             event->event_data.lorawan_mac_time.status =
-                ( smtc_modem_event_mac_request_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_mac_request_status_t ) modem_event.status;
             break;
         case SMTC_MODEM_EVENT_LORAWAN_FUOTA_DONE:
             event->event_data.fuota_status.successful =
-                ( get_modem_event_status( event->event_type ) == 0 ) ? true : false;
+                ( modem_event.status == 0 ) ? true : false;
             break;
 
         case SMTC_MODEM_EVENT_NEW_MULTICAST_SESSION_CLASS_C:
-            event->event_data.new_multicast_class_c.group_id = get_modem_event_status( event->event_type );
+            event->event_data.new_multicast_class_c.group_id = modem_event.status;
             break;
 
         case SMTC_MODEM_EVENT_NEW_MULTICAST_SESSION_CLASS_B:
-            event->event_data.new_multicast_class_b.group_id = get_modem_event_status( event->event_type );
+            event->event_data.new_multicast_class_b.group_id = modem_event.status;
             break;
 
 #if defined( ENABLE_FUOTA_FMP )
         case SMTC_MODEM_EVENT_FIRMWARE_MANAGEMENT:
-            event->event_data.fmp.status = get_modem_event_status( event->event_type );
+            event->event_data.fmp.status = modem_event.status;
             break;
 #endif
 
 #if defined( ADD_SMTC_CLOUD_DEVICE_MANAGEMENT )
         case SMTC_MODEM_EVENT_DM_SET_CONF:
             event->event_data.setconf.opcode =
-                ( smtc_modem_event_setconf_opcode_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_setconf_opcode_t ) modem_event.status;
             break;
         case SMTC_MODEM_EVENT_MUTE:
             event->event_data.mute.status =
-                ( smtc_modem_event_mute_status_t ) get_modem_event_status( event->event_type );
+                ( smtc_modem_event_mute_status_t ) modem_event.status;
             break;
 #endif
 #if defined( ADD_SMTC_LFU )
         case SMTC_MODEM_EVENT_UPLOAD_DONE:
-            event->event_data.uploaddone.status = get_modem_event_status( event->event_type );
+            event->event_data.uploaddone.status = modem_event.status;
             break;
 #endif  // ADD_SMTC_LFU
 
@@ -870,26 +890,29 @@ smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_
         case SMTC_MODEM_EVENT_RELAY_TX_DYNAMIC:
         case SMTC_MODEM_EVENT_RELAY_TX_MODE:
         case SMTC_MODEM_EVENT_RELAY_TX_SYNC:
-            event->event_data.relay_tx.status = get_modem_event_status( event->event_type );
+            event->event_data.relay_tx.status = modem_event.status;
             break;
 #endif
 
 #if defined( ADD_RELAY_RX )
         case SMTC_MODEM_EVENT_RELAY_RX_RUNNING:
-            event->event_data.relay_rx.status = get_modem_event_status( event->event_type );
+            event->event_data.relay_rx.status = modem_event.status;
             break;
 #endif
 
         case SMTC_MODEM_EVENT_TEST_MODE:
-            event->event_data.test_mode_status.status = get_modem_event_status( event->event_type );
+            event->event_data.test_mode_status.status = modem_event.status;
             break;
         case SMTC_MODEM_EVENT_REGIONAL_DUTY_CYCLE:
-            event->event_data.regional_duty_cycle.status = get_modem_event_status( event->event_type );
+            event->event_data.regional_duty_cycle.status = modem_event.status;
             break;
         case SMTC_MODEM_EVENT_NO_DOWNLINK_THRESHOLD:
-            event->event_data.no_downlink.status = get_modem_event_status( event->event_type );
+            event->event_data.no_downlink.status = modem_event.status;
             break;
         case SMTC_MODEM_EVENT_DOWNDATA:
+            event->event_data.downdata.fport  = modem_event.payload.downdata.fport;
+            event->event_data.downdata.length = modem_event.payload.downdata.length;
+            break;
         case SMTC_MODEM_EVENT_ALARM:
         case SMTC_MODEM_EVENT_JOINED:
         case SMTC_MODEM_EVENT_JOINFAIL:
@@ -902,9 +925,6 @@ smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_
         default:
             break;
         }
-        // Reset the status after get the value
-        set_modem_event_count_and_status( event->event_type, 0, 0 );
-        decrement_asynchronous_msgnumber( );
     }
     else
     {
@@ -914,6 +934,15 @@ smtc_modem_return_code_t smtc_modem_get_event( smtc_modem_event_t* event, uint8_
     return return_code;
 }
 
+smtc_modem_return_code_t smtc_modem_get_event_queue_stats( smtc_modem_event_queue_stats_t* stats )
+{
+    RETURN_INVALID_IF_NULL( stats );
+
+    stats->capacity = MODEM_EVENT_QUEUE_SIZE;
+    modem_event_get_and_clear_queue_stats( &stats->high_water_mark, &stats->folded_events, &stats->dropped_events );
+    return SMTC_MODEM_RC_OK;
+}
+
 smtc_modem_return_code_t smtc_modem_get_downlink_data( uint8_t  buff[SMTC_MODEM_MAX_LORAWAN_PAYLOAD_LENGTH],
                                                        uint8_t* length, smtc_modem_dl_metadata_t* metadata,
                                                        uint8_t* remaining_data_nb )
@@ -937,14 +966,25 @@ smtc_modem_return_code_t smtc_modem_get_downlink_data( uint8_t  buff[SMTC_MODEM_
     }
     else
     {
-        uint8_t  metadata_len;
-        uint16_t fifo_buff_length = 0;
-        fifo_ctrl_get( fifo_obj, buff, &fifo_buff_length, SMTC_MODEM_MAX_LORAWAN_PAYLOAD_LENGTH, metadata,
-                       &metadata_len, sizeof( smtc_modem_dl_metadata_t ) );
-        // Length of LoRaWAN packet cannot exceed 242
-        *length            = ( uint8_t ) fifo_buff_length;
-        *remaining_data_nb = nb_of_data - 1;
-        rc                 = SMTC_MODEM_RC_OK;
+        fifo_ctrl_span_t data_span;
+        fifo_ctrl_span_t metadata_span;
+
+        // Read the element in place: payload and metadata are copied once, straight out of the fifo buffer
+        if( ( fifo_ctrl_peek( fifo_obj, &data_span, &metadata_span ) != FIFO_STATUS_OK ) ||
+            ( ( data_span.part1_len + data_span.part2_len ) > SMTC_MODEM_MAX_LORAWAN_PAYLOAD_LENGTH ) ||
+            ( ( metadata_span.part1_len + metadata_span.part2_len ) > sizeof( smtc_modem_dl_metadata_t ) ) )
+        {
+            rc = SMTC_MODEM_RC_FAIL;
+        }
+        else
+        {
+            // Length of LoRaWAN packet cannot exceed 242
+            *length = ( uint8_t ) fifo_ctrl_span_copy( &data_span, buff );
+            fifo_ctrl_span_copy( &metadata_span, metadata );
+            *remaining_data_nb = nb_of_data - 1;
+            rc                 = SMTC_MODEM_RC_OK;
+        }
+        fifo_ctrl_consume( fifo_obj );
     }
 
     return rc;
@@ -1474,6 +1514,30 @@ smtc_modem_return_code_t smtc_modem_csma_get_parameters( uint8_t stack_id, uint8
 }
 #endif  // ADD_CSMA
 
+smtc_modem_return_code_t smtc_modem_get_channel_occupancy( uint8_t stack_id, uint8_t index,
+                                                           smtc_modem_channel_occupancy_t* occupancy )
+{
+    RETURN_INVALID_IF_NULL( occupancy );
+
+#if defined( ADD_CHANNEL_OCCUPANCY )
+    smtc_real_channel_occupancy_t channel;
+
+    if( smtc_real_channel_occupancy_get( lorawan_api_stack_mac_get( stack_id )->real, index, &channel ) == false )
+    {
+        return SMTC_MODEM_RC_FAIL;
+    }
+    occupancy->frequency_hz   = channel.frequency_hz;
+    occupancy->nb_senses      = channel.nb_senses;
+    occupancy->busy_ratio_pct = smtc_real_channel_occupancy_get_busy_ratio( &channel );
+    occupancy->rssi_valid     = ( channel.nb_rssi > 0 );
+    occupancy->rssi_dbm       = channel.rssi_avg_x16 / 16;
+
+    return SMTC_MODEM_RC_OK;
+#else
+    return SMTC_MODEM_RC_FAIL;
+#endif  // ADD_CHANNEL_OCCUPANCY
+}
+
 smtc_modem_return_code_t smtc_modem_get_charge( uint32_t* charge_mah )
 {
     RETURN_INVALID_IF_NULL( charge_mah );
@@ -2415,6 +2479,32 @@ smtc_modem_return_code_t smtc_modem_debug_connect_with_abp( uint8_t stack_id, ui
     return SMTC_MODEM_RC_OK;
 }
 
+smtc_modem_return_code_t smtc_modem_debug_get_rp_timeline( uint8_t* timeline_array, uint16_t timeline_array_max_length,
+                                                           uint16_t* timeline_array_length,
+                                                           uint16_t* lost_events_count )
+{
+    RETURN_INVALID_IF_NULL( timeline_array );
+    RETURN_INVALID_IF_NULL( timeline_array_length );
+    RETURN_INVALID_IF_NULL( lost_events_count );
+
+#if defined( ADD_RP_TIMELINE )
+    rp_timeline_event_t event;
+
+    *timeline_array_length = 0;
+    while( ( ( *timeline_array_length + SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH ) <= timeline_array_max_length ) &&
+           ( rp_timeline_pop( &modem_radio_planner.timeline, &event ) == true ) )
+    {
+        rp_timeline_event_serialize( &event, &timeline_array[*timeline_array_length] );
+        *timeline_array_length += SMTC_MODEM_RP_TIMELINE_EVENT_LENGTH;
+    }
+    *lost_events_count = rp_timeline_get_and_clear_lost( &modem_radio_planner.timeline );
+
+    return SMTC_MODEM_RC_OK;
+#else
+    return SMTC_MODEM_RC_FAIL;
+#endif  // ADD_RP_TIMELINE
+}
+
 /*
  * -----------------------------------------------------------------------------
  * ----------- SMTC CLOUD MODEM FUNCTIONS ---------------------------------------
@@ -2744,6 +2834,44 @@ smtc_modem_return_code_t smtc_modem_file_upload_init( uint8_t stack_id, uint8_t
                                         ( uint8_t ) cipher_mode )];
 }
 
+smtc_modem_return_code_t smtc_modem_file_upload_init_streamed( uint8_t stack_id, uint8_t index,
+                                                               smtc_modem_file_upload_cipher_mode_t cipher_mode,
+                                                               uint16_t                             file_length,
+                                                               smtc_modem_file_upload_read_t        read_callback,
+                                                               uint32_t                             average_delay_s )
+{
+    RETURN_BUSY_IF_TEST_MODE( );
+
+#if defined( ADD_LFU_STREAMED )
+    RETURN_INVALID_IF_NULL( read_callback );
+
+    if( cipher_mode > SMTC_MODEM_FILE_UPLOAD_AES_WITH_APPSKEY )
+    {
+        return SMTC_MODEM_RC_INVALID;
+    }
+
+    return lfu_rc_lut[file_upload_init_streamed( stack_id, read_callback, ( uint32_t ) file_length, average_delay_s,
+                                                 index, ( uint8_t ) cipher_mode )];
+#else
+    SMTC_MODEM_HAL_TRACE_ERROR( "smtc_modem_file_upload_init_streamed cannot be used if no streamed LFU is built\n" );
+    return SMTC_MODEM_RC_FAIL;
+#endif
+}
+
+smtc_modem_return_code_t smtc_modem_file_upload_write( uint8_t stack_id, const uint8_t* data, uint16_t length )
+{
+    RETURN_BUSY_IF_TEST_MODE( );
+
+#if defined( ADD_LFU_STREAMED )
+    RETURN_INVALID_IF_NULL( data );
+
+    return lfu_rc_lut[file_upload_write( stack_id, data, ( uint32_t ) length )];
+#else
+    SMTC_MODEM_HAL_TRACE_ERROR( "smtc_modem_file_upload_write cannot be used if no streamed LFU is built\n" );
+    return SMTC_MODEM_RC_FAIL;
+#endif
+}
+
 smtc_modem_return_code_t smtc_modem_file_upload_start( uint8_t stack_id )
 {
     RETURN_BUSY_IF_TEST_MODE( );
@@ -2793,6 +2921,13 @@ smtc_modem_return_code_t smtc_modem_store_and_forward_get_state( uint8_t
     return SMTC_MODEM_RC_OK;
 }
 
+smtc_modem_return_code_t smtc_modem_store_and_forward_set_aggregation( uint8_t stack_id, bool enabled,
+                                                                       uint32_t max_latency_s )
+{
+    RETURN_BUSY_IF_TEST_MODE( );
+    return store_and_fw_rc_lut[store_and_forward_flash_set_aggregation( stack_id, enabled, max_latency_s )];
+}
+
 smtc_modem_return_code_t smtc_modem_store_and_forward_flash_add_data( uint8_t stack_id, uint8_t fport, bool confirmed,
                                                                       const uint8_t* payload, uint8_t payload_length )
 {
@@ -2897,7 +3032,7 @@ static void modem_store_key_context( void )
     modem_key_ctx_t ctx = { 0 };
 
     // Restore current saved context
-    smtc_modem_hal_context_restore( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_restore( &modem_key_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
 
     // Check if some values have changed
     if( ( ctx.appkey_crc != modem_appkey_crc ) || ( ctx.appkey_crc_status != modem_appkey_status ) ||
@@ -2908,20 +3043,18 @@ static void modem_store_key_context( void )
         ctx.gen_appkey_crc        = modem_gen_appkey_crc;
         ctx.gen_appkey_crc_status = modem_gen_appkey_status;
         memcpy( ctx.data_block_int_key, modem_data_block_int_key, SMTC_MODEM_KEY_LENGTH );
-        ctx.crc = crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+        ctx.crc = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-        smtc_modem_hal_context_store( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
-        // dummy context reading to ensure context store is done before exiting the function
-        smtc_modem_hal_context_restore( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+        modem_context_cache_store( &modem_key_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
     }
 }
 
 static void modem_load_appkey_context( void )
 {
     modem_key_ctx_t ctx;
-    smtc_modem_hal_context_restore( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    modem_context_cache_restore( &modem_key_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
 
-    if( crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
+    if( modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
     {
         modem_appkey_status     = ctx.appkey_crc_status;
         modem_appkey_crc        = ctx.appkey_crc;
@@ -2937,10 +3070,8 @@ static void modem_load_appkey_context( void )
         ctx.gen_appkey_crc        = 0;
         ctx.gen_appkey_crc_status = MODEM_KEY_CRC_STATUS_INVALID;
 
-        ctx.crc = crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
-        smtc_modem_hal_context_store( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
-        // dummy context reading to ensure context store is done before exiting the function
-        smtc_modem_hal_context_restore( CONTEXT_KEY_MODEM, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+        ctx.crc = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+        modem_context_cache_store( &modem_key_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
     }
 }
 #endif
@@ -8,6 +8,11 @@ target_include_directories(smtc_modem_crypto PUBLIC
     ${SMTC_MODEM_CRYPTO_DIR}/smtc_secure_element
 )
 
+# Context integrity and storage use the CRC-32 engine and the context cache of the modem utilities
+target_include_directories(smtc_modem_crypto PRIVATE
+    ${CMAKE_CURRENT_LIST_DIR}/modem_utilities
+)
+
 target_link_libraries(smtc_modem_crypto PRIVATE
     smtc_modem_hal_interface
     smtc_modem_api_interface
@@ -22,9 +27,16 @@ target_sources(smtc_modem_crypto PRIVATE
     ${SMTC_MODEM_CRYPTO_DIR}/smtc_modem_crypto.c
 )
 
+# Soft AES implementation: byte oriented (aes.c) or 32-bit T-tables (aes_ttable.c)
+if(LBM_CRYPTO_SOFT_AES STREQUAL "TTABLE")
+    set(SMTC_MODEM_CRYPTO_SOFT_AES_SOURCE ${SMTC_MODEM_CRYPTO_DIR}/soft_secure_element/aes_ttable.c)
+else()
+    set(SMTC_MODEM_CRYPTO_SOFT_AES_SOURCE ${SMTC_MODEM_CRYPTO_DIR}/soft_secure_element/aes.c)
+endif()
+
 if(LBM_CRYPTO STREQUAL "SOFT")
     target_sources(smtc_modem_crypto PRIVATE
-        ${SMTC_MODEM_CRYPTO_DIR}/soft_secure_element/aes.c
+        ${SMTC_MODEM_CRYPTO_SOFT_AES_SOURCE}
         ${SMTC_MODEM_CRYPTO_DIR}/soft_secure_element/cmac.c
         ${SMTC_MODEM_CRYPTO_DIR}/soft_secure_element/soft_se.c
     )
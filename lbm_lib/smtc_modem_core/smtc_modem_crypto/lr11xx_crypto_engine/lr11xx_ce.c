@@ -45,7 +45,8 @@
 #include "modem_core.h"
 #include "lr11xx_system.h"
 #include "lr11xx_crypto_engine.h"
-#include "modem_core.h"
+#include "modem_context_cache.h"
+#include "modem_crc.h"
 #include "smtc_modem_hal.h"
 #include "smtc_modem_hal_dbg_trace.h"
 
@@ -117,6 +118,11 @@ typedef struct lr11xx_ce_context_nvm_s
 static lr11xx_ce_data_t lr11xx_ce_data;
 static const void*      lr11xx_ctx;
 
+// Context written through as it holds the nonces
+static uint8_t               lr11xx_ce_nvm_ctx_shadow[sizeof( lr11xx_ce_context_nvm_t )];
+static modem_context_cache_t lr11xx_ce_nvm_ctx_cache =
+    MODEM_CONTEXT_CACHE_INIT( CONTEXT_SECURE_ELEMENT, lr11xx_ce_nvm_ctx_shadow, 0 );
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
@@ -130,15 +136,6 @@ static const void*      lr11xx_ctx;
  */
 static lr11xx_crypto_keys_idx_t convert_key_id_from_se_to_lr11xx( smtc_se_key_identifier_t key_id );
 
-/**
- * @brief CRC function for lr11xx se context security
- *
- * @param [in] buf  Data buffer
- * @param [in] len Length of the data
- * @return uint32_t
- */
-uint32_t lr11xx_ce_crc( const uint8_t* buf, int len );
-
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -293,6 +290,60 @@ smtc_se_return_code_t smtc_secure_element_verify_aes_cmac( uint8_t* buffer, uint
     return status;
 }
 
+smtc_se_return_code_t smtc_secure_element_verify_aes_cmac_with_keys( const uint8_t* mic_bx_buffer, const uint8_t* buffer,
+                                                                     uint16_t size, uint32_t expected_cmac,
+                                                                     const smtc_se_key_identifier_t* key_ids,
+                                                                     uint8_t nb_key_ids, uint8_t* key_index,
+                                                                     uint8_t stack_id )
+{
+    smtc_se_return_code_t status = SMTC_SE_RC_FAIL_CMAC;
+    uint8_t               cmac_buffer[CRYPTO_BUFFER_SIZE];
+    uint16_t              cmac_size = 0;
+
+    if( ( buffer == NULL ) || ( key_ids == NULL ) || ( key_index == NULL ) )
+    {
+        return SMTC_SE_RC_ERROR_NPE;
+    }
+    if( size > CRYPTO_MAXMESSAGE_SIZE )
+    {
+        return SMTC_SE_RC_ERROR_BUF_SIZE;
+    }
+
+    // lr11xx verifies a contiguous message: build it once for all candidate keys
+    if( mic_bx_buffer != NULL )
+    {
+        memcpy( cmac_buffer, mic_bx_buffer, MIC_BLOCK_BX_SIZE );
+        cmac_size = MIC_BLOCK_BX_SIZE;
+    }
+    memcpy( &cmac_buffer[cmac_size], buffer, size );
+    cmac_size += size;
+
+    // lr11xx crypto operation needed: suspend modem radio access to secure this direct access
+    SMTC_MODEM_HAL_PANIC_ON_FAILURE( modem_suspend_radio_access( ) == true );
+
+    for( uint8_t i = 0; i < nb_key_ids; i++ )
+    {
+        SMTC_MODEM_HAL_PANIC_ON_FAILURE(
+            lr11xx_crypto_verify_aes_cmac( lr11xx_ctx, ( lr11xx_crypto_status_t* ) &status,
+                                           convert_key_id_from_se_to_lr11xx( key_ids[i] ), cmac_buffer, cmac_size,
+                                           ( uint8_t* ) &expected_cmac ) == LR11XX_STATUS_OK );
+
+        if( status != SMTC_SE_RC_FAIL_CMAC )
+        {
+            if( status == SMTC_SE_RC_SUCCESS )
+            {
+                *key_index = i;
+            }
+            break;
+        }
+    }
+
+    // lr11xx crypto operation done: resume modem radio access
+    SMTC_MODEM_HAL_PANIC_ON_FAILURE( modem_resume_radio_access( ) == true );
+
+    return status;
+}
+
 smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, uint16_t size,
                                                        smtc_se_key_identifier_t key_id, uint8_t* enc_buffer,
                                                        uint8_t stack_id )
@@ -326,6 +377,48 @@ smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, ui
     return status;
 }
 
+smtc_se_return_code_t smtc_secure_element_aes_ctr_encrypt( const uint8_t* buffer, uint16_t size,
+                                                           smtc_se_key_identifier_t key_id,
+                                                           const uint8_t ctr_block[16], uint8_t* enc_buffer,
+                                                           uint8_t stack_id )
+{
+    if( ( buffer == NULL ) || ( ctr_block == NULL ) || ( enc_buffer == NULL ) )
+    {
+        return SMTC_SE_RC_ERROR_NPE;
+    }
+
+    // A single block is used for the counter and its keystream to keep this path light on stack
+    uint8_t  s_block[16];
+    uint16_t ctr        = ( ( uint16_t ) ctr_block[14] << 8 ) | ctr_block[15];
+    uint16_t buffer_idx = 0;
+
+    while( buffer_idx < size )
+    {
+        uint16_t remaining  = size - buffer_idx;
+        uint16_t block_size = ( remaining > sizeof( s_block ) ) ? sizeof( s_block ) : remaining;
+
+        memcpy( s_block, ctr_block, 14 );
+        s_block[14] = ( uint8_t ) ( ctr >> 8 );
+        s_block[15] = ( uint8_t ) ctr;
+        ctr++;
+
+        smtc_se_return_code_t status =
+            smtc_secure_element_aes_encrypt( s_block, sizeof( s_block ), key_id, s_block, stack_id );
+        if( status != SMTC_SE_RC_SUCCESS )
+        {
+            return status;
+        }
+
+        for( uint16_t i = 0; i < block_size; i++ )
+        {
+            enc_buffer[buffer_idx + i] = buffer[buffer_idx + i] ^ s_block[i];
+        }
+        buffer_idx += block_size;
+    }
+
+    return SMTC_SE_RC_SUCCESS;
+}
+
 smtc_se_return_code_t smtc_secure_element_derive_and_store_key( uint8_t* input, smtc_se_key_identifier_t rootkey_id,
                                                                 smtc_se_key_identifier_t targetkey_id,
                                                                 uint8_t                  stack_id )
@@ -569,18 +662,14 @@ smtc_se_return_code_t smtc_secure_element_store_context( uint8_t stack_id )
 {
     // Note: Multistack is not suported in lr11xx crypto element
 
-    lr11xx_ce_context_nvm_t ctx_old = { 0 };
-    smtc_modem_hal_context_restore( CONTEXT_SECURE_ELEMENT, 0, ( uint8_t* ) &ctx_old, sizeof( ctx_old ) );
-
     lr11xx_ce_context_nvm_t ctx = {
         .data = lr11xx_ce_data,
     };
 
-    ctx.crc = lr11xx_ce_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+    ctx.crc = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
-    if( ctx.crc != ctx_old.crc )
+    if( modem_context_cache_store( &lr11xx_ce_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) ) == true )
     {
-        smtc_modem_hal_context_store( CONTEXT_SECURE_ELEMENT, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
         smtc_secure_element_restore_context( stack_id );
     }
     return SMTC_SE_RC_SUCCESS;
@@ -589,8 +678,8 @@ smtc_se_return_code_t smtc_secure_element_store_context( uint8_t stack_id )
 smtc_se_return_code_t smtc_secure_element_restore_context( uint8_t stack_id )
 {
     lr11xx_ce_context_nvm_t ctx;
-    smtc_modem_hal_context_restore( CONTEXT_SECURE_ELEMENT, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
-    if( lr11xx_ce_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
+    modem_context_cache_restore( &lr11xx_ce_nvm_ctx_cache, 0, ( uint8_t* ) &ctx, sizeof( ctx ) );
+    if( modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
     {
         lr11xx_ce_data = ctx.data;
         return SMTC_SE_RC_SUCCESS;
@@ -699,19 +788,4 @@ static lr11xx_crypto_keys_idx_t convert_key_id_from_se_to_lr11xx( smtc_se_key_id
     }
     return id;
 }
-
-uint32_t lr11xx_ce_crc( const uint8_t* buf, int len )
-{
-    uint32_t crc = 0xFFFFFFFF;
-    while( len-- > 0 )
-    {
-        crc = crc ^ *buf++;
-        for( int i = 0; i < 8; i++ )
-        {
-            uint32_t mask = -( crc & 1 );
-            crc           = ( crc >> 1 ) ^ ( 0xEDB88320 & mask );
-        }
-    }
-    return ~crc;
-}
 /* --- EOF ------------------------------------------------------------------ */
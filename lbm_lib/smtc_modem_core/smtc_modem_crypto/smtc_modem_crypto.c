@@ -70,11 +70,6 @@
  */
 #define MIC_BLOCK_BX_SIZE 16
 
-/*
- * Maximum size of the buffer for crypto operations
- */
-#define CRYPTO_BUFFER_SIZE ( CRYPTO_MAXMESSAGE_SIZE + MIC_BLOCK_BX_SIZE )
-
 /*
  * LoRaWAN version minor value
  */
@@ -199,11 +194,7 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_payload_encrypt( const uint8_t
         return SMTC_MODEM_CRYPTO_RC_ERROR_NPE;
     }
 
-    uint16_t buffer_idx = 0;
-    uint16_t ctr        = 1;
-    uint8_t  sBlock[16] = { 0 };
-    uint8_t  aBlock[16] = { 0 };
-    int16_t  local_size = size;
+    uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
 
@@ -219,23 +210,13 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_payload_encrypt( const uint8_t
     aBlock[12] = ( frame_counter >> 16 ) & 0xFF;
     aBlock[13] = ( frame_counter >> 24 ) & 0xFF;
 
-    while( local_size > 0 )
-    {
-        aBlock[15] = ctr & 0xFF;
-
-        ctr++;
-
-        if( smtc_secure_element_aes_encrypt( aBlock, 16, key_id, sBlock, stack_id ) != SMTC_SE_RC_SUCCESS )
-        {
-            return SMTC_MODEM_CRYPTO_RC_ERROR_SECURE_ELEMENT;
-        }
+    // Block counter starts at 1
+    aBlock[15] = 0x01;
 
-        for( uint8_t i = 0; i < ( ( local_size > 16 ) ? 16 : local_size ); i++ )
-        {
-            enc_buffer[buffer_idx + i] = buffer[buffer_idx + i] ^ sBlock[i];
-        }
-        local_size -= 16;
-        buffer_idx += 16;
+    if( smtc_secure_element_aes_ctr_encrypt( buffer, size, key_id, aBlock, enc_buffer, stack_id ) !=
+        SMTC_SE_RC_SUCCESS )
+    {
+        return SMTC_MODEM_CRYPTO_RC_ERROR_SECURE_ELEMENT;
     }
 
     return SMTC_MODEM_CRYPTO_RC_SUCCESS;
@@ -305,7 +286,19 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic( const uint8_t* buf
                                                               uint8_t dir, uint32_t fcnt, uint32_t expected_mic,
                                                               uint8_t stack_id )
 {
-    if( buffer == 0 )
+    uint8_t key_index;
+    return smtc_modem_crypto_verify_mic_with_keys( buffer, size, &key_id, 1, devaddr, dir, fcnt, expected_mic,
+                                                   &key_index, stack_id );
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic_with_keys( const uint8_t* buffer, uint16_t size,
+                                                                        const smtc_se_key_identifier_t* key_ids,
+                                                                        uint8_t nb_key_ids, uint32_t devaddr,
+                                                                        uint8_t dir, uint32_t fcnt,
+                                                                        uint32_t expected_mic, uint8_t* key_index,
+                                                                        uint8_t stack_id )
+{
+    if( ( buffer == 0 ) || ( key_ids == 0 ) || ( key_index == 0 ) )
     {
         return SMTC_MODEM_CRYPTO_RC_ERROR_NPE;
     }
@@ -314,16 +307,14 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic( const uint8_t* buf
         return SMTC_MODEM_CRYPTO_RC_ERROR_BUF_SIZE;
     }
 
-    uint8_t mic_buff[CRYPTO_BUFFER_SIZE] = { 0 };
+    uint8_t b0[MIC_BLOCK_BX_SIZE] = { 0 };
 
-    // Initialize the first Block
-    prepare_b0( size, dir, devaddr, fcnt, mic_buff );
-
-    // Copy the given data to the mic computation buffer
-    memcpy( ( mic_buff + MIC_BLOCK_BX_SIZE ), buffer, size );
+    // Initialize the first Block, shared by all candidate keys
+    prepare_b0( size, dir, devaddr, fcnt, b0 );
 
     smtc_se_return_code_t rc = SMTC_SE_RC_ERROR;
-    rc = smtc_secure_element_verify_aes_cmac( mic_buff, ( size + MIC_BLOCK_BX_SIZE ), expected_mic, key_id, stack_id );
+    rc = smtc_secure_element_verify_aes_cmac_with_keys( b0, buffer, size, expected_mic, key_ids, nb_key_ids, key_index,
+                                                        stack_id );
 
     if( rc == SMTC_SE_RC_SUCCESS )
     {
@@ -473,39 +464,31 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_get_class_b_rand( uint32_t bea
 smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt( const uint8_t* clear_buff, uint16_t len,
                                                                    uint8_t nonce[14], uint8_t* enc_buff,
                                                                    uint8_t stack_id )
+{
+    return smtc_modem_crypto_service_encrypt_from_block( clear_buff, len, nonce, 0, enc_buff, stack_id );
+}
+
+smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt_from_block( const uint8_t* clear_buff, uint16_t len,
+                                                                              uint8_t nonce[14], uint16_t block_index,
+                                                                              uint8_t* enc_buff, uint8_t stack_id )
 {
     if( ( clear_buff == 0 ) || ( enc_buff == 0 ) )
     {
         return SMTC_MODEM_CRYPTO_RC_ERROR_NPE;
     }
 
-    uint16_t index       = 0;
-    uint16_t ctr         = 1;
-    uint8_t  s_block[16] = { 0 };
     uint8_t  a_block[16] = { 0 };
-    int16_t  local_size  = len;
+    uint16_t ctr         = block_index + 1;
 
-    // first copy the 14 bytes of nonce into a_block first 14 bytes
+    // first copy the 14 bytes of nonce into a_block first 14 bytes, block counter starts at 1 for the first block
     memcpy( a_block, nonce, 14 );
+    a_block[14] = ( uint8_t ) ( ctr >> 8 );
+    a_block[15] = ( uint8_t ) ctr;
 
-    while( local_size > 0 )
+    if( smtc_secure_element_aes_ctr_encrypt( clear_buff, len, SMTC_SE_APP_S_KEY, a_block, enc_buff, stack_id ) !=
+        SMTC_SE_RC_SUCCESS )
     {
-        a_block[15] = ctr & 0xFF;
-        a_block[14] = ( ctr >> 8 ) & 0xFF;
-
-        ctr++;
-
-        if( smtc_secure_element_aes_encrypt( a_block, 16, SMTC_SE_APP_S_KEY, s_block, stack_id ) != SMTC_SE_RC_SUCCESS )
-        {
-            return SMTC_MODEM_CRYPTO_RC_ERROR_SECURE_ELEMENT;
-        }
-
-        for( uint8_t i = 0; i < ( ( local_size > 16 ) ? 16 : local_size ); i++ )
-        {
-            enc_buff[index + i] = clear_buff[index + i] ^ s_block[i];
-        }
-        local_size -= 16;
-        index += 16;
+        return SMTC_MODEM_CRYPTO_RC_ERROR_SECURE_ELEMENT;
     }
 
     return SMTC_MODEM_CRYPTO_RC_SUCCESS;
@@ -206,6 +206,29 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic( const uint8_t* buf
                                                               uint8_t dir, uint32_t fcnt, uint32_t expected_mic,
                                                               uint8_t stack_id );
 
+/**
+ * @brief Verifies mic against a list of candidate keys
+ *
+ * The B0 block is built once and the keys are tried in list order until one matches.
+ *
+ * @param [in] buffer Data buffer to compute the integrity code
+ * @param [in] size Data buffer size
+ * @param [in] key_ids List of candidate key identifiers
+ * @param [in] nb_key_ids Number of candidate key identifiers
+ * @param [in] devaddr Device address
+ * @param [in] dir Frame direction ( Uplink:0, Downlink:1 )
+ * @param [in] fcnt Frame counter
+ * @param [in] expected_mic Expected mic
+ * @param [out] key_index Index in key_ids of the matching key
+ * @return smtc_modem_crypto_return_code_t
+ */
+smtc_modem_crypto_return_code_t smtc_modem_crypto_verify_mic_with_keys( const uint8_t* buffer, uint16_t size,
+                                                                        const smtc_se_key_identifier_t* key_ids,
+                                                                        uint8_t nb_key_ids, uint32_t devaddr,
+                                                                        uint8_t dir, uint32_t fcnt,
+                                                                        uint32_t expected_mic, uint8_t* key_index,
+                                                                        uint8_t stack_id );
+
 /**
  * @brief Compute and add mic to a buffer
  *
@@ -274,6 +297,23 @@ smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt( const uint8_t
                                                                    uint8_t nonce[14], uint8_t* enc_buff,
                                                                    uint8_t stack_id );
 
+/**
+ * @brief Encryption function for modem services, starting at a given 16-bytes block of the ciphered data
+ *
+ * @remark Encrypting a buffer in several parts with this function gives the same result as encrypting it at once with
+ *         smtc_modem_crypto_service_encrypt(), as long as each part starts on a 16-bytes boundary
+ *
+ * @param [in]  clear_buff  Clear buffer
+ * @param [in]  len         Buffer length
+ * @param [in]  nonce       Nonce to be used
+ * @param [in]  block_index Index of the 16-bytes block of the ciphered data where \p clear_buff starts
+ * @param [out] enc_buff    Encrypted buffer
+ * @return smtc_modem_crypto_return_code_t
+ */
+smtc_modem_crypto_return_code_t smtc_modem_crypto_service_encrypt_from_block( const uint8_t* clear_buff, uint16_t len,
+                                                                              uint8_t nonce[14], uint16_t block_index,
+                                                                              uint8_t* enc_buff, uint8_t stack_id );
+
 #ifdef __cplusplus
 }
 #endif
@@ -201,6 +201,28 @@ smtc_se_return_code_t smtc_secure_element_compute_aes_cmac( const uint8_t* mic_b
 smtc_se_return_code_t smtc_secure_element_verify_aes_cmac( uint8_t* buffer, uint16_t size, uint32_t expected_cmac,
                                                            smtc_se_key_identifier_t key_id, uint8_t stack_id );
 
+/**
+ * @brief Verifies a CMAC against a list of candidate keys
+ *
+ * The keys are tried in list order and the search stops at the first key whose CMAC matches the expected cmac. The
+ * message is the concatenation of the optional Bx block and of the data buffer.
+ *
+ * @param [in] mic_bx_buffer Buffer containing the initial Bx block, NULL if none
+ * @param [in] buffer Data buffer
+ * @param [in] size Data buffer size
+ * @param [in] expected_cmac Expected cmac
+ * @param [in] key_ids List of candidate key identifiers
+ * @param [in] nb_key_ids Number of candidate key identifiers
+ * @param [out] key_index Index in key_ids of the matching key
+ * @param [in] stack_id The Stack Identifier
+ * @return Secure element return code as defined in @ref smtc_se_return_code_t, SMTC_SE_RC_FAIL_CMAC if no key matches
+ */
+smtc_se_return_code_t smtc_secure_element_verify_aes_cmac_with_keys( const uint8_t* mic_bx_buffer, const uint8_t* buffer,
+                                                                     uint16_t size, uint32_t expected_cmac,
+                                                                     const smtc_se_key_identifier_t* key_ids,
+                                                                     uint8_t nb_key_ids, uint8_t* key_index,
+                                                                     uint8_t stack_id );
+
 /**
  * @brief Encrypt a buffer
  *
@@ -215,6 +237,25 @@ smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, ui
                                                        smtc_se_key_identifier_t key_id, uint8_t* enc_buffer,
                                                        uint8_t stack_id );
 
+/**
+ * @brief Encrypt a buffer in AES-CTR mode
+ *
+ * The key is set up once for the whole buffer. The counter is held by the two last bytes of the counter block (big
+ * endian) and is incremented after each 16 bytes block.
+ *
+ * @param [in] buffer Data buffer
+ * @param [in] size Data buffer size
+ * @param [in] key_id Key identifier to determine the AES key to be used
+ * @param [in] ctr_block Initial counter block
+ * @param [out] enc_buffer Encrypted buffer
+ * @param [in] stack_id The Stack Identifier
+ * @return Secure element return code as defined in @ref smtc_se_return_code_t
+ */
+smtc_se_return_code_t smtc_secure_element_aes_ctr_encrypt( const uint8_t* buffer, uint16_t size,
+                                                           smtc_se_key_identifier_t key_id,
+                                                           const uint8_t ctr_block[16], uint8_t* enc_buffer,
+                                                           uint8_t stack_id );
+
 /**
  * @brief Derives and store a key
  *
@@ -71,7 +71,11 @@ typedef uint8_t length_type;
 
 typedef struct
 {
-    uint8_t ksch[( N_MAX_ROUNDS + 1 ) * N_BLOCK];
+    union
+    {
+        uint8_t  ksch[( N_MAX_ROUNDS + 1 ) * N_BLOCK];
+        uint32_t ksch_w[( N_MAX_ROUNDS + 1 ) * N_COL]; /* word view used by the T-table implementation (aes_ttable.c) */
+    };
     uint8_t rnd;
 } aes_context;
 
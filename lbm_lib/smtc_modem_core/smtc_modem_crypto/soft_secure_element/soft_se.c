@@ -43,7 +43,8 @@
 #include "smtc_secure_element.h"
 
 #include "aes.h"
-#include "cmac.h"
+#include "modem_context_cache.h"
+#include "modem_crc.h"
 
 #include "smtc_modem_hal.h"
 #include "smtc_modem_hal_dbg_trace.h"
@@ -80,6 +81,22 @@
  */
 #define LORAMAC_MHDR_FIELD_SIZE 1
 
+/*!
+ * AES block size in bytes
+ */
+#define SOFT_SE_AES_BLOCK_SIZE 16
+
+/*!
+ * Number of expanded AES key schedules (with their CMAC subkeys) kept in RAM by the soft secure element
+ */
+#ifndef SOFT_SE_AES_CACHE_NB_ENTRIES
+#define SOFT_SE_AES_CACHE_NB_ENTRIES 4
+#endif
+
+#if( SOFT_SE_AES_CACHE_NB_ENTRIES < 1 )
+#error "SOFT_SE_AES_CACHE_NB_ENTRIES must be at least 1"
+#endif
+
 #define SOFT_SE_KEY_LIST                                                                                             \
     {                                                                                                                \
         {                                                                                                            \
@@ -347,6 +364,23 @@ typedef struct soft_se_context_nvm_s
     uint32_t       crc;
 } soft_se_context_nvm_t;
 
+/**
+ * @brief Expanded AES key schedule and CMAC subkeys of a key of the key list
+ *
+ * @struct soft_se_aes_cache_entry_t
+ */
+typedef struct soft_se_aes_cache_entry_s
+{
+    aes_context              aes_ctx;                          //!< Expanded key schedule
+    uint8_t                  cmac_k1[SOFT_SE_AES_BLOCK_SIZE];  //!< CMAC subkey K1 (RFC 4493)
+    uint8_t                  cmac_k2[SOFT_SE_AES_BLOCK_SIZE];  //!< CMAC subkey K2 (RFC 4493)
+    bool                     has_cmac_subkeys;                 //!< True if the CMAC subkeys are computed
+    smtc_se_key_identifier_t key_id;                           //!< Key identifier the entry belongs to
+    uint8_t                  stack_id;                         //!< Stack identifier the entry belongs to
+    bool                     is_valid;                         //!< True if the entry matches the current key value
+    uint32_t                 last_use;                         //!< Cache access counter value at last use
+} soft_se_aes_cache_entry_t;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE VARIABLES -------------------------------------------------------
@@ -354,6 +388,14 @@ typedef struct soft_se_context_nvm_s
 
 static soft_se_data_t soft_se_data[NUMBER_OF_STACKS] = { 0 };
 
+// Contexts of all the stacks, written through as they hold the keys and nonces
+static uint8_t               soft_se_nvm_ctx_shadow[NUMBER_OF_STACKS * sizeof( soft_se_context_nvm_t )];
+static modem_context_cache_t soft_se_nvm_ctx_cache =
+    MODEM_CONTEXT_CACHE_INIT( CONTEXT_SECURE_ELEMENT, soft_se_nvm_ctx_shadow, 0 );
+
+static soft_se_aes_cache_entry_t soft_se_aes_cache[SOFT_SE_AES_CACHE_NB_ENTRIES] = { 0 };
+static uint32_t                  soft_se_aes_cache_access_cnt                    = 0;
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
@@ -373,6 +415,25 @@ static soft_se_data_t soft_se_data[NUMBER_OF_STACKS] = { 0 };
 static smtc_se_return_code_t get_key_by_id( smtc_se_key_identifier_t key_id, soft_se_key_t** key_item,
                                             uint8_t stack_id );
 
+/**
+ * @brief Gets the cache entry of a key, expanding the key only if not already cached
+ *
+ * @param [in] key_id Key identifier
+ * @param [out] entry Cache entry reference
+ * @param [in] stack_id The Stack Identifier
+ * @return smtc_se_return_code_t
+ */
+static smtc_se_return_code_t get_aes_cache_entry( smtc_se_key_identifier_t key_id, soft_se_aes_cache_entry_t** entry,
+                                                  uint8_t stack_id );
+
+/**
+ * @brief Drops the cached AES key schedules of a key
+ *
+ * @param [in] key_id Key identifier, SMTC_SE_NO_KEY to drop all the keys of the stack
+ * @param [in] stack_id The Stack Identifier
+ */
+static void invalidate_aes_ctx( smtc_se_key_identifier_t key_id, uint8_t stack_id );
+
 /**
  * @brief Computes a CMAC of a message using provided initial Bx block
  *
@@ -389,13 +450,26 @@ static smtc_se_return_code_t compute_cmac( const uint8_t* mic_bx_buffer, const u
                                            smtc_se_key_identifier_t key_id, uint32_t* cmac, uint8_t stack_id );
 
 /**
- * @brief CRC function for soft se context security
+ * @brief Left shift by one bit of a CMAC subkey with conditional xor of Rb, as per RFC 4493
  *
- * @param [in] buf  Data buffer
- * @param [in] len Length of the data
- * @return uint32_t
+ * @param [in] in Input block
+ * @param [out] out Shifted block
  */
-uint32_t soft_ce_crc( const uint8_t* buf, int len );
+static void cmac_subkey_shift( const uint8_t in[SOFT_SE_AES_BLOCK_SIZE], uint8_t out[SOFT_SE_AES_BLOCK_SIZE] );
+
+/**
+ * @brief Computes an AES-CMAC with the key schedule and subkeys of a cache entry
+ *
+ * The message is the concatenation of the optional Bx block and of the data buffer, no copy is done.
+ *
+ * @param [in] entry Cache entry of the key
+ * @param [in] mic_bx_buffer Buffer containing the initial Bx block, NULL if none
+ * @param [in] buffer Data buffer
+ * @param [in] size Data buffer size
+ * @return uint32_t The 4 first bytes of the cmac
+ */
+static uint32_t cmac_compute( soft_se_aes_cache_entry_t* entry, const uint8_t* mic_bx_buffer, const uint8_t* buffer,
+                              uint16_t size );
 
 /*
  * -----------------------------------------------------------------------------
@@ -413,6 +487,7 @@ smtc_se_return_code_t smtc_secure_element_init( void )
     {
         memcpy( ( uint8_t* ) &soft_se_data[stack_id], ( uint8_t* ) &local_data, sizeof( local_data ) );
     }
+    memset( soft_se_aes_cache, 0, sizeof( soft_se_aes_cache ) );
     SMTC_MODEM_HAL_TRACE_INFO( "Use soft secure element for cryptographic functionalities\n" );
 
     return SMTC_SE_RC_SUCCESS;
@@ -439,11 +514,13 @@ smtc_se_return_code_t smtc_secure_element_set_key( smtc_se_key_identifier_t key_
                 rc = smtc_secure_element_aes_encrypt( key, 16, SMTC_SE_MC_KE_KEY, decrypted_key, stack_id );
 
                 memcpy( soft_se_data[stack_id].key_list[i].key_value, decrypted_key, SMTC_SE_KEY_SIZE );
+                invalidate_aes_ctx( key_id, stack_id );
                 return rc;
             }
             else
             {
                 memcpy( &( soft_se_data[stack_id].key_list[i].key_value ), key, SMTC_SE_KEY_SIZE );
+                invalidate_aes_ctx( key_id, stack_id );
                 return SMTC_SE_RC_SUCCESS;
             }
         }
@@ -490,6 +567,37 @@ smtc_se_return_code_t smtc_secure_element_verify_aes_cmac( uint8_t* buffer, uint
     return rc;
 }
 
+smtc_se_return_code_t smtc_secure_element_verify_aes_cmac_with_keys( const uint8_t* mic_bx_buffer, const uint8_t* buffer,
+                                                                     uint16_t size, uint32_t expected_cmac,
+                                                                     const smtc_se_key_identifier_t* key_ids,
+                                                                     uint8_t nb_key_ids, uint8_t* key_index,
+                                                                     uint8_t stack_id )
+{
+    if( ( buffer == NULL ) || ( key_ids == NULL ) || ( key_index == NULL ) )
+    {
+        return SMTC_SE_RC_ERROR_NPE;
+    }
+
+    for( uint8_t i = 0; i < nb_key_ids; i++ )
+    {
+        soft_se_aes_cache_entry_t* entry;
+        smtc_se_return_code_t      rc = get_aes_cache_entry( key_ids[i], &entry, stack_id );
+
+        if( rc != SMTC_SE_RC_SUCCESS )
+        {
+            return rc;
+        }
+
+        if( cmac_compute( entry, mic_bx_buffer, buffer, size ) == expected_cmac )
+        {
+            *key_index = i;
+            return SMTC_SE_RC_SUCCESS;
+        }
+    }
+
+    return SMTC_SE_RC_FAIL_CMAC;
+}
+
 smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, uint16_t size,
                                                        smtc_se_key_identifier_t key_id, uint8_t* enc_buffer,
                                                        uint8_t stack_id )
@@ -505,21 +613,16 @@ smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, ui
         return SMTC_SE_RC_ERROR_BUF_SIZE;
     }
 
-    aes_context aes_ctx;
-    memset( &aes_ctx, 0, sizeof( aes_context ) );
-
-    soft_se_key_t*        key_item;
-    smtc_se_return_code_t rc = get_key_by_id( key_id, &key_item, stack_id );
+    soft_se_aes_cache_entry_t* entry;
+    smtc_se_return_code_t      rc = get_aes_cache_entry( key_id, &entry, stack_id );
 
     if( rc == SMTC_SE_RC_SUCCESS )
     {
-        smtc_aes_set_key( key_item->key_value, 16, &aes_ctx );
-
-        uint8_t block = 0;
+        uint16_t block = 0;
 
         while( size != 0 )
         {
-            smtc_aes_encrypt( &buffer[block], &enc_buffer[block], &aes_ctx );
+            smtc_aes_encrypt( &buffer[block], &enc_buffer[block], &entry->aes_ctx );
             block = block + 16;
             size  = size - 16;
         }
@@ -527,6 +630,49 @@ smtc_se_return_code_t smtc_secure_element_aes_encrypt( const uint8_t* buffer, ui
     return rc;
 }
 
+smtc_se_return_code_t smtc_secure_element_aes_ctr_encrypt( const uint8_t* buffer, uint16_t size,
+                                                           smtc_se_key_identifier_t key_id,
+                                                           const uint8_t ctr_block[16], uint8_t* enc_buffer,
+                                                           uint8_t stack_id )
+{
+    if( ( buffer == NULL ) || ( ctr_block == NULL ) || ( enc_buffer == NULL ) )
+    {
+        return SMTC_SE_RC_ERROR_NPE;
+    }
+
+    soft_se_aes_cache_entry_t* entry;
+    smtc_se_return_code_t      rc = get_aes_cache_entry( key_id, &entry, stack_id );
+
+    if( rc == SMTC_SE_RC_SUCCESS )
+    {
+        uint8_t  a_block[16];
+        uint8_t  s_block[16];
+        uint16_t ctr        = ( ( uint16_t ) ctr_block[14] << 8 ) | ctr_block[15];
+        uint16_t buffer_idx = 0;
+
+        memcpy( a_block, ctr_block, 14 );
+
+        while( buffer_idx < size )
+        {
+            uint16_t block_size = ( ( size - buffer_idx ) > 16 ) ? 16 : ( size - buffer_idx );
+
+            a_block[14] = ( uint8_t ) ( ctr >> 8 );
+            a_block[15] = ( uint8_t ) ctr;
+            ctr++;
+
+            smtc_aes_encrypt( a_block, s_block, &entry->aes_ctx );
+
+            for( uint8_t i = 0; i < block_size; i++ )
+            {
+                enc_buffer[buffer_idx + i] = buffer[buffer_idx + i] ^ s_block[i];
+            }
+            buffer_idx += block_size;
+        }
+        memset( s_block, 0, sizeof( s_block ) );
+    }
+    return rc;
+}
+
 smtc_se_return_code_t smtc_secure_element_derive_and_store_key( uint8_t* input, smtc_se_key_identifier_t rootkey_id,
                                                                 smtc_se_key_identifier_t targetkey_id,
                                                                 uint8_t                  stack_id )
@@ -736,23 +882,28 @@ smtc_se_return_code_t smtc_secure_element_store_context( uint8_t stack_id )
     // Copy the current ram context for chosen stack_id stack in ctx
     memcpy( ( uint8_t* ) &ctx.data, ( uint8_t* ) data_current_ctx, sizeof( soft_se_data_t ) );
 
-    ctx.crc = soft_ce_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
+    ctx.crc = modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) );
 
     // Store the current context related to stack_id
-    smtc_modem_hal_context_store( CONTEXT_SECURE_ELEMENT, stack_id * sizeof( ctx ), ( uint8_t* ) &ctx, sizeof( ctx ) );
-    smtc_secure_element_restore_context( stack_id );
+    if( modem_context_cache_store( &soft_se_nvm_ctx_cache, stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
+                                   sizeof( ctx ) ) == true )
+    {
+        smtc_secure_element_restore_context( stack_id );
+    }
     return SMTC_SE_RC_SUCCESS;
 }
 
 smtc_se_return_code_t smtc_secure_element_restore_context( uint8_t stack_id )
 {
     soft_se_context_nvm_t ctx = { 0 };
-    smtc_modem_hal_context_restore( CONTEXT_SECURE_ELEMENT, stack_id * sizeof( ctx ), ( uint8_t* ) &ctx,
-                                    sizeof( ctx ) );
+    modem_context_cache_restore( &soft_se_nvm_ctx_cache, stack_id * sizeof( ctx ), ( uint8_t* ) &ctx, sizeof( ctx ) );
 
     soft_se_data_t* data_ctx = &soft_se_data[stack_id];
 
-    if( soft_ce_crc( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
+    // Key values are about to change, drop all the schedules expanded for this stack
+    invalidate_aes_ctx( SMTC_SE_NO_KEY, stack_id );
+
+    if( modem_crc32( ( uint8_t* ) &ctx, sizeof( ctx ) - sizeof( ctx.crc ) ) == ctx.crc )
     {
         // Copy the context in soft_se_data tab
         memcpy( ( uint8_t* ) data_ctx, ( uint8_t* ) &ctx.data, ( sizeof( ctx.data ) ) );
@@ -791,57 +942,181 @@ static smtc_se_return_code_t get_key_by_id( smtc_se_key_identifier_t key_id, sof
     return SMTC_SE_RC_ERROR_INVALID_KEY_ID;
 }
 
-static smtc_se_return_code_t compute_cmac( const uint8_t* mic_bx_buffer, const uint8_t* buffer, uint16_t size,
-                                           smtc_se_key_identifier_t key_id, uint32_t* cmac, uint8_t stack_id )
+static smtc_se_return_code_t get_aes_cache_entry( smtc_se_key_identifier_t key_id, soft_se_aes_cache_entry_t** entry,
+                                                  uint8_t stack_id )
 {
-    if( ( buffer == NULL ) || ( cmac == NULL ) )
+    soft_se_aes_cache_entry_t* lru_entry = NULL;
+    uint32_t                   lru_age   = 0;
+
+    soft_se_aes_cache_access_cnt++;
+
+    for( uint8_t i = 0; i < SOFT_SE_AES_CACHE_NB_ENTRIES; i++ )
     {
-        return SMTC_SE_RC_ERROR_NPE;
-    }
+        soft_se_aes_cache_entry_t* cur_entry = &soft_se_aes_cache[i];
 
-    uint8_t      local_cmac[16];
-    AES_CMAC_CTX aes_cmac_ctx[1];
+        if( cur_entry->is_valid == false )
+        {
+            // A free entry is always the best candidate for a miss
+            if( ( lru_entry == NULL ) || ( lru_entry->is_valid == true ) )
+            {
+                lru_entry = cur_entry;
+            }
+            continue;
+        }
 
-    AES_CMAC_Init( aes_cmac_ctx );
+        if( ( cur_entry->key_id == key_id ) && ( cur_entry->stack_id == stack_id ) )
+        {
+            cur_entry->last_use = soft_se_aes_cache_access_cnt;
+            *entry              = cur_entry;
+            return SMTC_SE_RC_SUCCESS;
+        }
 
-    soft_se_key_t* key_item;
+        // Wrap-safe age of the entry
+        uint32_t age = soft_se_aes_cache_access_cnt - cur_entry->last_use;
+        if( ( lru_entry == NULL ) || ( ( lru_entry->is_valid == true ) && ( age > lru_age ) ) )
+        {
+            lru_entry = cur_entry;
+            lru_age   = age;
+        }
+    }
 
+    soft_se_key_t*        key_item;
     smtc_se_return_code_t rc = get_key_by_id( key_id, &key_item, stack_id );
 
-    if( rc == SMTC_SE_RC_SUCCESS )
+    if( rc != SMTC_SE_RC_SUCCESS )
     {
-        AES_CMAC_SetKey( aes_cmac_ctx, key_item->key_value );
+        return rc;
+    }
 
-        if( mic_bx_buffer != NULL )
+    memset( lru_entry, 0, sizeof( soft_se_aes_cache_entry_t ) );
+    smtc_aes_set_key( key_item->key_value, SMTC_SE_KEY_SIZE, &lru_entry->aes_ctx );
+    lru_entry->key_id   = key_id;
+    lru_entry->stack_id = stack_id;
+    lru_entry->is_valid = true;
+    lru_entry->last_use = soft_se_aes_cache_access_cnt;
+
+    *entry = lru_entry;
+    return SMTC_SE_RC_SUCCESS;
+}
+
+static void invalidate_aes_ctx( smtc_se_key_identifier_t key_id, uint8_t stack_id )
+{
+    for( uint8_t i = 0; i < SOFT_SE_AES_CACHE_NB_ENTRIES; i++ )
+    {
+        soft_se_aes_cache_entry_t* entry = &soft_se_aes_cache[i];
+
+        if( ( entry->stack_id == stack_id ) && ( ( key_id == SMTC_SE_NO_KEY ) || ( entry->key_id == key_id ) ) )
         {
-            AES_CMAC_Update( aes_cmac_ctx, mic_bx_buffer, 16 );
+            memset( entry, 0, sizeof( soft_se_aes_cache_entry_t ) );
         }
+    }
+}
 
-        AES_CMAC_Update( aes_cmac_ctx, buffer, size );
+static smtc_se_return_code_t compute_cmac( const uint8_t* mic_bx_buffer, const uint8_t* buffer, uint16_t size,
+                                           smtc_se_key_identifier_t key_id, uint32_t* cmac, uint8_t stack_id )
+{
+    if( ( buffer == NULL ) || ( cmac == NULL ) )
+    {
+        return SMTC_SE_RC_ERROR_NPE;
+    }
 
-        AES_CMAC_Final( local_cmac, aes_cmac_ctx );
+    soft_se_aes_cache_entry_t* entry;
+    smtc_se_return_code_t      rc = get_aes_cache_entry( key_id, &entry, stack_id );
 
-        // Bring into the required format
-        *cmac = ( uint32_t ) ( ( uint32_t ) local_cmac[3] << 24 | ( uint32_t ) local_cmac[2] << 16 |
-                               ( uint32_t ) local_cmac[1] << 8 | ( uint32_t ) local_cmac[0] );
+    if( rc == SMTC_SE_RC_SUCCESS )
+    {
+        *cmac = cmac_compute( entry, mic_bx_buffer, buffer, size );
     }
 
     return rc;
 }
 
-uint32_t soft_ce_crc( const uint8_t* buf, int len )
+static void cmac_subkey_shift( const uint8_t in[SOFT_SE_AES_BLOCK_SIZE], uint8_t out[SOFT_SE_AES_BLOCK_SIZE] )
 {
-    uint32_t crc = 0xFFFFFFFF;
-    while( len-- > 0 )
+    uint8_t msb = in[0] & 0x80;
+
+    for( uint8_t i = 0; i < ( SOFT_SE_AES_BLOCK_SIZE - 1 ); i++ )
+    {
+        out[i] = ( uint8_t ) ( ( in[i] << 1 ) | ( in[i + 1] >> 7 ) );
+    }
+    out[SOFT_SE_AES_BLOCK_SIZE - 1] = ( uint8_t ) ( in[SOFT_SE_AES_BLOCK_SIZE - 1] << 1 );
+
+    if( msb != 0 )
+    {
+        out[SOFT_SE_AES_BLOCK_SIZE - 1] ^= 0x87;
+    }
+}
+
+static uint32_t cmac_compute( soft_se_aes_cache_entry_t* entry, const uint8_t* mic_bx_buffer, const uint8_t* buffer,
+                              uint16_t size )
+{
+    uint8_t        x[SOFT_SE_AES_BLOCK_SIZE] = { 0 };
+    const uint8_t* last_block;
+    uint8_t        last_size;
+
+    // K1 and K2 only depend on the key: derive them once per cache entry
+    if( entry->has_cmac_subkeys == false )
+    {
+        smtc_aes_encrypt( x, x, &entry->aes_ctx );
+        cmac_subkey_shift( x, entry->cmac_k1 );
+        cmac_subkey_shift( entry->cmac_k1, entry->cmac_k2 );
+        memset( x, 0, sizeof( x ) );
+        entry->has_cmac_subkeys = true;
+    }
+
+    if( size == 0 )
+    {
+        // The Bx block, if any, is the last block of the message
+        last_block = mic_bx_buffer;
+        last_size  = ( mic_bx_buffer != NULL ) ? SOFT_SE_AES_BLOCK_SIZE : 0;
+    }
+    else
+    {
+        if( mic_bx_buffer != NULL )
+        {
+            for( uint8_t i = 0; i < SOFT_SE_AES_BLOCK_SIZE; i++ )
+            {
+                x[i] ^= mic_bx_buffer[i];
+            }
+            smtc_aes_encrypt( x, x, &entry->aes_ctx );
+        }
+        while( size > SOFT_SE_AES_BLOCK_SIZE )
+        {
+            for( uint8_t i = 0; i < SOFT_SE_AES_BLOCK_SIZE; i++ )
+            {
+                x[i] ^= buffer[i];
+            }
+            smtc_aes_encrypt( x, x, &entry->aes_ctx );
+            buffer += SOFT_SE_AES_BLOCK_SIZE;
+            size -= SOFT_SE_AES_BLOCK_SIZE;
+        }
+        last_block = buffer;
+        last_size  = ( uint8_t ) size;
+    }
+
+    if( last_size == SOFT_SE_AES_BLOCK_SIZE )
     {
-        crc = crc ^ *buf++;
-        for( int i = 0; i < 8; i++ )
+        for( uint8_t i = 0; i < SOFT_SE_AES_BLOCK_SIZE; i++ )
         {
-            uint32_t mask = -( crc & 1 );
-            crc           = ( crc >> 1 ) ^ ( 0xEDB88320 & mask );
+            x[i] ^= last_block[i] ^ entry->cmac_k1[i];
         }
     }
-    return ~crc;
+    else
+    {
+        // Incomplete last block is padded with 10...0
+        for( uint8_t i = 0; i < last_size; i++ )
+        {
+            x[i] ^= last_block[i];
+        }
+        x[last_size] ^= 0x80;
+        for( uint8_t i = 0; i < SOFT_SE_AES_BLOCK_SIZE; i++ )
+        {
+            x[i] ^= entry->cmac_k2[i];
+        }
+    }
+    smtc_aes_encrypt( x, x, &entry->aes_ctx );
+
+    return ( uint32_t ) x[3] << 24 | ( uint32_t ) x[2] << 16 | ( uint32_t ) x[1] << 8 | ( uint32_t ) x[0];
 }
 
 /* --- EOF ------------------------------------------------------------------ */
@@ -105,6 +105,7 @@ typedef enum
     CONTEXT_FUOTA,
     CONTEXT_SECURE_ELEMENT,
     CONTEXT_STORE_AND_FORWARD,
+    CONTEXT_SESSION_JOURNAL,
 } modem_context_type_t;
 
 /*
@@ -219,7 +220,7 @@ void smtc_modem_hal_context_store( const modem_context_type_t ctx_type, uint32_t
 
 /**
  * @brief Erase a chosen number of flash pages of a context
- * @remark This function is only used with CONTEXT_STORE_AND_FORWARD
+ * @remark This function is only used with CONTEXT_STORE_AND_FORWARD and CONTEXT_SESSION_JOURNAL
  *
  * @param [in] ctx_type   Type of modem context that need to be erased
  * @param [in] offset     Memory offset after ctx_type address
@@ -448,6 +449,16 @@ uint16_t smtc_modem_hal_store_and_forward_get_number_of_pages( void );
  */
 uint16_t smtc_modem_hal_flash_get_page_size( void );
 
+/* ------------ Needed for the LoRaWAN session journal  ------------*/
+
+/**
+ * @brief The number of reserved pages in flash for the LoRaWAN session journal
+ * @remark the number must be at least 3 pages, the flash page size is given by smtc_modem_hal_flash_get_page_size
+ *
+ * @return uint16_t
+ */
+uint16_t smtc_modem_hal_session_journal_get_number_of_pages( void );
+
 /* ------------ For Real Time OS compatibility  ------------*/
 
 /**